@@ -23,6 +23,8 @@ class BMV2Options : public CompilerOptions {
     std::filesystem::path outputFile;
     /// Read from json.
     bool loadIRFromJson = false;
+    /// Read from the binary IR format (loadIRFromJson is set as well).
+    bool loadIRFromBinary = false;
 
     BMV2Options() {
         registerOption(
@@ -49,6 +51,16 @@ class BMV2Options : public CompilerOptions {
             },
             "Use IR representation from JsonFile dumped previously,"
             "the compilation starts with reduced midEnd.");
+        registerOption(
+            "--fromBinaryIR", "file",
+            [this](const char *arg) {
+                loadIRFromJson = true;
+                loadIRFromBinary = true;
+                file = arg;
+                return true;
+            },
+            "Use IR representation dumped previously with --toBinaryIR,\n"
+            "the compilation starts with reduced midEnd.");
     }
 };
 
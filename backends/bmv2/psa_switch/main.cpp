@@ -18,6 +18,8 @@
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
 #include "fstream"
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
 #include "ir/ir.h"
 #include "ir/json_loader.h"
 #include "lib/error.h"
@@ -65,6 +67,19 @@ int main(int argc, char *const argv[]) {
             return 1;
         }
         if (program == nullptr || ::P4::errorCount() > 0) return 1;
+    } else if (options.loadIRFromBinary) {
+        BinaryLoader binaryFileLoader(options.file);
+        if (!binaryFileLoader) {
+            ::P4::error(ErrorType::ERR_IO, "%s: Not a valid binary IR file", options.file);
+            return 1;
+        }
+        try {
+            program = binaryFileLoader.loadNode<IR::P4Program>();
+        } catch (const std::exception &bug) {
+            std::cerr << bug.what() << std::endl;
+            return 1;
+        }
+        if (program == nullptr) return 1;
     } else {
         std::filebuf fb;
         if (fb.open(options.file, std::ios::in) == nullptr) {
@@ -94,6 +109,10 @@ int main(int argc, char *const argv[]) {
             auto dumpJsonStream = openFile(options.dumpJsonFile, true);
             JSONGenerator(*dumpJsonStream, true).emit(program);
         }
+        if (!options.dumpBinaryIRFile.empty()) {
+            auto dumpBinaryStream = openFile(options.dumpBinaryIRFile, true);
+            BinaryGenerator(*dumpBinaryStream, true).emit(program);
+        }
     } catch (const std::exception &bug) {
         std::cerr << bug.what() << std::endl;
         return 1;
@@ -17,6 +17,8 @@
 #include "frontends/common/applyOptionsPragmas.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/frontend.h"
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -34,7 +36,7 @@ int main(int argc, char *const argv[]) {
     setup_gc_logging();
     setup_signals();
 
-    AutoCompileContext autoBMV2Context(new BMV2::SimpleSwitchContext);
+    AutoCompileContext autoBMV2Context(new BMV2::SimpleSwitchContext, /* useArena */ true);
     auto &options = BMV2::SimpleSwitchContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
     options.compilerVersion = cstring(BMV2_SIMPLESWITCH_VERSION_STRING);
@@ -68,6 +70,19 @@ int main(int argc, char *const argv[]) {
             return 1;
         }
         if (program == nullptr || ::P4::errorCount() > 0) return 1;
+    } else if (options.loadIRFromBinary) {
+        BinaryLoader binaryFileLoader(options.file);
+        if (!binaryFileLoader) {
+            ::P4::error(ErrorType::ERR_IO, "%s: Not a valid binary IR file", options.file);
+            return 1;
+        }
+        try {
+            program = binaryFileLoader.loadNode<IR::P4Program>();
+        } catch (const std::exception &bug) {
+            std::cerr << bug.what() << std::endl;
+            return 1;
+        }
+        if (program == nullptr) return 1;
     } else {
         std::filebuf fb;
         if (fb.open(options.file, std::ios::in) == nullptr) {
@@ -97,6 +112,10 @@ int main(int argc, char *const argv[]) {
             auto dumpJsonStream = openFile(options.dumpJsonFile, true);
             JSONGenerator(*dumpJsonStream, true).emit(program);
         }
+        if (!options.dumpBinaryIRFile.empty() && !options.loadIRFromJson) {
+            auto dumpBinaryStream = openFile(options.dumpBinaryIRFile, true);
+            BinaryGenerator(*dumpBinaryStream, true).emit(program);
+        }
     } catch (const std::exception &bug) {
         std::cerr << bug.what() << std::endl;
         return 1;
@@ -11,6 +11,7 @@
 #include "backends/p4test/version.h"
 #include "control-plane/p4RuntimeSerializer.h"
 #include "frontends/common/applyOptionsPragmas.h"
+#include "frontends/common/compileServer.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/p4/evaluator/evaluator.h"
 #include "frontends/p4/frontend.h"
@@ -129,11 +130,8 @@ static void log_dump(const IR::Node *node, const char *head) {
     }
 }
 
-int main(int argc, char *const argv[]) {
-    setup_gc_logging();
-    setup_signals();
-
-    AutoCompileContext autoP4TestContext(new P4TestContext);
+static int compile(int argc, char *const argv[]) {
+    AutoCompileContext autoP4TestContext(new P4TestContext, /* useArena */ true);
     auto &options = P4TestContext::get().options();
     options.langVersion = CompilerOptions::FrontendVersion::P4_16;
     options.compilerVersion = cstring(P4TEST_VERSION_STRING);
@@ -243,3 +241,13 @@ int main(int argc, char *const argv[]) {
     if (Log::verbose()) std::cerr << "Done." << std::endl;
     return ::P4::errorCount() > 0;
 }
+
+int main(int argc, char *const argv[]) {
+    setup_gc_logging();
+    setup_signals();
+
+    if (auto status = compileAsClient(argc, argv)) return *status;
+    if (auto serverOptions = CompileServer::parseCommandLine(argc, argv))
+        return CompileServer(*serverOptions).run(compile);
+    return compile(argc, argv);
+}
@@ -4,8 +4,13 @@
 
 #include "backends/p4tools/common/core/abstract_execution_state.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "backends/p4tools/common/compiler/convert_hs_index.h"
 #include "backends/p4tools/common/core/target.h"
+#include "backends/p4tools/common/lib/ir_compare.h"
 #include "backends/p4tools/common/lib/variables.h"
 #include "ir/irutils.h"
 
@@ -31,7 +36,14 @@ const SymbolicEnv &AbstractExecutionState::getSymbolicEnv() const { return env;
 void AbstractExecutionState::printSymbolicEnv(std::ostream &out) const {
     // TODO(fruffy): How do we do logging here?
     out << "##### Symbolic Environment Begin #####\n";
-    for (const auto &envVar : env.getInternalMap()) {
+    // The environment is a hash map. Sort the variables to keep the output stable.
+    const auto &envMap = env.getInternalMap();
+    std::vector<std::pair<IR::StateVariable, const IR::Expression *>> envVars(envMap.begin(),
+                                                                              envMap.end());
+    std::sort(envVars.begin(), envVars.end(), [](const auto &left, const auto &right) {
+        return IR::StateVariableLess()(left.first, right.first);
+    });
+    for (const auto &envVar : envVars) {
         const auto var = envVar.first;
         const auto *val = envVar.second;
         out << "Variable: " << var->toString() << " Value: " << val << '\n';
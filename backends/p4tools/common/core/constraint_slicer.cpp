@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/common/core/constraint_slicer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+
+#include "ir/visitor.h"
+
+namespace P4::P4Tools {
+
+namespace {
+
+/// Collects the labels of the symbolic variables of an expression.
+class CollectSymbolicVariables : public Inspector {
+    std::vector<cstring> &variables;
+
+ public:
+    explicit CollectSymbolicVariables(std::vector<cstring> &variables) : variables(variables) {}
+
+    bool preorder(const IR::SymbolicVariable *var) override {
+        variables.push_back(var->label);
+        return false;
+    }
+};
+
+/// A union-find structure over the labels of symbolic variables.
+class VariableClasses {
+    std::unordered_map<cstring, size_t> ids;
+
+    std::vector<size_t> parent;
+
+ public:
+    /// @returns the id of @param label, which is a class of its own when it is first seen.
+    size_t idOf(cstring label) {
+        auto [it, inserted] = ids.try_emplace(label, parent.size());
+        if (inserted) {
+            parent.push_back(it->second);
+        }
+        return it->second;
+    }
+
+    /// @returns the representative of the class of @param id.
+    size_t find(size_t id) {
+        while (parent[id] != id) {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+    /// Merges the classes of @param left and @param right.
+    void unite(size_t left, size_t right) {
+        left = find(left);
+        right = find(right);
+        if (left != right) {
+            parent[std::max(left, right)] = std::min(left, right);
+        }
+    }
+};
+
+}  // namespace
+
+const std::vector<cstring> &ConstraintSlicer::variablesOf(const Constraint *constraint) {
+    auto [it, inserted] = variablesByConstraint.try_emplace(constraint);
+    if (inserted) {
+        auto &variables = it->second;
+        constraint->apply(CollectSymbolicVariables(variables));
+        std::sort(variables.begin(), variables.end());
+        variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+    }
+    return it->second;
+}
+
+std::vector<ConstraintSlicer::Partition> ConstraintSlicer::partition(
+    const std::vector<const Constraint *> &constraints) {
+    VariableClasses classes;
+    for (const auto *constraint : constraints) {
+        const auto &variables = variablesOf(constraint);
+        if (variables.empty()) {
+            continue;
+        }
+        auto first = classes.idOf(variables.front());
+        for (auto it = std::next(variables.begin()); it != variables.end(); ++it) {
+            classes.unite(first, classes.idOf(*it));
+        }
+    }
+
+    std::vector<Partition> partitions;
+    std::unordered_map<size_t, size_t> partitionOfClass;
+    std::optional<size_t> groundPartition;
+    size_t idx = 0;
+    for (const auto *constraint : constraints) {
+        const auto &variables = variablesOf(constraint);
+        if (variables.empty()) {
+            if (!groundPartition.has_value()) {
+                groundPartition = partitions.size();
+                partitions.emplace_back();
+            }
+            idx = groundPartition.value();
+        } else {
+            auto [it, inserted] = partitionOfClass.try_emplace(
+                classes.find(classes.idOf(variables.front())), partitions.size());
+            if (inserted) {
+                partitions.emplace_back();
+            }
+            idx = it->second;
+            partitions[idx].variables.insert(variables.begin(), variables.end());
+        }
+        partitions[idx].constraints.push_back(constraint);
+    }
+    // Move the partition of the last constraint to the front.
+    if (idx > 0) {
+        std::rotate(partitions.begin(), partitions.begin() + idx, partitions.begin() + idx + 1);
+    }
+    return partitions;
+}
+
+void ConstraintSlicer::clear() { variablesByConstraint.clear(); }
+
+}  // namespace P4::P4Tools
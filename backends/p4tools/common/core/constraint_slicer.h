@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_COMMON_CORE_CONSTRAINT_SLICER_H_
+#define BACKENDS_P4TOOLS_COMMON_CORE_CONSTRAINT_SLICER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/solver.h"
+#include "lib/cstring.h"
+
+namespace P4::P4Tools {
+
+/// Splits a list of constraints into independent partitions, in the style of the constraint
+/// independence optimization of KLEE. Two constraints are in the same partition if they share a
+/// symbolic variable, directly or through other constraints of the list. The conjunction of the
+/// constraints is satisfiable if and only if every partition is satisfiable, and the union of
+/// the models of the partitions is a model of the conjunction.
+///
+/// A path constraint usually consists of many partitions, for example one for each header. A
+/// new branch condition only extends the partitions whose variables it mentions, so the other
+/// partitions do not change from one query to the next.
+class ConstraintSlicer {
+ public:
+    struct Partition {
+        /// The constraints of the partition, in the order of the input.
+        std::vector<const Constraint *> constraints;
+
+        /// The labels of the symbolic variables that the constraints refer to.
+        std::unordered_set<cstring> variables;
+    };
+
+    /// Splits @param constraints into partitions. The partition of the last constraint, which is
+    /// usually the newest one, comes first. The other partitions are ordered by their first
+    /// constraint. Constraints without symbolic variables form a single partition.
+    std::vector<Partition> partition(const std::vector<const Constraint *> &constraints);
+
+    /// Forgets the variables of all constraints seen so far.
+    void clear();
+
+ private:
+    /// @returns the labels of the symbolic variables of @param constraint.
+    const std::vector<cstring> &variablesOf(const Constraint *constraint);
+
+    /// Caches the variables of each constraint seen so far. Path constraints are shared between
+    /// execution states, so the same constraints are partitioned over and over.
+    std::unordered_map<const Constraint *, std::vector<cstring>> variablesByConstraint;
+};
+
+}  // namespace P4::P4Tools
+
+#endif /* BACKENDS_P4TOOLS_COMMON_CORE_CONSTRAINT_SLICER_H_ */
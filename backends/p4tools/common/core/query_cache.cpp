@@ -0,0 +1,277 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/common/core/query_cache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "backends/p4tools/common/lib/logging.h"
+#include "frontends/common/constantFolding.h"
+#include "ir/visitor.h"
+#include "lib/error_reporter.h"
+#include "lib/exceptions.h"
+#include "lib/hash.h"
+#include "lib/null.h"
+
+namespace P4::P4Tools {
+
+namespace {
+
+/// @returns the hash of a normalized query.
+size_t hashQuery(const QueryCache::Query &query) {
+    size_t hash = 0;
+    for (const auto *constraint : query) {
+        hash = Util::hash_combine(hash, Util::Hash()(constraint));
+    }
+    return hash;
+}
+
+/// Substitutes the values of a model for the symbolic variables of a constraint. Sets @a failed
+/// if the constraint refers to a variable that the model does not bind, or if it contains an
+/// operation that the constant folder may reject, such as a division.
+class ModelSubstitution : public Transform {
+    const SymbolicMapping &model;
+
+ public:
+    bool failed = false;
+
+    explicit ModelSubstitution(const SymbolicMapping &model) : model(model) {}
+
+    const IR::Node *preorder(IR::SymbolicVariable *var) override {
+        prune();
+        auto it = model.find(var);
+        if (it == model.end()) {
+            failed = true;
+            return var;
+        }
+        return it->second;
+    }
+
+    const IR::Node *preorder(IR::Expression *expr) override {
+        if (!(expr->is<IR::Constant>() || expr->is<IR::BoolLiteral>() || expr->is<IR::Equ>() ||
+              expr->is<IR::Neq>() || expr->is<IR::Lss>() || expr->is<IR::Leq>() ||
+              expr->is<IR::Grt>() || expr->is<IR::Geq>() || expr->is<IR::LAnd>() ||
+              expr->is<IR::LOr>() || expr->is<IR::LNot>() || expr->is<IR::BAnd>() ||
+              expr->is<IR::BOr>() || expr->is<IR::BXor>() || expr->is<IR::Cmpl>() ||
+              expr->is<IR::Neg>() || expr->is<IR::Add>() || expr->is<IR::Sub>() ||
+              expr->is<IR::Mul>() || expr->is<IR::Concat>() || expr->is<IR::Slice>() ||
+              expr->is<IR::Cast>() || expr->is<IR::Mux>())) {
+            failed = true;
+            prune();
+        }
+        return expr;
+    }
+};
+
+}  // namespace
+
+QueryCache::Query QueryCache::normalize(const std::vector<const Constraint *> &constraints) {
+    Query query;
+    query.reserve(constraints.size());
+    for (const auto *constraint : constraints) {
+        auto it = representativeOf.find(constraint);
+        if (it == representativeOf.end()) {
+            it = representativeOf.emplace(constraint, *representatives.insert(constraint).first)
+                     .first;
+        }
+        if (const auto *boolLiteral = it->second->to<IR::BoolLiteral>();
+            boolLiteral != nullptr && boolLiteral->value) {
+            continue;
+        }
+        query.push_back(it->second);
+    }
+    std::sort(query.begin(), query.end());
+    query.erase(std::unique(query.begin(), query.end()), query.end());
+    return query;
+}
+
+std::optional<QueryCache::Result> QueryCache::lookup(const Query &query) {
+    addPerformanceCounter("solver_queries");
+    // Derived answers are recorded, so that a repetition of the query is an exact hit.
+    auto hit = [this, &query](size_t idx, const char *kind) {
+        addPerformanceCounter("solver_queries.cache_hits");
+        addPerformanceCounter(std::string("solver_queries.cache_hits.") + kind);
+        auto result = entries[idx].result;
+        if (entries[idx].query != query) {
+            insert(query, result);
+        }
+        return result;
+    };
+    auto hashIt = entriesByHash.find(hashQuery(query));
+    if (hashIt != entriesByHash.end()) {
+        for (auto idx : hashIt->second) {
+            if (entries[idx].query == query) {
+                return hit(idx, "exact");
+            }
+        }
+    }
+    if (auto idx = findUnsatSubset(query)) {
+        return hit(*idx, "unsat_subset");
+    }
+    if (auto idx = findSatSuperset(query)) {
+        return hit(*idx, "sat_superset");
+    }
+    if (auto idx = findSatisfyingModel(query)) {
+        return hit(*idx, "model_reuse");
+    }
+    return std::nullopt;
+}
+
+std::optional<size_t> QueryCache::findUnsatSubset(const Query &query) {
+    // Count, for every unsatisfiable entry, how many of its constraints are part of the query.
+    // The entries that are complete are subsets.
+    matches.resize(entries.size());
+    std::vector<size_t> touched;
+    std::optional<size_t> result;
+    for (const auto *constraint : query) {
+        auto it = unsatEntriesOf.find(constraint);
+        if (it == unsatEntriesOf.end()) {
+            continue;
+        }
+        for (auto idx : it->second) {
+            if (matches[idx]++ == 0) {
+                touched.push_back(idx);
+            }
+            if (matches[idx] == entries[idx].query.size()) {
+                result = idx;
+                break;
+            }
+        }
+        if (result.has_value()) {
+            break;
+        }
+    }
+    for (auto idx : touched) {
+        matches[idx] = 0;
+    }
+    return result;
+}
+
+std::optional<size_t> QueryCache::findSatSuperset(const Query &query) const {
+    if (query.empty()) {
+        return std::nullopt;
+    }
+    // A superset contains every constraint of the query, so it suffices to look at the entries
+    // that contain the rarest constraint.
+    const std::vector<size_t> *candidates = nullptr;
+    for (const auto *constraint : query) {
+        auto it = satEntriesOf.find(constraint);
+        if (it == satEntriesOf.end()) {
+            return std::nullopt;
+        }
+        if (candidates == nullptr || it->second.size() < candidates->size()) {
+            candidates = &it->second;
+        }
+    }
+    for (auto idx : *candidates) {
+        const auto &candidate = entries[idx].query;
+        if (std::includes(candidate.begin(), candidate.end(), query.begin(), query.end())) {
+            return idx;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<size_t> QueryCache::findSatisfyingModel(const Query &query) const {
+    for (auto idx : recentSatEntries) {
+        const auto &entry = entries[idx];
+        // The model satisfies the constraints of its own query. Only check the others.
+        Query unchecked;
+        std::set_difference(query.begin(), query.end(), entry.query.begin(), entry.query.end(),
+                            std::back_inserter(unchecked));
+        if (unchecked.size() > MAX_MODEL_CHECKS) {
+            continue;
+        }
+        if (std::all_of(unchecked.begin(), unchecked.end(), [&entry](const auto *constraint) {
+                return holds(constraint, *entry.result.model);
+            })) {
+            return idx;
+        }
+    }
+    return std::nullopt;
+}
+
+bool QueryCache::holds(const Constraint *constraint, const SymbolicMapping &model) {
+    ModelSubstitution substitution(model);
+    const auto *substituted = constraint->apply(substitution);
+    if (substitution.failed) {
+        return false;
+    }
+    // The constant folder reports problems as diagnostics. Keep them away from the user and
+    // treat them as a failed evaluation; the solver will answer the query instead.
+    ErrorReporter::Deferred diagnostics;
+    const IR::Node *evaluated = nullptr;
+    {
+        ErrorReporter::DeferScope defer(diagnostics);
+        evaluated = substituted->apply(DoConstantFolding(nullptr, false));
+    }
+    if (!diagnostics.empty()) {
+        return false;
+    }
+    const auto *result = evaluated->to<IR::BoolLiteral>();
+    return result != nullptr && result->value;
+}
+
+void QueryCache::insert(const Query &query, Result result) {
+    BUG_CHECK(result.isSat || result.model == nullptr,
+              "An unsatisfiable query can not have a model.");
+    if (entries.size() >= MAX_ENTRIES) {
+        clear();
+        // The constraints of the query stay the representatives of their classes.
+        representatives.insert(query.begin(), query.end());
+    }
+    auto idx = entries.size();
+    entries.push_back({query, result});
+    entriesByHash[hashQuery(query)].push_back(idx);
+    auto &entriesOf = result.isSat ? satEntriesOf : unsatEntriesOf;
+    for (const auto *constraint : query) {
+        entriesOf[constraint].push_back(idx);
+    }
+    if (result.model != nullptr) {
+        rememberModel(idx);
+    }
+}
+
+void QueryCache::setModel(const Query &query, const SymbolicMapping *model) {
+    CHECK_NULL(model);
+    auto hashIt = entriesByHash.find(hashQuery(query));
+    if (hashIt != entriesByHash.end()) {
+        for (auto idx : hashIt->second) {
+            auto &entry = entries[idx];
+            if (entry.query != query) {
+                continue;
+            }
+            BUG_CHECK(entry.result.isSat, "Unsatisfiable query can not have a model.");
+            if (entry.result.model == nullptr) {
+                entry.result.model = model;
+                rememberModel(idx);
+            }
+            return;
+        }
+    }
+    // The entry was dropped when the cache was full.
+    insert(query, {true, model});
+}
+
+void QueryCache::rememberModel(size_t idx) {
+    recentSatEntries.push_front(idx);
+    if (recentSatEntries.size() > MAX_RECENT_MODELS) {
+        recentSatEntries.pop_back();
+    }
+}
+
+void QueryCache::clear() {
+    entries.clear();
+    entriesByHash.clear();
+    satEntriesOf.clear();
+    unsatEntriesOf.clear();
+    recentSatEntries.clear();
+    matches.clear();
+    representatives.clear();
+    representativeOf.clear();
+}
+
+}  // namespace P4::P4Tools
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_COMMON_CORE_QUERY_CACHE_H_
+#define BACKENDS_P4TOOLS_COMMON_CORE_QUERY_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/solver.h"
+
+namespace P4::P4Tools {
+
+/// Caches the answers to satisfiability queries, in the style of the counterexample cache of
+/// KLEE. A query is a set of constraints. Besides answering repeated queries, the cache uses
+/// the following facts to answer queries it has not seen:
+///   - A query that contains an unsatisfiable query is unsatisfiable.
+///   - A query that is contained in a satisfiable query is satisfiable, with the same model.
+///   - A query is satisfiable if a recent model happens to satisfy it.
+/// Symbolic execution produces many queries that only differ from an earlier one in the last
+/// constraint, which makes the last two cases common.
+class QueryCache {
+ public:
+    /// A set of constraints, normalized by normalize().
+    using Query = std::vector<const Constraint *>;
+
+    /// The answer to a query.
+    struct Result {
+        /// Whether the query is satisfiable.
+        bool isSat;
+
+        /// A model of the query if it is satisfiable and its model has been extracted, nullptr
+        /// otherwise.
+        const SymbolicMapping *model;
+    };
+
+    /// Normalizes @param constraints into a query: equivalent constraints are replaced with a
+    /// single representative, and duplicates and constraints that are trivially true are dropped.
+    Query normalize(const std::vector<const Constraint *> &constraints);
+
+    /// @returns the answer to @param query if the cache can derive it without the solver.
+    std::optional<Result> lookup(const Query &query);
+
+    /// Records the answer to @param query.
+    void insert(const Query &query, Result result);
+
+    /// Records @param model as the model of the satisfiable @param query, which may have been
+    /// cached without one.
+    void setModel(const Query &query, const SymbolicMapping *model);
+
+    /// Removes all cached answers and forgets the representatives of the constraints.
+    void clear();
+
+ private:
+    /// The maximum number of cached answers. The cache is emptied once it is full, which keeps
+    /// the cost of the subset and superset searches bounded.
+    static constexpr size_t MAX_ENTRIES = 1024;
+
+    /// The number of most recent models that are tried on a new query.
+    static constexpr size_t MAX_RECENT_MODELS = 8;
+
+    /// Recent models are only tried if the query has at most this many constraints that the
+    /// model is not already known to satisfy.
+    static constexpr size_t MAX_MODEL_CHECKS = 8;
+
+    struct Entry {
+        Query query;
+        Result result;
+    };
+
+    /// Hashes and compares constraints structurally.
+    struct ConstraintHash {
+        size_t operator()(const Constraint *constraint) const {
+            return constraint->equiv_hash();
+        }
+    };
+    struct ConstraintEqual {
+        bool operator()(const Constraint *left, const Constraint *right) const {
+            return left == right || left->equiv(*right);
+        }
+    };
+
+    /// @returns the index of an unsatisfiable entry whose query is a subset of @param query.
+    std::optional<size_t> findUnsatSubset(const Query &query);
+
+    /// @returns the index of a satisfiable entry whose query is a superset of @param query.
+    std::optional<size_t> findSatSuperset(const Query &query) const;
+
+    /// Makes the model of the entry @param idx the first one that findSatisfyingModel tries.
+    void rememberModel(size_t idx);
+
+    /// @returns the index of a recent satisfiable entry whose model satisfies @param query.
+    std::optional<size_t> findSatisfyingModel(const Query &query) const;
+
+    /// @returns true if @param constraint evaluates to true in @param model. Returns false if
+    /// the constraint refers to a variable that the model does not bind, or if it uses an
+    /// operation that is not safe to evaluate outside of the solver.
+    static bool holds(const Constraint *constraint, const SymbolicMapping &model);
+
+    /// One representative for each class of equivalent constraints.
+    std::unordered_set<const Constraint *, ConstraintHash, ConstraintEqual> representatives;
+
+    /// Caches the representative of each constraint that has been normalized.
+    std::unordered_map<const Constraint *, const Constraint *> representativeOf;
+
+    std::vector<Entry> entries;
+
+    /// Maps the hash of a query to the entries with that query.
+    std::unordered_map<size_t, std::vector<size_t>> entriesByHash;
+
+    /// Maps each constraint to the satisfiable and unsatisfiable entries that contain it.
+    std::unordered_map<const Constraint *, std::vector<size_t>> satEntriesOf;
+    std::unordered_map<const Constraint *, std::vector<size_t>> unsatEntriesOf;
+
+    /// The most recent satisfiable entries that have a model, the newest first.
+    std::deque<size_t> recentSatEntries;
+
+    /// Scratch space for findUnsatSubset: the number of constraints of each entry that are part
+    /// of the query.
+    std::vector<uint32_t> matches;
+};
+
+}  // namespace P4::P4Tools
+
+#endif /* BACKENDS_P4TOOLS_COMMON_CORE_QUERY_CACHE_H_ */
@@ -15,6 +15,7 @@
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include "absl/strings/str_format.h"
+#include "backends/p4tools/common/lib/logging.h"
 #include "ir/ir.h"
 #include "ir/irutils.h"
 #include "ir/json_loader.h"  // IWYU pragma: keep
@@ -80,6 +81,7 @@ z3::expr Z3Solver::declareVar(const IR::SymbolicVariable &var) {
 }
 
 void Z3Solver::reset() {
+    forgetModel();
     z3solver.reset();
     declaredVarsById.clear();
     checkpoints.clear();
@@ -91,6 +93,8 @@ void Z3Solver::clearMemory() {
     reset();
     Z3_finalize_memory();
     z3solver = z3::solver(*new z3::context());
+    queryCache.clear();
+    constraintSlicer.clear();
     p4Assertions.clear();
     for (const auto &assert : p4AssertionsBuf) {
         push();
@@ -99,6 +103,7 @@ void Z3Solver::clearMemory() {
 }
 
 void Z3Solver::push() {
+    forgetModel();
     if (isIncremental) {
         z3solver.push();
     }
@@ -110,6 +115,7 @@ void Z3Solver::pop() {
     BUG_CHECK(isIncremental || z3Assertions.size() == p4Assertions.size(),
               "Number of assertions in P4 and Z3 formats aren't equal");
     BUG_CHECK(!checkpoints.empty(), "Check points list is empty");
+    forgetModel();
 
     size_t sz = checkpoints.back();
     checkpoints.pop_back();
@@ -178,16 +184,90 @@ std::optional<bool> Z3Solver::interpretSolverResult(z3::check_result result) {
 
 std::optional<bool> Z3Solver::checkSat() {
     Util::ScopedTimer ctCheckSat("checkSat");
-    return interpretSolverResult(z3solver.check());
+    forgetModel();
+    auto result = interpretSolverResult(z3solver.check());
+    z3HasModel = result == true;
+    return result;
 }
 
 std::optional<bool> Z3Solver::checkSat(const z3::expr_vector &asserts) {
     Util::ScopedTimer ctCheckSat("checkSat");
-    return interpretSolverResult(z3solver.check(asserts));
+    forgetModel();
+    auto result = interpretSolverResult(z3solver.check(asserts));
+    z3HasModel = result == true;
+    return result;
 }
 
 std::optional<bool> Z3Solver::checkSat(const std::vector<const Constraint *> &asserts) {
     Util::ScopedTimer ctZ3("z3");
+    unmodeledQuery.reset();
+    // Without the cache, the partitions would be sent to Z3 one by one, which costs more than
+    // the single query.
+    auto result = checkSatCached(asserts, useQueryCache && useConstraintSlicing);
+    // Few satisfiable queries are followed by getSymbolicMapping, so a model that is not
+    // cached yet is only extracted when it asks for it.
+    if (result == true && lastModel == nullptr) {
+        unmodeledQuery = asserts;
+    }
+    return result;
+}
+
+std::optional<bool> Z3Solver::checkSatCached(const std::vector<const Constraint *> &asserts,
+                                             bool slice) {
+    QueryCache::Query query;
+    if (useQueryCache) {
+        Util::ScopedTimer ctCache("queryCache");
+        query = queryCache.normalize(asserts);
+        if (auto cached = queryCache.lookup(query)) {
+            lastModel = cached->model;
+            return cached->isSat;
+        }
+    }
+    auto result = slice && asserts.size() > 1 ? checkSatSliced(asserts) : checkSatWithZ3(asserts);
+    // Satisfiable queries are cached with the model of their partitions if it is known.
+    // Otherwise extractModel adds the model once getSymbolicMapping asks for it.
+    if (useQueryCache && result.has_value()) {
+        queryCache.insert(query, {result.value(), lastModel});
+    }
+    return result;
+}
+
+std::optional<bool> Z3Solver::checkSatSliced(const std::vector<const Constraint *> &asserts) {
+    std::vector<ConstraintSlicer::Partition> partitions;
+    {
+        Util::ScopedTimer ctSlicing("constraintSlicing");
+        partitions = constraintSlicer.partition(asserts);
+    }
+    if (partitions.size() == 1) {
+        return checkSatWithZ3(asserts);
+    }
+    addPerformanceCounter("solver_queries.sliced");
+    std::vector<SymbolicMapping::value_type> values;
+    bool haveModels = true;
+    // The first partition contains the newest constraint. The other partitions are usually
+    // unchanged since an earlier query and are answered by the cache.
+    for (const auto &partition : partitions) {
+        auto result = checkSatCached(partition.constraints, false);
+        if (result != true) {
+            return result;
+        }
+        if (lastModel == nullptr) {
+            // Z3 answered the partition, or its model was never asked for. extractModel asks
+            // Z3 about the whole query if needed.
+            haveModels = false;
+            continue;
+        }
+        // A cached model may assign the variables of other partitions, too.
+        std::copy_if(lastModel->begin(), lastModel->end(), std::back_inserter(values),
+                     [&partition](const auto &entry) {
+                         return partition.variables.count(entry.first->label) > 0;
+                     });
+    }
+    lastModel = haveModels ? new SymbolicMapping(values.begin(), values.end()) : nullptr;
+    return true;
+}
+
+std::optional<bool> Z3Solver::checkSatWithZ3(const std::vector<const Constraint *> &asserts) {
     if (isIncremental) {
         // Find common prefix with the previous invocation's list of assertions
         auto from = asserts.begin();
@@ -212,6 +292,20 @@ std::optional<bool> Z3Solver::checkSat(const std::vector<const Constraint *> &as
     return isIncremental ? checkSat() : checkSat(z3Assertions);
 }
 
+void Z3Solver::enableQueryCache(bool enable) {
+    useQueryCache = enable;
+    if (!enable) {
+        queryCache.clear();
+    }
+}
+
+void Z3Solver::enableConstraintSlicing(bool enable) {
+    useConstraintSlicing = enable;
+    if (!enable) {
+        constraintSlicer.clear();
+    }
+}
+
 void Z3Solver::asrt(const Constraint *assertion) {
     CHECK_NULL(assertion);
     Z3Translator z3translator(*this);
@@ -223,6 +317,7 @@ void Z3Solver::asrt(const Constraint *assertion) {
 }
 
 void Z3Solver::asrt(const z3::expr &assertion) {
+    forgetModel();
     try {
         Z3_LOG("add assertion '%s'", toString(assertion));
         if (isIncremental) {
@@ -236,6 +331,43 @@ void Z3Solver::asrt(const z3::expr &assertion) {
 }
 
 const SymbolicMapping &Z3Solver::getSymbolicMapping() const {
+    if (lastModel != nullptr) {
+        return *lastModel;
+    }
+    if (unmodeledQuery.has_value()) {
+        // Extracting the model may change the assertions of the Z3 solver, but not the answers
+        // of the solver.
+        return const_cast<Z3Solver *>(this)->extractModel();
+    }
+    return *computeSymbolicMapping(true);
+}
+
+const SymbolicMapping &Z3Solver::extractModel() {
+    auto asserts = std::move(unmodeledQuery.value());
+    unmodeledQuery.reset();
+    if (!z3HasModel || asserts.size() != p4Assertions.size() ||
+        !std::equal(asserts.begin(), asserts.end(), p4Assertions.begin())) {
+        // The query was answered by the cache or in partitions, so Z3 does not hold its model.
+        addPerformanceCounter("solver_queries.model_requeries");
+        auto result = checkSatWithZ3(asserts);
+        BUG_CHECK(result == true, "Z3Solver: no model for a satisfiable query");
+    }
+    const auto *model = computeSymbolicMapping(false);
+    // Models that cannot be expressed with literals are not cached.
+    if (model != nullptr && useQueryCache) {
+        queryCache.setModel(queryCache.normalize(asserts), model);
+    }
+    lastModel = model != nullptr ? model : computeSymbolicMapping(true);
+    return *lastModel;
+}
+
+void Z3Solver::forgetModel() {
+    lastModel = nullptr;
+    unmodeledQuery.reset();
+    z3HasModel = false;
+}
+
+const SymbolicMapping *Z3Solver::computeSymbolicMapping(bool strict) const {
     Util::ScopedTimer ctZ3("z3");
     auto *result = new SymbolicMapping();
     // First, collect a map of all the declared variables we have encountered in the stack.
@@ -266,6 +398,10 @@ const SymbolicMapping &Z3Solver::getSymbolicMapping() const {
             BUG_CHECK(declaredVars.count(exprId) > 0, "Z3Solver: unknown variable declaration: %1%",
                       z3Expr);
             const auto *symbolicVar = declaredVars.at(exprId);
+            if (!strict && !symbolicVar->type->is<IR::Type_Boolean>() &&
+                !symbolicVar->type->is<IR::Type_Bits>()) {
+                return nullptr;
+            }
             const auto *value = toLiteral(z3Value, symbolicVar->type);
             result->emplace(symbolicVar, value);
         }
@@ -276,7 +412,7 @@ const SymbolicMapping &Z3Solver::getSymbolicMapping() const {
     } catch (...) {
         BUG("Z3Solver : unknown segmentation fault in getModel");
     }
-    return *result;
+    return result;
 }
 
 const IR::Literal *Z3Solver::toLiteral(const z3::expr &e, const IR::Type *type) {
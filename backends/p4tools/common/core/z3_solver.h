@@ -16,6 +16,8 @@
 #include <string>
 #include <vector>
 
+#include "backends/p4tools/common/core/constraint_slicer.h"
+#include "backends/p4tools/common/core/query_cache.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/solver.h"
@@ -49,6 +51,10 @@ class Z3Solver : public AbstractSolver {
 
     void timeout(unsigned tm) override;
 
+    /// Answers the query from the query cache if possible. Otherwise splits the query into
+    /// independent partitions, see ConstraintSlicer, answers each of them from the cache or with
+    /// Z3, and caches the answers. If the query is answered from the cache, the assertions of
+    /// the Z3 solver are left as they were.
     std::optional<bool> checkSat(const std::vector<const Constraint *> &asserts) override;
 
     /// Z3Solver specific checkSat function. Calls check on the input z3::expr_vector.
@@ -71,6 +77,14 @@ class Z3Solver : public AbstractSolver {
     /// Get the actual Z3 context that this class uses.
     [[nodiscard]] const z3::context &getZ3Ctx() const;
 
+    /// Enables or disables the query cache. It is enabled by default.
+    void enableQueryCache(bool enable);
+
+    /// Enables or disables the splitting of queries into independent partitions. It is enabled
+    /// by default. Queries are only split while the query cache is enabled, which answers the
+    /// partitions that did not change since an earlier query.
+    void enableConstraintSlicing(bool enable);
+
     /// @returns the list of active assertions on this solver.
     [[nodiscard]] safe_vector<const Constraint *> getAssertions() const;
 
@@ -85,7 +99,8 @@ class Z3Solver : public AbstractSolver {
     void pop();
 
     /// Reset the internal Z3 solver state (memory and active assertions).
-    /// In incremental state, all active assertions are reapplied after resetting.
+    /// In incremental state, all active assertions are reapplied after resetting. Also empties the
+    /// query cache and the cache of the constraint slicer.
     void clearMemory();
 
     /// Adds a Z3 assertion to the solver context.
@@ -120,6 +135,30 @@ class Z3Solver : public AbstractSolver {
     /// Helps to restore a state of incremental solver in a constructor.
     void addZ3Pushes(size_t &chkIndex, size_t asrtIndex);
 
+    /// Answers @param asserts from the query cache or with checkSatSliced or checkSatWithZ3,
+    /// depending on @param slice, and caches the answer.
+    std::optional<bool> checkSatCached(const std::vector<const Constraint *> &asserts, bool slice);
+
+    /// Answers each independent partition of @param asserts with checkSatCached and merges the
+    /// models of the partitions.
+    std::optional<bool> checkSatSliced(const std::vector<const Constraint *> &asserts);
+
+    /// Asserts @param asserts, reusing the assertions that the previous query has in common with
+    /// them in incremental mode, and asks Z3.
+    std::optional<bool> checkSatWithZ3(const std::vector<const Constraint *> &asserts);
+
+    /// Extracts the model of @ref unmodeledQuery, asking Z3 about the query again if the model
+    /// of the last Z3 query is not a model of it, and caches the model.
+    const SymbolicMapping &extractModel();
+
+    /// Forgets the model of the last query, when the state of the solver changes.
+    void forgetModel();
+
+    /// Extracts the model of the last satisfiable Z3 query. If @param strict is false, returns
+    /// nullptr instead of failing if the model assigns a variable that has no literal value,
+    /// such as a string.
+    [[nodiscard]] const SymbolicMapping *computeSymbolicMapping(bool strict) const;
+
     /// Helper function which converts a z3::check_result to a std::optional<bool>.
     static std::optional<bool> interpretSolverResult(z3::check_result result);
 
@@ -150,6 +189,30 @@ class Z3Solver : public AbstractSolver {
     /// Stores the timeout, as last set by @ref timeout.
     std::optional<unsigned> timeout_;
 
+    /// Caches the answers to the queries made with checkSat.
+    QueryCache queryCache;
+
+    /// Whether checkSat uses @ref queryCache.
+    bool useQueryCache = true;
+
+    /// Splits the queries made with checkSat into independent partitions.
+    ConstraintSlicer constraintSlicer;
+
+    /// Whether checkSat uses @ref constraintSlicer.
+    bool useConstraintSlicing = true;
+
+    /// The model of the last query made with checkSat, if it was satisfiable and its model is
+    /// known. Reset by every operation that changes the state of the solver.
+    const SymbolicMapping *lastModel = nullptr;
+
+    /// The last query made with checkSat, if it was satisfiable but its model has not been
+    /// extracted yet (see extractModel).
+    std::optional<std::vector<const Constraint *>> unmodeledQuery;
+
+    /// Whether the last Z3 query was satisfiable and the assertions have not changed since, so
+    /// that Z3 holds a model of @ref p4Assertions.
+    bool z3HasModel = false;
+
     DECLARE_TYPEINFO(Z3Solver, AbstractSolver);
 };
 
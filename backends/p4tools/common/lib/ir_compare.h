@@ -8,6 +8,8 @@
 #define BACKENDS_P4TOOLS_COMMON_LIB_IR_COMPARE_H_
 
 #include "ir/ir.h"
+#include "lib/big_int_util.h"
+#include "lib/hash.h"
 
 namespace P4::IR {
 
@@ -31,6 +33,30 @@ struct StateVariableLess {
     }
 };
 
+/// Hash for StateVariables, consistent with StateVariableEqual. Like the comparison, it only
+/// considers the label: member and path names and the indices of array accesses.
+struct StateVariableHash {
+    size_t operator()(const IR::StateVariable *s) const { return hash(s->ref); }
+    size_t operator()(const IR::StateVariable &s) const { return hash(s.ref); }
+
+ private:
+    static size_t hash(const IR::Expression *expr) {
+        if (const auto *member = expr->to<IR::Member>()) {
+            return Util::Hash()(hash(member->expr), member->member.name);
+        }
+        if (const auto *path = expr->to<IR::PathExpression>()) {
+            return Util::Hash()(path->path->name.name);
+        }
+        if (const auto *arrayIndex = expr->to<IR::ArrayIndex>()) {
+            if (const auto *index = arrayIndex->right->to<IR::Constant>()) {
+                return Util::Hash()(hash(arrayIndex->left), index->value);
+            }
+            return hash(arrayIndex->left);
+        }
+        return 0;
+    }
+};
+
 }  // namespace P4::IR
 
 #endif /* BACKENDS_P4TOOLS_COMMON_LIB_IR_COMPARE_H_ */
@@ -5,6 +5,8 @@
 #include "backends/p4tools/common/lib/logging.h"
 
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include "lib/error.h"
@@ -17,6 +19,23 @@ void enableInformationLogging() { Log::addDebugSpec("tools_info:4"); }
 
 void enablePerformanceLogging() { Log::addDebugSpec("tools_performance:4"); }
 
+namespace {
+
+/// Guards the performance counters.
+std::mutex countersLock;
+
+std::map<std::string, uint64_t> &counters() {
+    static auto *counters = new std::map<std::string, uint64_t>;
+    return *counters;
+}
+
+}  // namespace
+
+void addPerformanceCounter(const std::string &name, uint64_t value) {
+    std::lock_guard<std::mutex> guard(countersLock);
+    counters()[name] += value;
+}
+
 void printPerformanceReport(const std::optional<std::filesystem::path> &basePath) {
     // Do not emit a report if performance logging is not enabled.
     if (!Log::fileLogLevelIsAtLeast("tools_performance", 4)) {
@@ -48,6 +67,24 @@ void printPerformanceReport(const std::optional<std::filesystem::path> &basePath
         }
         timerList.emplace_back(timerData);
     }
+    {
+        std::lock_guard<std::mutex> guard(countersLock);
+        if (!counters().empty()) {
+            printFeature("tools_performance", 4, "============ Counters ============");
+        }
+        for (const auto &[name, value] : counters()) {
+            auto parentIt = counters().end();
+            if (auto pos = name.rfind('.'); pos != std::string::npos) {
+                parentIt = counters().find(name.substr(0, pos));
+            }
+            if (parentIt == counters().end() || parentIt->second == 0) {
+                printFeature("tools_performance", 4, "%s: %i", name, value);
+                continue;
+            }
+            printFeature("tools_performance", 4, "%s: %i (%0.2f %% of parent)", name, value,
+                         static_cast<double>(value) * 100 / static_cast<double>(parentIt->second));
+        }
+    }
     // Write the report to the file, if one was provided.
     if (basePath.has_value()) {
         auto perfFilePath = basePath.value();
@@ -7,6 +7,7 @@
 #ifndef BACKENDS_P4TOOLS_COMMON_LIB_LOGGING_H_
 #define BACKENDS_P4TOOLS_COMMON_LIB_LOGGING_H_
 
+#include <cstdint>
 #include <filesystem>
 #include <optional>
 #include <string>
@@ -63,6 +64,11 @@ void enableInformationLogging();
 /// Enable printing of timing reports.
 void enablePerformanceLogging();
 
+/// Adds @param value to the performance counter @param name. Counters are listed in the
+/// performance report. A counter named "a.b" is reported as a fraction of the counter "a", if
+/// that exists. This function is thread-safe.
+void addPerformanceCounter(const std::string &name, uint64_t value = 1);
+
 /// Print a performance report if performance logging is enabled.
 /// If a file is provided, it will be written to the file.
 void printPerformanceReport(const std::optional<std::filesystem::path> &basePath = std::nullopt);
@@ -10,14 +10,18 @@
 #include <map>
 #include <utility>
 
+#include "backends/p4tools/common/lib/ir_compare.h"
+#include "backends/p4tools/common/lib/persistent_map.h"
 #include "ir/ir.h"
 #include "ir/solver.h"
 #include "ir/visitor.h"
 
 namespace P4::P4Tools {
 
-/// Symbolic maps map a state variable to a IR::Expression.
-using SymbolicMapType = P4::flat_map<IR::StateVariable, const IR::Expression *>;
+/// Symbolic maps map a state variable to a IR::Expression. They are persistent, so that execution
+/// states can be copied without copying their symbolic environment.
+using SymbolicMapType = PersistentMap<IR::StateVariable, const IR::Expression *,
+                                      IR::StateVariableHash, IR::StateVariableEqual>;
 
 /// Represents a solution found by the solver. A model is a concretized form of a symbolic
 /// environment. All the expressions in a Model must be of type IR::Literal.
@@ -0,0 +1,528 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_COMMON_LIB_PERSISTENT_MAP_H_
+#define BACKENDS_P4TOOLS_COMMON_LIB_PERSISTENT_MAP_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "lib/hash.h"
+
+namespace P4::P4Tools {
+
+/// An immutable hash map with copy-on-write updates, implemented as a hash array mapped trie.
+/// Copying a map is O(1): the copy shares all nodes with the original. An update copies only
+/// the O(log32 n) nodes on the path to the updated entry, so maps that were copied from each
+/// other take memory proportional to the entries in which they differ.
+///
+/// Nodes are never modified once they are reachable from a map, and they are never freed
+/// explicitly; like IR nodes, they are reclaimed by the garbage collector.
+///
+/// Iteration order depends on the hashes of the keys, not on the order of insertion.
+template <class Key, class Value, class HashFn = Util::Hash, class Equal = std::equal_to<Key>>
+class PersistentMap {
+ public:
+    using Entry = std::pair<Key, Value>;
+    using value_type = Entry;
+
+ private:
+    /// Every level of the trie consumes this many bits of the hash.
+    static constexpr unsigned BITS = 5;
+    static constexpr unsigned MASK = (1U << BITS) - 1;
+    /// Keys whose hashes are equal in all bits end up in a collision node at this depth.
+    static constexpr unsigned MAX_SHIFT = 64;
+
+    struct Leaf {
+        uint64_t hash;
+        Entry entry;
+    };
+
+    /// A trie node. The bits of @a leafMap and @a childMap mark which of the 32 slots of this
+    /// node hold an entry and which hold a subtree; @a leaves and @a children hold them in slot
+    /// order. Collision nodes only have leaves, which are searched linearly.
+    struct Node {
+        uint32_t leafMap = 0;
+        uint32_t childMap = 0;
+        std::vector<Leaf> leaves;
+        std::vector<const Node *> children;
+
+        [[nodiscard]] bool isSingleLeaf() const { return children.empty() && leaves.size() == 1; }
+    };
+
+    const Node *root = nullptr;
+    size_t count = 0;
+
+    static unsigned slot(uint64_t hash, unsigned shift) { return (hash >> shift) & MASK; }
+
+    static unsigned index(uint32_t bitmap, uint32_t bit) {
+        return std::popcount(bitmap & (bit - 1));
+    }
+
+    static uint64_t hashOf(const Key &key) { return HashFn()(key); }
+
+    /// @returns a node that holds the leaves @p a and @p b, which have different keys.
+    static const Node *merge(Leaf a, Leaf b, unsigned shift) {
+        auto *node = new Node;
+        if (shift >= MAX_SHIFT) {
+            node->leaves = {std::move(a), std::move(b)};
+            return node;
+        }
+        auto slotA = slot(a.hash, shift);
+        auto slotB = slot(b.hash, shift);
+        if (slotA == slotB) {
+            node->childMap = 1U << slotA;
+            node->children.push_back(merge(std::move(a), std::move(b), shift + BITS));
+            return node;
+        }
+        node->leafMap = (1U << slotA) | (1U << slotB);
+        if (slotA < slotB) {
+            node->leaves = {std::move(a), std::move(b)};
+        } else {
+            node->leaves = {std::move(b), std::move(a)};
+        }
+        return node;
+    }
+
+    static const Value *find(const Node *node, uint64_t hash, const Key &key) {
+        for (unsigned shift = 0; node != nullptr; shift += BITS) {
+            if (shift >= MAX_SHIFT) {
+                for (const auto &leaf : node->leaves) {
+                    if (Equal()(leaf.entry.first, key)) {
+                        return &leaf.entry.second;
+                    }
+                }
+                return nullptr;
+            }
+            uint32_t bit = 1U << slot(hash, shift);
+            if ((node->leafMap & bit) != 0) {
+                const auto &leaf = node->leaves[index(node->leafMap, bit)];
+                if (leaf.hash == hash && Equal()(leaf.entry.first, key)) {
+                    return &leaf.entry.second;
+                }
+                return nullptr;
+            }
+            if ((node->childMap & bit) == 0) {
+                return nullptr;
+            }
+            node = node->children[index(node->childMap, bit)];
+        }
+        return nullptr;
+    }
+
+    /// @returns a copy of @p node in which @p leaf is set. @p added is set if the key is new.
+    static const Node *set(const Node *node, Leaf leaf, unsigned shift, bool &added) {
+        if (node == nullptr) {
+            added = true;
+            auto *result = new Node;
+            result->leafMap = 1U << slot(leaf.hash, shift);
+            result->leaves.push_back(std::move(leaf));
+            return result;
+        }
+        auto *result = new Node(*node);
+        if (shift >= MAX_SHIFT) {
+            for (auto &existing : result->leaves) {
+                if (Equal()(existing.entry.first, leaf.entry.first)) {
+                    existing.entry.second = std::move(leaf.entry.second);
+                    return result;
+                }
+            }
+            added = true;
+            result->leaves.push_back(std::move(leaf));
+            return result;
+        }
+        uint32_t bit = 1U << slot(leaf.hash, shift);
+        if ((node->leafMap & bit) != 0) {
+            auto leafIdx = index(node->leafMap, bit);
+            auto &existing = result->leaves[leafIdx];
+            if (existing.hash == leaf.hash && Equal()(existing.entry.first, leaf.entry.first)) {
+                existing.entry.second = std::move(leaf.entry.second);
+                return result;
+            }
+            // Push both entries down into a new subtree.
+            added = true;
+            const auto *child = merge(std::move(existing), std::move(leaf), shift + BITS);
+            result->leaves.erase(result->leaves.begin() + leafIdx);
+            result->leafMap &= ~bit;
+            result->childMap |= bit;
+            result->children.insert(result->children.begin() + index(result->childMap, bit),
+                                    child);
+            return result;
+        }
+        if ((node->childMap & bit) != 0) {
+            auto &child = result->children[index(node->childMap, bit)];
+            child = set(child, std::move(leaf), shift + BITS, added);
+            return result;
+        }
+        added = true;
+        result->leafMap |= bit;
+        result->leaves.insert(result->leaves.begin() + index(result->leafMap, bit),
+                              std::move(leaf));
+        return result;
+    }
+
+    /// @returns a copy of @p node without @p key, or nullptr if that leaves it empty. Returns
+    /// @p node itself if it does not contain @p key.
+    static const Node *erase(const Node *node, uint64_t hash, const Key &key, unsigned shift) {
+        if (shift >= MAX_SHIFT) {
+            for (size_t idx = 0; idx < node->leaves.size(); ++idx) {
+                if (Equal()(node->leaves[idx].entry.first, key)) {
+                    if (node->leaves.size() == 1) {
+                        return nullptr;
+                    }
+                    auto *result = new Node(*node);
+                    result->leaves.erase(result->leaves.begin() + idx);
+                    return result;
+                }
+            }
+            return node;
+        }
+        uint32_t bit = 1U << slot(hash, shift);
+        if ((node->leafMap & bit) != 0) {
+            auto leafIdx = index(node->leafMap, bit);
+            const auto &leaf = node->leaves[leafIdx];
+            if (leaf.hash != hash || !Equal()(leaf.entry.first, key)) {
+                return node;
+            }
+            if (node->isSingleLeaf()) {
+                return nullptr;
+            }
+            auto *result = new Node(*node);
+            result->leaves.erase(result->leaves.begin() + leafIdx);
+            result->leafMap &= ~bit;
+            return result;
+        }
+        if ((node->childMap & bit) == 0) {
+            return node;
+        }
+        auto childIdx = index(node->childMap, bit);
+        const auto *child = node->children[childIdx];
+        const auto *newChild = erase(child, hash, key, shift + BITS);
+        if (newChild == child) {
+            return node;
+        }
+        auto *result = new Node(*node);
+        if (newChild == nullptr) {
+            result->children.erase(result->children.begin() + childIdx);
+            result->childMap &= ~bit;
+            if (result->children.empty() && result->leaves.empty()) {
+                return nullptr;
+            }
+        } else if (newChild->isSingleLeaf()) {
+            // Pull a lone entry up into this node, so that the trie does not keep chains of
+            // nodes with a single entry.
+            result->children.erase(result->children.begin() + childIdx);
+            result->childMap &= ~bit;
+            result->leafMap |= bit;
+            result->leaves.insert(result->leaves.begin() + index(result->leafMap, bit),
+                                  newChild->leaves.front());
+        } else {
+            result->children[childIdx] = newChild;
+        }
+        return result;
+    }
+
+ public:
+    /// Iterates over the entries of a map in trie order.
+    class const_iterator {
+        friend class PersistentMap;
+
+        /// The path from the root to the current entry. Each element is a node and the position
+        /// of the next item to visit in it: first the leaves, then the children.
+        std::vector<std::pair<const Node *, size_t>> path;
+        const Entry *current = nullptr;
+
+        explicit const_iterator(const Node *root) {
+            if (root != nullptr) {
+                path.emplace_back(root, 0);
+                advance();
+            }
+        }
+
+        void advance() {
+            current = nullptr;
+            while (!path.empty()) {
+                auto &[node, pos] = path.back();
+                if (pos < node->leaves.size()) {
+                    current = &node->leaves[pos++].entry;
+                    return;
+                }
+                auto childPos = pos - node->leaves.size();
+                if (childPos < node->children.size()) {
+                    ++pos;
+                    path.emplace_back(node->children[childPos], 0);
+                    continue;
+                }
+                path.pop_back();
+            }
+        }
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry *;
+        using reference = const Entry &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *current; }
+        pointer operator->() const { return current; }
+
+        const_iterator &operator++() {
+            advance();
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            advance();
+            return result;
+        }
+
+        bool operator==(const const_iterator &other) const { return current == other.current; }
+        bool operator!=(const const_iterator &other) const { return current != other.current; }
+    };
+
+    using iterator = const_iterator;
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    [[nodiscard]] size_t size() const { return count; }
+
+    [[nodiscard]] const_iterator begin() const { return const_iterator(root); }
+
+    [[nodiscard]] const_iterator end() const { return const_iterator(); }
+
+    /// @returns the value of @p key, or nullptr if the map does not contain @p key.
+    [[nodiscard]] const Value *find(const Key &key) const {
+        return find(root, hashOf(key), key);
+    }
+
+    [[nodiscard]] size_t count_of(const Key &key) const { return find(key) != nullptr ? 1 : 0; }
+
+    [[nodiscard]] bool contains(const Key &key) const { return find(key) != nullptr; }
+
+    /// Sets the value of @p key. @returns true if @p key was not in the map yet.
+    bool set(const Key &key, Value value) {
+        bool added = false;
+        root = set(root, Leaf{hashOf(key), {key, std::move(value)}}, 0, added);
+        count += added ? 1 : 0;
+        return added;
+    }
+
+    /// Removes @p key from the map. @returns true if the map contained @p key.
+    bool erase(const Key &key) {
+        if (root == nullptr) {
+            return false;
+        }
+        const auto *newRoot = erase(root, hashOf(key), key, 0);
+        if (newRoot == root) {
+            return false;
+        }
+        root = newRoot;
+        --count;
+        return true;
+    }
+
+    void clear() {
+        root = nullptr;
+        count = 0;
+    }
+
+    /// @returns true if both maps hold equal keys with equal values.
+    bool operator==(const PersistentMap &other) const {
+        if (root == other.root) {
+            return true;
+        }
+        if (count != other.count) {
+            return false;
+        }
+        for (const auto &[key, value] : *this) {
+            const auto *otherValue = other.find(key);
+            if (otherValue == nullptr || !(*otherValue == value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/// An immutable hash set with copy-on-write updates. See PersistentMap.
+template <class Key, class HashFn = Util::Hash, class Equal = std::equal_to<Key>>
+class PersistentSet {
+    struct Unit {
+        bool operator==(const Unit &) const { return true; }
+    };
+    using Map = PersistentMap<Key, Unit, HashFn, Equal>;
+    Map map;
+
+ public:
+    /// Iterates over the elements of a set in trie order.
+    class const_iterator {
+        friend class PersistentSet;
+        typename Map::const_iterator it;
+
+        explicit const_iterator(typename Map::const_iterator it) : it(std::move(it)) {}
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Key;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Key *;
+        using reference = const Key &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return it->first; }
+        pointer operator->() const { return &it->first; }
+
+        const_iterator &operator++() {
+            ++it;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            ++it;
+            return result;
+        }
+
+        bool operator==(const const_iterator &other) const { return it == other.it; }
+        bool operator!=(const const_iterator &other) const { return it != other.it; }
+    };
+
+    using iterator = const_iterator;
+
+    [[nodiscard]] bool empty() const { return map.empty(); }
+
+    [[nodiscard]] size_t size() const { return map.size(); }
+
+    [[nodiscard]] const_iterator begin() const { return const_iterator(map.begin()); }
+
+    [[nodiscard]] const_iterator end() const { return const_iterator(map.end()); }
+
+    [[nodiscard]] bool contains(const Key &key) const { return map.contains(key); }
+
+    [[nodiscard]] size_t count(const Key &key) const { return map.count_of(key); }
+
+    /// Adds @p key to the set. @returns true if it was not in the set yet.
+    bool insert(const Key &key) { return map.set(key, Unit()); }
+
+    /// Removes @p key from the set. @returns true if the set contained @p key.
+    bool erase(const Key &key) { return map.erase(key); }
+
+    void clear() { map.clear(); }
+
+    bool operator==(const PersistentSet &other) const { return map == other.map; }
+};
+
+/// An immutable stack with copy-on-write updates. Copying a stack is O(1) and copies share
+/// their common bottom part. Iteration starts at the top.
+template <class T>
+class PersistentStack {
+    struct Node {
+        T value;
+        const Node *next;
+        size_t size;
+    };
+
+    const Node *head = nullptr;
+
+ public:
+    /// Iterates over the elements of a stack, from the top to the bottom.
+    class const_iterator {
+        friend class PersistentStack;
+        const Node *node = nullptr;
+
+        explicit const_iterator(const Node *node) : node(node) {}
+
+     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return node->value; }
+        pointer operator->() const { return &node->value; }
+
+        const_iterator &operator++() {
+            node = node->next;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            node = node->next;
+            return result;
+        }
+
+        bool operator==(const const_iterator &other) const { return node == other.node; }
+        bool operator!=(const const_iterator &other) const { return node != other.node; }
+    };
+
+    using iterator = const_iterator;
+
+    PersistentStack() = default;
+
+    /// Creates a stack with @p values, the first of which is on top.
+    PersistentStack(std::initializer_list<T> values) {
+        std::vector<T> reversed(values);
+        for (auto it = reversed.rbegin(); it != reversed.rend(); ++it) {
+            push(*it);
+        }
+    }
+
+    [[nodiscard]] bool empty() const { return head == nullptr; }
+
+    [[nodiscard]] size_t size() const { return head != nullptr ? head->size : 0; }
+
+    [[nodiscard]] const T &top() const { return head->value; }
+
+    void push(T value) { head = new Node{std::move(value), head, size() + 1}; }
+
+    void pop() { head = head->next; }
+
+    void clear() { head = nullptr; }
+
+    [[nodiscard]] const_iterator begin() const { return const_iterator(head); }
+
+    [[nodiscard]] const_iterator end() const { return const_iterator(); }
+
+    /// @returns the elements of this stack from the bottom to the top, i.e., in the order in
+    /// which they were pushed.
+    [[nodiscard]] std::vector<T> toVector() const {
+        std::vector<T> result(begin(), end());
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+    bool operator==(const PersistentStack &other) const {
+        if (size() != other.size()) {
+            return false;
+        }
+        for (auto a = head, b = other.head; a != b; a = a->next, b = b->next) {
+            if (!(a->value == b->value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+}  // namespace P4::P4Tools
+
+#endif /* BACKENDS_P4TOOLS_COMMON_LIB_PERSISTENT_MAP_H_ */
@@ -31,7 +31,7 @@ namespace P4::P4Tools {
 
 std::optional<uint32_t> Utils::currentSeed = std::nullopt;
 
-boost::random::mt19937 Utils::rng(0);
+thread_local boost::random::mt19937 Utils::rng(0);
 
 std::string Utils::getTimeStamp() {
     // get current time
@@ -58,6 +58,12 @@ void Utils::setRandomSeed(int seed) {
     rng.seed(seed);
 }
 
+void Utils::setThreadRandomSeed(uint32_t offset) {
+    if (currentSeed.has_value()) {
+        rng.seed(currentSeed.value() + offset);
+    }
+}
+
 std::optional<uint32_t> Utils::getCurrentSeed() { return currentSeed; }
 
 uint64_t Utils::getRandInt(uint64_t max) {
@@ -27,8 +27,9 @@ class Utils {
      *  Seeds, timestamps, randomness.
      * ========================================================================================= */
  private:
-    /// The random generator of this project. It is initialized with the input seed.
-    static boost::random::mt19937 rng;
+    /// The random generator of this project. It is initialized with the input seed. Every thread
+    /// has its own generator; threads other than the main thread start out seeded with 0.
+    static thread_local boost::random::mt19937 rng;
 
     /// Stores the state of the PRNG.
     static std::optional<uint32_t> currentSeed;
@@ -43,6 +44,11 @@ class Utils {
     /// Uses boost's mersenne twister.
     static void setRandomSeed(int seed);
 
+    /// Reseed the random generator of the calling thread with @var currentSeed plus @param
+    /// offset, so that threads exploring in parallel draw different sequences from the same
+    /// seed. Does nothing if no seed is set.
+    static void setThreadRandomSeed(uint32_t offset);
+
     /// @returns currentSeed.
     static std::optional<uint32_t> getCurrentSeed();
 
@@ -104,6 +104,8 @@ void GreedyNodeSelection::runImpl(const Callback &callBack,
                 auto nextState = pickSuccessor(successors);
                 if (nextState.has_value()) {
                     executionState = nextState.value();
+                    shareBranches(unexploredBranches);
+                    shareBranches(potentialBranches);
                     continue;
                 }
             }
@@ -120,7 +122,13 @@ void GreedyNodeSelection::runImpl(const Callback &callBack,
         // more branches to explore, finish execution. Not all branches are viable, so we loop
         // until either we run out of unexplored branches or we find a viable branch.
         if (potentialBranches.empty() && unexploredBranches.empty()) {
-            return;
+            // When exploring in parallel, continue with a branch of another worker.
+            auto stolenState = stealBranch();
+            if (!stolenState.has_value()) {
+                return;
+            }
+            executionState = stolenState.value();
+            continue;
         }
         // Select a new branch by iterating over all branches
         Util::ScopedTimer chooseBranchtimer("branch_selection");
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/parallel_search.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "backends/p4tools/common/lib/util.h"
+#include "ir/solver.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+#include "lib/log.h"
+#include "lib/thread_pool.h"
+
+#include "backends/p4tools/modules/testgen/core/program_info.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
+#include "backends/p4tools/modules/testgen/lib/execution_state.h"
+
+namespace P4::P4Tools::P4Testgen {
+
+void ExplorationFrontier::push(ExecutionStateReference state) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pending.push_back(state);
+    }
+    haveWork.notify_one();
+}
+
+std::optional<ExecutionStateReference> ExplorationFrontier::steal(bool busy) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (busy) {
+        --busyWorkers;
+    }
+    ++waiting;
+    haveWork.wait(guard, [this] { return stopped() || !pending.empty() || busyWorkers == 0; });
+    --waiting;
+    if (stopped() || pending.empty()) {
+        // Nobody is left to donate branches, so wake up all other waiting workers, too.
+        haveWork.notify_all();
+        return std::nullopt;
+    }
+    auto state = pending.front();
+    pending.pop_front();
+    ++busyWorkers;
+    return state;
+}
+
+void ExplorationFrontier::donate(std::vector<SymbolicExecutor::Branch> &branches) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t hungryWorkers = waiting.load();
+        if (hungryWorkers <= pending.size()) {
+            return;
+        }
+        auto count = std::min(hungryWorkers - pending.size(), branches.size());
+        for (size_t idx = 0; idx < count; ++idx) {
+            pending.push_back(branches[idx].nextState);
+        }
+        branches.erase(branches.begin(), branches.begin() + count);
+    }
+    haveWork.notify_all();
+}
+
+void ExplorationFrontier::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        isStopped = true;
+    }
+    haveWork.notify_all();
+}
+
+bool ExplorationFrontier::runCallback(const SymbolicExecutor::Callback &callback,
+                                      const FinalState &finalState) {
+    std::lock_guard<std::mutex> guard(callbackLock);
+    if (stopped()) {
+        return true;
+    }
+    if (callback(finalState)) {
+        stop();
+        return true;
+    }
+    return false;
+}
+
+bool ExplorationFrontier::updateVisitedNodes(const P4::Coverage::CoverageSet &newNodes) {
+    std::lock_guard<std::mutex> guard(coverageLock);
+    auto hasUpdated = false;
+    for (const auto *newNode : newNodes) {
+        hasUpdated |= visitedNodes.insert(newNode).second;
+    }
+    if (hasUpdated) {
+        ++visitedNodesVersion;
+    }
+    return hasUpdated;
+}
+
+void ExplorationFrontier::syncVisitedNodes(P4::Coverage::CoverageSet &nodes, uint64_t &version) {
+    if (visitedNodesVersion.load() == version) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(coverageLock);
+    nodes = visitedNodes;
+    version = visitedNodesVersion.load();
+}
+
+ParallelSearch::ParallelSearch(AbstractSolver &solver, const ProgramInfo &programInfo,
+                               unsigned workers, SolverFactory makeSolver,
+                               ExecutorFactory makeExecutor)
+    : SymbolicExecutor(solver, programInfo),
+      workers(workers),
+      makeSolver(std::move(makeSolver)),
+      makeExecutor(std::move(makeExecutor)) {
+    // The test back end reports coverage to this executor, so it uses the shared set, too.
+    frontier = &sharedFrontier;
+}
+
+void ParallelSearch::runImpl(const Callback &callBack, ExecutionStateReference executionState) {
+    // Give the pool back its previous size when the search ends, also when a worker throws.
+    struct RestoreConcurrency {
+        unsigned threads = Util::ThreadPool::concurrency();
+        ~RestoreConcurrency() { Util::ThreadPool::setConcurrency(threads); }
+    } restoreConcurrency;
+    Util::ThreadPool::setConcurrency(workers);
+    auto threads = std::min(workers, Util::ThreadPool::concurrency());
+    if (threads < workers) {
+        warning("P4Testgen was built without multithreading support. Exploring with %1% worker.",
+                threads);
+    }
+
+    struct Worker {
+        std::unique_ptr<AbstractSolver> solver;
+        std::unique_ptr<SymbolicExecutor> executor;
+        ErrorReporter::Deferred diagnostics;
+    };
+    std::vector<Worker> pool(threads);
+    for (auto &worker : pool) {
+        worker.solver = makeSolver();
+        worker.executor.reset(makeExecutor(*worker.solver));
+        worker.executor->frontier = &sharedFrontier;
+    }
+    sharedFrontier.push(executionState);
+
+    bool logging = Log::Detail::enableLoggingInContext;
+    auto &errorReporter = BaseCompileContext::get().errorReporter();
+    try {
+        Util::ThreadPool::parallelFor(threads, [&](size_t idx) {
+            auto &worker = pool[idx];
+            Log::Detail::enableLoggingInContext = logging;
+            // The error reporter is not thread-safe. Diagnostics are output once all workers are
+            // done.
+            ErrorReporter::DeferScope defer(worker.diagnostics);
+            Utils::setThreadRandomSeed(idx);
+            try {
+                auto state = sharedFrontier.steal(false);
+                if (state.has_value()) {
+                    worker.executor->runImpl(callBack, state.value());
+                }
+            } catch (...) {
+                sharedFrontier.stop();
+                throw;
+            }
+        });
+    } catch (...) {
+        for (auto &worker : pool) {
+            errorReporter.replay(worker.diagnostics);
+        }
+        throw;
+    }
+    for (auto &worker : pool) {
+        errorReporter.replay(worker.diagnostics);
+    }
+}
+
+}  // namespace P4::P4Tools::P4Testgen
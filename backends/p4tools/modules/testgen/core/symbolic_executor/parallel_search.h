@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_PARALLEL_SEARCH_H_
+#define BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_PARALLEL_SEARCH_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "ir/solver.h"
+#include "midend/coverage.h"
+
+#include "backends/p4tools/modules/testgen/core/program_info.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
+#include "backends/p4tools/modules/testgen/lib/execution_state.h"
+
+namespace P4::P4Tools::P4Testgen {
+
+/// The state shared by the workers of a ParallelSearch: the branches that idle workers can pick
+/// up, the set of visited nodes, and the lock that serializes the test callback.
+///
+/// Every worker explores its own branches with its own path selection strategy. A worker that
+/// runs out of branches blocks in steal(); busy workers check hungry() whenever they branch and
+/// hand their oldest unexplored branches, which are usually the closest to the root of the
+/// program, to the waiting workers with donate(). Exploration ends when all workers are idle
+/// or when the callback asks to stop.
+class ExplorationFrontier {
+ public:
+    ExplorationFrontier() = default;
+
+    /// Adds @param state to the branches waiting to be explored.
+    void push(ExecutionStateReference state);
+
+    /// Blocks until there is a branch to explore and returns it. @param busy is true if the
+    /// calling worker was exploring until now. Returns std::nullopt if exploration has ended.
+    std::optional<ExecutionStateReference> steal(bool busy);
+
+    /// @returns true if a worker is waiting for a branch.
+    [[nodiscard]] bool hungry() const { return waiting.load(std::memory_order_relaxed) > 0; }
+
+    /// Moves the oldest of @param branches to the waiting workers, one for each of them.
+    void donate(std::vector<SymbolicExecutor::Branch> &branches);
+
+    /// Ends exploration. Waiting workers return from steal() and the callback is no longer run.
+    void stop();
+
+    /// @returns true if exploration has ended.
+    [[nodiscard]] bool stopped() const { return isStopped.load(std::memory_order_relaxed); }
+
+    /// Runs @param callback on @param finalState, one worker at a time. Stops exploration if
+    /// the callback returns true.
+    bool runCallback(const SymbolicExecutor::Callback &callback, const FinalState &finalState);
+
+    /// Adds @param newNodes to the set of visited nodes. Returns true if there was an update.
+    bool updateVisitedNodes(const P4::Coverage::CoverageSet &newNodes);
+
+    /// Copies the set of visited nodes into @param nodes if it has changed since @param version.
+    void syncVisitedNodes(P4::Coverage::CoverageSet &nodes, uint64_t &version);
+
+ private:
+    /// Guards the branches and the worker counts.
+    std::mutex lock;
+
+    /// Signalled when a branch is pushed or exploration ends.
+    std::condition_variable haveWork;
+
+    /// Branches waiting for a worker.
+    std::deque<ExecutionStateReference> pending;
+
+    /// The number of workers currently exploring a branch.
+    unsigned busyWorkers = 0;
+
+    /// The number of workers blocked in steal().
+    std::atomic<unsigned> waiting = 0;
+
+    std::atomic<bool> isStopped = false;
+
+    /// Serializes the callback, which is usually not thread-safe.
+    std::mutex callbackLock;
+
+    /// Guards visitedNodes.
+    std::mutex coverageLock;
+
+    /// Set of all nodes executed in any testcase that has been outputted by any worker.
+    P4::Coverage::CoverageSet visitedNodes;
+
+    /// Incremented on every change of visitedNodes.
+    std::atomic<uint64_t> visitedNodesVersion = 0;
+};
+
+/// Explores the program with several workers in parallel. Each worker is an instance of one of
+/// the other path selection strategies backed by its own solver, so every worker runs in its
+/// own Z3 context. The workers share an ExplorationFrontier, through which they balance their
+/// branches and share coverage. The callback of this executor produces the tests one at a time,
+/// in the order in which the workers reach them.
+class ParallelSearch : public SymbolicExecutor {
+ public:
+    /// Creates the solver of a worker.
+    using SolverFactory = std::function<std::unique_ptr<AbstractSolver>()>;
+
+    /// Creates the path selection strategy of a worker, backed by @param solver. The search takes
+    /// ownership of the returned executor.
+    using ExecutorFactory = std::function<SymbolicExecutor *(AbstractSolver &solver)>;
+
+    void runImpl(const Callback &callBack, ExecutionStateReference executionState) override;
+
+    /// Explores with @param workers workers. If the compiler is built without ENABLE_MULTITHREAD
+    /// a single worker explores the whole program.
+    ParallelSearch(AbstractSolver &solver, const ProgramInfo &programInfo, unsigned workers,
+                   SolverFactory makeSolver, ExecutorFactory makeExecutor);
+
+ private:
+    /// The number of workers requested.
+    unsigned workers;
+
+    SolverFactory makeSolver;
+
+    ExecutorFactory makeExecutor;
+
+    ExplorationFrontier sharedFrontier;
+};
+
+}  // namespace P4::P4Tools::P4Testgen
+
+#endif /* BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_PARALLEL_SEARCH_H_ */
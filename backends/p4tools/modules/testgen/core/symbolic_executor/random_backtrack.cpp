@@ -57,6 +57,7 @@ void RandomBacktrack::runImpl(const Callback &callBack, ExecutionStateReference
                 auto nextState = pickSuccessor(successors);
                 if (nextState.has_value()) {
                     executionState = nextState.value();
+                    shareBranches(unexploredBranches);
                     continue;
                 }
             }
@@ -73,7 +74,13 @@ void RandomBacktrack::runImpl(const Callback &callBack, ExecutionStateReference
         // more branches to explore, finish execution. Not all branches are viable, so we loop
         // until either we run out of unexplored branches or we find a viable branch.
         if (unexploredBranches.empty()) {
-            return;
+            // When exploring in parallel, continue with a branch of another worker.
+            auto stolenState = stealBranch();
+            if (!stolenState.has_value()) {
+                return;
+            }
+            executionState = stolenState.value();
+            continue;
         }
         // Select a new branch by iterating over all branches
         Util::ScopedTimer chooseBranchtimer("branch_selection");
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/sharded_search.h"
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ir/solver.h"
+#include "lib/error.h"
+#include "lib/timer.h"
+
+#include "backends/p4tools/modules/testgen/core/program_info.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
+#include "backends/p4tools/modules/testgen/lib/exceptions.h"
+#include "backends/p4tools/modules/testgen/lib/execution_state.h"
+#include "backends/p4tools/modules/testgen/lib/logging.h"
+#include "backends/p4tools/modules/testgen/options.h"
+
+namespace P4::P4Tools::P4Testgen {
+
+ShardedSearch::ShardedSearch(AbstractSolver &solver, const ProgramInfo &programInfo,
+                             unsigned shardIndex, unsigned shardCount, SymbolicExecutor &explorer)
+    : SymbolicExecutor(solver, programInfo),
+      shardIndex(shardIndex),
+      shardCount(shardCount),
+      explorer(explorer) {}
+
+std::vector<ShardedSearch::Prefix> ShardedSearch::expandPrefixes(ExecutionStateReference root) {
+    Util::ScopedTimer timer("shard_split");
+    size_t target = static_cast<size_t>(shardCount) * BRANCHES_PER_SHARD;
+    std::vector<Prefix> prefixes;
+    std::deque<Prefix> pending;
+    pending.push_back({root, {}});
+    while (!pending.empty() && prefixes.size() + pending.size() < target) {
+        auto prefix = std::move(pending.front());
+        pending.pop_front();
+        try {
+            // Follow the path until it branches. Like --input-branches, only steps with more
+            // than one successor consume a branch identifier.
+            StepResult successors = nullptr;
+            while (!prefix.state.get().isTerminal()) {
+                successors = step(prefix.state);
+                if (successors->size() != 1) {
+                    break;
+                }
+                prefix.state = (*successors)[0].nextState;
+            }
+            if (prefix.state.get().isTerminal()) {
+                prefixes.push_back(std::move(prefix));
+                continue;
+            }
+            for (uint64_t bIdx = 0; bIdx < successors->size(); ++bIdx) {
+                auto branches = prefix.branches;
+                branches.push_back(bIdx + 1);
+                pending.push_back({(*successors)[bIdx].nextState, std::move(branches)});
+            }
+        } catch (TestgenUnimplemented &e) {
+            // If strict is enabled, bubble the exception up.
+            if (TestgenOptions::get().strict) {
+                throw;
+            }
+            // Otherwise drop the path, as the other strategies do.
+            warning("Path encountered unimplemented feature. Message: %1%\n", e.what());
+        }
+    }
+    prefixes.insert(prefixes.end(), std::make_move_iterator(pending.begin()),
+                    std::make_move_iterator(pending.end()));
+    std::sort(prefixes.begin(), prefixes.end(), [](const Prefix &left, const Prefix &right) {
+        return left.branches < right.branches;
+    });
+    return prefixes;
+}
+
+void ShardedSearch::runImpl(const Callback &callBack, ExecutionStateReference executionState) {
+    auto prefixes = expandPrefixes(executionState);
+    printInfo("Split the program into %1% branches for %2% shards.", prefixes.size(), shardCount);
+
+    // The test back end reports coverage to this executor. Pass it on to the explorer, which
+    // may use it to select paths.
+    bool stopped = false;
+    Callback shardCallback = [this, &callBack, &stopped](const FinalState &finalState) {
+        stopped = callBack(finalState);
+        (void)explorer.updateVisitedNodes(getVisitedNodes());
+        return stopped;
+    };
+    for (size_t idx = shardIndex; idx < prefixes.size() && !stopped; idx += shardCount) {
+        auto &prefix = prefixes[idx];
+        std::string branches;
+        for (auto branch : prefix.branches) {
+            branches += (branches.empty() ? "" : ",") + std::to_string(branch);
+        }
+        printInfo("Exploring the branch --input-branches \"%1%\".", branches);
+        if (prefix.state.get().isTerminal()) {
+            handleTerminalState(shardCallback, prefix.state);
+            continue;
+        }
+        explorer.runImpl(shardCallback, prefix.state);
+    }
+}
+
+}  // namespace P4::P4Tools::P4Testgen
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SHARDED_SEARCH_H_
+#define BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SHARDED_SEARCH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ir/solver.h"
+
+#include "backends/p4tools/modules/testgen/core/program_info.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
+#include "backends/p4tools/modules/testgen/lib/execution_state.h"
+
+namespace P4::P4Tools::P4Testgen {
+
+/// Explores one of several shards of the program, so that independent P4Testgen processes can
+/// share the work of exploring it. The executor expands the branches closest to the root of the
+/// program breadth-first until there are enough of them to go around, sorts them by their
+/// branch identifiers, and keeps every shardCount-th of them. The branch identifiers are the
+/// ones that --input-branches takes, and the expansion only depends on the program, so every
+/// process computes the same split and the shards do not overlap. The branches of the shard are
+/// then explored one after the other with the selected path selection strategy.
+class ShardedSearch : public SymbolicExecutor {
+ public:
+    void runImpl(const Callback &callBack, ExecutionStateReference executionState) override;
+
+    /// Explores shard @param shardIndex of @param shardCount with @param explorer, which must
+    /// be backed by @param solver.
+    ShardedSearch(AbstractSolver &solver, const ProgramInfo &programInfo, unsigned shardIndex,
+                  unsigned shardCount, SymbolicExecutor &explorer);
+
+ private:
+    /// A branch close to the root of the program.
+    struct Prefix {
+        /// The state at the start of the branch.
+        ExecutionStateReference state;
+
+        /// The branch identifiers that lead to the state, in the format of --input-branches.
+        std::vector<uint64_t> branches;
+    };
+
+    /// The number of branches that are split among the shards, per shard. More branches make
+    /// the shards more even, but are explored without the guidance of the path selection.
+    static constexpr unsigned BRANCHES_PER_SHARD = 8;
+
+    /// Expands @param root breadth-first until there are BRANCHES_PER_SHARD branches per shard
+    /// or nothing left to expand. @returns the branches, sorted by their branch identifiers.
+    std::vector<Prefix> expandPrefixes(ExecutionStateReference root);
+
+    unsigned shardIndex;
+
+    unsigned shardCount;
+
+    /// The path selection strategy that explores the branches of the shard.
+    SymbolicExecutor &explorer;
+};
+
+}  // namespace P4::P4Tools::P4Testgen
+
+#endif /* BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SHARDED_SEARCH_H_ */
@@ -19,6 +19,7 @@
 #include "midend/coverage.h"
 
 #include "backends/p4tools/modules/testgen/core/program_info.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/parallel_search.h"
 #include "backends/p4tools/modules/testgen/core/small_step/small_step.h"
 #include "backends/p4tools/modules/testgen/lib/execution_state.h"
 #include "backends/p4tools/modules/testgen/lib/final_state.h"
@@ -64,6 +65,9 @@ bool SymbolicExecutor::handleTerminalState(const Callback &callback,
     // final symbolic environment and trace, use it to evaluate the
     // final execution state, and finally delegate to the callback.
     const FinalState finalState(solver, terminalState);
+    if (frontier != nullptr) {
+        return frontier->runCallback(callback, finalState);
+    }
     return callback(finalState);
 }
 
@@ -92,6 +96,19 @@ SymbolicExecutor::Branch SymbolicExecutor::popRandomBranch(
     return branch;
 }
 
+void SymbolicExecutor::shareBranches(std::vector<SymbolicExecutor::Branch> &branches) {
+    if (frontier != nullptr && frontier->hungry() && !branches.empty()) {
+        frontier->donate(branches);
+    }
+}
+
+std::optional<ExecutionStateReference> SymbolicExecutor::stealBranch() {
+    if (frontier == nullptr) {
+        return std::nullopt;
+    }
+    return frontier->steal(true);
+}
+
 SymbolicExecutor::SymbolicExecutor(AbstractSolver &solver, const ProgramInfo &programInfo)
     : programInfo(programInfo),
       solver(solver),
@@ -105,6 +122,11 @@ SymbolicExecutor::SymbolicExecutor(AbstractSolver &solver, const ProgramInfo &pr
 }
 
 bool SymbolicExecutor::updateVisitedNodes(const P4::Coverage::CoverageSet &newNodes) {
+    if (frontier != nullptr) {
+        auto hasUpdated = frontier->updateVisitedNodes(newNodes);
+        frontier->syncVisitedNodes(visitedNodes, visitedNodesVersion);
+        return hasUpdated;
+    }
     auto hasUpdated = false;
     for (const auto *newNode : newNodes) {
         hasUpdated |= visitedNodes.insert(newNode).second;
@@ -112,7 +134,12 @@ bool SymbolicExecutor::updateVisitedNodes(const P4::Coverage::CoverageSet &newNo
     return hasUpdated;
 }
 
-const P4::Coverage::CoverageSet &SymbolicExecutor::getVisitedNodes() { return visitedNodes; }
+const P4::Coverage::CoverageSet &SymbolicExecutor::getVisitedNodes() {
+    if (frontier != nullptr) {
+        frontier->syncVisitedNodes(visitedNodes, visitedNodesVersion);
+    }
+    return visitedNodes;
+}
 
 void SymbolicExecutor::printCurrentTraceAndBranches(std::ostream &out,
                                                     const ExecutionState &executionState) {
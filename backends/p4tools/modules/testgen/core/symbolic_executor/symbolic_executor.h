@@ -8,7 +8,9 @@
 #define BACKENDS_P4TOOLS_MODULES_TESTGEN_CORE_SYMBOLIC_EXECUTOR_SYMBOLIC_EXECUTOR_H_
 
 #include <functional>
+#include <cstdint>
 #include <iosfwd>
+#include <optional>
 #include <vector>
 
 #include "ir/solver.h"
@@ -21,6 +23,8 @@
 
 namespace P4::P4Tools::P4Testgen {
 
+class ExplorationFrontier;
+
 /// Base abstract class for symbolic execution. It requires the implementation of
 /// the run method, and carries the base Branch struct, to be reused in inherited
 /// classes. It also holds a default termination method, which can be overridden.
@@ -73,9 +77,16 @@ class SymbolicExecutor {
     /// Set of all nodes, to be retrieved from programInfo.
     const P4::Coverage::CoverageSet &coverableNodes;
 
-    /// Set of all nodes executed in any testcase that has been outputted.
+    /// Set of all nodes executed in any testcase that has been outputted. When exploring in
+    /// parallel, this is a copy of the set shared by all workers.
     P4::Coverage::CoverageSet visitedNodes;
 
+    /// The frontier shared with the other workers of a ParallelSearch, or nullptr.
+    ExplorationFrontier *frontier = nullptr;
+
+    /// The version of the shared set of visited nodes that @var visitedNodes is a copy of.
+    uint64_t visitedNodesVersion = 0;
+
     /// Handles processing at the end of a P4 program.
     ///
     /// @returns true if symbolic execution should end; false if symbolic execution should continue
@@ -90,12 +101,22 @@ class SymbolicExecutor {
     /// Return true if the solver can find a solution and does not time out.
     static bool evaluateBranch(const SymbolicExecutor::Branch &branch, AbstractSolver &solver);
 
+    /// Hand some of the unexplored @param branches to idle workers when exploring in parallel.
+    void shareBranches(std::vector<SymbolicExecutor::Branch> &branches);
+
+    /// Called once this executor has explored all of its branches. When exploring in parallel,
+    /// waits for a branch of another worker and returns it. Returns std::nullopt if there is
+    /// nothing left to explore.
+    std::optional<ExecutionStateReference> stealBranch();
+
     /// Select a branch at random from the input @param candidateBranches.
     //  Remove the branch from the container.
     static SymbolicExecutor::Branch popRandomBranch(
         std::vector<SymbolicExecutor::Branch> &candidateBranches);
 
  private:
+    friend class ParallelSearch;
+
     SmallStepEvaluator evaluator;
 };
 
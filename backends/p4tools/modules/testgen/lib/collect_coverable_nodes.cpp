@@ -4,6 +4,7 @@
 
 #include "backends/p4tools/modules/testgen/lib/collect_coverable_nodes.h"
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -145,15 +146,21 @@ void CoverableNodesScanner::updateNodeCoverage(const IR::Node *node,
     CHECK_NULL(node);
 
     static NodeCache CACHED_NODES;
-    // If the node is already in the cache, return it.
-    auto it = CACHED_NODES.find(node);
-    if (it != CACHED_NODES.end()) {
-        nodes.insert(it->second.begin(), it->second.end());
-        return;
+    // The cache is shared by the workers of a parallel search.
+    static std::mutex CACHE_LOCK;
+    {
+        // If the node is already in the cache, return it.
+        std::lock_guard<std::mutex> guard(CACHE_LOCK);
+        auto it = CACHED_NODES.find(node);
+        if (it != CACHED_NODES.end()) {
+            nodes.insert(it->second.begin(), it->second.end());
+            return;
+        }
     }
     node->apply(*this);
     nodes.insert(coverableNodes.begin(), coverableNodes.end());
     // Store the result in the cache.
+    std::lock_guard<std::mutex> guard(CACHE_LOCK);
     CACHED_NODES.emplace(node, coverableNodes);
 }
 
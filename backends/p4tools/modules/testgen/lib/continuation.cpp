@@ -4,6 +4,7 @@
 
 #include "backends/p4tools/modules/testgen/lib/continuation.h"
 
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -38,17 +39,17 @@ bool Continuation::Body::empty() const { return cmds.empty(); }
 
 const Continuation::Command Continuation::Body::next() const {
     if (!cmds.empty()) {
-        return cmds.front();
+        return cmds.top();
     }
 
     BUG("Empty continuation body");
 }
 
-void Continuation::Body::push(Command cmd) { cmds.emplace_front(cmd); }
+void Continuation::Body::push(Command cmd) { cmds.push(std::move(cmd)); }
 
 void Continuation::Body::pop() {
     BUG_CHECK(!cmds.empty(), "Attempted to pop an empty command stack");
-    cmds.pop_front();
+    cmds.pop();
 }
 
 void Continuation::Body::clear() { cmds.clear(); }
@@ -133,7 +134,7 @@ Continuation::Body Continuation::apply(std::optional<const IR::Node *> value_opt
 
     // Create a copy of this continuation's body, with the value substituted for the continuation's
     // parameter.
-    Body result;
+    std::vector<Command> cmds;
 
     struct SubstVisitor {
         VariableSubstitution subst;
@@ -162,10 +163,10 @@ Continuation::Body Continuation::apply(std::optional<const IR::Node *> value_opt
     } subst(*parameterOpt, *value_opt);
 
     for (const auto &cmd : body.cmds) {
-        result.cmds.push_back(std::visit(subst, cmd));
+        cmds.push_back(std::visit(subst, cmd));
     }
 
-    return result;
+    return Body(cmds);
 }
 
 const Continuation::Parameter *Continuation::genParameter(const IR::Type *type, cstring name,
@@ -8,7 +8,6 @@
 #define BACKENDS_P4TOOLS_MODULES_TESTGEN_LIB_CONTINUATION_H_
 
 #include <cstdint>
-#include <deque>
 #include <initializer_list>
 #include <iosfwd>
 #include <map>
@@ -19,6 +18,7 @@
 #include <vector>
 
 #include "backends/p4tools/common/lib/namespace_context.h"
+#include "backends/p4tools/common/lib/persistent_map.h"
 #include "backends/p4tools/common/lib/trace_event.h"
 #include "ir/ir.h"
 #include "ir/node.h"
@@ -136,7 +136,9 @@ class Continuation {
         friend class Continuation;
         friend class Test::SmallStepTest;
 
-        std::deque<Command> cmds;
+        /// The commands of this body, the next one on top. Bodies are copied with every execution
+        /// state, so they share their commands.
+        PersistentStack<Command> cmds;
 
      public:
         /// Determines whether this body is empty.
@@ -161,7 +163,7 @@ class Continuation {
         /// Allows the command stack to be initialized with a list initializer.
         Body(std::initializer_list<Command> cmds);
 
-        /// Allow deque initialization with a vector. We iterate and push through the vector in
+        /// Allow stack initialization with a vector. We iterate and push through the vector in
         /// reverse.
         explicit Body(const std::vector<Command> &cmds);
 
@@ -9,7 +9,6 @@
 #include <initializer_list>
 #include <list>
 #include <map>
-#include <stack>
 #include <string>
 #include <utility>
 #include <variant>
@@ -68,8 +67,7 @@ const NamespaceContext *ExecutionState::StackFrame::getNameSpaces() const { retu
 
 ExecutionState::ExecutionState(const IR::P4Program *program)
     : AbstractExecutionState(program),
-      body({program}),
-      stack(*(new std::stack<std::reference_wrapper<const StackFrame>>())) {
+      body({program}) {
     env.set(&PacketVars::INPUT_PACKET_LABEL, IR::Constant::get(IR::Type_Bits::get(0), 0));
     env.set(&PacketVars::PACKET_BUFFER_LABEL, IR::Constant::get(IR::Type_Bits::get(0), 0));
     // We also add the taint property and set it to false.
@@ -87,7 +85,7 @@ ExecutionState::ExecutionState(const IR::P4Program *program)
 }
 
 ExecutionState::ExecutionState(Continuation::Body body)
-    : body(std::move(body)), stack(*(new std::stack<std::reference_wrapper<const StackFrame>>())) {
+    : body(std::move(body)) {
     // We also add the taint property and set it to false.
     setProperty("inUndefinedState"_cs, false);
     // Drop is initialized to false, too.
@@ -177,10 +175,10 @@ void ExecutionState::markVisited(const IR::Node *node) {
     if (node->is<IR::P4Action>() && !coverageOptions.coverActions) {
         return;
     }
-    visitedNodes.emplace(node);
+    visitedNodes.insert(node);
 }
 
-const P4::Coverage::CoverageSet &ExecutionState::getVisited() const { return visitedNodes; }
+const ExecutionState::VisitedNodes &ExecutionState::getVisited() const { return visitedNodes; }
 
 /// Compare types, considering Extracted_Varbit and bits equal if the (real/extracted) sizes are
 /// equal. This is because the packet expression can be something like 0 ++
@@ -217,36 +215,36 @@ void ExecutionState::set(const IR::StateVariable &var, const IR::Expression *val
     env.set(var, value);
 }
 
-const std::vector<std::reference_wrapper<const TraceEvent>> &ExecutionState::getTrace() const {
-    return trace;
+std::vector<std::reference_wrapper<const TraceEvent>> ExecutionState::getTrace() const {
+    return trace.toVector();
 }
 
 const Continuation::Body &ExecutionState::getBody() const { return body; }
 
-const std::stack<std::reference_wrapper<const ExecutionState::StackFrame>> &
-ExecutionState::getStack() const {
-    return stack;
-}
+const ExecutionState::Stack &ExecutionState::getStack() const { return stack; }
 
 void ExecutionState::setProperty(cstring propertyName, Continuation::PropertyValue property) {
-    stateProperties[propertyName] = property;
+    stateProperties.set(propertyName, property);
 }
 
 bool ExecutionState::hasProperty(cstring propertyName) const {
-    return stateProperties.count(propertyName) > 0;
+    return stateProperties.contains(propertyName);
 }
 
 void ExecutionState::addTestObject(cstring category, cstring objectLabel,
                                    const TestObject *object) {
-    testObjects[category][objectLabel] = object;
+    auto *testObjectCategory = new TestObjectMap(getTestObjectCategory(category));
+    (*testObjectCategory)[objectLabel] = object;
+    testObjects.set(category, testObjectCategory);
 }
 
 const TestObject *ExecutionState::getTestObject(cstring category, cstring objectLabel,
                                                 bool checked) const {
-    auto testObjectCategory = getTestObjectCategory(category);
-    auto it = testObjectCategory.find(objectLabel);
-    if (it != testObjectCategory.end()) {
-        return it->second;
+    if (const auto *testObjectCategory = testObjects.find(category)) {
+        auto it = (*testObjectCategory)->find(objectLabel);
+        if (it != (*testObjectCategory)->end()) {
+            return it->second;
+        }
     }
     if (checked) {
         BUG("Unable to find test object with the label %1% in the category %2%. ", objectLabel,
@@ -256,17 +254,17 @@ const TestObject *ExecutionState::getTestObject(cstring category, cstring object
 }
 
 TestObjectMap ExecutionState::getTestObjectCategory(cstring category) const {
-    auto it = testObjects.find(category);
-    if (it != testObjects.end()) {
-        return it->second;
+    if (const auto *testObjectCategory = testObjects.find(category)) {
+        return **testObjectCategory;
     }
     return {};
 }
 
 void ExecutionState::deleteTestObject(cstring category, cstring objectLabel) {
-    auto it = testObjects.find(category);
-    if (it != testObjects.end()) {
-        it->second.erase(objectLabel);
+    if (const auto *testObjectCategory = testObjects.find(category)) {
+        auto *updatedCategory = new TestObjectMap(**testObjectCategory);
+        updatedCategory->erase(objectLabel);
+        testObjects.set(category, updatedCategory);
     }
 }
 
@@ -284,7 +282,7 @@ ReachabilityEngineState *ExecutionState::getReachabilityEngineState() const {
  *  Trace events.
  * ============================================================================================= */
 
-void ExecutionState::add(const TraceEvent &event) { trace.emplace_back(event); }
+void ExecutionState::add(const TraceEvent &event) { trace.push(event); }
 
 void ExecutionState::popBody() { body.pop(); }
 
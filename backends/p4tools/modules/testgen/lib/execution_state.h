@@ -13,7 +13,6 @@
 #include <iostream>
 #include <map>
 #include <optional>
-#include <stack>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -21,6 +20,7 @@
 #include "backends/p4tools/common/compiler/reachability.h"
 #include "backends/p4tools/common/core/abstract_execution_state.h"
 #include "backends/p4tools/common/lib/namespace_context.h"
+#include "backends/p4tools/common/lib/persistent_map.h"
 #include "backends/p4tools/common/lib/symbolic_env.h"
 #include "backends/p4tools/common/lib/trace_event.h"
 #include "ir/declaration.h"
@@ -72,17 +72,31 @@ class ExecutionState : public AbstractExecutionState {
         [[nodiscard]] const NamespaceContext *getNameSpaces() const;
     };
 
+    /// The continuation stack. Iteration starts at the topmost frame.
+    using Stack = PersistentStack<std::reference_wrapper<const StackFrame>>;
+
+    /// The set of visited nodes. Nodes are identified by their source position, as in
+    /// P4::Coverage::CoverageSet.
+    using VisitedNodes =
+        PersistentSet<const IR::Node *, P4::Coverage::SourceIdHash, P4::Coverage::SourceIdEqual>;
+
     /// No move semantics because of constant members. We always need to clone a state.
     ExecutionState(ExecutionState &&) = delete;
     ExecutionState &operator=(ExecutionState &&) = delete;
     ~ExecutionState() override = default;
 
  private:
+    // Every branch clones the state it branches from, so all containers that grow with the length
+    // of the path are persistent: cloning a state is O(1) and the branches share the parts of their
+    // state that they have in common. Only the path constraints and branch decisions are plain
+    // vectors, since the solver needs them in order and they are cheap to copy.
+
     /// The program trace for the current program point (i.e., how we got to the current state).
-    std::vector<std::reference_wrapper<const TraceEvent>> trace;
+    /// The most recent event is on top.
+    PersistentStack<std::reference_wrapper<const TraceEvent>> trace;
 
     /// Set of visited nodes. Used for code coverage.
-    P4::Coverage::CoverageSet visitedNodes;
+    VisitedNodes visitedNodes;
 
     /// The remaining body of the current function being executed.
     ///
@@ -96,7 +110,7 @@ class ExecutionState : public AbstractExecutionState {
     /// becomes the top of the stack.
     ///
     // Invariant: if the @body is empty, then so is this, and this state is terminal.
-    std::stack<std::reference_wrapper<const StackFrame>> stack;
+    Stack stack;
 
     /// State properties are bools, integers, or strings that can be set and propagated across
     /// execution state. They are used to influence execution along a particular continuation path.
@@ -104,7 +118,7 @@ class ExecutionState : public AbstractExecutionState {
     /// written while this variable is active is tainted. This property must be unset manually to
     /// resume normal operation by setting the property "false". Usually, this is done directly
     /// after the tainted sequence of commands has been executed.
-    std::map<cstring, Continuation::PropertyValue> stateProperties;
+    PersistentMap<cstring, Continuation::PropertyValue> stateProperties;
 
     // Test objects are classes of variables that influence the execution of test frameworks. They
     // are collected during interpreter execution and consumed by the respective test framework. For
@@ -112,7 +126,8 @@ class ExecutionState : public AbstractExecutionState {
     // which defines control plane match action entries. Once the interpreter has solved for the
     // variables used by these test objects and concretized the values, they can be used to generate
     // a test. Test objects are not constant because they may be manipulated by a target back end.
-    std::map<cstring, TestObjectMap> testObjects;
+    // The object maps of a category are copied when they are updated, not when the state is.
+    PersistentMap<cstring, const TestObjectMap *> testObjects;
 
     /// The parserErrorLabel is set by the parser to indicate the variable corresponding to the
     /// parser error that is set by various built-in functions such as verify or extract.
@@ -176,20 +191,20 @@ class ExecutionState : public AbstractExecutionState {
     void markVisited(const IR::Node *node);
 
     /// @returns list of all nodes visited before reaching this state.
-    [[nodiscard]] const P4::Coverage::CoverageSet &getVisited() const;
+    [[nodiscard]] const VisitedNodes &getVisited() const;
 
     /// Sets the symbolic value of the given state variable to the given value. Constant folding
     /// is done on the given value before updating the symbolic state.
     void set(const IR::StateVariable &var, const IR::Expression *value) override;
 
-    /// @returns the current event trace.
-    [[nodiscard]] const std::vector<std::reference_wrapper<const TraceEvent>> &getTrace() const;
+    /// @returns the current event trace, in the order in which the events were added.
+    [[nodiscard]] std::vector<std::reference_wrapper<const TraceEvent>> getTrace() const;
 
     /// @returns the current body.
     [[nodiscard]] const Continuation::Body &getBody() const;
 
     /// @returns the current stack.
-    [[nodiscard]] const std::stack<std::reference_wrapper<const StackFrame>> &getStack() const;
+    [[nodiscard]] const Stack &getStack() const;
 
     /// Set the property with @arg propertyName to @arg property.
     void setProperty(cstring propertyName, Continuation::PropertyValue property);
@@ -201,9 +216,8 @@ class ExecutionState : public AbstractExecutionState {
     /// BUG, If the specified type does not match or the property is not found.
     template <class T>
     [[nodiscard]] T getProperty(cstring propertyName) const {
-        auto iterator = stateProperties.find(propertyName);
-        if (iterator != stateProperties.end()) {
-            auto val = iterator->second;
+        if (const auto *property = stateProperties.find(propertyName)) {
+            auto val = *property;
             try {
                 T resolvedVal = std::get<T>(val);
                 return resolvedVal;
@@ -119,5 +119,7 @@ const std::vector<std::reference_wrapper<const TraceEvent>> *FinalState::getTrac
     return &trace;
 }
 
-const P4::Coverage::CoverageSet &FinalState::getVisited() const { return state.get().getVisited(); }
+const ExecutionState::VisitedNodes &FinalState::getVisited() const {
+    return state.get().getVisited();
+}
 }  // namespace P4::P4Tools::P4Testgen
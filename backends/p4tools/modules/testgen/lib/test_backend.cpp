@@ -133,7 +133,10 @@ bool TestBackEnd::run(const FinalState &state) {
 
         // Commit an update to the visited nodes.
         // Only do this once we are sure we are generating a test.
-        auto hasUpdated = symbex.updateVisitedNodes(replacedState.getVisited());
+        const auto &stateVisitedNodes = replacedState.getVisited();
+        P4::Coverage::CoverageSet newVisitedNodes(stateVisitedNodes.begin(),
+                                                  stateVisitedNodes.end());
+        auto hasUpdated = symbex.updateVisitedNodes(newVisitedNodes);
 
         // Skip test case generation if the --only-covering-tests is enabled and we do not increase
         // coverage.
@@ -155,7 +158,7 @@ bool TestBackEnd::run(const FinalState &state) {
                 static_cast<float>(visitedNodes.size()) / static_cast<float>(coverableNodes.size());
             printInfo("============ Test %1%: Nodes covered: %2% (%3%/%4%) ============", testCount,
                       coverage, visitedNodes.size(), coverableNodes.size());
-            P4::Coverage::logCoverage(coverableNodes, visitedNodes, executionState->getVisited());
+            P4::Coverage::logCoverage(coverableNodes, visitedNodes, newVisitedNodes);
         }
 
         // Output the test.
@@ -57,6 +57,60 @@ TestgenOptions::TestgenOptions()
         "Sets the maximum number of tests to be generated [default: 1]. Setting the value to 0 "
         "will generate tests until no more paths can be found.");
 
+    registerOption(
+        "--parallel", "workers",
+        [this](const char *arg) {
+            try {
+                auto workers = std::stoll(arg);
+                if (workers < 1) {
+                    throw std::invalid_argument("Invalid input.");
+                }
+                parallelWorkers = static_cast<unsigned>(workers);
+            } catch (std::exception &) {
+                error("Invalid input value %1% for --parallel. Expected positive integer.", arg);
+                return false;
+            }
+            return true;
+        },
+        "Explore the program with this many workers in parallel [default: 1]. Every worker uses "
+        "the selected path selection policy with its own solver. The order of the generated tests "
+        "depends on the scheduling of the workers.");
+
+    registerOption(
+        "--shard", "index/count",
+        [this](const char *arg) {
+            try {
+                std::string shard(arg);
+                auto separator = shard.find('/');
+                if (separator == std::string::npos) {
+                    throw std::invalid_argument("Invalid input.");
+                }
+                size_t indexEnd = 0;
+                size_t countEnd = 0;
+                auto index = std::stoll(shard.substr(0, separator), &indexEnd);
+                auto count = std::stoll(shard.substr(separator + 1), &countEnd);
+                if (indexEnd != separator || countEnd != shard.size() - separator - 1 ||
+                    index < 0 || count < 1 || index >= count) {
+                    throw std::invalid_argument("Invalid input.");
+                }
+                shardIndex = static_cast<unsigned>(index);
+                shardCount = static_cast<unsigned>(count);
+            } catch (std::exception &) {
+                error(
+                    "Invalid input value %1% for --shard. Expected index/count with "
+                    "0 <= index < count.",
+                    arg);
+                return false;
+            }
+            return true;
+        },
+        "Only explore one of count shards of the program, so that several P4Testgen processes "
+        "can share the work. The branches near the start of the program are split among the "
+        "shards in the same way by every process. Each shard writes its tests to the "
+        "subdirectory shard-<index> of the output directory, together with a report of the "
+        "coverage it achieved if --track-coverage is given. Every shard produces up to "
+        "--max-tests tests.");
+
     registerOption(
         "--stop-metric", "stopMetric",
         [this](const char *arg) {
@@ -425,6 +479,25 @@ TestgenOptions::TestgenOptions()
         },
         "Produce only tests that violate the condition defined in assert calls. This will either "
         "produce no tests or only tests that contain counter examples.");
+
+    registerOption(
+        "--disable-solver-cache", nullptr,
+        [this](const char * /*arg*/) {
+            useSolverCache = false;
+            return true;
+        },
+        "Send every query to the solver, instead of answering repeated and subsumed queries and "
+        "queries that an earlier model satisfies from a cache. Without the cache, every test is "
+        "generated with a fresh model from the solver. Also disables constraint slicing.");
+
+    registerOption(
+        "--disable-constraint-slicing", nullptr,
+        [this](const char * /*arg*/) {
+            useConstraintSlicing = false;
+            return true;
+        },
+        "Send the whole path constraint to the solver, instead of only the constraints that "
+        "share variables with the newest branch condition.");
 }
 
 bool TestgenOptions::validateOptions() const {
@@ -435,6 +508,16 @@ bool TestgenOptions::validateOptions() const {
               "--assert-min-coverage is meaningless.");
         return false;
     }
+    if (shardCount > 1 && !selectedBranches.empty()) {
+        error(ErrorType::ERR_INVALID,
+              "--shard can not be used with --input-branches, which explores a single path.");
+        return false;
+    }
+    if (parallelWorkers > 1 && !selectedBranches.empty()) {
+        error(ErrorType::ERR_INVALID,
+              "--parallel can not be used with --input-branches, which explores a single path.");
+        return false;
+    }
     return true;
 }
 
@@ -30,6 +30,14 @@ class TestgenOptions : public AbstractP4cToolOptions {
     /// Maximum number of tests to be generated. Defaults to 1.
     int64_t maxTests = 1;
 
+    /// The number of workers exploring the program in parallel. Defaults to 1.
+    unsigned parallelWorkers = 1;
+
+    /// The shard of the branch tree that this process explores, and the number of shards. The
+    /// whole tree is a single shard by default.
+    unsigned shardIndex = 0;
+    unsigned shardCount = 1;
+
     /// Selects the path selection policy for test generation
     P4Testgen::PathSelectionPolicy pathSelectionPolicy = P4Testgen::PathSelectionPolicy::DepthFirst;
 
@@ -94,6 +102,12 @@ class TestgenOptions : public AbstractP4cToolOptions {
     /// This will either produce no tests or only tests that contain counter examples.
     bool assertionModeEnabled = false;
 
+    /// Answer repeated and subsumed solver queries from a cache. See QueryCache.
+    bool useSolverCache = true;
+
+    /// Split solver queries into independent partitions. See ConstraintSlicer.
+    bool useConstraintSlicing = true;
+
     /// Specifies general options which IR nodes to track for coverage in the targeted P4 program.
     /// Multiple options are possible.
     /// Currently supported: STATEMENTS, TABLE_ENTRIES, ACTIONS, PARSER_STATES
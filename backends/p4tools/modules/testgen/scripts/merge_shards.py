@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+
+# SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Merges the tests of several P4Testgen shards into one directory.
+
+P4Testgen invoked with --shard i/N writes its tests to the directory shard-i of the output
+directory. This script copies the tests of all shards into a single directory, drops tests that
+more than one shard produced, and numbers the remaining tests consecutively. If the shards were
+run with --track-coverage, it also combines their coverage reports.
+"""
+
+import argparse
+import json
+import re
+import sys
+from pathlib import Path
+
+PARSER = argparse.ArgumentParser(description=__doc__)
+
+PARSER.add_argument(
+    "shard_dirs",
+    nargs="+",
+    type=Path,
+    help="The output directories of the shards, or one directory holding the shard-i folders.",
+)
+PARSER.add_argument(
+    "-o",
+    "--out-dir",
+    dest="out_dir",
+    type=Path,
+    required=True,
+    help="The folder the merged tests are written to.",
+)
+
+# Tests with one file per test, for example "my_program_3.stf".
+PER_FILE_TEST = re.compile(r"^(?P<stem>.*)_(?P<id>\d+)\.(?P<ext>stf|txtpb|yml)$")
+# Lines that differ between runs even if the test is the same.
+VOLATILE_LINE = re.compile(r"^\s*(#|metadata:|seed:|date:|node_coverage:)")
+# The start of a test case in a PTF file.
+PTF_TEST_CLASS = re.compile(r"^class Test(\d+)\(AbstractTest\):$", re.MULTILINE)
+# The docstring of a PTF test case, which holds the date, the coverage and the trace.
+PTF_DOCSTRING = re.compile(r"'''.*?'''", re.DOTALL)
+COVERAGE_SUFFIX = "_coverage.json"
+
+
+def expand_shard_dirs(shard_dirs):
+    """Replaces a directory that holds shard-i folders by these folders, in the order of i."""
+    result = []
+    for shard_dir in shard_dirs:
+        shards = [path for path in shard_dir.glob("shard-*") if path.is_dir()]
+        if shards:
+            result.extend(sorted(shards, key=lambda path: int(path.name.split("-")[1])))
+        else:
+            result.append(shard_dir)
+    return result
+
+
+def test_key(content):
+    """Returns the content of a test without the lines that depend on the run."""
+    return "\n".join(line for line in content.splitlines() if not VOLATILE_LINE.match(line))
+
+
+def merge_per_file_tests(shard_dirs, out_dir):
+    """Copies the tests that are stored one per file. Returns the number of tests written and
+    the number of duplicates dropped."""
+    seen = set()
+    next_id = {}
+    written = 0
+    duplicates = 0
+    for shard_dir in shard_dirs:
+        tests = []
+        for path in shard_dir.iterdir():
+            match = PER_FILE_TEST.match(path.name)
+            if match:
+                tests.append((match["stem"], match["ext"], int(match["id"]), path))
+        for stem, ext, _, path in sorted(tests):
+            content = path.read_text()
+            key = (stem, ext, test_key(content))
+            if key in seen:
+                duplicates += 1
+                continue
+            seen.add(key)
+            test_id = next_id.get((stem, ext), 1)
+            next_id[(stem, ext)] = test_id + 1
+            out_dir.joinpath(f"{stem}_{test_id}.{ext}").write_text(content)
+            written += 1
+    return written, duplicates
+
+
+def merge_ptf_tests(shard_dirs, out_dir):
+    """Merges the PTF files, which contain a preamble followed by one class per test. Returns the
+    number of tests written and the number of duplicates dropped."""
+    preambles = {}
+    cases = {}
+    seen = set()
+    duplicates = 0
+    for shard_dir in shard_dirs:
+        for path in sorted(shard_dir.glob("*.py")):
+            content = path.read_text()
+            parts = PTF_TEST_CLASS.split(content)
+            if len(parts) < 3:
+                continue
+            preambles.setdefault(path.name, parts[0])
+            # The split alternates between the test id and the body of the test.
+            for body in parts[2::2]:
+                key = (path.name, PTF_DOCSTRING.sub("", body, count=1).strip())
+                if key in seen:
+                    duplicates += 1
+                    continue
+                seen.add(key)
+                cases.setdefault(path.name, []).append(body)
+    written = 0
+    for name, preamble in preambles.items():
+        with out_dir.joinpath(name).open("w") as ptf_file:
+            ptf_file.write(preamble.rstrip() + "\n")
+            for test_id, body in enumerate(cases[name], start=1):
+                ptf_file.write(f"\nclass Test{test_id}(AbstractTest):{body.rstrip()}\n")
+                written += 1
+    return written, duplicates
+
+
+def merge_coverage(shard_dirs, out_dir):
+    """Combines the coverage reports of the shards and prints the combined coverage."""
+    reports = {}
+    for shard_dir in shard_dirs:
+        for path in sorted(shard_dir.glob(f"*{COVERAGE_SUFFIX}")):
+            report = json.loads(path.read_text())
+            merged = reports.setdefault(path.name, {"coverable": set(), "covered": set()})
+            merged["coverable"].update(report["coverable"])
+            merged["covered"].update(report["covered"])
+    for name, report in reports.items():
+        coverable = report["coverable"]
+        covered = report["covered"] & coverable
+        merged = {"coverable": sorted(coverable), "covered": sorted(covered)}
+        out_dir.joinpath(name).write_text(json.dumps(merged, indent=4) + "\n")
+        coverage = len(covered) / len(coverable) if coverable else 1.0
+        print(
+            f"{name[: -len(COVERAGE_SUFFIX)]}: Nodes covered: {coverage:.2f} "
+            f"({len(covered)}/{len(coverable)})"
+        )
+
+
+def main(args):
+    shard_dirs = expand_shard_dirs(args.shard_dirs)
+    for shard_dir in shard_dirs:
+        if not shard_dir.is_dir():
+            print(f"{shard_dir} is not a directory.", file=sys.stderr)
+            return 1
+    args.out_dir.mkdir(parents=True, exist_ok=True)
+    written, duplicates = merge_per_file_tests(shard_dirs, args.out_dir)
+    ptf_written, ptf_duplicates = merge_ptf_tests(shard_dirs, args.out_dir)
+    print(
+        f"Merged {written + ptf_written} tests from {len(shard_dirs)} shards, "
+        f"dropped {duplicates + ptf_duplicates} duplicates."
+    )
+    merge_coverage(shard_dirs, args.out_dir)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(PARSER.parse_args()))
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+
+# SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Tests for merge_shards.py."""
+
+import contextlib
+import io
+import json
+import sys
+import tempfile
+import unittest
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+
+import merge_shards  # noqa: E402
+
+
+def stf_test(date, packet):
+    return f"# Date generated: {date}\n# Current node coverage: 0.5\npacket 0 {packet}\n"
+
+
+def ptf_test(date, packet):
+    return (
+        f"\n    '''\n    Date generated: {date}\n    '''\n\n"
+        f"    def runTest(self):\n        self.send({packet})\n"
+    )
+
+
+def ptf_file(*tests):
+    content = "import ptf\n\n"
+    for test_id, test in enumerate(tests, start=1):
+        content += f"class Test{test_id}(AbstractTest):{test}\n"
+    return content
+
+
+class MergeShardsTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp_dir = tempfile.TemporaryDirectory()
+        self.root = Path(self.tmp_dir.name)
+        self.shards = []
+        for shard_index in range(2):
+            shard_dir = self.root / "out" / f"shard-{shard_index}"
+            shard_dir.mkdir(parents=True)
+            self.shards.append(shard_dir)
+        self.out_dir = self.root / "merged"
+
+    def tearDown(self):
+        self.tmp_dir.cleanup()
+
+    def merge(self, *shard_dirs):
+        args = merge_shards.PARSER.parse_args(
+            [str(shard_dir) for shard_dir in shard_dirs] + ["-o", str(self.out_dir)]
+        )
+        output = io.StringIO()
+        with contextlib.redirect_stdout(output):
+            self.assertEqual(merge_shards.main(args), 0)
+        return output.getvalue()
+
+    def test_per_file_tests_are_deduplicated_and_renumbered(self):
+        self.shards[0].joinpath("prog_1.stf").write_text(stf_test("monday", "AA"))
+        self.shards[0].joinpath("prog_2.stf").write_text(stf_test("monday", "BB"))
+        # The same test as prog_1.stf of shard 0, generated at another time.
+        self.shards[1].joinpath("prog_1.stf").write_text(stf_test("tuesday", "AA"))
+        self.shards[1].joinpath("prog_2.stf").write_text(stf_test("tuesday", "CC"))
+
+        output = self.merge(self.root / "out")
+
+        self.assertIn("Merged 3 tests from 2 shards, dropped 1 duplicates.", output)
+        merged = sorted(path.name for path in self.out_dir.iterdir())
+        self.assertEqual(merged, ["prog_1.stf", "prog_2.stf", "prog_3.stf"])
+        self.assertIn("packet 0 AA", self.out_dir.joinpath("prog_1.stf").read_text())
+        self.assertIn("packet 0 BB", self.out_dir.joinpath("prog_2.stf").read_text())
+        self.assertIn("packet 0 CC", self.out_dir.joinpath("prog_3.stf").read_text())
+
+    def test_ptf_tests_are_deduplicated_and_renumbered(self):
+        self.shards[0].joinpath("prog.py").write_text(
+            ptf_file(ptf_test("monday", "AA"), ptf_test("monday", "BB"))
+        )
+        self.shards[1].joinpath("prog.py").write_text(
+            ptf_file(ptf_test("tuesday", "BB"), ptf_test("tuesday", "CC"))
+        )
+
+        output = self.merge(*self.shards)
+
+        self.assertIn("Merged 3 tests from 2 shards, dropped 1 duplicates.", output)
+        merged = self.out_dir.joinpath("prog.py").read_text()
+        self.assertTrue(merged.startswith("import ptf\n"))
+        self.assertEqual(merged.count("(AbstractTest):"), 3)
+        for test_id, packet in enumerate(["AA", "BB", "CC"], start=1):
+            self.assertIn(f"class Test{test_id}(AbstractTest):", merged)
+            self.assertLess(merged.index(f"Test{test_id}("), merged.index(f"send({packet})"))
+
+    def test_coverage_reports_are_combined(self):
+        reports = [
+            {"coverable": ["p.p4:1:1", "p.p4:2:1", "p.p4:3:1"], "covered": ["p.p4:1:1"]},
+            {"coverable": ["p.p4:1:1", "p.p4:2:1", "p.p4:3:1"], "covered": ["p.p4:2:1"]},
+        ]
+        for shard_dir, report in zip(self.shards, reports):
+            shard_dir.joinpath("prog_coverage.json").write_text(json.dumps(report))
+
+        output = self.merge(*self.shards)
+
+        self.assertIn("prog: Nodes covered: 0.67 (2/3)", output)
+        merged = json.loads(self.out_dir.joinpath("prog_coverage.json").read_text())
+        self.assertEqual(merged["coverable"], ["p.p4:1:1", "p.p4:2:1", "p.p4:3:1"])
+        self.assertEqual(merged["covered"], ["p.p4:1:1", "p.p4:2:1"])
+
+
+if __name__ == "__main__":
+    unittest.main()
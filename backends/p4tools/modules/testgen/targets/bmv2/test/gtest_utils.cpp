@@ -4,10 +4,105 @@
 
 #include "backends/p4tools/modules/testgen/targets/bmv2/test/gtest_utils.h"
 
+#include <sstream>
+
 #include "absl/strings/substitute.h"
 #include "test/gtest/helpers.h"
 
+#include "backends/p4tools/modules/testgen/targets/bmv2/test_backend/protobuf_ir.h"
+
 namespace P4::P4Tools::Test {
+
+using namespace P4::literals;
+
+std::string getBranchingV1modelProgram() {
+    return P4_SOURCE(P4Headers::V1MODEL, R"p4(
+header ethernet_t {
+    bit<48> dst_addr;
+    bit<48> src_addr;
+    bit<16> ether_type;
+}
+struct Headers {
+  ethernet_t eth_hdr;
+}
+struct Metadata {  }
+parser parse(packet_in pkt, out Headers hdr, inout Metadata m, inout standard_metadata_t sm) {
+  state start {
+      pkt.extract(hdr.eth_hdr);
+      transition accept;
+  }
+}
+control ingress(inout Headers hdr, inout Metadata meta, inout standard_metadata_t sm) {
+  apply {
+      if (hdr.eth_hdr.dst_addr == 1) {
+          hdr.eth_hdr.ether_type = 1;
+      } else if (hdr.eth_hdr.dst_addr == 2) {
+          hdr.eth_hdr.ether_type = 2;
+      }
+      if (hdr.eth_hdr.src_addr == 1) {
+          sm.egress_spec = 1;
+      } else {
+          sm.egress_spec = 2;
+      }
+      if (hdr.eth_hdr.ether_type == 0xF00D) {
+          mark_to_drop(sm);
+      }
+  }
+}
+control egress(inout Headers hdr, inout Metadata meta, inout standard_metadata_t sm) {
+  apply {}
+}
+control deparse(packet_out pkt, in Headers hdr) {
+  apply {
+    pkt.emit(hdr.eth_hdr);
+  }
+}
+control verifyChecksum(inout Headers hdr, inout Metadata meta) {
+  apply {}
+}
+control computeChecksum(inout Headers hdr, inout Metadata meta) {
+  apply {}
+}
+V1Switch(parse(), verifyChecksum(), ingress(), egress(), computeChecksum(), deparse()) main;
+)p4");
+}
+
+void P4TestgenBranchingTest::SetUp() {
+    P4TestgenBmv2Test::SetUp();
+    auto &testgenOptions = P4Testgen::TestgenOptions::get();
+    testgenOptions.target = "bmv2"_cs;
+    testgenOptions.arch = "v1model"_cs;
+    testgenOptions.testBackend = "PROTOBUF_IR"_cs;
+    testgenOptions.testBaseName = "dummy"_cs;
+    testgenOptions.minPktSize = 112;
+    testgenOptions.maxPktSize = 112;
+    // Explore all paths.
+    testgenOptions.maxTests = 0;
+}
+
+void P4TestgenBranchingTest::TearDown() {
+    auto &testgenOptions = P4Testgen::TestgenOptions::get();
+    testgenOptions.parallelWorkers = 1;
+    testgenOptions.shardIndex = 0;
+    testgenOptions.shardCount = 1;
+}
+
+std::multiset<std::string> getTestTraces(const P4Testgen::AbstractTestList &tests) {
+    std::multiset<std::string> traces;
+    for (const auto *test : tests) {
+        std::istringstream formattedTest(
+            test->checkedTo<P4Testgen::Bmv2::ProtobufIrTest>()->getFormattedTest());
+        std::string trace;
+        std::string line;
+        while (std::getline(formattedTest, line)) {
+            if (line.rfind("traces:", 0) == 0) {
+                trace += line + "\n";
+            }
+        }
+        traces.insert(trace);
+    }
+    return traces;
+}
 std::optional<const P4ToolsTestCase> createBmv2V1modelSmallStepExprTest(
     const std::string &hdrFields, const std::string &expr) {
     auto source = P4_SOURCE(P4Headers::V1MODEL, R"(
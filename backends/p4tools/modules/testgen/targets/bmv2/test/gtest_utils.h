@@ -7,6 +7,11 @@
 #ifndef BACKENDS_P4TOOLS_MODULES_TESTGEN_TARGETS_BMV2_TEST_GTEST_UTILS_H_
 #define BACKENDS_P4TOOLS_MODULES_TESTGEN_TARGETS_BMV2_TEST_GTEST_UTILS_H_
 
+#include <set>
+#include <string>
+
+#include "backends/p4tools/modules/testgen/lib/test_framework.h"
+#include "backends/p4tools/modules/testgen/options.h"
 #include "backends/p4tools/modules/testgen/test/gtest_utils.h"
 #include "backends/p4tools/modules/testgen/test/small-step/util.h"
 
@@ -26,6 +31,26 @@ class P4TestgenBmv2Test : public P4TestgenTest {
     }
 };
 
+/// @returns a v1model program whose ingress control has three consecutive branches, which gives
+/// tests that explore all paths a handful of distinct paths.
+std::string getBranchingV1modelProgram();
+
+/// @returns the traces of the Protobuf IR @param tests. The trace of a test identifies the path
+/// that it exercises.
+std::multiset<std::string> getTestTraces(const P4Testgen::AbstractTestList &tests);
+
+/// Generates a Protobuf IR test for every path of getBranchingV1modelProgram. Resets the options
+/// that the tests change to explore the program in parallel or in shards.
+class P4TestgenBranchingTest : public P4TestgenBmv2Test {
+ protected:
+    std::string source = getBranchingV1modelProgram();
+
+ public:
+    void SetUp() override;
+
+    void TearDown() override;
+};
+
 /// Creates a test case with the @hdrFields for stepping on an @expr.
 std::optional<const P4ToolsTestCase> createBmv2V1modelSmallStepExprTest(
     const std::string &hdrFields, const std::string &expr);
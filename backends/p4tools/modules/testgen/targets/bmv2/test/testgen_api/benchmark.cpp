@@ -5,10 +5,15 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstdint>
+#include <string>
+
 #include "backends/p4tools/common/compiler/context.h"
 #include "backends/p4tools/common/lib/logging.h"
 #include "frontends/common/options.h"
 #include "lib/compile_context.h"
+#include "lib/timer.h"
 #include "test/gtest/helpers.h"
 
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/path_selection.h"
@@ -50,4 +55,56 @@ TEST_F(P4TestgenBenchmark, SuccessfullyGenerate1000Tests) {
     // Print the report.
     P4Tools::printPerformanceReport();
 }
+
+/// @returns the number of symbolic execution steps taken so far.
+static uint64_t countSteps() {
+    uint64_t steps = 0;
+    for (const auto &timer : Util::getTimers()) {
+        if (timer.timerName.ends_with("step")) {
+            steps += timer.invocations;
+        }
+    }
+    return steps;
+}
+
+/// Measures how many execution states P4Testgen explores per second. Every step of the symbolic
+/// executor produces the successors of one state, so this is mostly bound by the cost of
+/// creating and cloning states.
+TEST_F(P4TestgenBenchmark, ExploredStatesPerSecond) {
+    const char *programs[] = {
+        "fabric_20190420/fabric.p4",
+        "v1model-special-ops-bmv2.p4",
+        "basic_routing-bmv2.p4",
+        "issue1043-bmv2.p4",
+    };
+    // Collect the step timers.
+    P4Tools::enablePerformanceLogging();
+    for (const auto *program : programs) {
+        auto &testgenOptions = P4Testgen::TestgenOptions::get();
+        testgenOptions.target = "bmv2"_cs;
+        testgenOptions.arch = "v1model"_cs;
+        auto includePath = P4CTestEnvironment::getProjectRoot() / "p4include";
+        testgenOptions.preprocessor_options = "-I" + includePath.string();
+        auto programFile =
+            P4CTestEnvironment::getProjectRoot() / "testdata/p4_16_samples" / program;
+        testgenOptions.file = programFile.string();
+        testgenOptions.testBackend = "PROTOBUF_IR"_cs;
+        testgenOptions.testBaseName = "dummy"_cs;
+        testgenOptions.seed = 1;
+        testgenOptions.minPktSize = 512;
+        testgenOptions.maxPktSize = 512;
+        testgenOptions.pathSelectionPolicy = P4Tools::P4Testgen::PathSelectionPolicy::DepthFirst;
+        testgenOptions.maxTests = 200;
+
+        auto stepsBefore = countSteps();
+        auto start = std::chrono::steady_clock::now();
+        auto testList = P4Testgen::Testgen::generateTests(testgenOptions);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        ASSERT_TRUE(testList.has_value()) << program;
+        auto steps = countSteps() - stepsBefore;
+        printFeature("tools_performance", 4, "%1%: %2% states in %3% s (%4% states/s)", program,
+                     steps, elapsed.count(), static_cast<double>(steps) / elapsed.count());
+    }
+}
+
 }  // namespace P4::P4Tools::Test
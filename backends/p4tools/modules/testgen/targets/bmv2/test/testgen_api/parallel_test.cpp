@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/modules/testgen/options.h"
+#include "backends/p4tools/modules/testgen/targets/bmv2/test/gtest_utils.h"
+#include "backends/p4tools/modules/testgen/testgen.h"
+#include "lib/thread_pool.h"
+
+namespace P4::P4Tools::Test {
+
+using P4TestgenParallel = P4TestgenBranchingTest;
+
+TEST_F(P4TestgenParallel, ExploresAllPaths) {
+    auto &testgenOptions = P4Testgen::TestgenOptions::get();
+    auto serialTests = P4Testgen::Testgen::generateTests(source, testgenOptions);
+    ASSERT_TRUE(serialTests.has_value());
+    ASSERT_GT(serialTests.value().size(), 3U);
+
+    // The workers explore the same paths, in a different order.
+    unsigned concurrency = Util::ThreadPool::concurrency();
+    testgenOptions.parallelWorkers = 4;
+    auto parallelTests = P4Testgen::Testgen::generateTests(source, testgenOptions);
+    testgenOptions.parallelWorkers = 1;
+    ASSERT_TRUE(parallelTests.has_value());
+    // The search leaves the size of the thread pool as it found it.
+    EXPECT_EQ(Util::ThreadPool::concurrency(), concurrency);
+    EXPECT_EQ(getTestTraces(parallelTests.value()), getTestTraces(serialTests.value()));
+
+    // With a limit, the workers stop once enough tests have been generated.
+    testgenOptions.maxTests = 3;
+    testgenOptions.parallelWorkers = 4;
+    parallelTests = P4Testgen::Testgen::generateTests(source, testgenOptions);
+    testgenOptions.parallelWorkers = 1;
+    ASSERT_TRUE(parallelTests.has_value());
+    EXPECT_EQ(parallelTests.value().size(), 3U);
+}
+
+}  // namespace P4::P4Tools::Test
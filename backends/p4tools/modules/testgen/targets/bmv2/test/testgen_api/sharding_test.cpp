@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "backends/p4tools/modules/testgen/options.h"
+#include "backends/p4tools/modules/testgen/targets/bmv2/test/gtest_utils.h"
+#include "backends/p4tools/modules/testgen/testgen.h"
+
+namespace P4::P4Tools::Test {
+
+using P4TestgenSharding = P4TestgenBranchingTest;
+
+TEST_F(P4TestgenSharding, ShardsPartitionThePaths) {
+    auto &testgenOptions = P4Testgen::TestgenOptions::get();
+    auto serialTests = P4Testgen::Testgen::generateTests(source, testgenOptions);
+    ASSERT_TRUE(serialTests.has_value());
+    ASSERT_GT(serialTests.value().size(), 3U);
+    auto serialTraces = getTestTraces(serialTests.value());
+    // Every test exercises a different path.
+    ASSERT_EQ(std::set<std::string>(serialTraces.begin(), serialTraces.end()).size(),
+              serialTraces.size());
+
+    // Every path is explored by exactly one of the shards.
+    for (unsigned shardCount : {2U, 3U, 16U}) {
+        std::multiset<std::string> shardedTraces;
+        testgenOptions.shardCount = shardCount;
+        for (unsigned shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+            testgenOptions.shardIndex = shardIndex;
+            auto shardTests = P4Testgen::Testgen::generateTests(source, testgenOptions);
+            ASSERT_TRUE(shardTests.has_value());
+            auto shardTraces = getTestTraces(shardTests.value());
+            shardedTraces.insert(shardTraces.begin(), shardTraces.end());
+        }
+        EXPECT_EQ(shardedTraces, serialTraces) << shardCount << " shards";
+    }
+}
+
+}  // namespace P4::P4Tools::Test
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/modules/testgen/test/lib/persistent_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "backends/p4tools/common/lib/persistent_map.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+/// Maps all keys to a handful of hashes, so that keys collide in every level of the trie.
+struct CollidingHash {
+    size_t operator()(int key) const { return key % 3; }
+};
+
+/// Checks that @p map holds exactly the entries of @p expected.
+template <class Map>
+void checkEntries(const Map &map, const std::map<int, int> &expected) {
+    ASSERT_EQ(map.size(), expected.size());
+    ASSERT_EQ(map.empty(), expected.empty());
+    for (const auto &[key, value] : expected) {
+        const auto *found = map.find(key);
+        ASSERT_NE(found, nullptr) << "missing key " << key;
+        ASSERT_EQ(*found, value);
+    }
+    std::map<int, int> iterated(map.begin(), map.end());
+    ASSERT_EQ(iterated, expected);
+}
+
+TEST_F(PersistentMapTest, SetFindErase) {
+    PersistentMap<int, int> map;
+    std::map<int, int> expected;
+    checkEntries(map, expected);
+    for (int key = 0; key < 2000; ++key) {
+        ASSERT_TRUE(map.set(key * 7, key));
+        expected[key * 7] = key;
+    }
+    checkEntries(map, expected);
+    ASSERT_EQ(map.find(3), nullptr);
+
+    // Overwriting a key does not change the size.
+    ASSERT_FALSE(map.set(14, -1));
+    expected[14] = -1;
+    checkEntries(map, expected);
+
+    for (int key = 0; key < 2000; key += 2) {
+        ASSERT_TRUE(map.erase(key * 7));
+        expected.erase(key * 7);
+    }
+    ASSERT_FALSE(map.erase(3));
+    checkEntries(map, expected);
+
+    for (int key = 1; key < 2000; key += 2) {
+        ASSERT_TRUE(map.erase(key * 7));
+    }
+    checkEntries(map, {});
+}
+
+TEST_F(PersistentMapTest, CopiesAreIndependent) {
+    PersistentMap<int, int> original;
+    for (int key = 0; key < 100; ++key) {
+        original.set(key, key);
+    }
+    auto copy = original;
+    ASSERT_TRUE(copy == original);
+    copy.set(5, 50);
+    copy.set(1000, 1000);
+    copy.erase(7);
+    ASSERT_FALSE(copy == original);
+
+    std::map<int, int> expected;
+    for (int key = 0; key < 100; ++key) {
+        expected[key] = key;
+    }
+    checkEntries(original, expected);
+    expected[5] = 50;
+    expected[1000] = 1000;
+    expected.erase(7);
+    checkEntries(copy, expected);
+
+    // Maps with the same entries are equal, regardless of how they were built.
+    auto rebuilt = original;
+    rebuilt.set(5, 50);
+    rebuilt.set(1000, 1000);
+    rebuilt.erase(7);
+    ASSERT_TRUE(rebuilt == copy);
+}
+
+TEST_F(PersistentMapTest, HashCollisions) {
+    PersistentMap<int, int, CollidingHash> map;
+    std::map<int, int> expected;
+    for (int key = 0; key < 30; ++key) {
+        map.set(key, -key);
+        expected[key] = -key;
+    }
+    checkEntries(map, expected);
+    auto copy = map;
+    for (int key = 0; key < 30; key += 3) {
+        ASSERT_TRUE(copy.erase(key));
+    }
+    checkEntries(map, expected);
+    for (int key = 0; key < 30; key += 3) {
+        expected.erase(key);
+    }
+    checkEntries(copy, expected);
+}
+
+TEST_F(PersistentMapTest, Set) {
+    PersistentSet<int> set;
+    ASSERT_TRUE(set.insert(1));
+    ASSERT_TRUE(set.insert(2));
+    ASSERT_FALSE(set.insert(1));
+    auto copy = set;
+    ASSERT_TRUE(copy.insert(3));
+    ASSERT_EQ(set.size(), 2U);
+    ASSERT_EQ(copy.count(3), 1U);
+    ASSERT_EQ(set.count(3), 0U);
+    std::set<int> elements(copy.begin(), copy.end());
+    ASSERT_EQ(elements, std::set<int>({1, 2, 3}));
+}
+
+TEST_F(PersistentMapTest, Stack) {
+    PersistentStack<int> stack = {3, 2, 1};
+    ASSERT_EQ(stack.size(), 3U);
+    ASSERT_EQ(stack.top(), 3);
+    auto copy = stack;
+    copy.pop();
+    copy.push(4);
+    ASSERT_EQ(stack.toVector(), std::vector<int>({1, 2, 3}));
+    ASSERT_EQ(copy.toVector(), std::vector<int>({1, 2, 4}));
+    ASSERT_FALSE(copy == stack);
+    copy.pop();
+    copy.push(3);
+    ASSERT_TRUE(copy == stack);
+    copy.clear();
+    ASSERT_TRUE(copy.empty());
+    ASSERT_EQ(copy.size(), 0U);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
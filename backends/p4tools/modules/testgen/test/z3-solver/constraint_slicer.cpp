@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/common/core/constraint_slicer.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "backends/p4tools/common/core/z3_solver.h"
+#include "ir/ir.h"
+#include "lib/cstring.h"
+
+#include "backends/p4tools/modules/testgen/test/z3-solver/accessor.h"
+#include "backends/p4tools/modules/testgen/test/z3-solver/solver_test_utils.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+using namespace P4::literals;
+
+using ConstraintSlicerTest = SolverTest;
+
+TEST_F(ConstraintSlicerTest, Partitions) {
+    ConstraintSlicer slicer;
+    auto partitions = slicer.partition({fooIsFive, ground, barIsSmall, bazIsLarge});
+    ASSERT_EQ(partitions.size(), 4U);
+    // The partition of the last constraint comes first, the others keep their order.
+    EXPECT_EQ(partitions[0].constraints, std::vector<const Constraint *>{bazIsLarge});
+    EXPECT_EQ(partitions[1].constraints, std::vector<const Constraint *>{fooIsFive});
+    EXPECT_EQ(partitions[2].constraints, std::vector<const Constraint *>{ground});
+    EXPECT_TRUE(partitions[2].variables.empty());
+    EXPECT_EQ(partitions[3].constraints, std::vector<const Constraint *>{barIsSmall});
+
+    // foo + bar == 6 connects the partitions of foo and bar.
+    partitions = slicer.partition({fooIsFive, bazIsLarge, barIsSmall, sumIsSix});
+    ASSERT_EQ(partitions.size(), 2U);
+    EXPECT_EQ(partitions[0].constraints,
+              (std::vector<const Constraint *>{fooIsFive, barIsSmall, sumIsSix}));
+    EXPECT_EQ(partitions[0].variables.size(), 2U);
+    EXPECT_EQ(partitions[0].variables.count("foo"_cs), 1U);
+    EXPECT_EQ(partitions[0].variables.count("bar"_cs), 1U);
+    EXPECT_EQ(partitions[1].constraints, std::vector<const Constraint *>{bazIsLarge});
+}
+
+TEST_F(ConstraintSlicerTest, SlicedSolverQueries) {
+    Z3Solver solver;
+    EXPECT_EQ(solver.checkSat({fooIsFive, bazIsLarge}), true);
+    EXPECT_EQ(solver.checkSat({fooIsFive, bazIsLarge, barIsSmall, sumIsSix}), true);
+
+    // The partitions were answered without extracting their models, so the model of the query
+    // comes from Z3.
+    const auto &mapping = solver.getSymbolicMapping();
+    EXPECT_EQ(valueOf(mapping, fooVar), 5);
+    EXPECT_EQ(valueOf(mapping, barVar), 1);
+    EXPECT_GT(valueOf(mapping, bazVar), 200);
+
+    // One unsatisfiable partition makes the query unsatisfiable.
+    const auto *bazIsSmall = new IR::Lss(bazVar, IR::Constant::get(eightBitType, 3));
+    EXPECT_EQ(solver.checkSat({fooIsFive, bazIsLarge, barIsSmall, bazIsSmall}), false);
+}
+
+TEST_F(ConstraintSlicerTest, NoSlicingWithoutCache) {
+    // Without the query cache every partition would be a separate Z3 query, so the solver asks
+    // Z3 about the whole query instead.
+    Z3Solver solver;
+    solver.enableQueryCache(false);
+    std::vector<const Constraint *> query = {fooIsFive, bazIsLarge, barIsSmall};
+    EXPECT_EQ(solver.checkSat(query), true);
+    Z3SolverAccessor accessor(solver);
+    EXPECT_EQ(accessor.getP4Assertions().size(), query.size());
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
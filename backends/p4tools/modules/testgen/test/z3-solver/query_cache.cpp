@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "backends/p4tools/common/core/query_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <vector>
+
+#include "backends/p4tools/common/core/z3_solver.h"
+#include "ir/ir.h"
+#include "ir/solver.h"
+
+#include "backends/p4tools/modules/testgen/test/z3-solver/solver_test_utils.h"
+
+namespace P4::P4Tools::Test {
+
+namespace {
+
+class QueryCacheTest : public SolverTest {
+ protected:
+    /// A model of foo == 5 and bar < 3.
+    const SymbolicMapping *model() const {
+        auto *model = new SymbolicMapping();
+        model->emplace(fooVar, IR::Constant::get(eightBitType, 5));
+        model->emplace(barVar, IR::Constant::get(eightBitType, 1));
+        return model;
+    }
+};
+
+TEST_F(QueryCacheTest, ExactMatch) {
+    QueryCache cache;
+    auto query = cache.normalize({fooIsFive, barIsSmall});
+    EXPECT_FALSE(cache.lookup(query).has_value());
+    const auto *fooBarModel = model();
+    cache.insert(query, {true, fooBarModel});
+
+    // Order, duplicates and structurally equal copies of a constraint do not matter.
+    const auto *fooIsFiveCopy = new IR::Equ(fooVar, IR::Constant::get(eightBitType, 5));
+    auto result = cache.lookup(cache.normalize({barIsSmall, fooIsFiveCopy, fooIsFive}));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->isSat);
+    EXPECT_EQ(result->model, fooBarModel);
+}
+
+TEST_F(QueryCacheTest, SubsetsAndSupersets) {
+    QueryCache cache;
+    cache.insert(cache.normalize({fooIsFive, barIsSmall}), {true, model()});
+    cache.insert(cache.normalize({fooIsFive, fooIsNotFive}), {false, nullptr});
+
+    // A subset of a satisfiable query is satisfiable.
+    auto result = cache.lookup(cache.normalize({barIsSmall}));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->isSat);
+
+    // A superset of an unsatisfiable query is unsatisfiable.
+    result = cache.lookup(cache.normalize({barIsSmall, fooIsNotFive, sumIsLarge, fooIsFive}));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_FALSE(result->isSat);
+}
+
+TEST_F(QueryCacheTest, ModelReuse) {
+    QueryCache cache;
+    cache.insert(cache.normalize({fooIsFive, barIsSmall}), {true, model()});
+
+    // foo + bar == 6 in the cached model.
+    auto result = cache.lookup(cache.normalize({fooIsFive, barIsSmall, sumIsLarge}));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->isSat);
+
+    // The model does not satisfy foo != 5, which may still be satisfiable.
+    EXPECT_FALSE(cache.lookup(cache.normalize({barIsSmall, fooIsNotFive})).has_value());
+
+    // The model does not bind baz.
+    const Constraint *bazIsOne = new IR::Equ(bazVar, IR::Constant::get(eightBitType, 1));
+    EXPECT_FALSE(cache.lookup(cache.normalize({bazIsOne})).has_value());
+}
+
+TEST_F(QueryCacheTest, ModelsAddedLater) {
+    QueryCache cache;
+    auto query = cache.normalize({fooIsFive, barIsSmall});
+    cache.insert(query, {true, nullptr});
+
+    // Without a model, the entry answers its subsets, but it can not be reused for other queries.
+    auto result = cache.lookup(cache.normalize({barIsSmall}));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->isSat);
+    EXPECT_EQ(result->model, nullptr);
+    auto larger = cache.normalize({fooIsFive, barIsSmall, sumIsLarge});
+    EXPECT_FALSE(cache.lookup(larger).has_value());
+
+    const auto *fooBarModel = model();
+    cache.setModel(query, fooBarModel);
+    EXPECT_EQ(cache.lookup(query)->model, fooBarModel);
+    result = cache.lookup(larger);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->isSat);
+}
+
+TEST_F(QueryCacheTest, Clear) {
+    QueryCache cache;
+    auto query = cache.normalize({fooIsFive, barIsSmall});
+    cache.insert(query, {true, model()});
+    const auto *fooIsFiveCopy = new IR::Equ(fooVar, IR::Constant::get(eightBitType, 5));
+    EXPECT_EQ(cache.normalize({fooIsFiveCopy}), QueryCache::Query{fooIsFive});
+
+    // Clearing the cache also forgets the representatives of the constraints.
+    cache.clear();
+    EXPECT_FALSE(cache.lookup(query).has_value());
+    EXPECT_EQ(cache.normalize({fooIsFiveCopy}), QueryCache::Query{fooIsFiveCopy});
+}
+
+TEST_F(QueryCacheTest, SolverAgreesWithoutCache) {
+    Z3Solver cachedSolver;
+    Z3Solver uncachedSolver;
+    uncachedSolver.enableQueryCache(false);
+    const std::vector<std::vector<const Constraint *>> queries = {
+        {fooIsFive},
+        {fooIsFive, barIsSmall},
+        {fooIsFive, barIsSmall, sumIsLarge},
+        {fooIsFive, fooIsNotFive},
+        {barIsSmall},
+        {fooIsFive, fooIsNotFive, barIsSmall},
+        {fooIsFive, barIsSmall},
+    };
+    for (const auto &query : queries) {
+        auto expected = uncachedSolver.checkSat(query);
+        EXPECT_EQ(cachedSolver.checkSat(query), expected);
+        if (expected != true) {
+            continue;
+        }
+        // The model of the cached solver must satisfy the query, too.
+        const auto &mapping = cachedSolver.getSymbolicMapping();
+        for (const auto *constraint : query) {
+            if (constraint == fooIsFive) {
+                EXPECT_EQ(valueOf(mapping, fooVar), 5);
+            } else if (constraint == barIsSmall) {
+                EXPECT_LT(valueOf(mapping, barVar), 3);
+            } else if (constraint == sumIsLarge) {
+                EXPECT_GT((valueOf(mapping, fooVar) + valueOf(mapping, barVar)) % 256, 4);
+            }
+        }
+    }
+}
+
+TEST_F(QueryCacheTest, SolverExtractsModelsOnDemand) {
+    Z3Solver solver;
+    ASSERT_EQ(solver.checkSat({fooIsFive, barIsSmall}), true);
+    // The cache answers the subset without a model, so Z3 is asked for one.
+    ASSERT_EQ(solver.checkSat({barIsSmall}), true);
+    const auto &mapping = solver.getSymbolicMapping();
+    EXPECT_LT(valueOf(mapping, barVar), 3);
+    EXPECT_EQ(&solver.getSymbolicMapping(), &mapping);
+
+    // The extracted model is cached with the query.
+    ASSERT_EQ(solver.checkSat({barIsSmall}), true);
+    EXPECT_EQ(&solver.getSymbolicMapping(), &mapping);
+}
+
+}  // namespace
+
+}  // namespace P4::P4Tools::Test
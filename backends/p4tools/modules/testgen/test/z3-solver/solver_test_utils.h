@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef BACKENDS_P4TOOLS_MODULES_TESTGEN_TEST_Z3_SOLVER_SOLVER_TEST_UTILS_H_
+#define BACKENDS_P4TOOLS_MODULES_TESTGEN_TEST_Z3_SOLVER_SOLVER_TEST_UTILS_H_
+
+#include <gtest/gtest.h>
+
+#include "backends/p4tools/common/lib/variables.h"
+#include "ir/ir.h"
+#include "ir/solver.h"
+#include "lib/big_int.h"
+#include "lib/cstring.h"
+
+namespace P4::P4Tools::Test {
+
+/// Constraints over the eight-bit symbolic variables foo, bar and baz, shared by the tests of the
+/// query cache and the constraint slicer.
+class SolverTest : public testing::Test {
+ protected:
+    const IR::Type_Bits *eightBitType = IR::Type_Bits::get(8);
+    const IR::SymbolicVariable *fooVar =
+        ToolsVariables::getSymbolicVariable(eightBitType, cstring("foo"));
+    const IR::SymbolicVariable *barVar =
+        ToolsVariables::getSymbolicVariable(eightBitType, cstring("bar"));
+    const IR::SymbolicVariable *bazVar =
+        ToolsVariables::getSymbolicVariable(eightBitType, cstring("baz"));
+
+    /// foo == 5
+    const Constraint *fooIsFive = new IR::Equ(fooVar, IR::Constant::get(eightBitType, 5));
+    /// foo != 5
+    const Constraint *fooIsNotFive = new IR::Neq(fooVar, IR::Constant::get(eightBitType, 5));
+    /// bar < 3
+    const Constraint *barIsSmall = new IR::Lss(barVar, IR::Constant::get(eightBitType, 3));
+    /// baz > 200
+    const Constraint *bazIsLarge = new IR::Grt(bazVar, IR::Constant::get(eightBitType, 200));
+    /// foo + bar > 4
+    const Constraint *sumIsLarge = new IR::Grt(new IR::Add(eightBitType, fooVar, barVar),
+                                               IR::Constant::get(eightBitType, 4));
+    /// foo + bar == 6
+    const Constraint *sumIsSix = new IR::Equ(new IR::Add(eightBitType, fooVar, barVar),
+                                             IR::Constant::get(eightBitType, 6));
+    /// 1 == 1
+    const Constraint *ground =
+        new IR::Equ(IR::Constant::get(eightBitType, 1), IR::Constant::get(eightBitType, 1));
+
+    /// @returns the value that @param model assigns to @param var. Fails the test and returns -1
+    /// if the model does not bind the variable.
+    static big_int valueOf(const SymbolicMapping &model, const IR::SymbolicVariable *var) {
+        auto it = model.find(var);
+        if (it == model.end()) {
+            ADD_FAILURE() << "The model does not bind " << var->label;
+            return big_int(-1);
+        }
+        return it->second->checkedTo<IR::Constant>()->value;
+    }
+};
+
+}  // namespace P4::P4Tools::Test
+
+#endif /* BACKENDS_P4TOOLS_MODULES_TESTGEN_TEST_Z3_SOLVER_SOLVER_TEST_UTILS_H_ */
@@ -7,6 +7,8 @@
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <fstream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -17,14 +19,18 @@
 #include "ir/solver.h"
 #include "lib/cstring.h"
 #include "lib/error.h"
+#include "lib/json.h"
+#include "midend/coverage.h"
 
 #include "backends/p4tools/modules/testgen/core/compiler_result.h"
 #include "backends/p4tools/modules/testgen/core/program_info.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/depth_first.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/greedy_node_cov.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/parallel_search.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/path_selection.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/random_backtrack.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/selected_branches.h"
+#include "backends/p4tools/modules/testgen/core/symbolic_executor/sharded_search.h"
 #include "backends/p4tools/modules/testgen/core/symbolic_executor/symbolic_executor.h"
 #include "backends/p4tools/modules/testgen/core/target.h"
 #include "backends/p4tools/modules/testgen/lib/test_backend.h"
@@ -37,9 +43,9 @@ namespace P4::P4Tools::P4Testgen {
 
 namespace {
 
-/// Pick the path selection algorithm for the symbolic executor.
-SymbolicExecutor *pickExecutionEngine(const TestgenOptions &testgenOptions,
-                                      const ProgramInfo &programInfo, AbstractSolver &solver) {
+/// Pick the path selection algorithm for a single symbolic executor.
+SymbolicExecutor *pickPathSelection(const TestgenOptions &testgenOptions,
+                                    const ProgramInfo &programInfo, AbstractSolver &solver) {
     const auto &pathSelectionPolicy = testgenOptions.pathSelectionPolicy;
     if (pathSelectionPolicy == PathSelectionPolicy::GreedyStmtCoverage) {
         return new GreedyNodeSelection(solver, programInfo);
@@ -54,6 +60,65 @@ SymbolicExecutor *pickExecutionEngine(const TestgenOptions &testgenOptions,
     return new DepthFirstSearch(solver, programInfo);
 }
 
+/// Pick the symbolic executor. With more than one worker, each of the workers of the parallel
+/// search uses the selected path selection algorithm with its own Z3 solver. With more than one
+/// shard, the executor only explores the shard of this process.
+SymbolicExecutor *pickExecutionEngine(const TestgenOptions &testgenOptions,
+                                      const ProgramInfo &programInfo, AbstractSolver &solver) {
+    SymbolicExecutor *explorer = nullptr;
+    if (testgenOptions.parallelWorkers > 1) {
+        explorer = new ParallelSearch(
+            solver, programInfo, testgenOptions.parallelWorkers,
+            [&testgenOptions] {
+                auto workerSolver = std::make_unique<Z3Solver>();
+                workerSolver->enableQueryCache(testgenOptions.useSolverCache);
+                workerSolver->enableConstraintSlicing(testgenOptions.useConstraintSlicing);
+                return workerSolver;
+            },
+            [&testgenOptions, &programInfo](AbstractSolver &workerSolver) {
+                return pickPathSelection(testgenOptions, programInfo, workerSolver);
+            });
+    } else {
+        explorer = pickPathSelection(testgenOptions, programInfo, solver);
+    }
+    if (testgenOptions.shardCount > 1) {
+        return new ShardedSearch(solver, programInfo, testgenOptions.shardIndex,
+                                 testgenOptions.shardCount, *explorer);
+    }
+    return explorer;
+}
+
+/// Writes the coverable and the covered nodes of the program to @param reportPath, so that the
+/// coverage of several P4Testgen runs can be combined. Nodes are identified by their source
+/// position, in the form "file:line:column".
+void writeCoverageReport(const std::filesystem::path &reportPath,
+                         const P4::Coverage::CoverageSet &coverableNodes,
+                         const P4::Coverage::CoverageSet &visitedNodes) {
+    using namespace P4::literals;
+
+    auto toJson = [](const P4::Coverage::CoverageSet &nodes) {
+        auto *positions = new Util::JsonArray();
+        for (const auto *node : nodes) {
+            unsigned line = 0;
+            unsigned column = 0;
+            auto file = node->getSourceInfo().toSourcePositionData(&line, &column);
+            positions->append(
+                cstring(file + ":" + std::to_string(line) + ":" + std::to_string(column)));
+        }
+        return positions;
+    };
+    Util::JsonObject report;
+    report.emplace("coverable"_cs, toJson(coverableNodes));
+    report.emplace("covered"_cs, toJson(visitedNodes));
+    std::ofstream out(reportPath);
+    if (!out) {
+        error("Unable to write the coverage report %1%.", reportPath.c_str());
+        return;
+    }
+    report.serialize(out);
+    out << std::endl;
+}
+
 /// Analyse the results of the symbolic execution and generate diagnostic messages.
 int postProcess(const TestgenOptions &testgenOptions, const TestBackEnd &testBackend) {
     // Do not print this warning if assertion mode is enabled.
@@ -85,6 +150,8 @@ std::optional<AbstractTestList> generateAndCollectAbstractTests(
                                                       testgenOptions.seed};
     // Need to declare the solver here to ensure its lifetime.
     Z3Solver solver;
+    solver.enableQueryCache(testgenOptions.useSolverCache);
+    solver.enableConstraintSlicing(testgenOptions.useConstraintSlicing);
     auto *symbolicExecutor = pickExecutionEngine(testgenOptions, programInfo, solver);
 
     // Each test back end has a different run function.
@@ -115,9 +182,16 @@ int generateAndWriteAbstractTests(const TestgenOptions &testgenOptions,
         error("Neither a file nor test base name was set. Can not infer a test name.");
     }
 
+    // Every shard writes its tests to a directory of its own.
+    auto outputDir = testgenOptions.outputDir;
+    if (testgenOptions.shardCount > 1) {
+        outputDir =
+            outputDir.value_or(".") / ("shard-" + std::to_string(testgenOptions.shardIndex));
+    }
+
     // Create the directory, if the directory string is valid and if it does not exist.
-    if (testgenOptions.outputDir.has_value()) {
-        auto testDir = testgenOptions.outputDir.value();
+    if (outputDir.has_value()) {
+        auto testDir = outputDir.value();
         try {
             std::filesystem::create_directories(testDir);
         } catch (const std::exception &err) {
@@ -133,6 +207,8 @@ int generateAndWriteAbstractTests(const TestgenOptions &testgenOptions,
 
     // Need to declare the solver here to ensure its lifetime.
     Z3Solver solver;
+    solver.enableQueryCache(testgenOptions.useSolverCache);
+    solver.enableConstraintSlicing(testgenOptions.useConstraintSlicing);
     auto *symbolicExecutor = pickExecutionEngine(testgenOptions, programInfo, solver);
 
     // Each test back end has a different run function.
@@ -144,6 +220,13 @@ int generateAndWriteAbstractTests(const TestgenOptions &testgenOptions,
     symbolicExecutor->run([testBackend](auto &&finalState) {
         return testBackend->run(std::forward<decltype(finalState)>(finalState));
     });
+    // Shards write the coverage they achieved, which merge_shards.py combines.
+    if (testgenOptions.hasCoverageTracking && testgenOptions.shardCount > 1) {
+        auto reportPath = testPath;
+        reportPath += "_coverage.json";
+        writeCoverageReport(reportPath, programInfo.getCoverableNodes(),
+                            symbolicExecutor->getVisitedNodes());
+    }
     return postProcess(testgenOptions, *testBackend);
 }
 
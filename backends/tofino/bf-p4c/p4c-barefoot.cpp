@@ -420,7 +420,7 @@ int main(int ac, char **av) {
     // initialize the Barefoot specific error types
     BFN::ErrorType::getErrorTypes();
 
-    AutoCompileContext autoBFNContext(new BFNContext);
+    AutoCompileContext autoBFNContext(new BFNContext, /* useArena */ true);
     auto &options = BackendOptions();
 
     if (!options.process(ac, av) || ::errorCount() > 0)
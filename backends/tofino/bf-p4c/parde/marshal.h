@@ -46,6 +46,9 @@ struct MarshaledFrom {
         return gress == other.gress && field_name == other.field_name &&
                pre_padding == other.pre_padding;
     }
+    friend size_t hash_value(const MarshaledFrom &m) {
+        return Util::Hash{}(static_cast<int>(m.gress), m.field_name, m.pre_padding);
+    }
 
     /// JSON serialization/deserialization.
     void toJSON(JSONGenerator &json) const;
@@ -33,6 +33,7 @@ class MatchRegisterSpec {
     cstring toString() const;
 
     bool operator==(const MatchRegisterSpec &other) const { return name == other.name; }
+    friend size_t hash_value(const MatchRegisterSpec &r) { return Util::Hash{}(r.name); }
 
     cstring name;
     size_t size;
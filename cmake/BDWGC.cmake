@@ -12,7 +12,6 @@ macro(p4c_obtain_bdwgc)
   set(HAVE_LIBGC 1)
 
   if(P4C_USE_PREINSTALLED_BDWGC)
-    option(ENABLE_MULTITHREAD "Use multithreading" OFF)
     find_package(LibGc 7.2.0 REQUIRED)
     # Some distros ship libgc/libcord without libgctba; only add it if present.
     find_library(LIBGC_GCTBA_LIBRARY NAMES gctba)
@@ -16,6 +16,9 @@
 /* Define to 1 if you have the LIBGC library. */
 #cmakedefine HAVE_LIBGC 1
 
+/* Define to 1 to allocate IR nodes in per-compilation arenas. */
+#cmakedefine HAVE_IR_ARENA 1
+
 /* Define to 1 if you have the GMP library. */
 #cmakedefine HAVE_LIBGMP 1
 
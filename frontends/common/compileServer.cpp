@@ -0,0 +1,416 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/compileServer.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+#include "frontends/common/parser_options.h"
+#include "frontends/common/precompiledHeader.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+#include "lib/log.h"
+
+namespace P4 {
+
+namespace {
+
+// A request is the size of the rest of the request, sent together with the client's
+// standard input, output and error, then the working directory and the command line, each
+// as a size and the characters.  A request without a command line asks the server to stop.
+// The reply is the exit status.
+
+constexpr uint32_t maxRequestSize = 1 << 24;
+
+/// How long a worker waits for the rest of a request once the client connected.
+constexpr time_t requestTimeout = 10;
+
+volatile sig_atomic_t stopRequested = 0;
+void requestStop(int) { stopRequested = 1; }
+
+/// The handlers and signal mask the server replaces while it runs, restored in the
+/// compilations.
+struct sigaction savedSigint, savedSigterm;
+sigset_t savedMask;
+
+bool sendAll(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool receiveAll(int fd, void *data, size_t size) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t n = recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool socketAddress(const std::filesystem::path &socket, sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket.native().size() >= sizeof(address.sun_path)) return false;
+    strcpy(address.sun_path, socket.c_str());
+    return true;
+}
+
+int connectTo(const std::filesystem::path &socket) {
+    sockaddr_un address;
+    if (!socketAddress(socket, address)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Send a request made of @p strings and the files @p fds, and wait for the reply.
+std::optional<int> request(const std::filesystem::path &socket,
+                           const std::vector<std::string> &strings, const int (&fds)[3]) {
+    std::string payload;
+    for (const auto &string : strings) {
+        uint32_t size = string.size();
+        payload.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        payload += string;
+    }
+    if (payload.size() > maxRequestSize) return std::nullopt;
+    int fd = connectTo(socket);
+    if (fd < 0) return std::nullopt;
+
+    uint32_t size = payload.size();
+    iovec iov = {&size, sizeof(size)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *files = CMSG_FIRSTHDR(&message);
+    files->cmsg_level = SOL_SOCKET;
+    files->cmsg_type = SCM_RIGHTS;
+    files->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(files), fds, sizeof(fds));
+
+    std::optional<int> rv;
+    int32_t status;
+    if (sendmsg(fd, &message, MSG_NOSIGNAL) == sizeof(size) &&
+        sendAll(fd, payload.data(), payload.size()) && receiveAll(fd, &status, sizeof(status)))
+        rv = status;
+    close(fd);
+    return rv;
+}
+
+/// Receive a request from @p client.  @return false if it is not a valid request.
+bool receiveRequest(int client, std::vector<std::string> &strings, int (&fds)[3]) {
+    uint32_t size;
+    iovec iov = {&size, sizeof(size)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    msghdr message = {};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(client, &message, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    int received = 0;
+    cmsghdr *files = n > 0 ? CMSG_FIRSTHDR(&message) : nullptr;
+    if (files && files->cmsg_level == SOL_SOCKET && files->cmsg_type == SCM_RIGHTS) {
+        received = (files->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(fds, CMSG_DATA(files), std::min<size_t>(received, 3) * sizeof(int));
+    }
+    bool ok = n == sizeof(size) && received == 3 && size <= maxRequestSize;
+    std::string payload(ok ? size : 0, '\0');
+    ok = ok && receiveAll(client, payload.data(), payload.size());
+    for (size_t pos = 0; ok && pos < payload.size();) {
+        uint32_t length;
+        ok = payload.size() - pos >= sizeof(length);
+        if (!ok) break;
+        memcpy(&length, payload.data() + pos, sizeof(length));
+        pos += sizeof(length);
+        ok = payload.size() - pos >= length;
+        if (ok) strings.emplace_back(payload, pos, length);
+        pos += length;
+    }
+    ok = ok && !strings.empty();
+    if (!ok)
+        for (int i = 0; i < std::min(received, 3); ++i) close(fds[i]);
+    return ok;
+}
+
+void waitForWorker(int options) {
+    int status;
+    while (waitpid(-1, &status, options) < 0 && errno == EINTR) {
+    }
+}
+
+}  // namespace
+
+std::optional<CompileServer::Options> CompileServer::parseCommandLine(int argc,
+                                                                       char *const argv[]) {
+    if (std::none_of(argv + 1, argv + argc, [](const char *a) { return !strcmp(a, "--server"); }))
+        return std::nullopt;
+    Options options;
+    options.workers = std::max(1U, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        char *end = nullptr;
+        if (arg == "--server" && i + 1 < argc) {
+            options.socket = argv[++i];
+        } else if (arg == "--server-cache" && i + 1 < argc) {
+            options.headerCache = argv[++i];
+        } else if (arg == "--server-workers" && i + 1 < argc &&
+                   (options.workers = strtoul(argv[++i], &end, 10)) > 0 && *end == 0) {
+            continue;
+        } else {
+            std::cerr << argv[0] << ": unexpected argument " << argv[i] << "\nUsage: " << argv[0]
+                      << " --server socket [--server-workers n] [--server-cache directory]"
+                      << std::endl;
+            options.socket.clear();
+            break;
+        }
+    }
+    return options;
+}
+
+CompileServer::CompileServer(Options options) : options(std::move(options)) {
+    if (this->options.headerCache.empty()) {
+        this->options.headerCache = this->options.socket;
+        this->options.headerCache += ".pch";
+    }
+}
+
+bool CompileServer::listen() {
+    sockaddr_un address;
+    if (!socketAddress(options.socket, address)) {
+        ::P4::error(ErrorType::ERR_INVALID, "%1%: socket name too long", options.socket);
+        return false;
+    }
+    std::error_code ec;
+    if (std::filesystem::is_socket(options.socket, ec)) {
+        if (int fd = connectTo(options.socket); fd >= 0) {
+            close(fd);
+            ::P4::error(ErrorType::ERR_INVALID, "%1%: a server is already listening",
+                        options.socket);
+            return false;
+        }
+        // left by a server that did not stop cleanly
+        std::filesystem::remove(options.socket, ec);
+    }
+    // Only the user running the server may connect, as a compilation can read and write any
+    // file the server can.  The umask keeps others out from the moment the socket is bound;
+    // its mode is set too, in case the umask is not applied to sockets.  Clients of other
+    // users are also rejected when they connect (see run).
+    listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    mode_t savedUmask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    bool bound = listener >= 0 &&
+                 bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    umask(savedUmask);
+    if (!bound || chmod(options.socket.c_str(), S_IRUSR | S_IWUSR) ||
+        ::listen(listener, SOMAXCONN)) {
+        ::P4::error(ErrorType::ERR_IO, "%1%: %2%", options.socket, strerror(errno));
+        if (listener >= 0) close(listener);
+        listener = -1;
+        return false;
+    }
+    return true;
+}
+
+int CompileServer::run(const Compile &compile) {
+    if (options.socket.empty()) return 1;
+    // for reporting errors and loading precompiled headers
+    AutoCompileContext serverContext(new P4CContextWithOptions<ParserOptions>);
+    std::error_code ec;
+    std::filesystem::create_directories(options.headerCache, ec);
+    if (ec) {
+        ::P4::error(ErrorType::ERR_IO, "%1%: %2%", options.headerCache, ec.message());
+        return 1;
+    }
+    if (!listen()) return 1;
+    LOG1("Compile server listening on " << options.socket << " with " << options.workers
+                                        << " workers");
+
+    // The signals which stop the server are only unblocked while waiting for a client, so
+    // that they cannot arrive between checking stopRequested and waiting.
+    struct sigaction stop = {};
+    stop.sa_handler = requestStop;
+    sigemptyset(&stop.sa_mask);
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    stopRequested = 0;
+    sigprocmask(SIG_BLOCK, &stopSignals, &savedMask);
+    sigaction(SIGINT, &stop, &savedSigint);
+    sigaction(SIGTERM, &stop, &savedSigterm);
+
+    while (!stopRequested) {
+        for (; running >= options.workers; --running) waitForWorker(0);
+        for (int status; running > 0 && waitpid(-1, &status, WNOHANG) > 0;) --running;
+        pollfd ready = {listener, POLLIN, 0};
+        if (ppoll(&ready, 1, nullptr, &savedMask) < 0 && errno == EINTR) continue;
+        int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EAGAIN || errno == EINTR || errno == ECONNABORTED) continue;
+            ::P4::error(ErrorType::ERR_IO, "%1%: %2%", options.socket, strerror(errno));
+            break;
+        }
+        ucred peer = {};
+        socklen_t peerSize = sizeof(peer);
+        if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &peerSize) < 0 ||
+            peer.uid != geteuid()) {
+            LOG1("Compile server: rejected a client of user " << peer.uid);
+            close(client);
+            continue;
+        }
+        serve(client, compile);
+    }
+
+    LOG1("Compile server stopping");
+    for (; running > 0; --running) waitForWorker(0);
+    close(listener);
+    listener = -1;
+    std::filesystem::remove(options.socket, ec);
+    sigaction(SIGINT, &savedSigint, nullptr);
+    sigaction(SIGTERM, &savedSigterm, nullptr);
+    sigprocmask(SIG_SETMASK, &savedMask, nullptr);
+    return ::P4::errorCount() > 0;
+}
+
+void CompileServer::serve(int client, const Compile &compile) {
+    if (size_t loaded = preloadPrecompiledHeaders(options.headerCache))
+        LOG1("Compile server: loaded " << loaded << " precompiled headers");
+    // don't let the processes forked write what is buffered again
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(nullptr);
+
+    pid_t worker = fork();
+    if (worker < 0) {
+        ::P4::error(ErrorType::ERR_IO, "fork: %1%", strerror(errno));
+    } else if (worker == 0) {
+        // The worker reads the request, so that a slow client does not hold up the others,
+        // then runs the compilation in another process, so that it can report how that
+        // ended, even if it crashes.
+        close(listener);
+        timeval timeout = {requestTimeout, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        std::vector<std::string> request;
+        int fds[3];
+        if (!receiveRequest(client, request, fds)) {
+            LOG1("Compile server: invalid request");
+            _exit(1);
+        }
+        int32_t rv = 1;
+        if (request.size() == 1) {
+            // The server stops as it would on SIGTERM, so the signal is pending before the
+            // client gets the reply.
+            for (int fd : fds) close(fd);
+            kill(getppid(), SIGTERM);
+            rv = 0;
+            sendAll(client, &rv, sizeof(rv));
+            _exit(0);
+        }
+        LOG2("Compile server: compiling in " << request[0]);
+        pid_t compilation = fork();
+        if (compilation == 0) {
+            close(client);
+            sigaction(SIGINT, &savedSigint, nullptr);
+            sigaction(SIGTERM, &savedSigterm, nullptr);
+            sigprocmask(SIG_SETMASK, &savedMask, nullptr);
+            for (int i = 0; i < 3; ++i) dup2(fds[i], i);
+            for (int fd : fds) close(fd);
+            if (chdir(request[0].c_str()) < 0) {
+                std::cerr << request[0] << ": " << strerror(errno) << std::endl;
+                _exit(1);
+            }
+            std::vector<std::string> args = {request[1], "--builtin-cpp", "--precompiled-header",
+                                             options.headerCache.string()};
+            args.insert(args.end(), request.begin() + 2, request.end());
+            std::vector<char *> argv;
+            for (auto &arg : args) argv.push_back(arg.data());
+            argv.push_back(nullptr);
+            int rv = compile(args.size(), argv.data());
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(nullptr);
+            _exit(rv);
+        }
+        for (int fd : fds) close(fd);
+        int status;
+        if (compilation > 0) {
+            while (waitpid(compilation, &status, 0) < 0 && errno == EINTR) {
+            }
+            rv = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+        }
+        sendAll(client, &rv, sizeof(rv));
+        _exit(0);
+    } else {
+        ++running;
+    }
+    close(client);
+}
+
+std::optional<int> compileOnServer(const std::filesystem::path &socket,
+                                   const std::vector<std::string> &args, int in, int out,
+                                   int err) {
+    if (args.empty()) return std::nullopt;
+    std::error_code ec;
+    std::vector<std::string> strings = {std::filesystem::current_path(ec).string()};
+    strings.insert(strings.end(), args.begin(), args.end());
+    return request(socket, strings, {in, out, err});
+}
+
+std::optional<int> compileAsClient(int argc, char *const argv[]) {
+    std::vector<std::string> args;
+    std::filesystem::path socket;
+    for (int i = 0; i < argc; ++i) {
+        if (!strcmp(argv[i], "--client") && i + 1 < argc)
+            socket = argv[++i];
+        else
+            args.push_back(argv[i]);
+    }
+    if (socket.empty()) return std::nullopt;
+    if (auto status = compileOnServer(socket, args)) return status;
+    std::cerr << argv[0] << ": no compile server listening on " << socket << std::endl;
+    return 1;
+}
+
+bool stopCompileServer(const std::filesystem::path &socket) {
+    std::error_code ec;
+    return request(socket, {std::filesystem::current_path(ec).string()}, {0, 1, 2}).has_value();
+}
+
+}  // namespace P4
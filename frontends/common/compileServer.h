@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FRONTENDS_COMMON_COMPILESERVER_H_
+#define FRONTENDS_COMMON_COMPILESERVER_H_
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace P4 {
+
+/**
+ * A long-lived compiler process which runs compilations for clients connecting to a
+ * local UNIX socket, so that they do not each pay for starting the compiler and parsing
+ * the headers their programs include.
+ *
+ * A client sends its working directory, its command line and its standard input, output
+ * and error (see compileOnServer and compileAsClient).  Only clients of the user running
+ * the server may connect.  The server forks a process for each client, which reads the
+ * request, runs the compiler's entry point with that command line in the client's directory
+ * and files, and sends the exit status back.  Forking isolates the compilations from each
+ * other and from the server: each one starts with its own copy of the server's state,
+ * pushes its own compile context and can change any global state (such as the logging
+ * options) without affecting the others.  At most `workers` compilations run at once.
+ *
+ * Compilations use the builtin preprocessor and precompiled headers (see
+ * parseWithPrecompiledHeader) kept in a cache directory, one for each set of headers.
+ * Before forking, the server loads the headers added to the cache since the last request,
+ * so that later compilations find the headers they include already parsed in memory.
+ */
+class CompileServer {
+ public:
+    struct Options {
+        /// The UNIX socket to listen on.
+        std::filesystem::path socket;
+        /// The maximum number of compilations to run at once.
+        unsigned workers = 1;
+        /// The directory of precompiled headers; the socket name with `.pch` appended if
+        /// empty.
+        std::filesystem::path headerCache;
+    };
+
+    /// The compiler's entry point: compile with the given command line and return the exit
+    /// status.
+    using Compile = std::function<int(int argc, char *const argv[])>;
+
+    /// @return std::nullopt if the command line does not ask for a server, i.e. does not
+    /// have a `--server socket` option.  Otherwise it may only have the options
+    /// `--server-workers n` and `--server-cache directory`; if it has any other argument,
+    /// an error is printed and the options returned have an empty socket.
+    static std::optional<Options> parseCommandLine(int argc, char *const argv[]);
+
+    explicit CompileServer(Options options);
+
+    /// Serve requests with @p compile until a client asks the server to stop (see
+    /// stopCompileServer) or it gets SIGINT or SIGTERM, then wait for the compilations
+    /// in progress.
+    /// @return the exit status for the server process.
+    int run(const Compile &compile);
+
+ private:
+    Options options;
+    int listener = -1;
+    unsigned running = 0;
+
+    bool listen();
+    void serve(int client, const Compile &compile);
+};
+
+/// Compile with the command line @p args (starting with the program name) on the server
+/// listening on @p socket, in the current working directory, with @p in, @p out and
+/// @p err as standard input, output and error.
+/// @return the exit status of the compilation, or std::nullopt if there is no server
+/// listening or it did not run the compilation.
+std::optional<int> compileOnServer(const std::filesystem::path &socket,
+                                   const std::vector<std::string> &args, int in = 0, int out = 1,
+                                   int err = 2);
+
+/// If the command line has a `--client socket` option, compile with the rest of the command
+/// line on the server listening on `socket`, in the current working directory and with the
+/// standard input, output and error of this process.
+/// @return std::nullopt if the command line has no `--client` option.  Otherwise the exit
+/// status of the compilation, or 1 if no server ran it.
+std::optional<int> compileAsClient(int argc, char *const argv[]);
+
+/// Ask the server listening on @p socket to stop once the compilations in progress are done.
+/// @return false if there is no server listening.
+bool stopCompileServer(const std::filesystem::path &socket);
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_COMPILESERVER_H_ */
@@ -19,6 +19,7 @@ limitations under the License.
 #include "frontends/common/parser_options.h"
 #include "frontends/common/resolveReferences/referenceMap.h"
 #include "frontends/p4/enumInstance.h"
+#include "ir/hash_cons.h"
 #include "lib/big_int_util.h"
 #include "lib/exceptions.h"
 #include "lib/log.h"
@@ -177,7 +178,8 @@ const IR::Node *DoConstantFolding::postorder(IR::Declaration_Constant *d) {
                     ::P4::error(ErrorType::ERR_TYPE_ERROR, "%1%: initializer has wrong type %2%", d,
                                 cst->type);
                 else if (cst->type->is<IR::Type_InfInt>())
-                    init = new IR::Constant(init->srcInfo, bittype, cst->value, cst->base);
+                    init = IR::HashCons::make<IR::Constant>(init->srcInfo, bittype, cst->value,
+                                                            cst->base);
             } else if (!d->type->is<IR::Type_InfInt>()) {
                 // Don't fold this yet, we can't evaluate the cast.
                 return d;
@@ -320,7 +322,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Cmpl *e) {
     }
 
     big_int value = ~cst->value;
-    return new IR::Constant(cst->srcInfo, t, value, cst->base, true);
+    return IR::HashCons::make<IR::Constant>(cst->srcInfo, t, value, cst->base, true);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::Neg *e) {
@@ -342,7 +344,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Neg *e) {
     }
 
     big_int value = -cst->value;
-    return new IR::Constant(cst->srcInfo, t, value, cst->base, true);
+    return IR::HashCons::make<IR::Constant>(cst->srcInfo, t, value, cst->base, true);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::UPlus *e) {
@@ -359,7 +361,7 @@ const IR::Node *DoConstantFolding::postorder(IR::UPlus *e) {
 
 const IR::Constant *DoConstantFolding::cast(const IR::Constant *node, unsigned base,
                                             const IR::Type_Bits *type, bool noWarning) const {
-    return new IR::Constant(node->srcInfo, type, node->value, base, noWarning);
+    return IR::HashCons::make<IR::Constant>(node->srcInfo, type, node->value, base, noWarning);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::Add *e) {
@@ -465,7 +467,7 @@ const IR::Node *DoConstantFolding::compare(const IR::Operation_Binary *e) {
             return e;
         }
         bool bresult = (left->value == right->value) == eqTest;
-        return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), bresult);
+        return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(), bresult);
     }
     if (const auto *left = eleft->to<IR::StringLiteral>()) {
         const auto *right = eright->to<IR::StringLiteral>();
@@ -474,7 +476,7 @@ const IR::Node *DoConstantFolding::compare(const IR::Operation_Binary *e) {
             return e;
         }
         bool bresult = (left->value == right->value) == eqTest;
-        return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), bresult);
+        return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(), bresult);
     }
     if (typesKnown) {
         auto le = EnumInstance::resolve(eleft, typeMap);
@@ -482,7 +484,8 @@ const IR::Node *DoConstantFolding::compare(const IR::Operation_Binary *e) {
         if (le != nullptr && re != nullptr) {
             BUG_CHECK(le->type == re->type, "%1%: different enum types in comparison", e);
             bool bresult = (le->name == re->name) == eqTest;
-            return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), bresult);
+            return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(),
+                                                       bresult);
         }
 
         auto llist = eleft->to<IR::ListExpression>();
@@ -506,7 +509,7 @@ const IR::Node *DoConstantFolding::compare(const IR::Operation_Binary *e) {
                 if (boolLit == nullptr) return e;
                 if (boolLit->value != eqTest) return boolLit;
             }
-            return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), eqTest);
+            return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(), eqTest);
         }
     }
 
@@ -596,9 +599,9 @@ const IR::Node *DoConstantFolding::binary(const IR::Operation_Binary *e,
     }
 
     if (e->is<IR::Operation_Relation>())
-        return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), value != 0);
+        return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(), value != 0);
     else
-        return new IR::Constant(e->srcInfo, resultType, value, left->base, true);
+        return IR::HashCons::make<IR::Constant>(e->srcInfo, resultType, value, left->base, true);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::LAnd *e) {
@@ -613,7 +616,7 @@ const IR::Node *DoConstantFolding::postorder(IR::LAnd *e) {
     if (lcst->value) {
         return e->right;
     }
-    return new IR::BoolLiteral(left->srcInfo, IR::Type_Boolean::get(), false);
+    return IR::HashCons::make<IR::BoolLiteral>(left->srcInfo, IR::Type_Boolean::get(), false);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::LOr *e) {
@@ -628,7 +631,7 @@ const IR::Node *DoConstantFolding::postorder(IR::LOr *e) {
     if (!lcst->value) {
         return e->right;
     }
-    return new IR::BoolLiteral(left->srcInfo, IR::Type_Boolean::get(), true);
+    return IR::HashCons::make<IR::BoolLiteral>(left->srcInfo, IR::Type_Boolean::get(), true);
 }
 
 static bool overflowWidth(const IR::Node *node, int width) {
@@ -693,7 +696,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Slice *e) {
     mask = (mask << (m - l + 1)) - 1;
     value = value & mask;
     auto resultType = IR::Type_Bits::get(m - l + 1);
-    return new IR::Constant(e->srcInfo, resultType, value, cbase->base, true);
+    return IR::HashCons::make<IR::Constant>(e->srcInfo, resultType, value, cbase->base, true);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::PlusSlice *e) {
@@ -738,7 +741,7 @@ const IR::Node *DoConstantFolding::postorder(IR::PlusSlice *e) {
     mask = (mask << w) - 1;
     value = value & mask;
     auto resultType = IR::Type_Bits::get(w);
-    return new IR::Constant(e->srcInfo, resultType, value, cbase->base, true);
+    return IR::HashCons::make<IR::Constant>(e->srcInfo, resultType, value, cbase->base, true);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::Member *e) {
@@ -750,7 +753,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Member *e) {
     if (type->is<IR::Type_Array>() && e->member == IR::Type_Array::arraySize) {
         auto st = type->to<IR::Type_Array>();
         auto size = st->getSize();
-        return new IR::Constant(st->size->srcInfo, origtype, size);
+        return IR::HashCons::make<IR::Constant>(st->size->srcInfo, origtype, size);
     }
 
     auto expr = getConstant(e->expr);
@@ -798,7 +801,8 @@ const IR::Node *DoConstantFolding::postorder(IR::Concat *e) {
 
     // handle string concatenations
     if (lstr && rstr) {
-        return new IR::StringLiteral(e->srcInfo, IR::Type_String::get(), lstr->value + rstr->value);
+        return IR::HashCons::make<IR::StringLiteral>(e->srcInfo, IR::Type_String::get(),
+                                                     lstr->value + rstr->value);
     }
 
     const auto *left = eleft->to<IR::Constant>();
@@ -830,7 +834,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Concat *e) {
     auto resultType = IR::Type_Bits::get(lt->width_bits() + rt->width_bits(), lt->isSigned);
     if (overflowWidth(e, resultType->width_bits())) return e;
     big_int value = (left->value << rt->width_bits()) | rvalue;
-    return new IR::Constant(e->srcInfo, resultType, value, left->base);
+    return IR::HashCons::make<IR::Constant>(e->srcInfo, resultType, value, left->base);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::LNot *e) {
@@ -842,7 +846,7 @@ const IR::Node *DoConstantFolding::postorder(IR::LNot *e) {
         ::P4::error(ErrorType::ERR_EXPECTED, "%1%: Expected a boolean value", op);
         return e;
     }
-    return new IR::BoolLiteral(cst->srcInfo, IR::Type_Boolean::get(), !cst->value);
+    return IR::HashCons::make<IR::BoolLiteral>(cst->srcInfo, IR::Type_Boolean::get(), !cst->value);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::Mux *e) {
@@ -922,7 +926,7 @@ const IR::Node *DoConstantFolding::shift(const IR::Operation_Binary *e) {
             }
         }
     }
-    return new IR::Constant(e->srcInfo, left->type, value, cl->base);
+    return IR::HashCons::make<IR::Constant>(e->srcInfo, left->type, value, cl->base);
 }
 
 const IR::Node *DoConstantFolding::postorder(IR::Cast *e) {
@@ -952,7 +956,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Cast *e) {
                 error(ErrorType::ERR_INVALID, "%1%: Cannot cast %1% directly to %2% (use bit<1>)",
                       arg, type);
             int v = arg->value ? 1 : 0;
-            return new IR::Constant(e->srcInfo, type, v, 10);
+            return IR::HashCons::make<IR::Constant>(e->srcInfo, type, v, 10);
         } else if (expr->is<IR::Member>()) {
             auto ei = EnumInstance::resolve(expr, typeMap);
             if (ei == nullptr) return e;
@@ -970,7 +974,8 @@ const IR::Node *DoConstantFolding::postorder(IR::Cast *e) {
                             "%1%: Cannot cast %1% to arbitrary precision integer", ctype);
                 return e;
             }
-            return new IR::Constant(e->srcInfo, etype, constant->value, constant->base);
+            return IR::HashCons::make<IR::Constant>(e->srcInfo, etype, constant->value,
+                                                    constant->base);
         }
     } else if (etype->is<IR::Type_Boolean>()) {
         if (expr->is<IR::BoolLiteral>()) return expr;
@@ -999,7 +1004,7 @@ const IR::Node *DoConstantFolding::postorder(IR::Cast *e) {
                 ::P4::error(ErrorType::ERR_INVALID, "%1%: Only 0 and 1 can be cast to booleans", e);
                 return e;
             }
-            return new IR::BoolLiteral(e->srcInfo, IR::Type_Boolean::get(), v == 1);
+            return IR::HashCons::make<IR::BoolLiteral>(e->srcInfo, IR::Type_Boolean::get(), v == 1);
         }
     } else if (etype->is<IR::Type_StructLike>()) {
         return CloneConstants::clone(expr, this);
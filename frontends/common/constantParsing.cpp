@@ -17,6 +17,8 @@ limitations under the License.
 #include "constantParsing.h"
 
 #include "frontends/common/options.h"
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
@@ -52,6 +54,22 @@ UnparsedConstant UnparsedConstant::fromJSON(JSONLoader &json) {
     return rv;
 }
 
+void UnparsedConstant::toBinary(BinaryGenerator &out) const {
+    out.emit(text);
+    out.emit(skip);
+    out.emit(base);
+    out.emit(hasWidth);
+}
+
+UnparsedConstant UnparsedConstant::fromBinary(BinaryLoader &in) {
+    UnparsedConstant rv = {};
+    in.load(rv.text);
+    in.load(rv.skip);
+    in.load(rv.base);
+    in.load(rv.hasWidth);
+    return rv;
+}
+
 /// A helper to parse constants which have an explicit width;
 /// @see UnparsedConstant for an explanation of the parameters.
 static IR::Constant *parseConstantWithWidth(Util::SourceInfo srcInfo, const char *text,
@@ -29,6 +29,8 @@ class SourceInfo;
 
 namespace P4 {
 
+class BinaryGenerator;
+class BinaryLoader;
 class JSONGenerator;
 class JSONLoader;
 
@@ -72,6 +74,8 @@ struct UnparsedConstant {
     bool hasWidth;  /// If true, a bitwidth and separator are present.
     void toJSON(JSONGenerator &) const;
     static UnparsedConstant fromJSON(JSONLoader &);
+    void toBinary(BinaryGenerator &) const;
+    static UnparsedConstant fromBinary(BinaryLoader &);
 };
 
 std::ostream &operator<<(std::ostream &out, const UnparsedConstant &constant);
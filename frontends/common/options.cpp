@@ -59,6 +59,14 @@ CompilerOptions::CompilerOptions(std::string_view defaultMessage) : ParserOption
             return true;
         },
         "Dump the compiler IR after the midend as JSON in the specified file.");
+    registerOption(
+        "--toBinaryIR", "file",
+        [this](const char *arg) {
+            dumpBinaryIRFile = arg;
+            return true;
+        },
+        "Dump the compiler IR after the midend in the specified file, in a binary\n"
+        "format which is smaller and faster to load than JSON.");
     registerOption(
         "--ndebug", nullptr,
         [this](const char *) {
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "frontends/common/options.h"
 #include "frontends/common/parser_options.h"
+#include "frontends/common/precompiledHeader.h"
 #include "frontends/p4-14/fromv1.0/converters.h"
 #include "frontends/parsers/parserDriver.h"
 #include "lib/error.h"
@@ -66,7 +67,11 @@ const IR::P4Program *parseP4File(const ParserOptions &options) {
               "compiler context");
 
     const IR::P4Program *result = nullptr;
-    if (options.doNotPreprocess) {
+    std::optional<const IR::P4Program *> precompiled;
+    if (!options.precompiledHeader.empty()) precompiled = parseWithPrecompiledHeader(options);
+    if (precompiled) {
+        result = *precompiled;
+    } else if (options.doNotPreprocess) {
         auto *file = fopen(options.file.c_str(), "r");
         if (file == nullptr) {
             ::P4::error(ErrorType::ERR_NOT_FOUND, "%1%: No such file or directory.", options.file);
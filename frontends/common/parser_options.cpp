@@ -15,11 +15,18 @@
 #include <filesystem>
 #include <memory>
 #include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
 #include <unordered_set>
+#include <vector>
 
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_format.h"
+#include "frontends/common/preprocessor.h"
 #include "frontends/p4/toP4/toP4.h"
+#include "ir/hash_cons.h"
+#include "ir/pass_profile.h"
 #include "lib/exceptions.h"
 #include "lib/exename.h"
 #include "lib/log.h"
@@ -27,6 +34,56 @@
 
 namespace P4 {
 
+namespace {
+
+/// Quotes @p word for the shell, unless it only contains characters that the shell takes
+/// literally.
+std::string shellQuote(const std::string &word) {
+    static const std::regex plain("[A-Za-z0-9_+=,./:@%^-]+");
+    if (std::regex_match(word, plain)) return word;
+    std::string quoted = "'";
+    for (char c : word) quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    return quoted + "'";
+}
+
+/// Splits @p text into words as the shell does: words are separated by whitespace, and
+/// quotes and backslashes make whitespace and quotes part of a word.
+std::vector<std::string> splitShellWords(std::string_view text) {
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '\'') {
+            auto end = text.find('\'', i + 1);
+            if (end == std::string_view::npos) end = text.size();
+            word.append(text.substr(i + 1, end - i - 1));
+            i = end;
+        } else if (c == '"') {
+            for (++i; i < text.size() && text[i] != '"'; ++i) {
+                if (text[i] == '\\' && i + 1 < text.size() &&
+                    std::string_view("\"\\$`").find(text[i + 1]) != std::string_view::npos)
+                    ++i;
+                word += text[i];
+            }
+        } else if (c == '\\' && i + 1 < text.size()) {
+            word += text[++i];
+        } else if (isspace(static_cast<unsigned char>(c))) {
+            if (inWord) words.push_back(std::move(word));
+            word.clear();
+            inWord = false;
+            continue;
+        } else {
+            word += c;
+        }
+        inWord = true;
+    }
+    if (inWord) words.push_back(std::move(word));
+    return words;
+}
+
+}  // namespace
+
 /* CONFIG_PKGDATADIR is defined by cmake at compile time to be the same as
  * CMAKE_INSTALL_PREFIX This is only valid when the compiler is built and
  * installed from source locally. If the compiled binary is moved to another
@@ -80,21 +137,21 @@ ParserOptions::ParserOptions(std::string_view defaultMessage) : Util::Options(de
     registerOption(
         "-I", "path",
         [this](const char *arg) {
-            preprocessor_options += std::string(" -I") + arg;
+            preprocessor_options += " " + shellQuote(std::string("-I") + arg);
             return true;
         },
         "Specify include path (passed to preprocessor)");
     registerOption(
         "-D", "arg=value",
         [this](const char *arg) {
-            preprocessor_options += std::string(" -D") + arg;
+            preprocessor_options += " " + shellQuote(std::string("-D") + arg);
             return true;
         },
         "Define macro (passed to preprocessor)");
     registerOption(
         "-U", "arg",
         [this](const char *arg) {
-            preprocessor_options += std::string(" -U") + arg;
+            preprocessor_options += " " + shellQuote(std::string("-U") + arg);
             return true;
         },
         "Undefine macro (passed to preprocessor)");
@@ -198,6 +255,37 @@ ParserOptions::ParserOptions(std::string_view defaultMessage) : Util::Options(de
             return true;
         },
         "Skip preprocess, assume input file is already preprocessed.");
+    registerOption(
+        "--builtin-cpp", nullptr,
+        [this](const char *) {
+            builtinPreprocessor = true;
+            return true;
+        },
+        "Preprocess with the builtin preprocessor instead of running cpp.  It caches the\n"
+        "headers it reads, which helps when a process compiles many programs.");
+    registerOption(
+        "--precompiled-header", "file",
+        [this](const char *arg) {
+            precompiledHeader = arg;
+            return true;
+        },
+        "Save the parsed headers included at the start of the program (such as core.p4\n"
+        "and the architecture) in the specified file, and load them from it instead of\n"
+        "parsing them again in later compilations with the same headers and options.\n"
+        "If the file is a directory, a file is kept in it for each set of headers.");
+    registerOption(
+        "--server", "socket",
+        [](const char *) {
+            // handled before the options by compilers which can run as a server
+            ::P4::error(ErrorType::ERR_UNSUPPORTED,
+                        "--server is not supported by this compiler, or must be given with "
+                        "only --server-workers and --server-cache");
+            return false;
+        },
+        "Run as a compile server listening on the specified UNIX socket: compile the\n"
+        "programs sent to it, keeping the precompiled headers in memory.  It only takes\n"
+        "the options --server-workers n (the number of compilations run at once) and\n"
+        "--server-cache dir (the precompiled header directory, by default socket.pch).");
     registerOption(
         "--disable-annotations", "annotations",
         [this](const char *arg) {
@@ -328,6 +416,41 @@ ParserOptions::ParserOptions(std::string_view defaultMessage) : Util::Options(de
         "When the optimization is enabled, compiler tries to identify the cases,\n"
         "when it can inline the subparser's states only once for multiple\n"
         "invocations of the same subparser instance.");
+    registerOption(
+        "--hash-cons-leaves", nullptr,
+        [](const char *) {
+            IR::HashCons::enable();
+            return true;
+        },
+        "Share a single instance of identical constants and literals created by\n"
+        "constant folding and strength reduction, to reduce the memory used by the IR.\n");
+    registerOption(
+        "--incremental-typecheck", nullptr,
+        [this](const char *) {
+            incrementalTypeChecking = true;
+            return true;
+        },
+        "Only re-infer the types of the top-level declarations that were changed\n"
+        "by the frontend passes since the previous type checking.\n");
+    registerOption(
+        "--parallel-typecheck", nullptr,
+        [this](const char *) {
+            parallelTypeChecking = true;
+            return true;
+        },
+        "Infer the types of top-level parsers, controls, actions and functions\n"
+        "which do not refer to each other concurrently.  Off by default: every\n"
+        "worker forks the type map and copies the name lookup caches, which can\n"
+        "cost more than it saves; only use it where it was measured to help.\n");
+    registerOption(
+        "--pass-profile", "file",
+        [](const char *arg) {
+            PassProfile::writeAtExit(arg);
+            return true;
+        },
+        "[Compiler debugging] Write a profile of the time, IR nodes visited and cloned, and\n"
+        "memory allocated by each compiler pass to file.  The file is in Chrome trace-event\n"
+        "format; its \"passes\" field holds the totals for the pass hierarchy.\n");
     registerOption(
         "--doNotEmitIncludes", nullptr,
         [this](const char *) {
@@ -405,9 +528,56 @@ const char *ParserOptions::getIncludePath() const {
     return path.c_str();
 }
 
+std::unique_ptr<Preprocessor> ParserOptions::makeBuiltinPreprocessor() const {
+    std::vector<std::filesystem::path> includePath;
+    std::vector<std::pair<char, std::string>> macros;
+    for (const auto &arg : splitShellWords(preprocessor_options.string() + getIncludePath())) {
+        if (arg.size() < 3 || arg[0] != '-') return nullptr;
+        if (arg[1] == 'I')
+            includePath.emplace_back(arg.substr(2));
+        else if (arg[1] == 'D' || arg[1] == 'U')
+            macros.emplace_back(arg[1], arg.substr(2));
+        else
+            return nullptr;
+    }
+    auto preprocessor = std::make_unique<Preprocessor>(std::move(includePath));
+    for (auto &[flag, macro] : macros) {
+        if (flag == 'D')
+            preprocessor->define(macro);
+        else
+            preprocessor->undefine(macro);
+    }
+    return preprocessor;
+}
+
 std::optional<ParserOptions::PreprocessorResult> ParserOptions::preprocess() const {
     FILE *in = nullptr;
 
+    std::unique_ptr<Preprocessor> preprocessor;
+    if (builtinPreprocessor && file != "-") {
+        preprocessor = makeBuiltinPreprocessor();
+        if (!preprocessor && Log::verbose())
+            std::cerr << "Preprocessor options not supported by --builtin-cpp; using cpp"
+                      << std::endl;
+    }
+
+    if (preprocessor) {
+        auto text = preprocessor->process(file);
+        if (!text) return std::nullopt;
+        if (doNotCompile) {
+            fputs(text->c_str(), stdout);
+            return std::nullopt;
+        }
+        in = fmemopen(nullptr, text->size() + 1, "w+");
+        if (in == nullptr) {
+            ::P4::error(ErrorType::ERR_IO, "Error buffering preprocessor output");
+            return std::nullopt;
+        }
+        fwrite(text->data(), 1, text->size(), in);
+        rewind(in);
+        return ParserOptions::PreprocessorResult(in, [](FILE *f) { fclose(f); });
+    }
+
     if (file == "-") {
         in = stdin;
     } else {
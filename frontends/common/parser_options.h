@@ -23,6 +23,7 @@
 
 namespace P4 {
 
+class Preprocessor;
 class ToP4;
 
 /// Standard include paths for .p4 header files. The values are determined by
@@ -68,7 +69,7 @@ class ParserOptions : public Util::Options {
     cstring exe_name;
     /// Which language to compile
     FrontendVersion langVersion = FrontendVersion::P4_16;
-    /// options to pass to preprocessor
+    /// options to pass to preprocessor, quoted for the shell
     cstring preprocessor_options = cstring::empty;
     /// file to compile (- for stdin)
     std::filesystem::path file;
@@ -78,18 +79,31 @@ class ParserOptions : public Util::Options {
     cstring compilerVersion;
     /// if true skip preprocess
     bool doNotPreprocess = false;
+    /// if true preprocess with the builtin preprocessor instead of running cpp
+    bool builtinPreprocessor = false;
+    /// if not empty, the parsed standard headers included at the start of the program are
+    /// saved to and loaded from this file
+    std::filesystem::path precompiledHeader;
     /// substrings matched against pass names
     std::vector<cstring> top4;
     /// debugging dumps of programs written in this folder
     std::filesystem::path dumpFolder = ".";
     /// If false, optimization of callee parsers (subparsers) inlining is disabled.
     bool optimizeParserInlining = false;
+    /// If true, type checking only re-infers the declarations changed by the previous passes.
+    bool incrementalTypeChecking = false;
+    /// If true, type checking infers independent top-level declarations concurrently.
+    /// Off by default, as no speedup has been measured yet (see TypeMap::parallel).
+    bool parallelTypeChecking = false;
     /// Expect that the only remaining argument is the input file.
     void setInputFile();
     /// Return target specific include path.
     const char *getIncludePath() const override;
     /// Returns the output of the preprocessor.
     std::optional<ParserOptions::PreprocessorResult> preprocess() const;
+    /// Returns the builtin preprocessor configured with the -I, -D and -U options, or null if
+    /// there are other preprocessor options, which only cpp understands.
+    std::unique_ptr<Preprocessor> makeBuiltinPreprocessor() const;
     /// True if we are compiling a P4 v1.0 or v1.1 program
     bool isv1() const;
     /// Get a debug hook function suitable for insertion in the pass managers. The hook is
@@ -0,0 +1,253 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/precompiledHeader.h"
+
+#include <unistd.h>
+
+#include <cinttypes>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "frontends/common/preprocessor.h"
+#include "frontends/parsers/parserDriver.h"
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
+#include "lib/arena.h"
+#include "lib/hash.h"
+#include "lib/log.h"
+#include "lib/source_file.h"
+
+namespace P4 {
+
+namespace {
+
+using Dependencies = std::vector<std::pair<std::string, int64_t>>;
+
+/// The contents of a precompiled header.
+struct Header {
+    std::string key;
+    Dependencies dependencies;
+    std::string definitions;
+    std::string text;
+    const IR::P4Program *program = nullptr;
+};
+
+int64_t modificationTime(const std::filesystem::path &path) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return ec ? -1 : time.time_since_epoch().count();
+}
+
+bool upToDate(const std::filesystem::path &path, const Dependencies &dependencies) {
+    for (auto &[dependency, mtime] : dependencies) {
+        if (modificationTime(dependency) != mtime) {
+            LOG2("Precompiled header " << path << " is older than " << dependency);
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Headers already loaded or created by this process, by key.  Kept so that a process
+/// compiling many programs (such as a compile server, see CompileServer) loads each one once.
+std::map<std::string, Header> &loadedHeaders() {
+    static std::map<std::string, Header> headers;
+    return headers;
+}
+
+/// The headers in loadedHeaders() can only be kept if they are not in an arena that will be
+/// freed at the end of the compilation.
+bool keepHeaders() { return Util::Arena::current() == nullptr; }
+
+/// Returns the number of lines at the start of @p text made of #include, #define and
+/// #undef directives (and comments), or 0 if they do not include anything.
+unsigned prefixLines(std::string_view text) {
+    auto lines = Preprocessor::tokenize(text);
+    bool includes = false;
+    for (auto &line : lines) {
+        std::vector<const Preprocessor::Token *> tokens;
+        for (auto &t : line.tokens)
+            if (t.kind != Preprocessor::Token::Space && t.kind != Preprocessor::Token::Comment)
+                tokens.push_back(&t);
+        if (tokens.empty()) continue;
+        auto directive = tokens.size() >= 2 && tokens[0]->text == "#" ? tokens[1]->text : "";
+        if (directive == "include") {
+            includes = true;
+        } else if (directive != "define" && directive != "undef") {
+            return includes ? line.line - 1 : 0;
+        }
+    }
+    return 0;  // nothing but directives: nothing to gain
+}
+
+/// Returns the line number and the file of the line marker @p line, or std::nullopt if it is
+/// not a line marker.
+std::optional<std::pair<unsigned, std::string>> lineMarker(const std::string &line) {
+    unsigned number = 0;
+    char name[2];
+    if (sscanf(line.c_str(), "# %u %1[\"]", &number, name) != 2) return std::nullopt;
+    auto start = line.find('"') + 1;
+    return std::make_pair(number, line.substr(start, line.find('"', start) - start));
+}
+
+/// Recreates the InputSources of the preprocessed @p text, as the lexer builds them.  The
+/// text starts with a line marker for the program it was taken from, which names the file
+/// unless @p file is given.
+Util::InputSources *inputSources(const std::string &text, std::filesystem::path file) {
+    if (file.empty()) {
+        if (auto marker = lineMarker(text.substr(0, text.find('\n')))) file = marker->second;
+    }
+    auto *sources = new Util::InputSources;
+    sources->mapLine(file.string(), 1);
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);) {
+        sources->appendText(line.c_str());
+        if (auto marker = lineMarker(line)) sources->mapLine(marker->second, marker->first);
+        sources->appendText("\n");
+    }
+    return sources;
+}
+
+/// Load the precompiled header in @p path, if it is up to date and (unless @p key is null)
+/// is for @p key.  Source positions in the header refer to @p file or, if it is empty, to
+/// the program the header was created from.
+std::optional<Header> load(const std::filesystem::path &path, const std::string *key,
+                           const std::filesystem::path &file = {}) {
+    BinaryLoader loader(path);
+    if (!loader || !loader.hasSourcePositions()) return std::nullopt;
+    try {
+        Header header;
+        loader >> header.key;
+        if (key && header.key != *key) {
+            LOG2("Precompiled header " << path << " is for other directives or options");
+            return std::nullopt;
+        }
+        loader >> header.dependencies;
+        if (!upToDate(path, header.dependencies)) return std::nullopt;
+        loader >> header.definitions >> header.text;
+        loader.setSources(inputSources(header.text, file));
+        header.program = loader.loadNode<IR::P4Program>();
+        if (header.program == nullptr) return std::nullopt;
+        return header;
+    } catch (const Util::CompilationError &e) {
+        LOG2("Cannot load precompiled header " << path << ": " << e.what());
+        return std::nullopt;
+    }
+}
+
+void save(const std::filesystem::path &path, const Header &header) {
+    // written to a temporary file, in case another compilation is reading it
+    auto temp = path;
+    temp += ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(temp, std::ios::binary);
+        BinaryGenerator generator(out, BinaryIR::SourcePositions);
+        generator.emit(header.key);
+        generator.emit(header.dependencies);
+        generator.emit(header.definitions);
+        generator.emit(header.text);
+        generator.emit(header.program);
+        if (!out) {
+            LOG1("Cannot write precompiled header " << temp);
+            std::filesystem::remove(temp);
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) std::filesystem::remove(temp, ec);
+}
+
+}  // namespace
+
+std::optional<const IR::P4Program *> parseWithPrecompiledHeader(const ParserOptions &options) {
+    if (options.isv1() || options.doNotPreprocess || options.doNotCompile || options.file == "-")
+        return std::nullopt;
+    auto preprocessor = options.makeBuiltinPreprocessor();
+    if (!preprocessor) return std::nullopt;
+
+    std::ifstream in(options.file, std::ios::binary);
+    if (!in) return std::nullopt;  // reported when parsing without it
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    unsigned lines = prefixLines(text);
+    if (lines == 0) return std::nullopt;
+    size_t split = 0;
+    for (unsigned i = 0; i < lines; ++i) split = text.find('\n', split) + 1;
+    std::string prefix = text.substr(0, split);
+    // the rest keeps its line numbers
+    std::string rest = std::string(lines, '\n') + text.substr(split);
+
+    std::string key = prefix + '\0' + options.preprocessor_options.string() +
+                      options.getIncludePath() + '\0' +
+                      std::filesystem::absolute(options.file).parent_path().string() + '\0' +
+                      options.compilerVersion.string();
+    // a directory holds one header for each key
+    auto path = options.precompiledHeader;
+    if (std::filesystem::is_directory(path)) {
+        char name[24];
+        snprintf(name, sizeof(name), "%016" PRIx64 ".pch", Util::hash(key.data(), key.size()));
+        path /= name;
+    }
+
+    std::optional<Header> header;
+    auto cached = loadedHeaders().find(key);
+    if (cached != loadedHeaders().end() && upToDate(path, cached->second.dependencies)) {
+        LOG1("Using precompiled header " << path << " loaded before");
+        header = cached->second;
+    } else if ((header = load(path, &key, options.file))) {
+        LOG1("Loaded precompiled header " << path);
+    } else {
+        LOG1("Creating precompiled header " << path);
+        auto preprocessed = preprocessor->process(prefix, options.file);
+        if (!preprocessed) return nullptr;
+        header.emplace();
+        header->key = key;
+        for (auto &dependency : preprocessor->dependencies())
+            header->dependencies.emplace_back(dependency.string(), modificationTime(dependency));
+        header->definitions = preprocessor->definitions();
+        header->text = std::move(*preprocessed);
+        std::istringstream stream(header->text);
+        header->program = P4ParserDriver::parse(stream, options.file.string());
+        if (header->program == nullptr || ::P4::errorCount() > 0) return nullptr;
+        save(path, *header);
+    }
+    if (keepHeaders()) loadedHeaders()[key] = *header;
+
+    preprocessor->process(header->definitions, "<precompiled header>");
+    auto preprocessed = preprocessor->process(rest, options.file);
+    if (!preprocessed) return nullptr;
+    std::istringstream stream(*preprocessed);
+    return P4ParserDriver::parse(stream, options.file.string(), header->program);
+}
+
+size_t preloadPrecompiledHeaders(const std::filesystem::path &directory) {
+    static std::map<std::filesystem::path, int64_t> seen;  // files loaded, with their mtime
+    if (!keepHeaders()) return 0;
+    size_t count = 0;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, ec)) {
+        const auto &path = entry.path();
+        if (path.extension() != ".pch" || !entry.is_regular_file(ec)) continue;
+        auto mtime = modificationTime(path);
+        if (seen.count(path) && seen.at(path) == mtime) continue;
+        seen[path] = mtime;
+        if (auto header = load(path, nullptr)) {
+            LOG1("Preloaded precompiled header " << path);
+            loadedHeaders()[header->key] = std::move(*header);
+            ++count;
+        }
+    }
+    return count;
+}
+
+}  // namespace P4
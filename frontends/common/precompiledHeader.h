@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FRONTENDS_COMMON_PRECOMPILEDHEADER_H_
+#define FRONTENDS_COMMON_PRECOMPILEDHEADER_H_
+
+#include <optional>
+
+#include "frontends/common/parser_options.h"
+
+namespace P4::IR {
+class P4Program;
+}  // namespace P4::IR
+
+namespace P4 {
+
+/**
+ * Parse the P4-16 program in options.file using the precompiled header
+ * options.precompiledHeader.
+ *
+ * A precompiled header holds the declarations parsed from the #include, #define
+ * and #undef directives at the start of a program (usually core.p4 and the
+ * architecture), so that the following compilations of programs starting with the
+ * same directives, with the same preprocessor options, only preprocess and parse
+ * the rest of the program.  It is written in the binary IR format, with:
+ *   - a key made of the directives, the preprocessor options and the compiler version;
+ *   - the files included by the directives and their modification times;
+ *   - the macros defined by the directives, as #define directives;
+ *   - the preprocessed text of the directives, which the source positions refer to;
+ *   - the P4Program parsed from it.
+ * The file is created, or replaced if it is out of date.  If options.precompiledHeader
+ * is a directory, it holds a file for each key.  Headers loaded or created are also kept
+ * in memory, unless IR is being allocated in an arena.  The rest of the program is
+ * preprocessed with the builtin preprocessor.
+ *
+ * @return the program (null if it has errors), or std::nullopt if the program cannot
+ * use a precompiled header: it does not start with #include directives, it is not
+ * a P4-16 file to preprocess, or the preprocessor options require cpp.
+ */
+std::optional<const IR::P4Program *> parseWithPrecompiledHeader(const ParserOptions &options);
+
+/**
+ * Load the up to date precompiled headers in @p directory into memory, so that
+ * compilations in this process, or in processes forked from it, use them without reading
+ * them.  Files loaded by earlier calls are skipped unless they have changed.
+ *
+ * @return the number of headers loaded.
+ */
+size_t preloadPrecompiledHeaders(const std::filesystem::path &directory);
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_PRECOMPILEDHEADER_H_ */
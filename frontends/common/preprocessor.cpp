@@ -0,0 +1,938 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/preprocessor.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+
+#include "lib/error.h"
+
+namespace P4 {
+
+namespace {
+
+using Token = Preprocessor::Token;
+
+bool isWordChar(char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+bool isSpace(const Token &t) {
+    return t.kind == Token::Space || t.kind == Token::Comment || t.kind == Token::Marker;
+}
+bool isPunct(const Token &t, std::string_view text) {
+    return t.kind == Token::Punct && t.text == text;
+}
+size_t skipSpace(const std::vector<Token> &tokens, size_t pos) {
+    while (pos < tokens.size() && isSpace(tokens[pos])) ++pos;
+    return pos;
+}
+bool isDirective(const Preprocessor::Line &line) {
+    size_t p = skipSpace(line.tokens, 0);
+    return p < line.tokens.size() && isPunct(line.tokens[p], "#");
+}
+
+/// Text of @p tokens, with whitespace and comments collapsed into single spaces.
+std::string toText(const std::vector<Token> &tokens, size_t from = 0) {
+    std::string rv;
+    bool space = false;
+    for (size_t i = from; i < tokens.size(); ++i) {
+        if (isSpace(tokens[i])) {
+            space = !rv.empty();
+            continue;
+        }
+        if (space) rv += ' ';
+        space = false;
+        rv += tokens[i].text;
+    }
+    return rv;
+}
+
+// true if two tokens written next to each other could be read as one
+bool mayPaste(char a, char b) {
+    static const char *punct = "+-*/%<>=!&|^.#:";
+    if (isWordChar(a) && isWordChar(b)) return true;
+    return strchr(punct, a) && strchr(punct, b);
+}
+
+/// Evaluates the expression of an #if, after macro expansion.
+class ConditionEvaluator {
+    const std::vector<Token> &tokens;
+    size_t pos = 0;
+
+    int64_t fail(std::string msg) {
+        if (message.empty()) message = std::move(msg);
+        pos = tokens.size();
+        return 0;
+    }
+    bool accept(std::string_view op) {
+        if (pos < tokens.size() && isPunct(tokens[pos], op)) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    void expect(std::string_view op) {
+        if (!accept(op)) fail("expected '" + std::string(op) + "' in #if expression");
+    }
+
+    static int precedence(const std::string &op) {
+        static const std::map<std::string, int> table = {
+            {"||", 1}, {"&&", 2}, {"|", 3},  {"^", 4},  {"&", 5},  {"==", 6}, {"!=", 6},
+            {"<", 7},  {">", 7},  {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8}, {"+", 9},
+            {"-", 9},  {"*", 10}, {"/", 10}, {"%", 10}};
+        auto it = table.find(op);
+        return it == table.end() ? 0 : it->second;
+    }
+
+    int64_t apply(const std::string &op, int64_t l, int64_t r) {
+        if ((op == "/" || op == "%") && r == 0) return fail("division by zero in #if");
+        if (op == "*") return l * r;
+        if (op == "/") return l / r;
+        if (op == "%") return l % r;
+        if (op == "+") return l + r;
+        if (op == "-") return l - r;
+        if (op == "<<") return r < 0 || r > 63 ? 0 : l << r;
+        if (op == ">>") return r < 0 || r > 63 ? 0 : l >> r;
+        if (op == "<") return l < r;
+        if (op == ">") return l > r;
+        if (op == "<=") return l <= r;
+        if (op == ">=") return l >= r;
+        if (op == "==") return l == r;
+        if (op == "!=") return l != r;
+        if (op == "&") return l & r;
+        if (op == "^") return l ^ r;
+        if (op == "|") return l | r;
+        if (op == "&&") return l && r;
+        return l || r;
+    }
+
+    int64_t number(const std::string &text) {
+        std::string_view digits(text);
+        while (!digits.empty() && strchr("uUlL", digits.back())) digits.remove_suffix(1);
+        int base = 10;
+        bool prefix = digits.size() > 2 && digits[0] == '0';
+        if (prefix && (digits[1] == 'x' || digits[1] == 'X')) {
+            base = 16;
+            digits.remove_prefix(2);
+        } else if (prefix && (digits[1] == 'b' || digits[1] == 'B')) {
+            base = 2;
+            digits.remove_prefix(2);
+        } else if (digits.size() > 1 && digits[0] == '0') {
+            base = 8;
+        }
+        uint64_t value = 0;
+        auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value, base);
+        if (digits.empty() || ec != std::errc() || end != digits.data() + digits.size())
+            return fail("invalid integer constant \"" + text + "\" in #if");
+        return static_cast<int64_t>(value);
+    }
+
+    int64_t unary() {
+        if (pos >= tokens.size()) return fail("#if with no expression");
+        const Token &t = tokens[pos++];
+        switch (t.kind) {
+            case Token::Identifier:
+                return 0;
+            case Token::Number:
+                return number(t.text);
+            case Token::Punct:
+                if (t.text == "(") {
+                    auto v = conditional();
+                    expect(")");
+                    return v;
+                }
+                if (t.text == "!") return !unary();
+                if (t.text == "~") return ~unary();
+                if (t.text == "-") return -unary();
+                if (t.text == "+") return unary();
+                [[fallthrough]];
+            default:
+                return fail("token \"" + t.text + "\" is not valid in #if expressions");
+        }
+    }
+
+    int64_t binary(int minPrecedence) {
+        auto left = unary();
+        while (pos < tokens.size() && tokens[pos].kind == Token::Punct) {
+            auto op = tokens[pos].text;
+            int prec = precedence(op);
+            if (prec == 0 || prec < minPrecedence) break;
+            ++pos;
+            auto right = binary(prec + 1);
+            left = apply(op, left, right);
+        }
+        return left;
+    }
+
+    int64_t conditional() {
+        auto c = binary(1);
+        if (!accept("?")) return c;
+        auto a = conditional();
+        expect(":");
+        auto b = conditional();
+        return c ? a : b;
+    }
+
+ public:
+    std::string message;  // error, if any
+
+    explicit ConditionEvaluator(const std::vector<Token> &tokens) : tokens(tokens) {}
+    std::optional<int64_t> run() {
+        auto v = conditional();
+        if (pos < tokens.size())
+            fail("missing binary operator before \"" + tokens[pos].text + "\"");
+        if (!message.empty()) return std::nullopt;
+        return v;
+    }
+};
+
+}  // namespace
+
+struct Preprocessor::Cache {
+    struct Include {
+        std::string output;
+        Recording changes;
+    };
+    std::mutex mutex;
+    std::map<std::filesystem::path, std::shared_ptr<const Source>> files;
+    std::map<std::string, std::shared_ptr<const Include>> includes;
+    CacheStats stats;
+};
+
+Preprocessor::Cache &Preprocessor::cache() {
+    static Cache cache;
+    return cache;
+}
+
+Preprocessor::CacheStats Preprocessor::cacheStats() {
+    std::lock_guard<std::mutex> lock(cache().mutex);
+    return cache().stats;
+}
+
+void Preprocessor::clearCache() {
+    std::lock_guard<std::mutex> lock(cache().mutex);
+    cache().files.clear();
+    cache().includes.clear();
+    cache().stats = CacheStats();
+}
+
+std::shared_ptr<const Preprocessor::Source> Preprocessor::read(const std::filesystem::path &path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return nullptr;
+    auto &c = cache();
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        if (auto it = c.files.find(path); it != c.files.end() && it->second->mtime == mtime)
+            return it->second;
+    }
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nullptr;
+    std::stringstream text;
+    text << in.rdbuf();
+    auto source = std::make_shared<Source>();
+    source->mtime = mtime;
+    source->lines = tokenize(text.str());
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.files[path] = source;
+    return source;
+}
+
+Preprocessor::Lines Preprocessor::tokenize(std::string_view text) {
+    static const char *multiCharPunct[] = {"...", "##", "<<", ">>", "<=",
+                                           ">=",  "==", "!=", "&&", "||"};
+    Lines lines;
+    unsigned lineNo = 1;
+    size_t i = 0, n = text.size();
+    auto add = [&](Token::Kind kind, size_t start) {
+        if (lines.back().line == 0) lines.back().line = lineNo;
+        lines.back().tokens.push_back(Token{kind, std::string(text.substr(start, i - start))});
+    };
+    auto endLine = [&]() {
+        // lines with nothing but whitespace are dropped
+        if (!lines.empty() &&
+            std::all_of(lines.back().tokens.begin(), lines.back().tokens.end(),
+                        [](const Token &t) { return t.kind == Token::Space; }))
+            lines.pop_back();
+        lines.push_back(Line{0, {}});  // line 0: not started yet
+    };
+    lines.push_back(Line{0, {}});
+    while (i < n) {
+        char c = text[i];
+        size_t start = i;
+        if (c == '\\' && i + 1 < n && text[i + 1] == '\n') {
+            i += 2;
+            ++lineNo;
+        } else if (c == '\\' && i + 2 < n && text[i + 1] == '\r' && text[i + 2] == '\n') {
+            i += 3;
+            ++lineNo;
+        } else if (c == '\n') {
+            ++i;
+            ++lineNo;
+            endLine();
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            while (i < n && strchr(" \t\r\f\v", text[i]) && text[i]) ++i;
+            add(Token::Space, start);
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '/') {
+            while (i < n && text[i] != '\n') ++i;
+            add(Token::Comment, start);
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '*') {
+            auto end = text.find("*/", i + 2);
+            i = end == std::string_view::npos ? n : end + 2;
+            add(Token::Comment, start);
+            lineNo += std::count(text.begin() + start, text.begin() + i, '\n');
+        } else if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (i < n && isWordChar(text[i])) ++i;
+            add(Token::Identifier, start);
+        } else if (isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '.' && i + 1 < n && isdigit(static_cast<unsigned char>(text[i + 1])))) {
+            for (++i; i < n; ++i) {
+                if (isWordChar(text[i]) || text[i] == '.') continue;
+                if ((text[i] == '+' || text[i] == '-') && strchr("eEpP", text[i - 1])) continue;
+                break;
+            }
+            add(Token::Number, start);
+        } else if (c == '"') {
+            // backslash-newline inside a string joins the lines, as anywhere else
+            unsigned joined = 0;
+            for (++i; i < n && text[i] != '"' && text[i] != '\n'; ++i) {
+                if (text[i] != '\\' || i + 1 >= n) continue;
+                if (text[i + 1] == '\n') ++joined;
+                ++i;
+            }
+            if (i < n && text[i] == '"') ++i;
+            add(Token::String, start);
+            if (joined) {
+                auto &str = lines.back().tokens.back().text;
+                for (size_t pos; (pos = str.find("\\\n")) != std::string::npos;)
+                    str.erase(pos, 2);
+                lineNo += joined;
+            }
+        } else {
+            size_t len = 1;
+            for (auto *p : multiCharPunct) {
+                if (text.substr(i).substr(0, strlen(p)) == p) {
+                    len = strlen(p);
+                    break;
+                }
+            }
+            i += len;
+            add(Token::Punct, start);
+        }
+    }
+    endLine();
+    lines.pop_back();
+    return lines;
+}
+
+std::string Preprocessor::Macro::definition() const {
+    std::string rv;
+    if (function) {
+        rv += '(';
+        for (auto &p : params) rv += p + ',';
+        rv += ')';
+    }
+    for (auto &t : body) rv += t.text;
+    return rv;
+}
+
+void Preprocessor::setMacro(const std::string &name, std::optional<Macro> macro) {
+    auto hash = [&name](const Macro &m) {
+        return std::hash<std::string>()(name + '\0' + m.definition());
+    };
+    if (auto it = macros.find(name); it != macros.end()) {
+        macroHash ^= hash(it->second);
+        macros.erase(it);
+    }
+    if (macro) {
+        macroHash ^= hash(*macro);
+        macros.emplace(name, *macro);
+    }
+    for (auto *r : recordings) r->macros.emplace_back(name, macro);
+}
+
+void Preprocessor::define(std::string_view def) {
+    std::string text(def);
+    if (auto eq = text.find('='); eq != std::string::npos)
+        text[eq] = ' ';
+    else
+        text += " 1";
+    auto lines = tokenize(text);
+    if (!lines.empty()) defineMacro(lines.front().tokens, 0, 0);
+}
+
+void Preprocessor::undefine(std::string_view name) { setMacro(std::string(name), std::nullopt); }
+
+std::string Preprocessor::definitions() const {
+    std::string rv;
+    for (auto &[name, macro] : macros) {
+        rv += "#define " + name;
+        if (macro.function) {
+            rv += '(';
+            for (size_t i = 0; i < macro.params.size(); ++i) {
+                if (i) rv += ", ";
+                rv += macro.variadic && i + 1 == macro.params.size() ? "..." : macro.params[i];
+            }
+            rv += ')';
+        }
+        if (!macro.body.empty()) rv += ' ';
+        for (auto &t : macro.body) rv += t.text;
+        rv += '\n';
+    }
+    return rv;
+}
+
+void Preprocessor::error(unsigned line, const std::string &msg) {
+    if (curFile)
+        ::P4::error(ErrorType::ERR_INVALID, "%1%:%2%: %3%", curFile->name,
+                    line + curFile->lineDelta, msg);
+    else
+        ::P4::error(ErrorType::ERR_INVALID, "%1%", msg);
+}
+
+std::optional<std::string> Preprocessor::process(const std::filesystem::path &file) {
+    auto source = read(file);
+    if (!source) {
+        ::P4::error(ErrorType::ERR_NOT_FOUND, "%1%: No such file or directory.", file);
+        return std::nullopt;
+    }
+    auto errors = ::P4::errorCount();
+    out.clear();
+    included.clear();
+    fatal = false;
+    File f{file, file.string()};
+    run(source->lines, f);
+    outFile = curFile = nullptr;
+    if (::P4::errorCount() > errors) return std::nullopt;
+    return std::move(out);
+}
+
+std::optional<std::string> Preprocessor::process(std::string_view text,
+                                                 const std::filesystem::path &name) {
+    auto errors = ::P4::errorCount();
+    out.clear();
+    included.clear();
+    fatal = false;
+    File f{name, name.string()};
+    run(tokenize(text), f);
+    outFile = curFile = nullptr;
+    if (::P4::errorCount() > errors) return std::nullopt;
+    return std::move(out);
+}
+
+void Preprocessor::run(const Lines &lines, File &file) {
+    auto *savedFile = curFile;
+    curFile = &file;
+    marker(1, file, depth ? " 1" : "");
+    for (size_t i = 0; i < lines.size() && !fatal; ++i) {
+        auto &line = lines[i];
+        curLine = line.line;
+        if (isDirective(line)) {
+            directive(lines, i, file);
+            continue;
+        }
+        if (!file.active()) continue;
+        std::deque<Token> input(line.tokens.begin(), line.tokens.end());
+        size_t last = i;
+        auto more = [&]() { return last + 1 < lines.size() && !isDirective(lines[last + 1]); };
+        disabled.clear();
+        auto result = expand(input, more());
+        while (!result) {
+            // a macro call continues on the next line
+            input.push_back(Token{Token::Space, " "});
+            ++last;
+            input.insert(input.end(), lines[last].tokens.begin(), lines[last].tokens.end());
+            disabled.clear();
+            result = expand(input, more());
+        }
+        sync(file, line.line);
+        emit(*result);
+        i = last;
+    }
+    if (!file.conditions.empty() && !fatal)
+        error(file.conditions.back().line, "unterminated conditional directive");
+    curFile = savedFile;
+}
+
+void Preprocessor::directive(const Lines &lines, size_t &index, File &file) {
+    auto &line = lines[index];
+    auto &tokens = line.tokens;
+    size_t p = skipSpace(tokens, skipSpace(tokens, 0) + 1);
+    if (p >= tokens.size()) return;  // null directive
+    const std::string &name = tokens[p].text;
+    std::vector<Token> args(tokens.begin() + p + 1, tokens.end());
+    // physical line after this one, for the line markers
+    unsigned next = index + 1 < lines.size() ? lines[index + 1].line : line.line + 1;
+
+    if (name == "if" || name == "ifdef" || name == "ifndef") {
+        bool parent = file.active(), value = false;
+        if (parent && name == "if") {
+            value = condition(args, line.line).value_or(false);
+        } else if (parent) {
+            size_t q = skipSpace(args, 0);
+            if (q < args.size() && args[q].kind == Token::Identifier)
+                value = (macros.count(args[q].text) > 0) == (name == "ifdef");
+            else
+                error(line.line, "no macro name given in #" + name + " directive");
+        }
+        file.conditions.push_back(Condition{parent && value, !parent || value, false, line.line});
+        return;
+    }
+    if (name == "elif" || name == "else" || name == "endif") {
+        if (file.conditions.empty()) {
+            error(line.line, "#" + name + " without #if");
+            return;
+        }
+        auto &c = file.conditions.back();
+        if (name == "endif") {
+            file.conditions.pop_back();
+            return;
+        }
+        if (c.sawElse) error(line.line, "#" + name + " after #else");
+        if (name == "else") {
+            c.active = !c.taken;
+            c.sawElse = true;
+        } else {
+            c.active = !c.taken && condition(args, line.line).value_or(false);
+        }
+        c.taken = c.taken || c.active;
+        return;
+    }
+    if (!file.active()) return;
+
+    if (name == "define") {
+        defineMacro(args, 0, line.line);
+    } else if (name == "undef") {
+        size_t q = skipSpace(args, 0);
+        if (q < args.size() && args[q].kind == Token::Identifier)
+            setMacro(args[q].text, std::nullopt);
+        else
+            error(line.line, "no macro name given in #undef directive");
+    } else if (name == "include") {
+        include(args, file, line.line);
+        if (!fatal) marker(next, file, " 2");
+    } else if (name == "line" || tokens[p].kind == Token::Number) {
+        auto expanded = name == "line" ? *expand({args.begin(), args.end()}, false) : tokens;
+        size_t q = skipSpace(expanded, name == "line" ? 0 : p);
+        unsigned number = 0;
+        auto *text = q < expanded.size() ? &expanded[q].text : nullptr;
+        if (!text || expanded[q].kind != Token::Number ||
+            std::from_chars(text->data(), text->data() + text->size(), number).ec != std::errc()) {
+            error(line.line, "#line directive requires a line number");
+            return;
+        }
+        q = skipSpace(expanded, q + 1);
+        if (q < expanded.size() && expanded[q].kind == Token::String)
+            file.name = expanded[q].text.substr(1, expanded[q].text.size() - 2);
+        file.lineDelta = static_cast<int>(number) - static_cast<int>(line.line + 1);
+        outFile = nullptr;
+    } else if (name == "error") {
+        error(line.line, "#error " + toText(args));
+    } else if (name == "warning") {
+        ::P4::warning(ErrorType::WARN_FAILED, "%1%:%2%: #warning %3%", file.name,
+                      line.line + file.lineDelta, toText(args));
+    } else {
+        // #pragma and others are left for the P4 lexer, which ignores them
+        sync(file, line.line);
+        emit(tokens);
+    }
+}
+
+void Preprocessor::defineMacro(const std::vector<Token> &tokens, size_t pos, unsigned line) {
+    size_t i = skipSpace(tokens, pos);
+    if (i >= tokens.size() || tokens[i].kind != Token::Identifier) {
+        error(line, "macro names must be identifiers");
+        return;
+    }
+    std::string name = tokens[i++].text;
+    if (name == "defined") {
+        error(line, "\"defined\" cannot be used as a macro name");
+        return;
+    }
+    Macro m;
+    if (i < tokens.size() && isPunct(tokens[i], "(")) {
+        m.function = true;
+        for (++i;;) {
+            i = skipSpace(tokens, i);
+            if (i < tokens.size() && isPunct(tokens[i], ")") && m.params.empty()) {
+                ++i;
+                break;
+            }
+            if (i < tokens.size() && tokens[i].kind == Token::Identifier) {
+                m.params.push_back(tokens[i].text);
+            } else if (i < tokens.size() && isPunct(tokens[i], "...")) {
+                m.variadic = true;
+                m.params.push_back("__VA_ARGS__");
+            } else {
+                error(line, "expected parameter name in macro parameter list");
+                return;
+            }
+            i = skipSpace(tokens, i + 1);
+            if (i < tokens.size() && isPunct(tokens[i], ",") && !m.variadic) {
+                ++i;
+            } else if (i < tokens.size() && isPunct(tokens[i], ")")) {
+                ++i;
+                break;
+            } else {
+                error(line, "expected ',' or ')' in macro parameter list");
+                return;
+            }
+        }
+    }
+    // whitespace and comments in the body become single spaces
+    for (i = skipSpace(tokens, i); i < tokens.size(); ++i) {
+        if (!isSpace(tokens[i]))
+            m.body.push_back(tokens[i]);
+        else if (m.body.back().kind != Token::Space)
+            m.body.push_back(Token{Token::Space, " "});
+    }
+    if (!m.body.empty() && m.body.back().kind == Token::Space) m.body.pop_back();
+    setMacro(name, std::move(m));
+}
+
+std::optional<bool> Preprocessor::condition(std::vector<Token> tokens, unsigned line) {
+    std::deque<Token> input;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].kind != Token::Identifier || tokens[i].text != "defined") {
+            input.push_back(tokens[i]);
+            continue;
+        }
+        size_t j = skipSpace(tokens, i + 1);
+        bool paren = j < tokens.size() && isPunct(tokens[j], "(");
+        if (paren) j = skipSpace(tokens, j + 1);
+        if (j >= tokens.size() || tokens[j].kind != Token::Identifier) {
+            error(line, "operator \"defined\" requires an identifier");
+            return std::nullopt;
+        }
+        auto &macro = tokens[j].text;
+        bool value = macros.count(macro) || macro == "__FILE__" || macro == "__LINE__";
+        if (paren) {
+            j = skipSpace(tokens, j + 1);
+            if (j >= tokens.size() || !isPunct(tokens[j], ")")) {
+                error(line, "missing ')' after \"defined\"");
+                return std::nullopt;
+            }
+        }
+        input.push_back(Token{Token::Number, value ? "1" : "0"});
+        i = j;
+    }
+    std::vector<Token> expr = *expand(std::move(input), false);
+    expr.erase(std::remove_if(expr.begin(), expr.end(), isSpace), expr.end());
+    ConditionEvaluator evaluator(expr);
+    auto value = evaluator.run();
+    if (!value) {
+        error(line, evaluator.message);
+        return std::nullopt;
+    }
+    return *value != 0;
+}
+
+void Preprocessor::include(std::vector<Token> tokens, File &file, unsigned line) {
+    auto parse = [](const std::vector<Token> &tokens, std::string &name, bool &quoted) {
+        size_t i = skipSpace(tokens, 0);
+        if (i >= tokens.size()) return false;
+        if (tokens[i].kind == Token::String && tokens[i].text.size() >= 2) {
+            name = tokens[i].text.substr(1, tokens[i].text.size() - 2);
+            quoted = true;
+            return true;
+        }
+        if (!isPunct(tokens[i], "<")) return false;
+        name.clear();
+        for (++i; i < tokens.size() && !isPunct(tokens[i], ">"); ++i) name += tokens[i].text;
+        quoted = false;
+        return i < tokens.size();
+    };
+    std::string name;
+    bool quoted = false;
+    if (!parse(tokens, name, quoted) &&
+        !parse(*expand({tokens.begin(), tokens.end()}, false), name, quoted)) {
+        error(line, "#include expects \"FILENAME\" or <FILENAME>");
+        return;
+    }
+    if (depth >= 200) {
+        error(line, "#include nested depth 200 exceeds maximum");
+        fatal = true;
+        return;
+    }
+    std::vector<std::filesystem::path> candidates;
+    std::filesystem::path path(name);
+    if (path.is_absolute()) {
+        candidates.push_back(path);
+    } else {
+        if (quoted) candidates.push_back(file.path.parent_path() / path);
+        for (auto &dir : includePath) candidates.push_back(dir / path);
+    }
+    for (auto &candidate : candidates) {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(candidate, ec)) {
+            includeFile(candidate, candidate.string());
+            return;
+        }
+    }
+    error(line, name + ": No such file or directory");
+    fatal = true;
+}
+
+void Preprocessor::includeFile(const std::filesystem::path &path, const std::string &name) {
+    std::string key = path.string() + '\n' + name + '\n' + std::to_string(macroHash);
+    for (auto &dir : includePath) key += '\n' + dir.string();
+    auto &c = cache();
+    std::shared_ptr<const Cache::Include> cached;
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        if (auto it = c.includes.find(key); it != c.includes.end()) {
+            cached = it->second;
+            for (auto &[file, mtime] : cached->changes.files) {
+                std::error_code ec;
+                if (std::filesystem::last_write_time(file, ec) != mtime || ec) {
+                    cached = nullptr;
+                    break;
+                }
+            }
+            if (cached) ++c.stats.hits;
+        }
+    }
+    if (cached) {
+        out += cached->output;
+        for (auto &dependency : cached->changes.files) included.insert(dependency.first);
+        for (auto &[macro, def] : cached->changes.macros) setMacro(macro, def);
+        for (auto *r : recordings)
+            r->files.insert(r->files.end(), cached->changes.files.begin(),
+                            cached->changes.files.end());
+        return;
+    }
+
+    auto source = read(path);
+    if (!source) {
+        error(curLine, name + ": cannot read file");
+        fatal = true;
+        return;
+    }
+    included.insert(path);
+    Recording changes;
+    recordings.push_back(&changes);
+    for (auto *r : recordings) r->files.emplace_back(path, source->mtime);
+    auto errors = ::P4::errorCount();
+    auto start = out.size();
+    File file{path, name};
+    ++depth;
+    run(source->lines, file);
+    --depth;
+    recordings.pop_back();
+    if (::P4::errorCount() > errors || fatal) return;
+    auto include = std::make_shared<Cache::Include>();
+    include->output = out.substr(start);
+    include->changes = std::move(changes);
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.includes[key] = include;
+    ++c.stats.misses;
+}
+
+std::optional<std::vector<Token>> Preprocessor::expand(std::deque<Token> input, bool more) {
+    std::vector<Token> result;
+    while (!input.empty()) {
+        Token t = std::move(input.front());
+        input.pop_front();
+        if (t.kind == Token::Marker) {
+            // end of the expansion of a macro, which can be expanded again
+            if (!t.text.empty()) disabled.erase(t.text);
+            result.push_back(Token{Token::Marker, ""});
+            continue;
+        }
+        if (t.kind != Token::Identifier || t.noexpand) {
+            result.push_back(std::move(t));
+            continue;
+        }
+        auto it = macros.find(t.text);
+        if (it == macros.end()) {
+            if (t.text == "__LINE__")
+                result.push_back(
+                    Token{Token::Number, std::to_string(curLine + curFile->lineDelta)});
+            else if (t.text == "__FILE__")
+                result.push_back(Token{Token::String, '"' + curFile->name + '"'});
+            else
+                result.push_back(std::move(t));
+            continue;
+        }
+        if (disabled.count(t.text)) {
+            t.noexpand = true;
+            result.push_back(std::move(t));
+            continue;
+        }
+        const Macro &macro = it->second;
+        std::vector<std::vector<Token>> args;
+        if (macro.function) {
+            size_t k = 0;
+            while (k < input.size() && isSpace(input[k])) ++k;
+            if (k == input.size() && more) return std::nullopt;  // '(' may be on the next line
+            if (k == input.size() || !isPunct(input[k], "(")) {
+                result.push_back(std::move(t));
+                continue;
+            }
+            for (size_t j = 0; j <= k; ++j) {
+                if (input.front().kind == Token::Marker) disabled.erase(input.front().text);
+                input.pop_front();
+            }
+            int level = 0;
+            bool closed = false;
+            args.emplace_back();
+            while (!input.empty()) {
+                Token a = std::move(input.front());
+                input.pop_front();
+                if (a.kind == Token::Marker) {
+                    if (!a.text.empty()) disabled.erase(a.text);
+                    continue;
+                }
+                if (isPunct(a, ")") && level == 0) {
+                    closed = true;
+                    break;
+                }
+                if (isPunct(a, "(")) ++level;
+                if (isPunct(a, ")")) --level;
+                if (isPunct(a, ",") && level == 0 &&
+                    !(macro.variadic && args.size() >= macro.params.size())) {
+                    args.emplace_back();
+                    continue;
+                }
+                args.back().push_back(std::move(a));
+            }
+            if (!closed) {
+                if (more) return std::nullopt;
+                error(curLine, "unterminated argument list invoking macro \"" + t.text + "\"");
+                return result;
+            }
+            if (macro.params.empty() && args.size() == 1 &&
+                std::all_of(args[0].begin(), args[0].end(), isSpace))
+                args.clear();
+            if (macro.variadic && args.size() + 1 == macro.params.size()) args.emplace_back();
+            if (args.size() != macro.params.size()) {
+                error(curLine, "macro \"" + t.text + "\" passed " + std::to_string(args.size()) +
+                                   " arguments, but takes " +
+                                   std::to_string(macro.params.size()));
+                result.push_back(std::move(t));
+                continue;
+            }
+        }
+        auto body = substitute(macro, args);
+        // rescan the result together with the rest of the input
+        input.push_front(Token{Token::Marker, t.text});
+        input.insert(input.begin(), body.begin(), body.end());
+        input.push_front(Token{Token::Marker, ""});
+        disabled.insert(t.text);
+    }
+    return result;
+}
+
+std::vector<Token> Preprocessor::substitute(const Macro &macro,
+                                            std::vector<std::vector<Token>> &args) {
+    static const Token paste{Token::Marker, "##"};
+    auto param = [&macro](const Token &t) -> int {
+        if (t.kind != Token::Identifier) return -1;
+        auto it = std::find(macro.params.begin(), macro.params.end(), t.text);
+        return it == macro.params.end() ? -1 : int(it - macro.params.begin());
+    };
+    // arguments without leading and trailing whitespace
+    for (auto &arg : args) {
+        while (!arg.empty() && isSpace(arg.back())) arg.pop_back();
+        auto first = std::find_if_not(arg.begin(), arg.end(), isSpace);
+        arg.erase(arg.begin(), first);
+    }
+
+    auto &body = macro.body;
+    std::vector<Token> tokens;
+    for (size_t i = 0; i < body.size(); ++i) {
+        auto &t = body[i];
+        size_t next = skipSpace(body, i + 1);
+        if (isPunct(t, "##")) {
+            while (!tokens.empty() && tokens.back().kind == Token::Space) tokens.pop_back();
+            tokens.push_back(paste);
+            i = next - 1;
+            continue;
+        }
+        if (macro.function && isPunct(t, "#") && next < body.size() && param(body[next]) >= 0) {
+            std::string text = "\"";
+            for (auto &c : toText(args[param(body[next])])) {
+                if (c == '"' || c == '\\') text += '\\';
+                text += c;
+            }
+            tokens.push_back(Token{Token::String, text + '"'});
+            i = next;
+            continue;
+        }
+        int p = param(t);
+        if (p < 0) {
+            tokens.push_back(t);
+            continue;
+        }
+        bool pasted = (!tokens.empty() && tokens.back().kind == Token::Marker &&
+                       tokens.back().text == "##") ||
+                      (next < body.size() && isPunct(body[next], "##"));
+        if (pasted) {
+            if (args[p].empty()) tokens.push_back(Token{Token::Marker, ""});  // placemarker
+            tokens.insert(tokens.end(), args[p].begin(), args[p].end());
+        } else {
+            auto expanded = *expand({args[p].begin(), args[p].end()}, false);
+            tokens.insert(tokens.end(), expanded.begin(), expanded.end());
+        }
+    }
+
+    // paste the tokens on each side of ##
+    std::vector<Token> rv;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].kind != Token::Marker || tokens[i].text != "##") {
+            rv.push_back(tokens[i]);
+            continue;
+        }
+        if (++i >= tokens.size()) break;
+        if (rv.empty() || (rv.back().kind == Token::Marker && rv.back().text.empty())) {
+            if (!rv.empty()) rv.pop_back();
+            rv.push_back(tokens[i]);
+        } else if (tokens[i].kind != Token::Marker) {
+            auto lines = tokenize(rv.back().text + tokens[i].text);
+            rv.pop_back();
+            if (!lines.empty())
+                rv.insert(rv.end(), lines.front().tokens.begin(), lines.front().tokens.end());
+        }
+    }
+    return rv;
+}
+
+void Preprocessor::marker(unsigned line, const File &file, const char *flag) {
+    outFile = &file;
+    outLine = line + file.lineDelta;
+    out += "# " + std::to_string(outLine) + " \"" + file.name + '"' + flag + '\n';
+}
+
+void Preprocessor::sync(const File &file, unsigned line) {
+    unsigned target = line + file.lineDelta;
+    if (outFile == &file && target >= outLine && target <= outLine + 8) {
+        out.append(target - outLine, '\n');
+        outLine = target;
+    } else {
+        marker(line, file);
+    }
+}
+
+void Preprocessor::emit(const std::vector<Token> &tokens) {
+    bool boundary = false;
+    for (auto &t : tokens) {
+        if (t.kind == Token::Marker) {
+            boundary = true;
+            continue;
+        }
+        if (boundary && !out.empty() && !t.text.empty() && mayPaste(out.back(), t.text.front()))
+            out += ' ';
+        boundary = false;
+        out += t.text;
+        outLine += std::count(t.text.begin(), t.text.end(), '\n');
+    }
+    out += '\n';
+    ++outLine;
+}
+
+}  // namespace P4
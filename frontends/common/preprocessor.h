@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FRONTENDS_COMMON_PREPROCESSOR_H_
+#define FRONTENDS_COMMON_PREPROCESSOR_H_
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace P4 {
+
+/// An in-process implementation of the part of the C preprocessor used by P4 programs, as an
+/// alternative to running `cpp` for every compilation.  It supports #include, object-like
+/// and function-like macros (with #, ## and __VA_ARGS__), #undef, conditionals (#if, #ifdef,
+/// #ifndef, #elif, #else, #endif), #line, #error and #warning.  Other directives (such as
+/// #pragma) are copied to the output, where the P4 lexer ignores them.  Like `cpp -C`, it
+/// keeps comments, and the output contains line markers in the format written by cpp.
+///
+/// Files are cached for the lifetime of the process: the tokens of every file read, keyed on
+/// its path and modification time, and the output of every #include, keyed additionally on
+/// the include path and the macros defined at the point of the #include.  So the standard
+/// headers (core.p4, the architecture files) are only read and expanded once by a process
+/// compiling many programs.
+class Preprocessor {
+ public:
+    explicit Preprocessor(std::vector<std::filesystem::path> includePath = {})
+        : includePath(std::move(includePath)) {}
+
+    /// Define a macro like the -D option: @p def is NAME or NAME=VALUE.
+    void define(std::string_view def);
+    /// Undefine a macro like the -U option.
+    void undefine(std::string_view name);
+
+    /// Preprocess @p file.  Returns nullopt if errors were reported.
+    std::optional<std::string> process(const std::filesystem::path &file);
+    /// Preprocess @p text, as the contents of a file named @p name.
+    std::optional<std::string> process(std::string_view text, const std::filesystem::path &name);
+
+    /// The macros currently defined, as #define directives.
+    std::string definitions() const;
+    /// The files included by the last call to process, directly or indirectly.
+    const std::set<std::filesystem::path> &dependencies() const { return included; }
+
+    struct CacheStats {
+        size_t hits = 0;    // #includes whose output was reused
+        size_t misses = 0;  // #includes which were expanded
+    };
+    static CacheStats cacheStats();
+    static void clearCache();
+
+    struct Token {
+        enum Kind : uint8_t { Identifier, Number, String, Punct, Space, Comment, Marker };
+        Kind kind;
+        std::string text;
+        bool noexpand = false;  // a macro name which must not be expanded any more
+    };
+    /// A logical line: lines ending with a backslash are joined to the next one, and block
+    /// comments may span several lines.
+    struct Line {
+        unsigned line;  // the physical line it starts on
+        std::vector<Token> tokens;
+    };
+    using Lines = std::vector<Line>;
+    static Lines tokenize(std::string_view text);
+
+ private:
+    struct Macro {
+        bool function = false;
+        bool variadic = false;
+        std::vector<std::string> params;
+        std::vector<Token> body;
+        std::string definition() const;
+    };
+    struct Condition {
+        bool active;   // the current group is copied to the output
+        bool taken;    // a group was (or must not be) taken
+        bool sawElse = false;
+        unsigned line;
+    };
+    struct File {
+        std::filesystem::path path;
+        std::string name;  // for line markers and __FILE__
+        int lineDelta = 0;
+        std::vector<Condition> conditions;
+        bool active() const { return conditions.empty() || conditions.back().active; }
+    };
+    /// Changes to the macros and files read by an #include, while it is being expanded.
+    struct Recording {
+        std::vector<std::pair<std::string, std::optional<Macro>>> macros;
+        std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> files;
+    };
+    struct Source {
+        std::filesystem::file_time_type mtime;
+        Lines lines;
+    };
+    struct Cache;
+    static Cache &cache();
+    /// Read and tokenize @p path, or get it from the cache.
+    static std::shared_ptr<const Source> read(const std::filesystem::path &path);
+
+    std::vector<std::filesystem::path> includePath;
+    std::map<std::string, Macro> macros;
+    uint64_t macroHash = 0;  // order-independent hash of all macro definitions
+    std::set<std::string> disabled;  // macros being expanded
+    std::vector<Recording *> recordings;
+    std::set<std::filesystem::path> included;
+    std::string out;
+    const File *outFile = nullptr;  // file and line at the end of the output
+    unsigned outLine = 0;
+    const File *curFile = nullptr;
+    unsigned curLine = 0;
+    unsigned depth = 0;
+    bool fatal = false;
+
+    void setMacro(const std::string &name, std::optional<Macro> macro);
+    void run(const Lines &lines, File &file);
+    void directive(const Lines &lines, size_t &index, File &file);
+    void include(std::vector<Token> tokens, File &file, unsigned line);
+    void includeFile(const std::filesystem::path &path, const std::string &name);
+    void defineMacro(const std::vector<Token> &tokens, size_t pos, unsigned line);
+    std::optional<bool> condition(std::vector<Token> tokens, unsigned line);
+
+    /// Expand the macros in @p input.  If @p more, the input may continue on the next line,
+    /// and nullopt is returned if it ends in the middle of a macro call.
+    std::optional<std::vector<Token>> expand(std::deque<Token> input, bool more);
+    std::vector<Token> substitute(const Macro &macro, std::vector<std::vector<Token>> &args);
+
+    void marker(unsigned line, const File &file, const char *flag = "");
+    void sync(const File &file, unsigned line);
+    void emit(const std::vector<Token> &tokens);
+    void error(unsigned line, const std::string &msg);
+};
+
+}  // namespace P4
+
+#endif /* FRONTENDS_COMMON_PREPROCESSOR_H_ */
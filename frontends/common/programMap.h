@@ -17,6 +17,7 @@ limitations under the License.
 #ifndef FRONTENDS_COMMON_PROGRAMMAP_H_
 #define FRONTENDS_COMMON_PROGRAMMAP_H_
 
+#include "ir/analysis_manager.h"
 #include "ir/ir.h"
 #include "lib/log.h"
 
@@ -25,7 +26,9 @@ namespace P4 {
 // Base class for various maps.
 // A map is computed on a certain P4Program.
 // If the program has not changed, the map is up-to-date.
-class ProgramMap : public IHasDbPrint {
+// Maps registered with an AnalysisManager also remain up-to-date across
+// passes which declare that they preserve them.
+class ProgramMap : public IHasDbPrint, public CachedAnalysis {
  protected:
     const IR::P4Program *fake = new IR::P4Program();
     const IR::P4Program *program = nullptr;
@@ -61,6 +64,11 @@ class ProgramMap : public IHasDbPrint {
         // since the 'fake' node cannot appear in a program.
         program = fake;
     }
+
+    cstring analysisName() const override { return mapKind; }
+    const IR::Node *analyzedRoot() const override { return program == fake ? nullptr : program; }
+    void rootReplaced(const IR::Node *root) override { updateMap(root); }
+    void invalidate() override { ProgramMap::clear(); }
 };
 
 }  // namespace P4
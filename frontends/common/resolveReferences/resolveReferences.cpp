@@ -45,6 +45,26 @@ ResolutionContext::NamespaceDeclsByName &ResolutionContext::memoizeDeclsByName(
     return namesToDecls;
 }
 
+const absl::flat_hash_map<cstring, std::vector<const IR::Declaration_MatchKind *>, Util::Hash> &
+ResolutionContext::memoizeMatchKinds(const IR::P4Program *program) const {
+    if (matchKindsProgram == program) return matchKinds;
+    matchKinds.clear();
+    for (const auto *obj : program->objects) {
+        if (const auto *match_kind = obj->to<IR::Declaration_MatchKind>())
+            for (const auto *member : match_kind->members)
+                matchKinds[member->name.name].push_back(match_kind);
+    }
+    matchKindsProgram = program;
+    return matchKinds;
+}
+
+void ResolutionContext::clearNamespaceIndices() const {
+    namespaceDecls.clear();
+    namespaceDeclNames.clear();
+    matchKinds.clear();
+    matchKindsProgram = nullptr;
+}
+
 std::vector<const IR::IDeclaration *> ResolutionContext::resolve(const IR::ID &name,
                                                                  P4::ResolutionType type) const {
     const Context *ctxt = nullptr;
@@ -171,11 +191,12 @@ std::vector<const IR::IDeclaration *> ResolutionContext::lookup(const IR::INames
 std::vector<const IR::IDeclaration *> ResolutionContext::lookupMatchKind(const IR::ID &name) const {
     LOG2("Resolving " << name << " as match kind");
     if (const auto *global = findOrigCtxt<IR::P4Program>()) {
-        for (const auto *obj : global->objects) {
-            if (const auto *match_kind = obj->to<IR::Declaration_MatchKind>()) {
-                auto rv = lookup(match_kind, name, ResolutionType::Any);
-                if (!rv.empty()) return rv;
-            }
+        const auto &byName = memoizeMatchKinds(global);
+        auto it = byName.find(name.name);
+        if (it == byName.end()) return {};
+        for (const auto *match_kind : it->second) {
+            auto rv = lookup(match_kind, name, ResolutionType::Any);
+            if (!rv.empty()) return rv;
         }
     }
     return {};
@@ -379,6 +400,7 @@ void ResolveReferences::checkShadowing(const IR::INamespace *ns) const {
 
 Visitor::profile_t ResolveReferences::init_apply(const IR::Node *node) {
     anyOrder = refMap->isV1();
+    clearNamespaceIndices();
     // Check shadowing even if the program map is up-to-date.
     if (!refMap->checkMap(node) || checkShadow) refMap->clear();
     return Inspector::init_apply(node);
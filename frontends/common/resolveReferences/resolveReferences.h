@@ -46,11 +46,24 @@ class ResolutionContext : virtual public Visitor, public DeclarationLookup {
     // future lookups.
     NamespaceDeclsByName &memoizeDeclsByName(const IR::INamespace *ns) const;
 
+    // Returns a mapping from name -> match_kind declarations declaring that name in the
+    // given program, and caches the result for future lookups.
+    const absl::flat_hash_map<cstring, std::vector<const IR::Declaration_MatchKind *>,
+                              Util::Hash> &
+    memoizeMatchKinds(const IR::P4Program *program) const;
+
+    // The caches below are built lazily, one namespace at a time, and are keyed by the
+    // namespace node.  Modifying a namespace always clones it, so the modified node gets an
+    // index of its own.  ResolveReferences drops them all when it is applied.
     mutable absl::flat_hash_map<const IR::INamespace *, std::vector<const IR::IDeclaration *>,
                                 Util::Hash>
         namespaceDecls;
     mutable absl::flat_hash_map<const IR::INamespace *, NamespaceDeclsByName, Util::Hash>
         namespaceDeclNames;
+    mutable const IR::P4Program *matchKindsProgram = nullptr;
+    mutable absl::flat_hash_map<cstring, std::vector<const IR::Declaration_MatchKind *>,
+                                Util::Hash>
+        matchKinds;
 
  protected:
     // Note that all errors have been merged by the parser into
@@ -72,6 +85,9 @@ class ResolutionContext : virtual public Visitor, public DeclarationLookup {
     ResolutionContext();
     explicit ResolutionContext(bool ao) : anyOrder(ao) {}
 
+    /// Drop all the cached namespace indices; they are rebuilt on demand.
+    void clearNamespaceIndices() const;
+
     /// We are resolving a method call.  Find the arguments from the context.
     const IR::Vector<IR::Argument> *methodArguments(cstring name) const;
 
@@ -229,6 +229,8 @@ const IR::P4Program *FrontEnd::run(const CompilerOptions &options, const IR::P4P
     if (program == nullptr && options.listFrontendPasses == 0) return nullptr;
 
     TypeMap typeMap;
+    typeMap.setIncremental(options.incrementalTypeChecking);
+    typeMap.setParallel(options.parallelTypeChecking);
 
     MetricsPassManager metricsPassManager(options, &typeMap, P4CContext::get().options().metrics);
 
@@ -380,6 +382,10 @@ const IR::P4Program *FrontEnd::run(const CompilerOptions &options, const IR::P4P
     passes.setName("FrontEnd");
     passes.setStopOnError(true);
     passes.addDebugHooks(hooks, true);
+    // Skip recomputing types after passes which preserve them.
+    AnalysisManager analyses;
+    analyses.registerAnalysis(&typeMap);
+    passes.setAnalysisManager(&analyses);
     const IR::P4Program *result = program->apply(passes);
     return result;
 }
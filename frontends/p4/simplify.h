@@ -60,6 +60,10 @@ class DoSimplifyControlFlow : public Transform, public ResolutionContext {
         // We may want to replace the same statement with different things
         // in different places.
         visitDagOnce = false;
+        onlyVisitSubtreesWith<IR::BlockStatement, IR::IfStatement, IR::EmptyStatement,
+                              IR::SwitchStatement>();
+        // Only statements are replaced, reusing the original expressions.
+        preserves<TypeMap>();
     }
     const IR::Node *postorder(IR::BlockStatement *statement) override;
     const IR::Node *postorder(IR::IfStatement *statement) override;
@@ -42,6 +42,11 @@ class DoSimplifyDefUse : public Transform {
 /// The Cloner pass below may insert @hidden annotations
 /// on empty control blocks; remove them
 class RemoveHidden : public Transform {
+ public:
+    // Only empty blocks are replaced, which have no types.
+    RemoveHidden() { preserves<TypeMap>(); }
+
+ private:
     const IR::Node *postorder(IR::BlockStatement *stat) override {
         if (!stat->components.empty()) return stat;
         if (!stat->hasOnlyAnnotation(IR::Annotation::hiddenAnnotation)) return stat;
@@ -55,7 +60,11 @@ class SimplifyDefUse : public PassManager {
 
     class Cloner : public CloneExpressions {
      public:
-        Cloner() { setName("Cloner"); }
+        Cloner() {
+            setName("Cloner");
+            // The types of the expressions are carried over to their clones.
+            preserves<TypeMap>();
+        }
         const IR::Node *postorder(IR::EmptyStatement *stat) override {
             // You cannot clone an empty statement, since
             // the visitor claims it's equal to the original one.
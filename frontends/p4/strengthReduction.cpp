@@ -16,6 +16,8 @@ limitations under the License.
 
 #include "strengthReduction.h"
 
+#include "ir/hash_cons.h"
+
 namespace P4 {
 
 /// @section Helper methods
@@ -123,7 +125,7 @@ const IR::Node *DoStrengthReduction::postorder(IR::BXor *expr) {
     if (expr->left->equiv(*expr->right) && expr->left->type &&
         !expr->left->type->is<IR::Type_Unknown>())
         // we assume that this type is right
-        return new IR::Constant(expr->srcInfo, expr->left->type, 0);
+        return IR::HashCons::make<IR::Constant>(expr->srcInfo, expr->left->type, 0);
     if (expr->left->is<IR::Constant>()) std::swap(expr->left, expr->right);
     return expr;
 }
@@ -221,14 +223,15 @@ const IR::Node *DoStrengthReduction::postorder(IR::Sub *expr) {
     // Replace `a - constant` with `a + (-constant)`
     if (policy->enableSubConstToAddTransform && expr->right->is<IR::Constant>()) {
         auto cst = expr->right->to<IR::Constant>();
-        auto neg = new IR::Constant(cst->srcInfo, cst->type, -cst->value, cst->base, true);
+        auto neg = IR::HashCons::make<IR::Constant>(cst->srcInfo, cst->type, -cst->value,
+                                                    cst->base, true);
         auto result = new IR::Add(expr->srcInfo, expr->type, expr->left, neg);
         return result;
     }
     if (hasSideEffects(expr)) return expr;
     if (expr->left->equiv(*expr->right) && expr->left->type &&
         !expr->left->type->is<IR::Type_Unknown>())
-        return new IR::Constant(expr->srcInfo, expr->left->type, 0);
+        return IR::HashCons::make<IR::Constant>(expr->srcInfo, expr->left->type, 0);
     return expr;
 }
 
@@ -239,7 +242,7 @@ const IR::Node *DoStrengthReduction::postorder(IR::SubSat *expr) {
     if (isZero(expr->left) && type && !type->isSigned) return expr->left;
     if (expr->left->equiv(*expr->right) && expr->left->type &&
         !expr->left->type->is<IR::Type_Unknown>())
-        return new IR::Constant(expr->srcInfo, expr->left->type, 0);
+        return IR::HashCons::make<IR::Constant>(expr->srcInfo, expr->left->type, 0);
     return expr;
 }
 
@@ -338,8 +341,8 @@ const IR::Node *DoStrengthReduction::postorder(IR::Mod *expr) {
     if (exp >= 0) {
         big_int mask = 1;
         mask = (mask << exp) - 1;
-        auto amt =
-            new IR::Constant(expr->right->srcInfo, expr->right->to<IR::Constant>()->type, mask);
+        auto amt = IR::HashCons::make<IR::Constant>(
+            expr->right->srcInfo, expr->right->to<IR::Constant>()->type, mask);
         auto sh = new IR::BAnd(expr->srcInfo, expr->type, expr->left, amt);
         return sh;
     }
@@ -433,7 +436,7 @@ const IR::Node *DoStrengthReduction::postorder(IR::Slice *expr) {
         }
         if (hi + shift_amt < 0) {
             if (!hasSideEffects(shift_of))
-                return new IR::Constant(IR::Type_Bits::get(hi - lo + 1), 0);
+                return IR::HashCons::make<IR::Constant>(IR::Type_Bits::get(hi - lo + 1), 0);
             // TODO: here we could promote the side-effect into a
             // separate statement.  and still return the constant.
             // But for now we only produce expressions.
@@ -445,7 +448,8 @@ const IR::Node *DoStrengthReduction::postorder(IR::Slice *expr) {
             expr->e2 = new IR::Constant(0);
             return new IR::Concat(
                 expr->srcInfo, expr->type, expr,
-                new IR::Constant(expr->srcInfo, IR::Type_Bits::get(-(lo + shift_amt)), 0));
+                IR::HashCons::make<IR::Constant>(expr->srcInfo,
+                                                 IR::Type_Bits::get(-(lo + shift_amt)), 0));
         }
     }
 
@@ -158,6 +158,12 @@ Visitor::profile_t ReadOnlyTypeInference::init_apply(const IR::Node *node) {
     return rv;
 }
 
+const IR::Node *ReadOnlyTypeInference::apply_visitor(const IR::Node *n, const char *name) {
+    return visitIncrementally(n, name, [this](const IR::Node *n, const char *name) {
+        return Inspector::apply_visitor(n, name);
+    });
+}
+
 void ReadOnlyTypeInference::end_apply(const IR::Node *node) {
     TypeInferenceBase::finish(node);
     Inspector::end_apply(node);
@@ -113,6 +113,11 @@ void TypeInferenceBase::start(const IR::Node *node) {
         LOG2("TypeInference for " << dbp(node));
     }
     initialNode = node;
+    if (const auto *program = node->to<IR::P4Program>(); program && typeMap->incremental) {
+        changedNames.clear();
+        for (const auto *decl : typeMap->staleDeclarations(program->objects))
+            addDeclaredNames(decl, changedNames);
+    }
     if (!nameGen) {
         nameGen = std::make_shared<MinimalNameGenerator>();
         node->apply(*nameGen);
@@ -128,6 +133,11 @@ ReadOnlyTypeInference *TypeInferenceBase::readOnlyClone() const {
     return new ReadOnlyTypeInference(this->typeMap, nameGen);
 }
 
+void TypeInferenceBase::forkTypeMap() {
+    typeMap = new TypeMap(typeMap);
+    if (nameGen) nameGen = std::make_shared<MinimalNameGenerator>(*nameGen);
+}
+
 bool TypeInferenceBase::done() const {
     auto orig = getOriginal();
     bool done = typeMap->contains(orig);
@@ -135,6 +145,54 @@ bool TypeInferenceBase::done() const {
     return done;
 }
 
+bool TypeInferenceBase::isProgramObject() const {
+    // called before visiting the node, so the context is the one of its parent (the objects
+    // vector is inline in the program, so it has no context of its own)
+    const auto *ctxt = getChildContext();
+    return ctxt && ctxt->node->is<IR::P4Program>();
+}
+
+bool TypeInferenceBase::checkUnchanged(const IR::Node *n) {
+    if (!typeMap->isChecked(n)) return false;
+    for (auto name : typeMap->checkedReferences(n)) {
+        if (changedNames.contains(name)) {
+            LOG3("TI " << dbp(n) << " depends on changed " << name);
+            typeMap->forget(n);
+            return false;
+        }
+    }
+    return true;
+}
+
+void TypeInferenceBase::skipChecked(const IR::Node *n) const {
+    LOG3("TI Skipping unchanged " << dbp(n));
+    getChildContext()->child_index++;
+}
+
+void TypeInferenceBase::setChecked(const IR::Node *n) {
+    typeMap->setChecked(n, referencedNames(n));
+}
+
+TypeMap::NameSet TypeInferenceBase::referencedNames(const IR::Node *node) {
+    // Collects the names referred to by paths.
+    class ReferencedNames : public Inspector {
+     public:
+        TypeMap::NameSet names;
+        ReferencedNames() { setName("ReferencedNames"); }
+        void postorder(const IR::Path *path) override { names.insert(path->name.name); }
+    } references;
+    node->apply(references);
+    return std::move(references.names);
+}
+
+void TypeInferenceBase::addDeclaredNames(const IR::Node *decl, TypeMap::NameSet &names) {
+    if (const auto *matchKind = decl->to<IR::Declaration_MatchKind>()) {
+        for (const auto *member : matchKind->members) names.insert(member->name.name);
+    } else if (const auto *declaration = decl->to<IR::IDeclaration>()) {
+        names.insert(declaration->getName().name);
+    }
+}
+
 const IR::Type *TypeInferenceBase::getType(const IR::Node *element) const {
     const IR::Type *result = typeMap->getType(element);
     // This should be happening only when type-checking already failed
@@ -82,6 +82,9 @@ class TypeInferenceBase : public virtual Visitor, public ResolutionContext {
     TypeMap *typeMap;
     const IR::Node *initialNode;
     std::shared_ptr<MinimalNameGenerator> nameGen;
+    // In incremental mode, the names declared by the top-level declarations which were
+    // visited, or removed from the program, since the start of this traversal.
+    TypeMap::NameSet changedNames;
 
  public:
     // Node itself + flag whether we'd prune()
@@ -100,6 +103,7 @@ class TypeInferenceBase : public virtual Visitor, public ResolutionContext {
     bool checkArrays = true;
     bool errorOnNullDecls = false;
     const IR::Node *getInitialNode() const { return initialNode; }
+    const TypeMap *getTypeMap() const { return typeMap; }
     const IR::Type *getType(const IR::Node *element) const;
     const IR::Type *getTypeType(const IR::Node *element) const;
     void setType(const IR::Node *element, const IR::Type *type);
@@ -118,6 +122,34 @@ class TypeInferenceBase : public virtual Visitor, public ResolutionContext {
     // (visitDagOnce cannot take care of this).
     bool done() const;
 
+    // In incremental mode (see TypeMap::incremental) the top-level declarations of the
+    // program which were checked before and have not changed since (they are the same node)
+    // are not visited again, unless they refer to a declaration which was visited again,
+    // added or removed.  Called by apply_visitor, with @visit visiting @n.
+    template <class Visit>
+    const IR::Node *visitIncrementally(const IR::Node *n, const char *name, Visit visit) {
+        if (!typeMap->incremental || n == nullptr || !isProgramObject()) return visit(n, name);
+        if (checkUnchanged(n)) {
+            skipChecked(n);
+            return n;
+        }
+        unsigned errors = ::P4::errorCount();
+        const IR::Node *result = visit(n, name);
+        addDeclaredNames(n, changedNames);
+        if (result && ::P4::errorCount() == errors) setChecked(result);
+        return result;
+    }
+    bool isProgramObject() const;
+    // True if @n was checked and the declarations it refers to did not change.  Otherwise,
+    // if @n was checked, its types may be stale, and are removed from the type map.
+    bool checkUnchanged(const IR::Node *n);
+    void skipChecked(const IR::Node *n) const;
+    void setChecked(const IR::Node *n);
+    // @returns the names referred to by paths in @node.
+    static TypeMap::NameSet referencedNames(const IR::Node *node);
+    // Adds the names declared by the top-level declaration @decl to @names.
+    static void addDeclaredNames(const IR::Node *decl, TypeMap::NameSet &names);
+
     TypeVariableSubstitution *unifyBase(bool allowCasts, const IR::Node *errorPosition,
                                         const IR::Type *destType, const IR::Type *srcType,
                                         std::string_view errorFormat,
@@ -354,6 +386,13 @@ class TypeInferenceBase : public virtual Visitor, public ResolutionContext {
     void finish(const IR::Node *Node);
 
     ReadOnlyTypeInference *readOnlyClone() const;
+    // Give this copy of a type inference its own fork of the type map, used to infer some
+    // declarations on a worker thread; mergeTypeMap adds the result to the original map.
+    void forkTypeMap();
+    void mergeTypeMap(const TypeInferenceBase &fork) {
+        typeMap->merge(*fork.typeMap);
+        changedNames.insert(fork.changedNames.begin(), fork.changedNames.end());
+    }
     // Apply recursively the typechecker to the newly created node
     // to add all component subtypes in the typemap.
     // Return 'true' if errors were discovered in the learning process.
@@ -375,6 +414,7 @@ class ReadOnlyTypeInference : public virtual Inspector, public TypeInferenceBase
         : TypeInferenceBase(typeMap, true, checkArrays, errorOnNullDecls) {}
 
     Visitor::profile_t init_apply(const IR::Node *node) override;
+    const IR::Node *apply_visitor(const IR::Node *, const char *name = nullptr) override;
     void end_apply(const IR::Node *Node) override;
 
     bool preorder(const IR::Expression *) override { return !done(); }
@@ -510,6 +550,8 @@ class TypeInference : public virtual Transform, public TypeInferenceBase {
     Visitor::profile_t init_apply(const IR::Node *node) override;
     const IR::Node *apply_visitor(const IR::Node *, const char *name = nullptr) override;
     void end_apply(const IR::Node *Node) override;
+    TypeInference *clone() const override;
+    void parallel_merge(Visitor &v) override;
 
     const IR::Node *pruneIfDone(const IR::Node *node) {
         if (done()) Transform::prune();
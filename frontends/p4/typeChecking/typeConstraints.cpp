@@ -23,7 +23,7 @@ limitations under the License.
 
 namespace P4 {
 
-int TypeConstraint::crtid = 0;
+std::atomic<int> TypeConstraint::crtid = 0;
 
 void TypeConstraints::addEqualityConstraint(const IR::Node *source, const IR::Type *left,
                                             const IR::Type *right) {
@@ -46,6 +46,7 @@ TypeVariableSubstitution *TypeConstraints::solve() {
         bool success = solve(last->to<P4::BinaryConstraint>());
         if (!success) return nullptr;
     }
+    currentSubstitution->resolve();
     LOG3("Constraint solution:\n" << currentSubstitution);
     return currentSubstitution;
 }
@@ -67,8 +68,8 @@ bool TypeConstraints::solve(const BinaryConstraint *constraint) {
         if (constraint->left == constraint->right) return true;
 
         // check to see whether we already have a substitution for leftTv
-        const IR::Type *leftSubst = currentSubstitution->lookup(leftTv);
-        if (leftSubst == nullptr) {
+        const IR::Type *leftSubst = currentSubstitution->find(leftTv);
+        if (leftSubst == constraint->left) {
             auto right = constraint->right->apply(replaceVariables)->to<IR::Type>();
             if (leftTv == right->to<IR::ITypeVar>()) return true;
             LOG3("Binding " << leftTv << " => " << right);
@@ -85,8 +86,8 @@ bool TypeConstraints::solve(const BinaryConstraint *constraint) {
 
     if (isUnifiableTypeVariable(constraint->right)) {
         auto rightTv = constraint->right->to<IR::ITypeVar>();
-        const IR::Type *rightSubst = currentSubstitution->lookup(rightTv);
-        if (rightSubst == nullptr) {
+        const IR::Type *rightSubst = currentSubstitution->find(rightTv);
+        if (rightSubst == constraint->right) {
             auto left = constraint->left->apply(replaceVariables)->to<IR::Type>();
             if (left->to<IR::ITypeVar>() == rightTv) return true;
             LOG3("Binding " << rightTv << " => " << left);
@@ -17,6 +17,8 @@ limitations under the License.
 #ifndef FRONTENDS_P4_TYPECHECKING_TYPECONSTRAINTS_H_
 #define FRONTENDS_P4_TYPECHECKING_TYPECONSTRAINTS_H_
 
+#include <atomic>
+
 #include "ir/ir.h"
 #include "lib/castable.h"
 #include "lib/error_helper.h"
@@ -55,7 +57,7 @@ class Explain : public Inspector {
 
 class TypeConstraint : public IHasDbPrint, public ICastable {
     int id;  // for debugging
-    static int crtid;
+    static std::atomic<int> crtid;
     /// The following are used when reporting errors.
     cstring errFormat;
     std::vector<const IR::Node *> errArguments;
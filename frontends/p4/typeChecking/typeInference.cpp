@@ -12,7 +12,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "absl/container/flat_hash_set.h"
 #include "ir/dump.h"
+#include "lib/thread_pool.h"
 #include "typeChecker.h"
 
 namespace P4 {
@@ -26,11 +28,74 @@ namespace P4 {
     }
 
 DEFINE_PREORDER(IR::Function)
-DEFINE_PREORDER(IR::P4Program)
 DEFINE_PREORDER(IR::Declaration_Instance)
 DEFINE_PREORDER(IR::EntriesList)
 DEFINE_PREORDER(IR::Type_SerEnum)
 
+const IR::Node *TypeInference::preorder(IR::P4Program *program) {
+    auto [res, done] = TypeInferenceBase::preorder(program);
+    if (done) Transform::prune();
+    if (done || !getTypeMap()->parallel || Util::ThreadPool::inWorker()) return res;
+
+    // Top-level parsers, controls, actions and functions only depend on the objects
+    // declared before them, so a run of them which do not refer to each other can be
+    // inferred concurrently.  The other objects are inferred in order, as usual.  Every batch
+    // costs a fork of the type map and a copy of the name caches per worker (see
+    // TypeMap::parallel), so batches of a single object are inferred in place.
+    IR::Vector<IR::Node> objects;
+    auto add = [&objects](const IR::Node *result) {
+        if (!result) return;
+        if (const auto *vec = result->to<IR::VectorBase>()) {
+            for (const auto *el : *vec) objects.push_back(el);
+        } else {
+            objects.push_back(result);
+        }
+    };
+    std::vector<const IR::Node *> batch;
+    absl::flat_hash_set<cstring, Util::Hash> batchNames;
+    auto flush = [&]() {
+        std::optional<std::vector<const IR::Node *>> results;
+        if (batch.size() > 1) results = parallel_transform(batch, "objects");
+        if (results) {
+            for (const auto *result : *results) add(result);
+        } else {
+            for (const auto *obj : batch) add(apply_visitor(obj, "objects"));
+        }
+        batch.clear();
+        batchNames.clear();
+    };
+    for (const auto *obj : program->objects) {
+        if (!obj->is<IR::P4Parser>() && !obj->is<IR::P4Control>() && !obj->is<IR::P4Action>() &&
+            !obj->is<IR::Function>()) {
+            flush();
+            add(apply_visitor(obj, "objects"));
+            continue;
+        }
+        for (auto name : referencedNames(obj)) {
+            if (batchNames.count(name)) {
+                flush();
+                break;
+            }
+        }
+        batch.push_back(obj);
+        batchNames.insert(obj->to<IR::IDeclaration>()->getName().name);
+    }
+    flush();
+    program->objects = std::move(objects);
+    Transform::prune();
+    return program;
+}
+
+TypeInference *TypeInference::clone() const {
+    auto *rv = new TypeInference(*this);
+    rv->forkTypeMap();
+    return rv;
+}
+
+void TypeInference::parallel_merge(Visitor &v) {
+    mergeTypeMap(dynamic_cast<TypeInference &>(v));
+}
+
 #define DEFINE_POSTORDER(type) \
     const IR::Node *TypeInference::postorder(type *n) { return TypeInferenceBase::postorder(n); }
 
@@ -159,7 +224,10 @@ void TypeInference::end_apply(const IR::Node *node) {
 }
 
 const IR::Node *TypeInference::apply_visitor(const IR::Node *orig, const char *name) {
-    const auto *transformed = Transform::apply_visitor(orig, name);
+    const auto *transformed =
+        visitIncrementally(orig, name, [this](const IR::Node *n, const char *name) {
+            return Transform::apply_visitor(n, name);
+        });
     BUG_CHECK(!readOnly || orig == transformed,
               "At this point in the compilation typechecking should not infer new types anymore, "
               "but it did: node %1% changed to %2%",
@@ -5,6 +5,10 @@
 
 #include "typeSubstitution.h"
 
+#include <functional>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
 #include "frontends/p4/typeMap.h"
 #include "lib/cstring.h"
 #include "typeConstraints.h"
@@ -32,9 +36,17 @@ cstring TypeVariableSubstitution::compose(const IR::ITypeVar *var, const IR::Typ
         }
     }
 
+    // A variable which is bound to var through a chain of variables is already implied
+    if (auto tv = substitution->to<IR::ITypeVar>()) {
+        if (find(tv) == var->asType()) {
+            LOG3("Ignoring substitution already implied " << var << "->" << substitution);
+            return cstring::empty;
+        }
+    }
+
     // First check whether the substitution is legal.
-    // It is not if var occurs in substitution
-    TypeOccursVisitor occurs(var);
+    // It is not if var occurs in substitution, once the bound variables are substituted
+    TypeOccursVisitor occurs(var, this);
     substitution->apply(occurs);
     if (occurs.occurs) return "'%1%' cannot be replaced with '%2%' which already contains it"_cs;
 
@@ -45,36 +57,83 @@ cstring TypeVariableSubstitution::compose(const IR::ITypeVar *var, const IR::Typ
             substitution->toString(), bound->toString());
     }
 
-    // Replace var with substitution everywhere
-    TypeVariableSubstitution *tvs = new TypeVariableSubstitution();
-    bool success = tvs->setBinding(var, substitution);
-    if (!success) BUG("Cannot set binding");
-
-    TypeVariableSubstitutionVisitor visitor(tvs);
-    bool cycle = false;  // set if we detect X -> V and V -> X substitutions.
-    for (auto &bound : binding) {
-        const IR::Type *type = bound.second;
-        const IR::Node *newType = type->apply(visitor);
-        if (newType == nullptr) return "Could not replace '%1%' with '%2%'"_cs;
-        if (newType == type) continue;
-
-        if (bound.first->asType() == newType) {
-            cycle = true;
-        } else {
-            LOG3("Refining substitution for " << bound.first->getNode() << " to " << newType);
-            bound.second = newType->to<IR::Type>();
-        }
+    // The types bound to other variables may contain var: they are not rewritten here, but
+    // in resolve(), once all the variables are bound.
+    LOG3("Actual binding " << var << " " << dbp(var) << "->" << dbp(substitution) << "="
+                           << substitution);
+    bool success = setBinding(var, substitution);
+    if (!success) BUG("Failed to insert binding");
+    return cstring::empty;
+}
+
+const IR::Type *TypeVariableSubstitution::find(const IR::ITypeVar *var) {
+    const IR::Type *type = var->asType();
+    std::vector<const IR::ITypeVar *> chain;
+    while (const auto *tv = type->to<IR::ITypeVar>()) {
+        auto it = binding.find(tv);
+        if (it == binding.end()) break;
+        chain.push_back(tv);
+        type = it->second;
     }
+    // Bindings never change once set, so the variables on the chain can skip it.
+    if (chain.size() > 1)
+        for (const auto *tv : chain) binding[tv] = type;
+    return type;
+}
+
+namespace {
 
-    if (cycle) {
-        LOG3("Ignoring substitution already implied " << var << "->" << substitution);
-    } else {
-        LOG3("Actual binding " << var << " " << dbp(var) << "->" << dbp(substitution) << "="
-                               << substitution);
-        success = setBinding(var, substitution);
-        if (!success) BUG("Failed to insert binding");
+/// Substitutes the bound variables in a type, resolving their bindings first
+/// (see TypeVariableSubstitution::resolve).
+class ResolveBindings : public TypeVariableSubstitutionVisitor {
+    const std::function<const IR::Type *(const IR::ITypeVar *)> &resolved;
+
+    const IR::Node *substitute(const IR::ITypeVar *var, const IR::Node *node) {
+        const IR::Type *type = resolved(var);
+        if (type == nullptr) return node;
+        // the resolved type contains no bound variables
+        prune();
+        return type;
     }
-    return cstring::empty;
+
+ public:
+    ResolveBindings(const TypeVariableSubstitution *bindings,
+                    const std::function<const IR::Type *(const IR::ITypeVar *)> &resolved)
+        : TypeVariableSubstitutionVisitor(bindings), resolved(resolved) {
+        setName("ResolveBindings");
+    }
+    const IR::Node *preorder(IR::Type_Any *tv) override {
+        return substitute(getOriginal<IR::Type_Any>(), tv);
+    }
+    const IR::Node *preorder(IR::Type_Var *tv) override {
+        return substitute(getOriginal<IR::Type_Var>(), tv);
+    }
+    const IR::Node *preorder(IR::Type_InfInt *ti) override {
+        return substitute(getOriginal<IR::Type_InfInt>(), ti);
+    }
+};
+
+}  // namespace
+
+void TypeVariableSubstitution::resolve() {
+    absl::flat_hash_set<const IR::ITypeVar *, Util::Hash> resolved;
+    // Returns the resolved type bound to var, or nullptr if var is not bound.
+    std::function<const IR::Type *(const IR::ITypeVar *)> resolveBinding;
+    resolveBinding = [&](const IR::ITypeVar *var) -> const IR::Type * {
+        auto it = binding.find(var);
+        if (it == binding.end()) return nullptr;
+        // The occurs check in compose() guarantees that the bindings have no cycles.
+        if (resolved.insert(var).second) {
+            ResolveBindings visitor(this, resolveBinding);
+            const auto *type = it->second->apply(visitor)->to<IR::Type>();
+            if (type != it->second)
+                LOG3("Refining substitution for " << var->getNode() << " to " << type);
+            it->second = type;
+        }
+        return it->second;
+    };
+    for (auto &bound : binding) resolveBinding(bound.first);
+    debugValidate();
 }
 
 void TypeVariableSubstitution::simpleCompose(const TypeVariableSubstitution *other) {
@@ -8,6 +8,7 @@
 #ifndef FRONTENDS_P4_TYPECHECKING_TYPESUBSTITUTION_H_
 #define FRONTENDS_P4_TYPECHECKING_TYPESUBSTITUTION_H_
 
+#include <iterator>
 #include <map>
 #include <sstream>
 
@@ -59,6 +60,15 @@ class TypeSubstitution : public IHasDbPrint {
     }
 
     void clear() { binding.clear(); }
+
+    size_t size() const { return binding.size(); }
+
+    /// Add the @count bindings made last in @other, for keys which are not bound here.
+    void mergeLast(const TypeSubstitution &other, size_t count) {
+        auto it = other.binding.end();
+        std::advance(it, -static_cast<std::ptrdiff_t>(count));
+        for (; it != other.binding.end(); ++it) binding.emplace(it->first, it->second);
+    }
 };
 
 class TypeVariableSubstitution final : public TypeSubstitution<const IR::ITypeVar *> {
@@ -67,10 +77,21 @@ class TypeVariableSubstitution final : public TypeSubstitution<const IR::ITypeVa
     TypeVariableSubstitution(const TypeVariableSubstitution &other) = default;
     bool setBindings(const IR::Node *errorLocation, const IR::TypeParameters *params,
                      const IR::Vector<IR::Type> *args);
+    /// Bind 'var' to 'substitution'.  The types already bound are not rewritten: the
+    /// bindings are kept in triangular form, where a bound type may contain variables which
+    /// are bound as well, until resolve() substitutes them.
     /// Returns an empty string on error, or an error message format otherwise.
     /// The error message should be used with 'var' and 'substitution' as arguments when
     /// reporting an error (i.e., it may contain %1% and %2% inside).
     cstring compose(const IR::ITypeVar *var, const IR::Type *substitution);
+    /// Follow the chain of variables bound to variables which starts at 'var', and return
+    /// the type at its end: an unbound variable ('var' itself if it is not bound), or the
+    /// type bound to the last variable.  All the variables on the chain are bound directly
+    /// to that type (path compression), so following the chain again takes constant time.
+    const IR::Type *find(const IR::ITypeVar *var);
+    /// Substitute the bound variables in the bound types, so that they contain no bound
+    /// variables.  Each bound type is only traversed once.
+    void resolve();
     // In this variant of compose all variables in 'other' that are
     // assigned to are disjoint from all variables already in 'this'.
     void simpleCompose(const TypeVariableSubstitution *other);
@@ -7,14 +7,21 @@
 
 namespace P4 {
 
-bool TypeOccursVisitor::preorder(const IR::Type_Var *typeVariable) {
-    if (*typeVariable == *(toFind->asType())) occurs = true;
+bool TypeOccursVisitor::occursIn(const IR::Type *typeVariable) {
+    if (*typeVariable == *(toFind->asType())) {
+        occurs = true;
+    } else if (bindings) {
+        if (const auto *bound = bindings->lookup(typeVariable->to<IR::ITypeVar>())) visit(bound);
+    }
     return occurs;
 }
 
+bool TypeOccursVisitor::preorder(const IR::Type_Var *typeVariable) {
+    return occursIn(typeVariable);
+}
+
 bool TypeOccursVisitor::preorder(const IR::Type_InfInt *typeVariable) {
-    if (*typeVariable == *(toFind->asType())) occurs = true;
-    return occurs;
+    return occursIn(typeVariable);
 }
 
 const IR::Node *TypeVariableSubstitutionVisitor::preorder(IR::TypeParameters *tps) {
@@ -19,13 +19,20 @@ namespace P4 {
 /**
  * See if a variable occurs in a Type.
  * If true, return null, else return the original type.
+ * If 'bindings' are given, the variable is also looked for in the types bound to the
+ * variables which occur in the Type.
  */
 class TypeOccursVisitor : public Inspector {
+    const TypeVariableSubstitution *bindings;
+    bool occursIn(const IR::Type *typeVariable);
+
  public:
     const IR::ITypeVar *toFind;
     bool occurs;
 
-    explicit TypeOccursVisitor(const IR::ITypeVar *toFind) : toFind(toFind), occurs(false) {
+    explicit TypeOccursVisitor(const IR::ITypeVar *toFind,
+                               const TypeVariableSubstitution *bindings = nullptr)
+        : bindings(bindings), toFind(toFind), occurs(false) {
         setName("TypeOccurs");
     }
     bool preorder(const IR::Type_Var *typeVariable) override;
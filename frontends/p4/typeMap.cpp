@@ -5,6 +5,8 @@
 
 #include "typeMap.h"
 
+#include <algorithm>
+
 namespace P4 {
 
 bool TypeMap::typeIsEmpty(const IR::Type *type) const {
@@ -56,7 +58,8 @@ void TypeMap::setCompileTimeConstant(const IR::Expression *expression) {
 }
 
 bool TypeMap::isCompileTimeConstant(const IR::Expression *expression) const {
-    bool result = constants.find(expression) != constants.end();
+    bool result = constants.find(expression) != constants.end() ||
+                  (base && !isForgotten(expression) && base->isCompileTimeConstant(expression));
     LOG3(dbp(expression) << (result ? " constant" : " not constant"));
     return result;
 }
@@ -69,16 +72,119 @@ void TypeMap::cloneExpressionProperties(const IR::Expression *to, const IR::Expr
     if (isCompileTimeConstant(from)) setCompileTimeConstant(to);
 }
 
+void TypeMap::nodeReplaced(const IR::Node *node, const IR::Node *replacement) {
+    if (replacement == nullptr || contains(replacement)) return;
+    const auto *type = lookupType(node);
+    if (type == nullptr) return;
+    LOG3("Preserving type of " << dbp(node) << " for " << dbp(replacement));
+    typeMap.emplace(replacement, type);
+    auto *from = node->to<IR::Expression>();
+    auto *to = replacement->to<IR::Expression>();
+    if (!from || !to) return;
+    if (isLeftValue(from)) setLeftValue(to);
+    if (isCompileTimeConstant(from)) setCompileTimeConstant(to);
+}
+
 void TypeMap::clear() {
     LOG3("Clearing typeMap");
     typeMap.clear();
     leftValues.clear();
     constants.clear();
     allTypeVariables.clear();
+    checkedDeclarations.clear();
+    base = nullptr;
+    forgotten.clear();
     program = nullptr;
     ProgramMap::clear();
 }
 
+TypeMap::TypeMap(const TypeMap *base)
+    : ProgramMap(*base),
+      canonicalTuples(base->canonicalTuples),
+      canonicalStacks(base->canonicalStacks),
+      canonicalP4lists(base->canonicalP4lists),
+      canonicalLists(base->canonicalLists),
+      allTypeVariables(base->allTypeVariables),
+      base(base),
+      baseSizes{base->allTypeVariables.size(), base->canonicalTuples.size(),
+                base->canonicalStacks.size(), base->canonicalP4lists.size(),
+                base->canonicalLists.size()},
+      strictStruct(base->strictStruct),
+      incremental(base->incremental),
+      parallel(base->parallel) {}
+
+const IR::Type *TypeMap::lookupType(const IR::Node *element) const {
+    if (auto it = typeMap.find(element); it != typeMap.end()) return it->second;
+    if (base && !isForgotten(element)) return base->lookupType(element);
+    return nullptr;
+}
+
+const TypeMap::CheckedDeclaration *TypeMap::findChecked(const IR::Node *decl) const {
+    if (auto it = checkedDeclarations.find(decl->clone_id); it != checkedDeclarations.end())
+        return &it->second;
+    return base ? base->findChecked(decl) : nullptr;
+}
+
+void TypeMap::merge(const TypeMap &fragment) {
+    BUG_CHECK(fragment.base == this, "Merging a type map which is not a fork of this one");
+    // Only the fork's own entries are added; the rest of it is this map.
+    for (const auto *node : fragment.forgotten) {
+        typeMap.erase(node);
+        if (const auto *expression = node->to<IR::Expression>()) {
+            leftValues.erase(expression);
+            constants.erase(expression);
+        }
+    }
+    for (auto [node, type] : fragment.typeMap) typeMap.emplace(node, type);
+    leftValues.insert(fragment.leftValues.begin(), fragment.leftValues.end());
+    constants.insert(fragment.constants.begin(), fragment.constants.end());
+    allTypeVariables.mergeLast(fragment.allTypeVariables,
+                               fragment.allTypeVariables.size() - fragment.baseSizes.typeVariables);
+    for (const auto &[cloneId, checked] : fragment.checkedDeclarations) {
+        // keep the latest version of each declaration
+        auto [it, inserted] = checkedDeclarations.emplace(cloneId, checked);
+        if (!inserted && it->second.decl->id < checked.decl->id) it->second = checked;
+    }
+    auto mergeCanonical = [](std::vector<const IR::Type *> &to,
+                             const std::vector<const IR::Type *> &from, size_t baseSize) {
+        for (auto it = from.begin() + baseSize; it != from.end(); ++it)
+            if (std::find(to.begin(), to.end(), *it) == to.end()) to.push_back(*it);
+    };
+    mergeCanonical(canonicalTuples, fragment.canonicalTuples, fragment.baseSizes.tuples);
+    mergeCanonical(canonicalStacks, fragment.canonicalStacks, fragment.baseSizes.stacks);
+    mergeCanonical(canonicalP4lists, fragment.canonicalP4lists, fragment.baseSizes.p4lists);
+    mergeCanonical(canonicalLists, fragment.canonicalLists, fragment.baseSizes.lists);
+}
+
+void TypeMap::forget(const IR::Node *node) {
+    struct Forget : public Inspector {
+        TypeMap &map;
+        explicit Forget(TypeMap &map) : map(map) { setName("ForgetTypes"); }
+        void postorder(const IR::Node *node) override {
+            map.typeMap.erase(node);
+            if (const auto *expression = node->to<IR::Expression>()) {
+                map.leftValues.erase(expression);
+                map.constants.erase(expression);
+            }
+            if (map.base) map.forgotten.insert(node);
+        }
+    } forget(*this);
+    node->apply(forget);
+}
+
+std::vector<const IR::Node *> TypeMap::staleDeclarations(
+    const IR::Vector<IR::Node> &objects) const {
+    absl::flat_hash_set<const IR::Node *, Util::Hash> current(objects.begin(), objects.end());
+    std::vector<const IR::Node *> result;
+    for (const auto &[cloneId, checked] : checkedDeclarations)
+        if (!current.contains(checked.decl)) result.push_back(checked.decl);
+    if (base) {
+        for (const auto *decl : base->staleDeclarations(objects))
+            if (!checkedDeclarations.contains(decl->clone_id)) result.push_back(decl);
+    }
+    return result;
+}
+
 void TypeMap::checkPrecondition(const IR::Node *element, const IR::Type *type) const {
     CHECK_NULL(element);
     CHECK_NULL(type);
@@ -88,20 +194,19 @@ void TypeMap::checkPrecondition(const IR::Node *element, const IR::Type *type) c
 
 void TypeMap::setType(const IR::Node *element, const IR::Type *type) {
     checkPrecondition(element, type);
-    auto [it, inserted] = typeMap.emplace(element, type);
-    if (!inserted) {
-        const IR::Type *existingType = it->second;
+    if (const IR::Type *existingType = lookupType(element)) {
         if (!implicitlyConvertibleTo(type, existingType))
             BUG("Changing type of %1% in type map from %2% to %3%", dbp(element), dbp(existingType),
                 dbp(type));
         return;
     }
+    typeMap.emplace(element, type);
     LOG3("setType " << dbp(element) << " => " << dbp(type));
 }
 
 const IR::Type *TypeMap::getType(const IR::Node *element, bool notNull) const {
     CHECK_NULL(element);
-    const auto *result = get(typeMap, element);
+    const auto *result = lookupType(element);
     LOG4("Looking up type for " << dbp(element) << " => " << dbp(result));
     if (notNull && result == nullptr)
         BUG_CHECK(errorCount() > 0, "Could not find type for %1%", dbp(element));
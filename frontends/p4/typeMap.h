@@ -30,6 +30,10 @@ Objects that have a type in the map:
 - type declarations - map name to the actual type
 */
 class TypeMap final : public ProgramMap {
+ public:
+    using NameSet = absl::flat_hash_set<cstring, Util::Hash>;
+
+ private:
     // We want to have the same canonical type for two
     // different tuples, lists, stacks, or p4lists with the same signature.
     std::vector<const IR::Type *> canonicalTuples;
@@ -49,28 +53,94 @@ class TypeMap final : public ProgramMap {
     // type that is substituted for it.
     TypeVariableSubstitution allTypeVariables;
 
+    // Top-level declarations checked without errors by a type inference using this map,
+    // indexed by clone_id: re-checking a rewritten version of a declaration replaces the
+    // entry of the old version.
+    struct CheckedDeclaration {
+        const IR::Node *decl;
+        // The names referred to in the declaration: the declarations it depends on.
+        NameSet references;
+    };
+    absl::flat_hash_map<int, CheckedDeclaration> checkedDeclarations;
+
+    // The map this one is a fork of (see TypeMap(const TypeMap *)), or nullptr.  A fork only
+    // holds what was added to it, and looks up everything else in its base.
+    const TypeMap *base = nullptr;
+    // Nodes whose properties in the base were removed from a fork by forget().
+    absl::flat_hash_set<const IR::Node *, Util::Hash> forgotten;
+    // The number of type variable bindings and of canonical types of the base when the
+    // fork was made; the ones after them were added to the fork.
+    struct {
+        size_t typeVariables = 0, tuples = 0, stacks = 0, p4lists = 0, lists = 0;
+    } baseSizes;
+
     // checks some preconditions before setting the type
     void checkPrecondition(const IR::Node *element, const IR::Type *type) const;
+    const IR::Type *lookupType(const IR::Node *element) const;
+    const CheckedDeclaration *findChecked(const IR::Node *decl) const;
+    bool isForgotten(const IR::Node *node) const { return forgotten.contains(node); }
 
  public:
     TypeMap() : ProgramMap("TypeMap"), strictStruct(false) {}
+    /// Makes a fork of @base, used to type a part of the program on a worker thread.  The
+    /// fork starts out empty and looks up what it does not hold in @base, which must not be
+    /// modified while the fork is in use.  @base.merge(fork) adds what the fork holds.
+    explicit TypeMap(const TypeMap *base);
 
     /// If true we require structs to have the same name to be
     /// equivalent, if false only that the have the same fields.
     bool strictStruct;
     void setStrictStruct(bool value) { strictStruct = value; }
-    bool contains(const IR::Node *element) { return typeMap.count(element) != 0; }
+    /// If true, type inference only re-infers the top-level declarations of the program
+    /// which changed since they were last checked with this map.
+    bool incremental = false;
+    void setIncremental(bool value) { incremental = value; }
+    /// If true, type inference infers independent top-level declarations of the program
+    /// concurrently, each worker using a fork of this map which is merged back with merge().
+    /// Each worker also copies the ResolutionContext name caches of the inference, and the
+    /// workers' types are merged serially, so this only pays off when the declarations take
+    /// much longer to infer than that.  It has not been measured to be faster yet, so it is
+    /// off by default (see --parallel-typecheck).
+    bool parallel = false;
+    void setParallel(bool value) { parallel = value; }
+    /// True if @decl is a top-level declaration which was checked without errors, and has
+    /// not been rewritten since.
+    bool isChecked(const IR::Node *decl) const {
+        const auto *checked = findChecked(decl);
+        return checked && checked->decl == decl;
+    }
+    /// The names referred to in @decl, which must be checked.
+    const NameSet &checkedReferences(const IR::Node *decl) const {
+        return findChecked(decl)->references;
+    }
+    /// Records that @decl, which refers to @references, was checked without errors.
+    void setChecked(const IR::Node *decl, NameSet references) {
+        checkedDeclarations[decl->clone_id] = {decl, std::move(references)};
+    }
+    /// Removes the types and properties of @node and the nodes below it.
+    void forget(const IR::Node *node);
+    /// @returns the checked declarations which are not among @objects, because they were
+    /// removed from the program or rewritten.
+    std::vector<const IR::Node *> staleDeclarations(const IR::Vector<IR::Node> &objects) const;
+    bool contains(const IR::Node *element) { return lookupType(element) != nullptr; }
     void setType(const IR::Node *element, const IR::Type *type);
     const IR::Type *getType(const IR::Node *element, bool notNull = false) const;
     // unwraps a TypeType into its contents
     const IR::Type *getTypeType(const IR::Node *element, bool notNull) const;
     void dbprint(std::ostream &out) const override;
     void clear();
+    /// Add the information in @fragment, a fork of this map which has been used to type
+    /// some other part of the program, to this map.
+    void merge(const TypeMap &fragment);
+    /// Give @replacement the type and properties of @node, as it has been produced by a
+    /// pass which preserves types.
+    void nodeReplaced(const IR::Node *node, const IR::Node *replacement) override;
     bool isLeftValue(const IR::Expression *expression) const {
-        return leftValues.count(expression) > 0;
+        return leftValues.count(expression) > 0 ||
+               (base && !isForgotten(expression) && base->isLeftValue(expression));
     }
     bool isCompileTimeConstant(const IR::Expression *expression) const;
-    size_t size() const { return typeMap.size(); }
+    size_t size() const { return typeMap.size() + (base ? base->size() : 0); }
 
     void setLeftValue(const IR::Expression *expression);
     void cloneExpressionProperties(const IR::Expression *to, const IR::Expression *from);
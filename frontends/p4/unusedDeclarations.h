@@ -18,6 +18,7 @@ limitations under the License.
 #define FRONTENDS_P4_UNUSEDDECLARATIONS_H_
 
 #include "../common/resolveReferences/resolveReferences.h"
+#include "frontends/p4/typeMap.h"
 #include "ir/ir.h"
 #include "ir/pass_manager.h"
 #include "lib/stringify.h"
@@ -135,6 +136,12 @@ class UnusedDeclarations : public Transform, ResolutionContext {
                        bool infoRemoved)
         : used(used), removeUnused(removeUnused), warnUnused(warnUnused), infoRemoved(infoRemoved) {
         setName("UnusedDeclarations");
+        // Subtrees without declarations are skipped; subclasses with a preorder for other
+        // nodes must widen this.
+        onlyVisitSubtreesWith<IR::Declaration, IR::Type_Declaration, IR::Type_Method,
+                              IR::Declaration_MatchKind>();
+        // Declarations are only removed, which does not change the types of the rest.
+        preserves<TypeMap>();
     }
 
  public:
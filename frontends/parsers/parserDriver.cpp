@@ -74,10 +74,9 @@ AbstractParserDriver::AbstractParserDriver() : sources(new Util::InputSources())
 AbstractParserDriver::~AbstractParserDriver() {}
 
 void AbstractParserDriver::onReadToken(const char *text) {
-    auto posBeforeToken = sources->getCurrentPosition();
+    auto offsetBeforeToken = sources->getCurrentOffset();
     sources->appendText(text);
-    auto posAfterToken = sources->getCurrentPosition();
-    yylloc = Util::SourceInfo(sources, posBeforeToken, posAfterToken);
+    yylloc = Util::SourceInfo::fromOffsets(sources, offsetBeforeToken, sources->getCurrentOffset());
 }
 
 void AbstractParserDriver::onReadLineNumber(const char *text) {
@@ -154,6 +153,75 @@ bool P4ParserDriver::parse(AbstractP4Lexer &lexer, std::string_view sourceFile,
     return parse(inputStream.get(), sourceFile, sourceLine);
 }
 
+/* static */ const IR::P4Program *P4ParserDriver::parse(std::istream &in,
+                                                        std::string_view sourceFile,
+                                                        const IR::P4Program *prefix) {
+    LOG1("Parsing P4-16 program " << sourceFile << " after " << prefix->objects.size()
+                                  << " precompiled declarations");
+
+    P4ParserDriver driver;
+    auto objects = driver.declarePrefix(prefix);
+    P4Lexer lexer(in);
+    if (!driver.parse(lexer, sourceFile)) return nullptr;
+    IR::P4Program *rv = driver.result->to<IR::P4Program>();
+    BUG_CHECK(rv, "parse result is not a program?");
+    rv->objects.insert(rv->objects.begin(), objects.begin(), objects.end());
+    return rv;
+}
+
+safe_vector<const IR::Node *> P4ParserDriver::declarePrefix(const IR::P4Program *prefix) {
+    // The same names are declared as by the actions of the grammar.
+    auto declareArchBlock = [this](const IR::Type_ArchBlock *type, bool allowDuplicates) {
+        structure->pushContainerType(type->name, allowDuplicates);
+        if (!type->typeParameters->empty()) structure->markAsTemplate(type->name);
+        structure->pop();
+    };
+    auto declareFunction = [this](IR::ID name, const IR::Type_Method *type) {
+        structure->declareObject(name, type->returnType ? type->returnType->toString()
+                                                        : cstring::empty);
+        if (!type->typeParameters->empty()) structure->markAsTemplate(name);
+    };
+
+    safe_vector<const IR::Node *> objects;
+    for (const auto *node : prefix->objects) {
+        if (const auto *error = node->to<IR::Type_Error>()) {
+            // user declarations are added to the members of the first declaration
+            node = allErrors = error->clone();
+        } else if (const auto *matchKind = node->to<IR::Declaration_MatchKind>()) {
+            node = allMatchKinds = matchKind->clone();
+        } else if (const auto *type = node->to<IR::Type_StructLike>()) {
+            structure->pushContainerType(type->name, true);
+            structure->markAsTemplate(type->name);
+            structure->pop();
+        } else if (const auto *type = node->to<IR::Type_Extern>()) {
+            structure->pushContainerType(type->name, true);
+            if (!type->typeParameters->empty()) structure->markAsTemplate(type->name);
+            for (const auto *method : type->methods)
+                if (method->name != type->name) declareFunction(method->name, method->type);
+            structure->pop();
+        } else if (const auto *type = node->to<IR::Type_ArchBlock>()) {
+            declareArchBlock(type, !type->is<IR::Type_Package>());
+        } else if (const auto *parser = node->to<IR::P4Parser>()) {
+            declareArchBlock(parser->type, true);
+        } else if (const auto *control = node->to<IR::P4Control>()) {
+            declareArchBlock(control->type, true);
+        } else if (const auto *method = node->to<IR::Method>()) {
+            declareFunction(method->name, method->type);
+        } else if (const auto *function = node->to<IR::Function>()) {
+            declareFunction(function->name, function->type);
+        } else if (node->is<IR::Type_Enum>() || node->is<IR::Type_SerEnum>() ||
+                   node->is<IR::Type_Typedef>() || node->is<IR::Type_Newtype>()) {
+            structure->declareType(node->to<IR::Type_Declaration>()->name);
+        } else if (const auto *constant = node->to<IR::Declaration_Constant>()) {
+            structure->declareObject(constant->name, constant->type->toString());
+        } else if (const auto *instance = node->to<IR::Declaration_Instance>()) {
+            structure->declareObject(instance->name, instance->type->toString());
+        }
+        objects.push_back(node);
+    }
+    return objects;
+}
+
 /* static */ std::pair<const IR::P4Program *, const Util::InputSources *>
 P4ParserDriver::parseProgramSources(std::istream &in, std::string_view sourceFile,
                                     unsigned sourceLine /* = 1 */) {
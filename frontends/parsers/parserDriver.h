@@ -106,6 +106,16 @@ class P4ParserDriver final : public AbstractParserDriver {
     static const IR::P4Program *parse(FILE *in, std::string_view sourceFile,
                                       unsigned sourceLine = 1);
 
+    /**
+     * Parse the rest of a P4-16 program, whose first declarations @p prefix were
+     * parsed before (see PrecompiledHeader).  The names declared by @p prefix are
+     * known to the parser, `error` and `match_kind` declarations are merged with
+     * the ones in @p prefix, and the program returned starts with the declarations
+     * of @p prefix.
+     */
+    static const IR::P4Program *parse(std::istream &in, std::string_view sourceFile,
+                                      const IR::P4Program *prefix);
+
     /// Parses the input and returns a pair with the P4Program and InputSources.
     /// Use this when both the parsed P4Program and InputSources are required,
     /// as opposed to the `parse` method, which only returns the P4Program.
@@ -213,6 +223,11 @@ class P4ParserDriver final : public AbstractParserDriver {
     /// Common functionality for parsing.
     bool parse(AbstractP4Lexer &lexer, std::string_view sourceFile, unsigned sourceLine = 1);
 
+    /// Declare the names declared by the top-level declarations of @p prefix as if
+    /// they had been parsed, and return the declarations to put at the start of the
+    /// program.
+    safe_vector<const IR::Node *> declarePrefix(const IR::P4Program *prefix);
+
     /// Common functionality for parsing annotation bodies.
     template <typename T>
     const T *parse(P4AnnotationLexer::Type type, const Util::SourceInfo &srcInfo,
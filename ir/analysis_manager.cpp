@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/analysis_manager.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+#include "ir/ir.h"
+#include "ir/visitor.h"
+#include "lib/exceptions.h"
+#include "lib/log.h"
+
+namespace P4 {
+
+namespace {
+
+template <class V>
+void setHook(Visitor *pass, std::function<void(const IR::Node *, const IR::Node *)> hook) {
+    if (auto *v = dynamic_cast<V *>(pass)) v->setOnNodeTransformedHook(hook);
+}
+
+}  // namespace
+
+void AnalysisManager::registerAnalysis(CachedAnalysis *analysis) {
+    CHECK_NULL(analysis);
+    if (std::find(analyses.begin(), analyses.end(), analysis) == analyses.end())
+        analyses.push_back(analysis);
+}
+
+void AnalysisManager::unregisterAnalysis(CachedAnalysis *analysis) {
+    BUG_CHECK(running.empty(), "Unregistering %1% while passes are running",
+              analysis->analysisName());
+    analyses.erase(std::remove(analyses.begin(), analyses.end(), analysis), analyses.end());
+}
+
+bool AnalysisManager::preserved(const CachedAnalysis *analysis) const {
+    const std::type_info &kind = typeid(*analysis);
+    for (auto &frame : running)
+        if (frame.pass->preservesAnalysis(kind)) return true;
+    return false;
+}
+
+void AnalysisManager::beforePass(Visitor *pass, const IR::Node *root) {
+    CHECK_NULL(pass);
+    running.push_back({pass, root, {}, {}, false});
+    auto &frame = running.back();
+    std::vector<CachedAnalysis *> keep;
+    for (auto *analysis : analyses) {
+        if (analysis->analyzedRoot() != root) continue;
+        frame.valid.push_back(analysis);
+        if (preserved(analysis)) keep.push_back(analysis);
+    }
+    if (keep.empty()) return;
+
+    const std::function<void(const IR::Node *, const IR::Node *)> *saved = nullptr;
+    if (auto *t = dynamic_cast<Transform *>(pass))
+        saved = &t->getOnNodeTransformedHook();
+    else if (auto *m = dynamic_cast<Modifier *>(pass))
+        saved = &m->getOnNodeTransformedHook();
+    if (!saved) return;
+    frame.savedHook = *saved;
+    frame.hooked = true;
+    auto hook = [keep, previous = frame.savedHook](const IR::Node *from, const IR::Node *to) {
+        if (previous) previous(from, to);
+        for (auto *analysis : keep) analysis->nodeReplaced(from, to);
+    };
+    setHook<Transform>(pass, hook);
+    setHook<Modifier>(pass, hook);
+}
+
+void AnalysisManager::afterPass(Visitor *pass, const IR::Node *result) {
+    // Frames of passes aborted by an exception (such as a backtrack) are discarded, and the
+    // analyses they kept valid are invalidated.
+    while (!running.empty()) {
+        auto &frame = running.back();
+        bool done = frame.pass == pass;
+        if (frame.hooked) {
+            setHook<Transform>(frame.pass, frame.savedHook);
+            setHook<Modifier>(frame.pass, frame.savedHook);
+        }
+        const IR::Node *to = done ? result : nullptr;
+        if (to != frame.root) {
+            for (auto *analysis : frame.valid) {
+                // analyses recomputed by the pass itself are up to date
+                if (analysis->analyzedRoot() != frame.root) continue;
+                if (to && preserved(analysis)) {
+                    LOG2(analysis->analysisName() << " preserved by " << frame.pass->name());
+                    analysis->rootReplaced(to);
+                } else {
+                    LOG2(analysis->analysisName() << " invalidated by " << frame.pass->name());
+                    analysis->invalidate();
+                }
+            }
+        }
+        running.pop_back();
+        if (done) return;
+    }
+    BUG("%1% was not started by the AnalysisManager", pass->name());
+}
+
+}  // namespace P4
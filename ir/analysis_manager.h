@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_ANALYSIS_MANAGER_H_
+#define IR_ANALYSIS_MANAGER_H_
+
+#include <functional>
+#include <vector>
+
+#include "lib/cstring.h"
+
+namespace P4 {
+
+namespace IR {
+class Node;
+}  // namespace IR
+
+class Visitor;
+
+/// The result of an analysis of an IR tree (such as a TypeMap or a ReferenceMap) that can be
+/// reused by later passes as long as the tree does not change.
+class CachedAnalysis {
+ public:
+    virtual ~CachedAnalysis() = default;
+
+    virtual cstring analysisName() const = 0;
+    /// @return the root of the tree the analysis is valid for, or nullptr if there is none.
+    virtual const IR::Node *analyzedRoot() const = 0;
+    /// A pass that preserves this analysis replaced @node by @replacement (which may be null).
+    virtual void nodeReplaced(const IR::Node * /*node*/, const IR::Node * /*replacement*/) {}
+    /// A pass that preserves this analysis changed the analyzed root into @root.
+    virtual void rootReplaced(const IR::Node *root) = 0;
+    /// The analyzed tree was changed by a pass that does not preserve this analysis.
+    virtual void invalidate() = 0;
+};
+
+/// Keeps the analyses registered with it up to date while a PassManager runs its passes, in
+/// the style of LLVM's pass manager.  Passes declare the analyses they keep valid with
+/// Visitor::preserves<T>() (a pass nested in a PassManager also preserves everything the
+/// PassManager declares).  When a pass changes the tree an analysis was computed for:
+///   - if the pass preserves the analysis, the nodes replaced by the pass (when it is a
+///     Transform or a Modifier) are reported to the analysis with nodeReplaced and the new
+///     root with rootReplaced, so the cached result is reused for the new tree;
+///   - otherwise the analysis is invalidated, and will be recomputed by the next pass that
+///     needs it.
+/// Analyses which the pass itself recomputed for the new tree are left alone.
+///
+/// A PassManager uses the AnalysisManager set with PassManager::setAnalysisManager, or the
+/// one of the PassManager running it.
+class AnalysisManager {
+    std::vector<CachedAnalysis *> analyses;
+    struct Frame {
+        Visitor *pass;
+        const IR::Node *root;
+        std::vector<CachedAnalysis *> valid;
+        std::function<void(const IR::Node *, const IR::Node *)> savedHook;
+        bool hooked = false;
+    };
+    std::vector<Frame> running;
+
+    bool preserved(const CachedAnalysis *analysis) const;
+
+ public:
+    void registerAnalysis(CachedAnalysis *analysis);
+    void unregisterAnalysis(CachedAnalysis *analysis);
+
+    /// Called by PassManager around running @pass on @root.
+    void beforePass(Visitor *pass, const IR::Node *root);
+    void afterPass(Visitor *pass, const IR::Node *result);
+};
+
+}  // namespace P4
+
+#endif /* IR_ANALYSIS_MANAGER_H_ */
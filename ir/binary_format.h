@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_BINARY_FORMAT_H_
+#define IR_BINARY_FORMAT_H_
+
+#include <cstdint>
+#include <string_view>
+
+/// Constants of the binary IR format written by BinaryGenerator and read by BinaryLoader.
+///
+/// A file is the magic string, followed by the format version and flags as varints, and a
+/// single value.  Values are written in the order of the fields of the IR classes
+/// (toBinary methods and BinaryLoader constructors are generated by the ir-generator), with
+/// no field names or other framing:
+///   - integers and enums as LEB128 varints, zigzag-encoded if signed;
+///   - strings as an index into a string table built while writing: index 0 is the null
+///     string, an index one past the end of the table is followed by the length and the
+///     bytes of a new entry;
+///   - containers as their size followed by their elements;
+///   - nodes as a NodeTag, followed for a NewNode by the index of the node type name, the
+///     node id and the fields of the node, or for a NodeRef by the id of a node written
+///     before.
+namespace P4::BinaryIR {
+
+inline constexpr std::string_view magic = "P4IRBIN";
+inline constexpr uint64_t version = 1;
+
+enum Flags : uint64_t {
+    SourceInfo = 1,       // every node is followed by its source position
+    SourcePositions = 2,  // every node is followed by its start and end positions in the
+                          // Util::InputSources it was parsed from (see BinaryLoader::setSources)
+};
+
+enum NodeTag : uint8_t {
+    NullNode = 0,
+    NewNode = 1,
+    NodeRef = 2,
+};
+
+}  // namespace P4::BinaryIR
+
+#endif /* IR_BINARY_FORMAT_H_ */
@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_BINARY_GENERATOR_H_
+#define IR_BINARY_GENERATOR_H_
+
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+#include "ir/binary_format.h"
+#include "ir/id.h"
+#include "ir/json_generator.h"
+#include "ir/node.h"
+#include "lib/big_int.h"
+#include "lib/bitvec.h"
+#include "lib/cstring.h"
+#include "lib/ltbitmatrix.h"
+#include "lib/match.h"
+#include "lib/ordered_map.h"
+#include "lib/ordered_set.h"
+#include "lib/safe_vector.h"
+#include "lib/string_map.h"
+
+namespace P4 {
+
+/// Writes values (usually an IR tree) to a stream in the binary IR format described in
+/// ir/binary_format.h.  The output is written as the tree is traversed, and can be read back
+/// with BinaryLoader.
+class BinaryGenerator {
+    std::ostream &out;
+    uint64_t flags;
+    std::unordered_set<int> node_refs;
+    std::unordered_map<cstring, uint64_t> strings;
+
+    template <typename T>
+    class has_toBinary {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::toBinary));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+    template <typename T>
+    class has_toJSON {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::toJSON));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+ public:
+    explicit BinaryGenerator(std::ostream &out, bool dumpSourceInfo = false)
+        : BinaryGenerator(out, dumpSourceInfo ? BinaryIR::SourceInfo : BinaryIR::Flags(0)) {}
+    /// With BinaryIR::SourcePositions, the source positions of the nodes can only be read back
+    /// with the Util::InputSources they refer to.
+    BinaryGenerator(std::ostream &out, BinaryIR::Flags flags) : out(out), flags(flags) {
+        out.write(BinaryIR::magic.data(), BinaryIR::magic.size());
+        emit_varint(BinaryIR::version);
+        emit_varint(flags);
+    }
+
+    template <typename T>
+    void emit(const T &val) {
+        generate(val);
+    }
+
+    void emit_varint(uint64_t v) {
+        char buf[10];
+        size_t len = 0;
+        for (; v >= 0x80; v >>= 7) buf[len++] = static_cast<char>(v | 0x80);
+        buf[len++] = static_cast<char>(v);
+        out.write(buf, len);
+    }
+    void emit_signed(int64_t v) {
+        emit_varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+    void emit_bytes(std::string_view bytes) {
+        emit_varint(bytes.size());
+        out.write(bytes.data(), bytes.size());
+    }
+    void emit_string(cstring s) {
+        if (s.isNull()) {
+            emit_varint(0);
+            return;
+        }
+        auto [it, added] = strings.emplace(s, strings.size() + 1);
+        emit_varint(it->second);
+        if (added) emit_bytes(s.string_view());
+    }
+
+ private:
+    template <typename T>
+    void generate_elements(const T &v) {
+        emit_varint(std::size(v));
+        for (auto &el : v) generate(el);
+    }
+
+    template <typename T>
+    void generate(const safe_vector<T> &v) {
+        generate_elements(v);
+    }
+    template <typename T>
+    void generate(const std::vector<T> &v) {
+        generate_elements(v);
+    }
+    template <typename T>
+    void generate(const std::set<T> &v) {
+        generate_elements(v);
+    }
+    template <typename T>
+    void generate(const ordered_set<T> &v) {
+        generate_elements(v);
+    }
+    template <typename K, typename V>
+    void generate(const std::map<K, V> &v) {
+        generate_elements(v);
+    }
+    template <typename K, typename V>
+    void generate(const std::multimap<K, V> &v) {
+        generate_elements(v);
+    }
+    template <typename K, typename V>
+    void generate(const ordered_map<K, V> &v) {
+        generate_elements(v);
+    }
+    template <typename V>
+    void generate(const string_map<V> &v) {
+        generate_elements(v);
+    }
+
+    template <typename T, typename U>
+    void generate(const std::pair<T, U> &v) {
+        generate(v.first);
+        generate(v.second);
+    }
+
+    template <typename T>
+    void generate(const std::optional<T> &v) {
+        generate(v.has_value());
+        if (v) generate(*v);
+    }
+
+    template <class... Types>
+    void generate(const std::variant<Types...> &v) {
+        emit_varint(v.index());
+        std::visit([this](auto &value) { this->generate(value); }, v);
+    }
+
+    void generate(bool v) { out.put(v ? 1 : 0); }
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> generate(T v) {
+        if constexpr (std::is_signed_v<T>)
+            emit_signed(v);
+        else
+            emit_varint(v);
+    }
+    template <typename T>
+    std::enable_if_t<std::is_enum_v<T>> generate(T v) {
+        generate(static_cast<std::underlying_type_t<T>>(v));
+    }
+    void generate(double v) {
+        char buf[sizeof(v)];
+        std::memcpy(buf, &v, sizeof(v));
+        out.write(buf, sizeof(v));
+    }
+    template <typename T>
+    std::enable_if_t<std::is_same_v<T, big_int>> generate(const T &v) {
+        std::string magnitude;
+        boost::multiprecision::export_bits(v, std::back_inserter(magnitude), 8);
+        generate(v < 0);
+        emit_bytes(magnitude);
+    }
+
+    void generate(cstring v) { emit_string(v); }
+    void generate(const std::string &v) { emit_bytes(v); }
+    void generate(const IR::ID &v) {
+        emit_string(v.name);
+        emit_string(v.originalName);
+    }
+
+    void generate(const bitvec &v) {
+        size_t words = (v.max().index() + 64) / 64;
+        emit_varint(words);
+        for (size_t i = 0; i < words; ++i) emit_varint(v.getrange(i * 64, 64));
+    }
+    void generate(const match_t &v) {
+        generate(v.word0);
+        generate(v.word1);
+    }
+    void generate(const LTBitMatrix &v) {
+        std::stringstream text;
+        text << v;
+        emit_bytes(text.str());
+    }
+
+    template <typename T>
+    std::enable_if_t<has_toBinary<T>::value && !std::is_base_of_v<IR::INode, T>> generate(
+        const T &v) {
+        v.toBinary(*this);
+    }
+
+    // Types with only a JSON representation are embedded as JSON text.
+    template <typename T>
+    std::enable_if_t<!has_toBinary<T>::value && has_toJSON<T>::value &&
+                     !std::is_base_of_v<IR::INode, T>>
+    generate(const T &v) {
+        std::stringstream json;
+        JSONGenerator(json).emit(v);
+        emit_bytes(json.str());
+    }
+
+    void generate(const IR::INode &v_) {
+        auto &v = *v_.getNode();
+        if (!node_refs.insert(v.id).second) {
+            out.put(BinaryIR::NodeRef);
+            emit_signed(v.id);
+            return;
+        }
+        out.put(BinaryIR::NewNode);
+        emit_string(v.node_type_name());
+        emit_signed(v.id);
+        v.toBinary(*this);
+        if (flags & BinaryIR::SourceInfo) v.sourceInfoToBinary(*this);
+        if (flags & BinaryIR::SourcePositions) {
+            for (auto position : {v.srcInfo.getStart(), v.srcInfo.getEnd()}) {
+                emit_varint(position.getLineNumber());
+                emit_varint(position.getColumnNumber());
+            }
+        }
+    }
+
+    // See JSONGenerator::generate(const T *const &) for the extra `const &`
+    template <typename T>
+    void generate(const T *const &v) {
+        if constexpr (std::is_base_of_v<IR::INode, T>) {
+            if (v)
+                generate(static_cast<const IR::INode &>(*v));
+            else
+                out.put(BinaryIR::NullNode);
+        } else {
+            generate(v != nullptr);
+            if (v) generate(*v);
+        }
+    }
+
+    template <typename T, size_t N>
+    void generate(const T (&v)[N]) {
+        for (auto &el : v) generate(el);
+    }
+};
+
+}  // namespace P4
+
+#endif /* IR_BINARY_GENERATOR_H_ */
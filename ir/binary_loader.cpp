@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/binary_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/map.h"
+
+namespace P4 {
+
+BinaryLoader::BinaryLoader(const std::filesystem::path &file) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            mapped = data;
+            mappedSize = st.st_size;
+            pos = static_cast<const char *>(data);
+            end = pos + mappedSize;
+        }
+    }
+    close(fd);
+    if (mapped) readHeader();
+}
+
+BinaryLoader::~BinaryLoader() {
+    if (mapped) munmap(mapped, mappedSize);
+}
+
+void BinaryLoader::error(std::string_view msg) const {
+    throw Util::CompilationError("Invalid binary IR: %1%", msg);
+}
+
+void BinaryLoader::readHeader() {
+    auto size = BinaryIR::magic.size();
+    if (size_t(end - pos) < size || std::string_view(pos, size) != BinaryIR::magic) return;
+    pos += size;
+    if (varint() != BinaryIR::version) error("unsupported version");
+    flags = varint();
+    valid = true;
+}
+
+uint64_t BinaryLoader::stringIndex() {
+    auto index = varint();
+    if (index == strings.size() + 1) {
+        strings.push_back(cstring(bytes()));
+        factories.push_back(nullptr);
+    } else if (index > strings.size()) {
+        error("invalid string index");
+    }
+    return index;
+}
+
+const IR::Node *BinaryLoader::get_node(BinaryNodeFactoryFn factory) {
+    switch (byte()) {
+        case BinaryIR::NullNode:
+            return nullptr;
+        case BinaryIR::NodeRef: {
+            auto it = node_refs.find(signedVarint());
+            if (it == node_refs.end()) error("reference to a node which was not read");
+            return it->second;
+        }
+        case BinaryIR::NewNode:
+            break;
+        default:
+            error("invalid node tag");
+    }
+    auto type = stringIndex();
+    if (type == 0) error("missing node type");
+    if (!factory) {
+        auto &known = factories[type - 1];
+        if (!known) {
+            known = get(IR::binary_unpacker_table, strings[type - 1]);
+            if (!known) error(std::string("unknown node type ") + strings[type - 1].c_str());
+        }
+        factory = known;
+    }
+    // the node gets a new id; the saved one is only used by references to it
+    auto savedId = static_cast<int>(signedVarint());
+    auto *node = factory(*this);
+    CHECK_NULL(node);
+    if (hasSourceInfo()) node->sourceInfoFromBinary(*this);
+    if (hasSourcePositions()) {
+        if (!sources) error("no input sources for the source positions");
+        unsigned line = varint(), column = varint(), endLine = varint(), endColumn = varint();
+        if (line != 0) {
+            Util::SourcePosition start(line, column), end(endLine, endColumn);
+            if (!end.isValid() || end < start || sources->getCurrentPosition() < end)
+                error("invalid source position");
+            node->srcInfo = Util::SourceInfo(sources, start, end);
+        }
+    }
+    node_refs[savedId] = node;
+    return node;
+}
+
+}  // namespace P4
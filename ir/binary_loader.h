@@ -0,0 +1,420 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_BINARY_LOADER_H_
+#define IR_BINARY_LOADER_H_
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "binary_format.h"
+#include "ir.h"
+#include "json_loader.h"
+#include "lib/big_int.h"
+#include "lib/bitvec.h"
+#include "lib/cstring.h"
+#include "lib/exceptions.h"
+#include "lib/ltbitmatrix.h"
+#include "lib/match.h"
+#include "lib/ordered_map.h"
+#include "lib/ordered_set.h"
+#include "lib/safe_vector.h"
+#include "lib/string_map.h"
+
+namespace P4 {
+
+/// Reads values written by BinaryGenerator.  The input is either a buffer in memory or a file,
+/// which is mapped into memory instead of being read.  Malformed input throws a
+/// Util::CompilationError.
+class BinaryLoader {
+    template <typename T>
+    class has_fromBinary {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::fromBinary));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+    template <typename T>
+    class has_fromJSON {
+        typedef char small;
+        typedef struct {
+            char c[2];
+        } big;
+
+        template <typename C>
+        static small test(decltype(&C::fromJSON));
+        template <typename C>
+        static big test(...);
+
+     public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    const char *pos = nullptr, *end = nullptr;
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
+    uint64_t flags = 0;
+    bool valid = false;
+    const Util::InputSources *sources = nullptr;
+    std::unordered_map<int, IR::Node *> node_refs;
+    std::vector<cstring> strings;
+    // factories of the node types in the string table, looked up the first time they are used
+    std::vector<BinaryNodeFactoryFn> factories;
+
+    void readHeader();
+    uint64_t stringIndex();
+    const IR::Node *get_node(BinaryNodeFactoryFn factory = nullptr);
+
+ public:
+    BinaryLoader(const char *data, size_t size) : pos(data), end(data + size) { readHeader(); }
+    explicit BinaryLoader(const std::filesystem::path &file);
+    BinaryLoader(const BinaryLoader &) = delete;
+    ~BinaryLoader();
+
+    /// False if the input is not in the binary IR format.
+    explicit operator bool() const { return valid; }
+    /// True if the nodes were written with their source position.
+    bool hasSourceInfo() const { return flags & BinaryIR::SourceInfo; }
+    /// True if the nodes were written with their positions in a Util::InputSources.
+    bool hasSourcePositions() const { return flags & BinaryIR::SourcePositions; }
+    /// Set the Util::InputSources which the source positions of the nodes refer to.
+    void setSources(const Util::InputSources *sources) { this->sources = sources; }
+
+    [[noreturn]] void error(std::string_view msg) const;
+
+    uint8_t byte() {
+        if (pos == end) error("unexpected end of input");
+        return static_cast<uint8_t>(*pos++);
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        error("invalid varint");
+    }
+    int64_t signedVarint() {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    std::string_view bytes() {
+        uint64_t size = varint();
+        if (size > uint64_t(end - pos)) error("unexpected end of input");
+        std::string_view rv(pos, size);
+        pos += size;
+        return rv;
+    }
+    cstring string() {
+        auto index = stringIndex();
+        return index ? strings[index - 1] : cstring();
+    }
+
+ private:
+    template <typename T>
+    void unpack_vector(T &v) {
+        typename T::value_type temp;
+        v.clear();
+        for (auto size = varint(); size > 0; --size) {
+            unpack(temp);
+            v.push_back(temp);
+        }
+    }
+    template <typename T>
+    void unpack_set(T &v) {
+        typename T::value_type temp;
+        v.clear();
+        for (auto size = varint(); size > 0; --size) {
+            unpack(temp);
+            v.insert(temp);
+        }
+    }
+    // the keys in the value_type of maps are const
+    template <typename T>
+    void unpack_map(T &v) {
+        std::pair<typename T::key_type, typename T::mapped_type> temp;
+        v.clear();
+        for (auto size = varint(); size > 0; --size) {
+            unpack(temp);
+            v.insert(temp);
+        }
+    }
+
+    template <typename T>
+    void unpack(safe_vector<T> &v) {
+        unpack_vector(v);
+    }
+    template <typename T>
+    void unpack(std::vector<T> &v) {
+        unpack_vector(v);
+    }
+    template <typename T>
+    void unpack(std::set<T> &v) {
+        unpack_set(v);
+    }
+    template <typename T>
+    void unpack(ordered_set<T> &v) {
+        unpack_set(v);
+    }
+    template <typename K, typename V>
+    void unpack(std::map<K, V> &v) {
+        unpack_map(v);
+    }
+    template <typename K, typename V>
+    void unpack(std::multimap<K, V> &v) {
+        unpack_map(v);
+    }
+    template <typename K, typename V>
+    void unpack(ordered_map<K, V> &v) {
+        unpack_map(v);
+    }
+    template <typename V>
+    void unpack(string_map<V> &v) {
+        unpack_map(v);
+    }
+
+    template <typename T>
+    void unpack(IR::Vector<T> &v) {
+        v = get_node(BinaryNodeFactoryFn(&IR::Vector<T>::fromBinary))->as<IR::Vector<T>>();
+    }
+    template <typename T>
+    void unpack(const IR::Vector<T> *&v) {
+        auto *node = get_node(BinaryNodeFactoryFn(&IR::Vector<T>::fromBinary));
+        v = node ? node->checkedTo<IR::Vector<T>>() : nullptr;
+    }
+    template <typename T>
+    void unpack(IR::IndexedVector<T> &v) {
+        v = get_node(BinaryNodeFactoryFn(&IR::IndexedVector<T>::fromBinary))
+                ->as<IR::IndexedVector<T>>();
+    }
+    template <typename T>
+    void unpack(const IR::IndexedVector<T> *&v) {
+        auto *node = get_node(BinaryNodeFactoryFn(&IR::IndexedVector<T>::fromBinary));
+        v = node ? node->checkedTo<IR::IndexedVector<T>>() : nullptr;
+    }
+    template <class T, template <class K, class V, class COMP, class ALLOC> class MAP, class COMP,
+              class ALLOC>
+    void unpack(IR::NameMap<T, MAP, COMP, ALLOC> &m) {
+        m = get_node(BinaryNodeFactoryFn(&IR::NameMap<T, MAP, COMP, ALLOC>::fromBinary))
+                ->as<IR::NameMap<T, MAP, COMP, ALLOC>>();
+    }
+    template <class T, template <class K, class V, class COMP, class ALLOC> class MAP, class COMP,
+              class ALLOC>
+    void unpack(const IR::NameMap<T, MAP, COMP, ALLOC> *&m) {
+        auto *node = get_node(BinaryNodeFactoryFn(&IR::NameMap<T, MAP, COMP, ALLOC>::fromBinary));
+        m = node ? node->checkedTo<IR::NameMap<T, MAP, COMP, ALLOC>>() : nullptr;
+    }
+
+    template <typename T, typename U>
+    void unpack(std::pair<T, U> &v) {
+        unpack(v.first);
+        unpack(v.second);
+    }
+
+    template <typename T>
+    void unpack(std::optional<T> &v) {
+        bool isValid = false;
+        unpack(isValid);
+        if (!isValid) {
+            v = std::nullopt;
+            return;
+        }
+        T value;
+        unpack(value);
+        v = std::move(value);
+    }
+
+    template <size_t N, class Variant>
+    void unpack_variant(size_t target, Variant &variant) {
+        if constexpr (N == std::variant_size_v<Variant>) {
+            error("invalid variant index");
+        } else if (N == target) {
+            variant.template emplace<N>();
+            unpack(std::get<N>(variant));
+        } else {
+            unpack_variant<N + 1>(target, variant);
+        }
+    }
+    template <class... Types>
+    void unpack(std::variant<Types...> &v) {
+        unpack_variant<0>(varint(), v);
+    }
+
+    void unpack(bool &v) { v = byte() != 0; }
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> unpack(T &v) {
+        if constexpr (std::is_signed_v<T>)
+            v = static_cast<T>(signedVarint());
+        else
+            v = static_cast<T>(varint());
+    }
+    template <typename T>
+    std::enable_if_t<std::is_enum_v<T>> unpack(T &v) {
+        std::underlying_type_t<T> value;
+        unpack(value);
+        v = static_cast<T>(value);
+    }
+    void unpack(double &v) {
+        if (end - pos < ptrdiff_t(sizeof(v))) error("unexpected end of input");
+        std::memcpy(&v, pos, sizeof(v));
+        pos += sizeof(v);
+    }
+    void unpack(big_int &v) {
+        bool negative = byte() != 0;
+        auto magnitude = bytes();
+        v = 0;
+        boost::multiprecision::import_bits(v, magnitude.begin(), magnitude.end(), 8);
+        if (negative) v = -v;
+    }
+
+    void unpack(cstring &v) { v = string(); }
+    void unpack(std::string &v) { v = bytes(); }
+    void unpack(IR::ID &v) {
+        v.name = string();
+        v.originalName = string();
+    }
+
+    void unpack(bitvec &v) {
+        v.clear();
+        auto words = varint();
+        for (size_t i = 0; i < words; ++i) v.putrange(i * 64, 64, varint());
+    }
+    void unpack(match_t &v) {
+        unpack(v.word0);
+        unpack(v.word1);
+    }
+    void unpack(LTBitMatrix &m) { std::string(bytes()).c_str() >> m; }
+
+    // Nested IR classes return a pointer from fromBinary, other types a value.
+    template <typename T>
+    std::enable_if_t<has_fromBinary<T>::value && !std::is_base_of_v<IR::INode, T>> unpack(
+        T &v) {
+        if constexpr (std::is_pointer_v<decltype(T::fromBinary(*this))>)
+            v = *T::fromBinary(*this);
+        else
+            v = T::fromBinary(*this);
+    }
+
+    template <typename T>
+    std::enable_if_t<!has_fromBinary<T>::value && has_fromJSON<T>::value &&
+                     !std::is_base_of_v<IR::INode, T>>
+    unpack(T &v) {
+        std::stringstream json;
+        json << bytes();
+        JSONLoader(json) >> v;
+    }
+
+    template <typename T>
+    std::enable_if_t<std::is_base_of_v<IR::INode, T>> unpack(T &v) {
+        auto *node = get_node();
+        if (!node) error("missing inline node");
+        v = node->as<T>();
+    }
+    template <typename T>
+    void unpack(const T *&v) {
+        if constexpr (std::is_base_of_v<IR::INode, T>) {
+            auto *node = get_node();
+            v = node ? node->checkedTo<T>() : nullptr;
+        } else {
+            bool present = false;
+            unpack(present);
+            if (!present) {
+                v = nullptr;
+                return;
+            }
+            if constexpr (has_fromBinary<T>::value &&
+                          std::is_pointer_v<decltype(T::fromBinary(*this))>) {
+                v = T::fromBinary(*this);
+            } else {
+                auto *value = new T();
+                unpack(*value);
+                v = value;
+            }
+        }
+    }
+    template <typename T>
+    std::enable_if_t<!std::is_base_of_v<IR::INode, T>> unpack(T *&v) {
+        const T *value;
+        unpack(value);
+        v = const_cast<T *>(value);
+    }
+
+    template <typename T, size_t N>
+    void unpack(T (&v)[N]) {
+        for (auto &el : v) unpack(el);
+    }
+
+ public:
+    template <typename T>
+    void load(T &v) {
+        unpack(v);
+    }
+
+    /// Reads the node of type T written next in the input.
+    template <typename T>
+    const T *loadNode() {
+        const T *v = nullptr;
+        unpack(v);
+        return v;
+    }
+
+    template <typename T>
+    BinaryLoader &operator>>(T &v) {
+        unpack(v);
+        return *this;
+    }
+};
+
+template <class T>
+IR::Vector<T>::Vector(BinaryLoader &in) : VectorBase(in) {
+    in.load(vec);
+}
+template <class T>
+IR::Node *IR::Vector<T>::fromBinary(BinaryLoader &in) {
+    return new Vector<T>(in);
+}
+template <class T>
+IR::IndexedVector<T>::IndexedVector(BinaryLoader &in) : Vector<T>(in) {
+    in.load(declarations);
+}
+template <class T>
+IR::Node *IR::IndexedVector<T>::fromBinary(BinaryLoader &in) {
+    return new IndexedVector<T>(in);
+}
+template <class T, template <class K, class V, class COMP, class ALLOC> class MAP /*= std::map */,
+          class COMP /*= std::less<cstring>*/,
+          class ALLOC /*= std::allocator<std::pair<cstring, const T*>>*/>
+IR::NameMap<T, MAP, COMP, ALLOC>::NameMap(BinaryLoader &in) : Node(in) {
+    in.load(symbols);
+}
+template <class T, template <class K, class V, class COMP, class ALLOC> class MAP /*= std::map */,
+          class COMP /*= std::less<cstring>*/,
+          class ALLOC /*= std::allocator<std::pair<cstring, const T*>>*/>
+IR::Node *IR::NameMap<T, MAP, COMP, ALLOC>::fromBinary(BinaryLoader &in) {
+    return new IR::NameMap<T, MAP, COMP, ALLOC>(in);
+}
+
+}  // namespace P4
+
+#endif /* IR_BINARY_LOADER_H_ */
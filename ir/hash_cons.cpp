@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/hash_cons.h"
+
+#ifdef MULTITHREAD
+#include <mutex>
+#endif
+
+#include "absl/container/flat_hash_set.h"
+#include "ir/ir.h"
+#include "lib/hash.h"
+#include "lib/compile_context.h"
+
+namespace P4::IR {
+
+bool HashCons::enabled_ = false;
+
+namespace {
+
+/// Nodes are only shared when they are at the same source position, so that diagnostics and
+/// debug information about a shared node refer to the right place.
+size_t positionHash(const Util::SourceInfo &si) {
+    if (si.isValid()) {
+        auto start = si.getStart();
+        return Util::Hash{}(start.getLineNumber(), start.getColumnNumber());
+    }
+    if (const auto *saved = si.getSaved())
+        return Util::Hash{}(saved->filename, saved->line, saved->column);
+    return 0;
+}
+
+bool samePosition(const Util::SourceInfo &a, const Util::SourceInfo &b) {
+    if (!(a == b)) return false;
+    if (a.isValid()) return true;
+    // Invalid positions compare equal, but may still carry the position read from a file.
+    const auto *sa = a.getSaved(), *sb = b.getSaved();
+    if (!sa || !sb) return sa == sb;
+    return sa->filename == sb->filename && sa->line == sb->line && sa->column == sb->column;
+}
+
+struct NodeHash {
+    size_t operator()(const Node *n) const {
+        return Util::hash_combine(n->equiv_hash(), positionHash(n->srcInfo));
+    }
+};
+
+struct NodeEq {
+    bool operator()(const Node *a, const Node *b) const {
+        return a == b || (a->equiv(*b) && samePosition(a->srcInfo, b->srcInfo));
+    }
+};
+
+absl::flat_hash_set<const Node *, NodeHash, NodeEq> &table() {
+    static auto *table = new absl::flat_hash_set<const Node *, NodeHash, NodeEq>;
+    return *table;
+}
+
+#ifdef MULTITHREAD
+std::mutex tableLock;
+#endif
+
+/// The context whose end will empty the table.
+AutoCompileContext *clearingContext = nullptr;
+
+/// Make sure the table is emptied when the innermost compile context ends.
+void clearAtContextEnd() {
+    auto *context = AutoCompileContext::innermost();
+    if (context == nullptr || context == clearingContext) return;
+    clearingContext = context;
+    context->atEnd([] { HashCons::clear(); });
+}
+
+}  // namespace
+
+const Node *HashCons::intern(const Node *n) {
+    if (!enabled_ || n == nullptr) return n;
+    if (auto *expr = n->to<Expression>(); expr && expr->type->is<ITypeVar>()) return n;
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(tableLock);
+#endif
+    clearAtContextEnd();
+    return *table().insert(n).first;
+}
+
+size_t HashCons::size() {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(tableLock);
+#endif
+    return table().size();
+}
+
+void HashCons::clear() {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(tableLock);
+#endif
+    table().clear();
+    clearingContext = nullptr;
+}
+
+}  // namespace P4::IR
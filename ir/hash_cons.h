@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_HASH_CONS_H_
+#define IR_HASH_CONS_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace P4::IR {
+
+class Node;
+
+/// An optional hash-consing table for immutable IR leaf nodes (Constant, BoolLiteral,
+/// StringLiteral and the like), so that passes which keep recreating the same leaves (such as
+/// ConstantFolding and StrengthReduction) share a single instance of each.  Nodes are
+/// considered identical when they are `equiv`, using the `equiv_hash` generated by the
+/// ir-generator, and have the same source position, so diagnostics about a shared node point
+/// at the right place.  Leaves are mostly shared between the iterations of a repeated pass;
+/// the IR only becomes a DAG where several parents have a leaf from the same position (as
+/// after inlining), which visitors already allow for with singletons like Type_Bits.
+///
+/// The table only lives as long as the innermost AutoCompileContext in which nodes were
+/// interned: it is emptied when that context ends, before the nodes in its arena are freed.
+///
+/// Only nodes without children (other than their type) should be interned.  In particular
+/// PathExpressions must not be, since the ReferenceMap keys on the identity of their Path,
+/// and Type_Bits is already shared through Type_Bits::get.  Expressions whose type is a type
+/// variable (such as Type_InfInt) are never interned, as type inference tells them apart by
+/// identity.
+///
+/// Hash-consing is disabled by default, in which case intern returns its argument and make
+/// just allocates a new node.
+class HashCons {
+    static bool enabled_;
+
+ public:
+    HashCons() = delete;
+
+    static bool enabled() { return enabled_; }
+    static void enable(bool enable = true) { enabled_ = enable; }
+
+    /// @return the node already in the table that is identical to @n, or @n (after adding it to
+    /// the table) if there is none.  Returns @n unchanged if hash-consing is disabled.
+    static const Node *intern(const Node *n);
+    template <class T>
+    static const T *intern(const T *n) {
+        return static_cast<const T *>(intern(static_cast<const Node *>(n)));
+    }
+
+    /// Construct a T from @args and intern it.
+    template <class T, class... Args>
+    static const T *make(Args &&...args) {
+        static_assert(std::is_base_of_v<Node, T>, "HashCons::make requires an IR node class");
+        return intern(static_cast<const T *>(new T(std::forward<Args>(args)...)));
+    }
+
+    /// @return the number of distinct nodes in the table.
+    static size_t size();
+    /// Forget all interned nodes.  Called when the compile context ends; must also be called
+    /// before the memory of interned nodes is released in any other way.
+    static void clear();
+};
+
+}  // namespace P4::IR
+
+#endif /* IR_HASH_CONS_H_ */
@@ -18,6 +18,8 @@
 #include "lib/string_map.h"
 
 namespace P4 {
+class BinaryGenerator;
+class BinaryLoader;
 class JSONLoader;
 }  // namespace P4
 
@@ -75,6 +77,7 @@ class IndexedVector : public Vector<T> {
         insert(Vector<T>::end(), start, end);
     }
     explicit IndexedVector(JSONLoader &json);
+    explicit IndexedVector(BinaryLoader &in);
 
     void clear() {
         IR::Vector<T>::clear();
@@ -212,6 +215,8 @@ class IndexedVector : public Vector<T> {
 
     void toJSON(JSONGenerator &json) const override;
     static Node *fromJSON(JSONLoader &json);
+    void toBinary(BinaryGenerator &out) const override;
+    static Node *fromBinary(BinaryLoader &in);
     void validate() const override {
         if (invalid) return;  // don't crash the compiler because an error happened
         for (auto el : *this) {
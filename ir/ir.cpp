@@ -55,8 +55,8 @@ const cstring IApply::applyMethodName = "apply"_cs;
 const cstring P4Program::main = "main"_cs;
 const cstring Type_Error::error = "error"_cs;
 
-long IR::Declaration::nextId = 0;
-long IR::This::nextId = 0;
+std::atomic<long> IR::Declaration::nextId = 0;
+std::atomic<long> IR::This::nextId = 0;
 
 const Type_Method *P4Control::getConstructorMethodType() const {
     return new Type_Method(getTypeParameters(), type, constructorParams, getName());
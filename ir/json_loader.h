@@ -48,39 +48,93 @@ class JSONLoader {
 
     std::unordered_map<int, IR::Node *> &node_refs;
     std::unique_ptr<JsonData> json_root;
-    const JsonData *json = nullptr;
+    mutable const JsonData *json = nullptr;
     JsonData::LocationInfo *locinfo = nullptr;
     bool (*errfn)(const JSONLoader &, std::string_view msg) = nullptr;
+    // When loading from a stream, objects and arrays are read directly from the parser as
+    // they are unpacked (frame is the one this loader is reading), so that the whole input
+    // never needs to be held in memory as a JsonData tree.  Other values are read into json.
+    std::unique_ptr<JsonPullParser> root_parser;
+    JsonPullParser *parser = nullptr;
+    std::shared_ptr<JsonPullParser::Frame> frame;
 
     JSONLoader(const JsonData *json, std::unordered_map<int, IR::Node *> &refs,
                JsonData::LocationInfo *locinfo)
         : node_refs(refs), json(json), locinfo(locinfo) {}
+    // loader for the next value read from parser
+    JSONLoader(JsonPullParser *parser, std::unordered_map<int, IR::Node *> &refs,
+               JsonData::LocationInfo *locinfo)
+        : node_refs(refs), locinfo(locinfo), parser(parser) {
+        frame = parser->beginValue(json_root);
+        json = json_root.get();
+    }
+
+    // true if reading an object or array from the parser
+    bool streaming() const { return frame && !frame->data; }
+    // the value as a JsonData tree, reading it from the parser if needed
+    const JsonData *data() const {
+        if (frame) {
+            parser->materialize(*frame);
+            json = frame->data.get();
+        }
+        return json;
+    }
 
  public:
     explicit JSONLoader(std::istream &in, JsonData::LocationInfo *li = nullptr)
-        : node_refs(*(new std::unordered_map<int, IR::Node *>())), locinfo(li) {
-        in >> json_root;
+        : node_refs(*(new std::unordered_map<int, IR::Node *>())),
+          locinfo(li),
+          root_parser(new JsonPullParser(in)),
+          parser(root_parser.get()) {
+        frame = parser->beginValue(json_root);
         json = json_root.get();
     }
 
     JSONLoader(const JSONLoader &unpacker, std::string_view field)
         : node_refs(unpacker.node_refs), json(nullptr), locinfo(unpacker.locinfo) {
         if (!unpacker) return;
-        if (auto *obj = unpacker.json->to<JsonObject>()) {
+        if (unpacker.streaming() && unpacker.frame->isObject) {
+            // Fields skipped to find this one are kept for later.  Fields are usually asked
+            // for in the order they were written, so these are few and small (such as
+            // Node_Type).  Objects and arrays which were read can't be asked for again.
+            auto &obj = *unpacker.frame;
+            if (auto it = obj.fields.find(field); it != obj.fields.end()) {
+                json = it->second.get();
+                return;
+            }
+            parser = unpacker.parser;
+            std::string key;
+            while (parser->nextItem(obj, &key)) {
+                if (key != field) {
+                    parser->stream() >> obj.fields[key];
+                    continue;
+                }
+                frame = parser->beginValue(json_root);
+                if ((json = json_root.get())) obj.fields.emplace(key, std::move(json_root));
+                return;
+            }
+            return;
+        }
+        if (auto *obj = unpacker.data()->to<JsonObject>()) {
             if (auto it = obj->find(field); it != obj->end()) {
                 json = it->second.get();
             }
         }
     }
 
-    explicit operator bool() const { return json != nullptr; }
+    explicit operator bool() const { return json != nullptr || frame != nullptr; }
     template <typename T>
     [[nodiscard]] bool is() const {
-        return json && json->is<T>();
+        if (streaming()) {
+            if constexpr (std::is_same_v<T, JsonObject>) return frame->isObject;
+            if constexpr (std::is_same_v<T, JsonVector>) return !frame->isObject;
+            return std::is_same_v<T, JsonData>;
+        }
+        return data() && json->is<T>();
     }
     template <typename T>
     [[nodiscard]] const T &as() const {
-        return json->as<T>();
+        return data()->as<T>();
     }
 
     std::string locdesc(const JsonData &d) const {
@@ -88,17 +142,57 @@ class JSONLoader {
         return locinfo->desc(d);
     }
     std::string locdesc() const {
-        if (!json) return "";
+        if (streaming()) return locinfo ? locinfo->desc(frame->start) : "";
+        if (!data()) return "";
         return locdesc(*json);
     }
     bool error(std::string_view msg) const {
-        if ((!errfn || errfn(*this, msg)) && JsonData::strict) throw JsonData::error(msg, json);
+        if ((!errfn || errfn(*this, msg)) && JsonData::strict) {
+            if (streaming()) throw JsonData::error(msg, frame->start);
+            throw JsonData::error(msg, data());
+        }
         return false;
     }
 
  private:
+    /// Call @p fn with a loader for each element of an array.
+    template <typename F>
+    void for_each_element(F fn) {
+        if (streaming() && !frame->isObject) {
+            while (parser->nextItem(*frame)) {
+                JSONLoader elem(parser, node_refs, locinfo);
+                fn(elem);
+            }
+            return;
+        }
+        for (auto &e : as<JsonVector>()) {
+            JSONLoader elem(e.get(), node_refs, locinfo);
+            fn(elem);
+        }
+    }
+    /// Call @p fn with the name and a loader for the value of each field of an object.
+    template <typename F>
+    void for_each_field(F fn) {
+        if (streaming() && frame->isObject) {
+            for (auto &e : frame->fields) {
+                JSONLoader field(e.second.get(), node_refs, locinfo);
+                fn(e.first, field);
+            }
+            std::string key;
+            while (parser->nextItem(*frame, &key)) {
+                JSONLoader field(parser, node_refs, locinfo);
+                fn(cstring(key), field);
+            }
+            return;
+        }
+        for (auto &e : as<JsonObject>()) {
+            JSONLoader field(e.second.get(), node_refs, locinfo);
+            fn(e.first, field);
+        }
+    }
+
     const IR::Node *get_node(NodeFactoryFn factory = nullptr) {
-        if (!json || !json->is<JsonObject>()) return nullptr;  // invalid json exception?
+        if (!is<JsonObject>()) return nullptr;  // invalid json exception?
         int id;
         auto success = load("Node_ID", id) || error("missing field Node_ID");
         if (!success) return nullptr;
@@ -131,30 +225,30 @@ class JSONLoader {
     void unpack_json(safe_vector<T> &v) {
         T temp;
         v.clear();
-        for (auto &e : as<JsonVector>()) {
-            load(e, temp);
+        for_each_element([&](JSONLoader &e) {
+            e.unpack_json(temp);
             v.push_back(temp);
-        }
+        });
     }
 
     template <typename T>
     void unpack_json(std::set<T> &v) {
         T temp;
         v.clear();
-        for (auto &e : as<JsonVector>()) {
-            load(e, temp);
+        for_each_element([&](JSONLoader &e) {
+            e.unpack_json(temp);
             v.insert(temp);
-        }
+        });
     }
 
     template <typename T>
     void unpack_json(ordered_set<T> &v) {
         T temp;
         v.clear();
-        for (auto &e : as<JsonVector>()) {
-            load(e, temp);
+        for_each_element([&](JSONLoader &e) {
+            e.unpack_json(temp);
             v.insert(temp);
-        }
+        });
     }
 
     template <typename T>
@@ -192,16 +286,16 @@ class JSONLoader {
         std::pair<K, V> temp;
         v.clear();
         if (is<JsonVector>()) {
-            for (auto &e : as<JsonVector>()) {
-                load(e, temp);
+            for_each_element([&](JSONLoader &e) {
+                e.unpack_json(temp);
                 v.insert(temp);
-            }
+            });
         } else {
-            for (auto &e : as<JsonObject>()) {
-                load(JsonString(e.first), temp.first);
-                load(e.second, temp.second);
+            for_each_field([&](cstring key, JSONLoader &e) {
+                load(JsonString(key.string_view()), temp.first);
+                e.unpack_json(temp.second);
                 v.insert(temp);
-            }
+            });
         }
     }
     template <typename K, typename V>
@@ -209,27 +303,27 @@ class JSONLoader {
         std::pair<K, V> temp;
         v.clear();
         if (is<JsonVector>()) {
-            for (auto &e : as<JsonVector>()) {
-                load(e, temp);
+            for_each_element([&](JSONLoader &e) {
+                e.unpack_json(temp);
                 v.insert(temp);
-            }
+            });
         } else {
-            for (auto &e : as<JsonObject>()) {
-                load(JsonString(e.first), temp.first);
-                load(e.second, temp.second);
+            for_each_field([&](cstring key, JSONLoader &e) {
+                load(JsonString(key.string_view()), temp.first);
+                e.unpack_json(temp.second);
                 v.insert(temp);
-            }
+            });
         }
     }
     template <typename V>
     void unpack_json(string_map<V> &v) {
         std::pair<cstring, V> temp;
         v.clear();
-        for (auto &e : as<JsonObject>()) {
-            temp.first = e.first;
-            load(e.second, temp.second);
+        for_each_field([&](cstring key, JSONLoader &e) {
+            temp.first = key;
+            e.unpack_json(temp.second);
             v.insert(temp);
-        }
+        });
     }
 
     template <typename K, typename V>
@@ -237,16 +331,16 @@ class JSONLoader {
         std::pair<K, V> temp;
         v.clear();
         if (is<JsonVector>()) {
-            for (auto &e : as<JsonVector>()) {
-                load(e, temp);
+            for_each_element([&](JSONLoader &e) {
+                e.unpack_json(temp);
                 v.insert(temp);
-            }
+            });
         } else {
-            for (auto &e : as<JsonObject>()) {
-                load(JsonString(e.first), temp.first);
-                load(e.second, temp.second);
+            for_each_field([&](cstring key, JSONLoader &e) {
+                load(JsonString(key.string_view()), temp.first);
+                e.unpack_json(temp.second);
                 v.insert(temp);
-            }
+            });
         }
     }
 
@@ -254,10 +348,10 @@ class JSONLoader {
     void unpack_json(std::vector<T> &v) {
         T temp;
         v.clear();
-        for (auto &e : as<JsonVector>()) {
-            load(e, temp);
+        for_each_element([&](JSONLoader &e) {
+            e.unpack_json(temp);
             v.push_back(temp);
-        }
+        });
     }
 
     template <typename T, typename U>
@@ -323,24 +417,24 @@ class JSONLoader {
             v = cstring();
     }
     void unpack_json(IR::ID &v) {
-        if (!json->is<JsonNull>()) v.name = as<JsonString>();
+        if (!is<JsonNull>()) v.name = as<JsonString>();
     }
 
     void unpack_json(LTBitMatrix &m) {
-        if (auto *s = json->to<JsonString>()) s->c_str() >> m;
+        if (auto *s = data()->to<JsonString>()) s->c_str() >> m;
     }
 
     void unpack_json(bitvec &v) {
-        if (auto *s = json->to<JsonString>()) s->c_str() >> v;
+        if (auto *s = data()->to<JsonString>()) s->c_str() >> v;
     }
 
     template <typename T>
     std::enable_if_t<std::is_enum_v<T>> unpack_json(T &v) {
-        if (auto *s = json->to<JsonString>()) *s >> v;
+        if (auto *s = data()->to<JsonString>()) *s >> v;
     }
 
     void unpack_json(match_t &v) {
-        if (auto *s = json->to<JsonString>()) s->c_str() >> v;
+        if (auto *s = data()->to<JsonString>()) s->c_str() >> v;
     }
 
     template <typename T>
@@ -382,11 +476,11 @@ class JSONLoader {
 
     template <typename T, size_t N>
     void unpack_json(T (&v)[N]) {
-        if (auto *j = json->to<JsonVector>()) {
-            for (size_t i = 0; i < N && i < j->size(); ++i) {
-                load(j->at(i), v[i]);
-            }
-        }
+        if (!is<JsonVector>()) return;
+        size_t i = 0;
+        for_each_element([&](JSONLoader &e) {
+            if (i < N) e.unpack_json(v[i++]);
+        });
     }
 
  public:
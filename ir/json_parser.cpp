@@ -11,6 +11,7 @@
 #include <utility>
 
 #include "absl/strings/escaping.h"
+#include "lib/exceptions.h"
 
 namespace P4 {
 
@@ -77,6 +78,23 @@ static std::string token(std::istream &in) {
     return rv;
 }
 
+// read the rest of a string after the opening '"'
+static std::string readString(std::istream &in) {
+    std::string s;
+    getline(in, s, '"');
+    while (!s.empty() && s.back() == '\\') {
+        int bscount = 0;  // odd number of '\' chars mean the quote is escaped
+        for (auto t = s.rbegin(); t != s.rend() && *t == '\\'; ++t) bscount++;
+        if ((bscount & 1) == 0) break;
+        s += '"';
+        std::string more;
+        getline(in, more, '"');
+        s += more;
+    }
+    absl::CUnescape(s, &s);
+    return s;
+}
+
 std::istream &operator>>(std::istream &in, std::unique_ptr<JsonData> &json) {
     while (in) {
         char ch;
@@ -137,19 +155,7 @@ std::istream &operator>>(std::istream &in, std::unique_ptr<JsonData> &json) {
                 return in;
             }
             case '"': {
-                std::string s;
-                getline(in, s, '"');
-                while (!s.empty() && s.back() == '\\') {
-                    int bscount = 0;  // odd number of '\' chars mean the quote is escaped
-                    for (auto t = s.rbegin(); t != s.rend() && *t == '\\'; ++t) bscount++;
-                    if ((bscount & 1) == 0) break;
-                    s += '"';
-                    std::string more;
-                    getline(in, more, '"');
-                    s += more;
-                }
-                absl::CUnescape(s, &s);
-                json = std::make_unique<JsonString>(s);
+                json = std::make_unique<JsonString>(readString(in));
                 json->start = start;
                 json->finish = lastpos(in);
                 return in;
@@ -244,6 +250,117 @@ std::istream &operator>>(std::istream &in, std::unique_ptr<JsonData> &json) {
     return in;
 }
 
+std::shared_ptr<JsonPullParser::Frame> JsonPullParser::beginValue(
+    std::unique_ptr<JsonData> &scalar) {
+    char ch = 0;
+    in >> std::ws >> ch;
+    if (in && (ch == '{' || ch == '[')) {
+        auto f = std::make_shared<Frame>(ch == '{', lastpos(in));
+        open.push_back(f);
+        return f;
+    }
+    if (in) in.unget();
+    in >> scalar;
+    return nullptr;
+}
+
+bool JsonPullParser::nextItem(Frame &f, std::string *key) {
+    if (f.closed) return false;
+    unwind(f);
+    char end = f.isObject ? '}' : ']';
+    char ch = 0;
+    in >> std::ws >> ch;
+    if (in && !f.first && ch != end) {
+        if (ch == ',') {
+            in >> std::ws >> ch;
+            if (JsonData::strict && in && ch == end)
+                throw JsonData::error(f.isObject ? "extra ',' at end of object"
+                                                 : "extra ',' at end of vector",
+                                      lastpos(in));
+        } else if (JsonData::strict) {
+            throw JsonData::error(f.isObject ? "missing ',' in object" : "missing ',' in vector",
+                                  lastpos(in));
+        }
+    }
+    if (!in || ch == end) {
+        close(f);
+        return false;
+    }
+    f.first = false;
+    if (!f.isObject) {
+        in.unget();
+        return true;
+    }
+    if (ch != '"') throw JsonData::error("expected a field name in object", lastpos(in));
+    std::string name = readString(in);
+    in >> std::ws >> ch;
+    if (!in || ch != ':') {
+        if (JsonData::strict) throw JsonData::error("missing ':' in object", lastpos(in));
+        if (in) in.unget();
+    }
+    if (key) *key = std::move(name);
+    return true;
+}
+
+void JsonPullParser::skipValue() {
+    int depth = 0;
+    char ch = 0;
+    do {
+        if (!(in >> std::ws >> ch)) return;
+        switch (ch) {
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                --depth;
+                break;
+            case '"':
+                readString(in);
+                break;
+            default:
+                if (depth == 0) {
+                    // a number, true, false or null
+                    while (in.get(ch) && (isalnum(ch) || ch == '-' || ch == '+' || ch == '.')) {
+                    }
+                    if (in) in.unget();
+                }
+        }
+    } while (depth > 0);
+}
+
+void JsonPullParser::materialize(Frame &f) {
+    if (f.data) return;
+    if (f.isObject) {
+        string_map<std::unique_ptr<JsonData>> obj = std::move(f.fields);
+        std::string key;
+        while (nextItem(f, &key)) in >> obj[key];
+        f.data = std::make_unique<JsonObject>(std::move(obj));
+    } else {
+        std::vector<std::unique_ptr<JsonData>> vec;
+        while (nextItem(f)) in >> vec.emplace_back();
+        f.data = std::make_unique<JsonVector>(std::move(vec));
+    }
+    f.data->start = f.start;
+    f.data->finish = lastpos(in);
+}
+
+// skip whatever is left of frames nested in f
+void JsonPullParser::unwind(Frame &f) {
+    while (!open.empty() && open.back().get() != &f) {
+        auto &inner = *open.back();
+        std::string key;
+        while (nextItem(inner, &key)) skipValue();
+    }
+}
+
+void JsonPullParser::close(Frame &f) {
+    BUG_CHECK(!open.empty() && open.back().get() == &f, "closing json frame out of order");
+    f.closed = true;
+    open.pop_back();
+}
+
 std::pair<int, int> JsonData::LocationInfo::loc(std::streamoff l) {
     if (l < 0) return std::make_pair(-1, -1);
     auto it = line.upper_bound(l);
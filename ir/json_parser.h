@@ -29,6 +29,7 @@ class JsonData : public ICastable {
     static bool strict;  // enforce strict syntax checking of json on input, default false.
 
     friend std::istream &operator>>(std::istream &in, std::unique_ptr<JsonData> &json);
+    friend class JsonPullParser;
     struct error : public std::runtime_error {
         const JsonData *data = nullptr;  // object/item with error if parsed
         std::streamoff loc = -1;         // location of the error if no object
@@ -119,6 +120,49 @@ std::ostream &operator<<(std::ostream &out, const JsonData *json);
 inline std::ostream &operator<<(std::ostream &out, const JsonData &json) { return out << &json; }
 std::istream &operator>>(std::istream &in, std::unique_ptr<JsonData> &json);
 
+/// Pull parser reading json incrementally from a stream, so that a consumer (JSONLoader) can
+/// build its own data structures without first building a JsonData tree of the whole input.
+/// Objects and arrays are entered with beginValue and read one item at a time with nextItem.
+/// Scalar values are always returned as (small) JsonData objects.
+class JsonPullParser {
+ public:
+    /// An object or array being read.
+    struct Frame {
+        bool isObject;
+        bool first = true;    // no item read yet
+        bool closed = false;  // the closing brace or bracket has been read
+        std::streamoff start;
+        /// Fields of an object which have been read, but are kept for later use, in order.
+        string_map<std::unique_ptr<JsonData>> fields;
+        /// The whole value, if it was read into a JsonData tree by materialize
+        std::unique_ptr<JsonData> data;
+        Frame(bool isObject, std::streamoff start) : isObject(isObject), start(start) {}
+    };
+
+    explicit JsonPullParser(std::istream &in) : in(in) {}
+
+    /// Start reading the next value.  Objects and arrays return a new Frame; other values are
+    /// read into @p scalar.
+    std::shared_ptr<Frame> beginValue(std::unique_ptr<JsonData> &scalar);
+    /// Move to the next item of @p f, returning false (and closing the frame) at its end.
+    /// Any part of the previous item which was not read is skipped.  For objects, the
+    /// field name is returned in @p key.  The value of the item must be read next, with
+    /// beginValue, skipValue or operator>>.
+    bool nextItem(Frame &f, std::string *key = nullptr);
+    /// Skip the next value without building anything.
+    void skipValue();
+    /// Read what is left of @p f into f.data (together with any kept fields).
+    void materialize(Frame &f);
+    std::istream &stream() { return in; }
+
+ private:
+    std::istream &in;
+    std::vector<std::shared_ptr<Frame>> open;  // frames not yet closed, innermost last
+
+    void unwind(Frame &f);
+    void close(Frame &f);
+};
+
 }  // namespace P4
 
 #endif /* IR_JSON_PARSER_H_ */
@@ -27,6 +27,8 @@ limitations under the License.
 #include "lib/map.h"
 
 namespace P4 {
+class BinaryGenerator;
+class BinaryLoader;
 class JSONLoader;
 }  // namespace P4
 
@@ -55,6 +57,7 @@ class NameMap : public Node {
     NameMap(const NameMap &) = default;
     NameMap(NameMap &&) = default;
     explicit NameMap(JSONLoader &);
+    explicit NameMap(BinaryLoader &);
     NameMap &operator=(const NameMap &) = default;
     NameMap &operator=(NameMap &&) = default;
     typedef typename map_t::value_type value_type;
@@ -144,12 +147,20 @@ class NameMap : public Node {
             if (el.first != it->first || !el.second->equiv(*(it++)->second)) return false;
         return true;
     }
+    size_t equiv_hash() const override {
+        size_t rv = Node::equiv_hash();
+        for (auto &el : *this)
+            rv = Util::hash_combine(rv, Util::Hash{}(el.first, el.second->equiv_hash()));
+        return rv;
+    }
     cstring node_type_name() const override { return "NameMap<" + T::static_type_name() + ">"; }
     static cstring static_type_name() { return "NameMap<" + T::static_type_name() + ">"; }
     void visit_children(Visitor &v, const char *) override;
     void visit_children(Visitor &v, const char *) const override;
     void toJSON(JSONGenerator &json) const override;
     static Node *fromJSON(JSONLoader &json);
+    void toBinary(BinaryGenerator &out) const override;
+    static Node *fromBinary(BinaryLoader &in);
 
     Util::Enumerator<const T *> *valueEnumerator() const {
         return Util::enumerate(Values(symbols));
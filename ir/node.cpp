@@ -19,14 +19,20 @@ limitations under the License.
 
 #include "node.h"
 
+#include <config.h>
+
 #include <ostream>
+#include <vector>
 // use in combination with "raise" below
 // #include <csignal>
 
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
 #include "ir/declaration.h"
 #include "ir/ir.h"
 #include "ir/json_generator.h"
 #include "ir/json_loader.h"
+#include "lib/arena.h"
 #include "lib/indent.h"
 #include "lib/json.h"
 #include "lib/log.h"
@@ -37,6 +43,19 @@ void IR::Node::traceVisit(const char *visitor) const {
     LOG3("Visiting " << visitor << " " << id << ":" << node_type_name());
 }
 
+#if HAVE_IR_ARENA
+namespace {
+/// Nodes allocated in an arena whose constructor has not run yet, innermost last.  Arguments of
+/// a constructor are evaluated after the node they are for is allocated, so there can be several.
+struct PendingArenaNode {
+    char *memory;
+    size_t size;
+    Util::Arena *arena;
+};
+thread_local std::vector<PendingArenaNode> pendingArenaNodes;
+}  // namespace
+#endif
+
 void IR::Node::traceCreation() const {
     /*
       You can use this to trigger a breakpoint in the debugger when a
@@ -45,9 +64,54 @@ void IR::Node::traceCreation() const {
         raise(SIGINT);
     */
     LOG5("Created node " << id);
+#if HAVE_IR_ARENA
+    // Nodes own containers and strings on the heap, so they must be destroyed with the arena.
+    // Only the node that an allocation was made for registers, not nodes that are members of it.
+    if (!pendingArenaNodes.empty()) {
+        auto &top = pendingArenaNodes.back();
+        const auto *self = reinterpret_cast<const char *>(this);
+        if (self >= top.memory && self < top.memory + top.size) {
+            top.arena->destroyLater(top.memory, const_cast<Node *>(this),
+                                    [](void *node) { static_cast<Node *>(node)->~Node(); });
+            pendingArenaNodes.pop_back();
+        }
+    }
+#endif
+}
+
+std::atomic<int> IR::Node::currentId = 0;
+
+void IR::Node::reserveId(int id) {
+    int current = currentId.load(std::memory_order_relaxed);
+    while (id >= current) {
+        if (currentId.compare_exchange_weak(current, id + 1)) break;
+    }
+}
+
+void *IR::Node::operator new(size_t size) {
+#if HAVE_IR_ARENA
+    if (auto *arena = Util::Arena::current()) {
+        auto *p = static_cast<char *>(arena->allocate(size));
+        pendingArenaNodes.push_back({p, size, arena});
+        return p;
+    }
+#endif
+    return ::operator new(size);
 }
 
-int IR::Node::currentId = 0;
+void IR::Node::operator delete(void *p) {
+#if HAVE_IR_ARENA
+    // Nodes in an arena are freed with it; the destructor has run already.
+    if (auto *arena = Util::Arena::owner(p)) {
+        if (!pendingArenaNodes.empty() && pendingArenaNodes.back().memory == p)
+            pendingArenaNodes.pop_back();  // the constructor threw before the node registered
+        else
+            arena->forget(p);
+        return;
+    }
+#endif
+    ::operator delete(p);
+}
 
 void IR::Node::toJSON(JSONGenerator &json) const {
     json.emit("Node_ID", id);
@@ -57,12 +121,20 @@ void IR::Node::toJSON(JSONGenerator &json) const {
 IR::Node::Node(JSONLoader &json) : id(-1) {
     json.load("Node_ID", id) || json.error("missing field Node_Id");
     if (id < 0)
-        id = currentId++;
-    else if (id >= currentId)
-        currentId = id + 1;
+        id = newId();
+    else
+        reserveId(id);
     clone_id = id;
+    traceCreation();
 }
 
+// The id is written with the node type by BinaryGenerator, and read by BinaryLoader to
+// resolve references to the node.  Loaded nodes get new ids, as the saved ones may already be
+// used by nodes of this process.
+void IR::Node::toBinary(BinaryGenerator &) const {}
+
+IR::Node::Node(BinaryLoader &) : id(newId()), clone_id(id) { traceCreation(); }
+
 // Abbreviated debug print
 cstring IR::dbp(const IR::INode *node) {
     std::stringstream str;
@@ -113,7 +185,8 @@ Util::JsonObject *IR::Node::sourceInfoJsonObj() const {
     unsigned lineNumber, columnNumber;
     cstring fName = prepareSourceInfoForJSON(si, &lineNumber, &columnNumber);
     if (fName == nullptr) {
-        if (si.line == -1) {
+        auto *saved = si.getSaved();
+        if (saved == nullptr || saved->line == -1) {
             // -1 is default value for objects when SourceInfo
             // was not read from jsonFile using "--fromJSON" flag
             return nullptr;
@@ -121,10 +194,10 @@ Util::JsonObject *IR::Node::sourceInfoJsonObj() const {
             // Added source_info for jsonObject when "--fromJSON" flag is used
             // which parameters are saved in srcInfo fileds(filename, line, column and srcBrief)
             auto json1 = new Util::JsonObject();
-            json1->emplace("filename", srcInfo.filename);
-            json1->emplace("line", srcInfo.line);
-            json1->emplace("column", srcInfo.column);
-            json1->emplace("source_fragment", srcInfo.srcBrief);
+            json1->emplace("filename", saved->filename);
+            json1->emplace("line", saved->line);
+            json1->emplace("column", saved->column);
+            json1->emplace("source_fragment", saved->srcBrief);
             return json1;
         }
     } else {
@@ -156,13 +229,39 @@ void IR::Node::sourceInfoToJSON(JSONGenerator &json) const {
 
 void IR::Node::sourceInfoFromJSON(JSONLoader &json) {
     if (auto si = JSONLoader(json, "Source_Info")) {
-        si.load("filename", srcInfo.filename);
-        si.load("line", srcInfo.line);
-        si.load("column", srcInfo.column);
-        si.load("source_fragment", srcInfo.srcBrief);
+        Util::SourceInfo::Saved saved;
+        si.load("filename", saved.filename);
+        si.load("line", saved.line);
+        si.load("column", saved.column);
+        si.load("source_fragment", saved.srcBrief);
+        srcInfo = Util::SourceInfo(saved.filename, saved.line, saved.column, saved.srcBrief);
     }
 }
 
+void IR::Node::sourceInfoToBinary(BinaryGenerator &out) const {
+    Util::SourceInfo si = srcInfo;
+    unsigned lineNumber, columnNumber;
+    cstring fName = prepareSourceInfoForJSON(si, &lineNumber, &columnNumber);
+    // a null file name stands for no source position
+    out.emit(fName);
+    if (fName == nullptr) return;
+    out.emit(lineNumber);
+    out.emit(columnNumber);
+    out.emit(si.toBriefSourceFragment());
+}
+
+void IR::Node::sourceInfoFromBinary(BinaryLoader &in) {
+    cstring fName;
+    in.load(fName);
+    if (fName == nullptr) return;
+    unsigned lineNumber, columnNumber;
+    cstring srcBrief;
+    in.load(lineNumber);
+    in.load(columnNumber);
+    in.load(srcBrief);
+    srcInfo = Util::SourceInfo(fName, lineNumber, columnNumber, srcBrief);
+}
+
 IRNODE_DEFINE_APPLY_OVERLOAD(Node, , )
 
 bool IR::INode::hasAnnotation(cstring name) const {
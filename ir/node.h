@@ -17,12 +17,17 @@ limitations under the License.
 #ifndef IR_NODE_H_
 #define IR_NODE_H_
 
+#include <atomic>
+#include <cstddef>
 #include <iosfwd>
+#include <ranges>
+#include <type_traits>
 
 #include "ir/gen-tree-macro.h"
 #include "ir/inode.h"
 #include "ir/ir-tree-macros.h"
 #include "lib/cstring.h"
+#include "lib/hash.h"
 #include "lib/source_file.h"
 
 namespace P4 {
@@ -31,6 +36,8 @@ struct Visitor_Context;
 class Inspector;
 class Modifier;
 class Transform;
+class BinaryGenerator;
+class BinaryLoader;
 class JSONGenerator;
 class JSONLoader;
 }  // namespace P4
@@ -68,7 +75,11 @@ class Node : public virtual INode {
     Node &operator=(Node &&) = default;
 
  protected:
-    static int currentId;
+    // Ids are allocated atomically, so that nodes can be created on any thread.
+    static std::atomic<int> currentId;
+    static int newId() { return currentId.fetch_add(1, std::memory_order_relaxed); }
+    /// Make sure @p id is not allocated again, for a node read back with its id.
+    static void reserveId(int id);
     void traceVisit(const char *visitor) const;
     friend class ::P4::Visitor;
     friend class ::P4::Inspector;
@@ -82,14 +93,19 @@ class Node : public virtual INode {
     int id;        // unique id for each node
     int clone_id;  // unique id this node was cloned from (recursively)
     void traceCreation() const;
-    Node() : id(currentId++), clone_id(id) { traceCreation(); }
-    explicit Node(Util::SourceInfo si) : srcInfo(si), id(currentId++), clone_id(id) {
+    Node() : id(newId()), clone_id(id) { traceCreation(); }
+    explicit Node(Util::SourceInfo si) : srcInfo(si), id(newId()), clone_id(id) {
         traceCreation();
     }
-    Node(const Node &other) : srcInfo(other.srcInfo), id(currentId++), clone_id(other.clone_id) {
+    Node(const Node &other) : srcInfo(other.srcInfo), id(newId()), clone_id(other.clone_id) {
         traceCreation();
     }
     virtual ~Node() {}
+    /// When the compiler is built with ENABLE_IR_ARENA, nodes are allocated in the current
+    /// Util::Arena, if there is one, and are destroyed and freed when the arena is destroyed;
+    /// deleting a node in an arena only runs its destructor.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
     const Node *apply(Visitor &v, const Visitor_Context *ctxt = nullptr) const;
     const Node *apply(Visitor &&v, const Visitor_Context *ctxt = nullptr) const {
         return apply(v, ctxt);
@@ -104,10 +120,14 @@ class Node : public virtual INode {
     static cstring static_type_name() { return "Node"_cs; }
     virtual int num_children() { return 0; }
     explicit Node(JSONLoader &json);
+    explicit Node(BinaryLoader &in);
     cstring toString() const override { return node_type_name(); }
     void toJSON(JSONGenerator &json) const override;
     void sourceInfoToJSON(JSONGenerator &json) const;
     void sourceInfoFromJSON(JSONLoader &json);
+    virtual void toBinary(BinaryGenerator &out) const;
+    void sourceInfoToBinary(BinaryGenerator &out) const;
+    void sourceInfoFromBinary(BinaryLoader &in);
     Util::JsonObject *sourceInfoJsonObj() const;
     /* operator== does a 'shallow' comparison, comparing two Node subclass objects for equality,
      * and comparing pointers in the Node directly for equality */
@@ -115,6 +135,9 @@ class Node : public virtual INode {
     /* 'equiv' does a deep-equals comparison, comparing all non-pointer fields and recursing
      * though all Node subclass pointers to compare them with 'equiv' as well. */
     virtual bool equiv(const Node &a) const { return this->typeId() == a.typeId(); }
+    /* 'equiv_hash' is a structural hash consistent with 'equiv': nodes that are equiv have the
+     * same equiv_hash. */
+    virtual size_t equiv_hash() const { return Util::Hash{}(this->typeId()); }
 #define DEFINE_OPEQ_FUNC(CLASS, BASE) \
     virtual bool operator==(const CLASS &) const { return false; }
     IRNODE_ALL_SUBCLASSES(DEFINE_OPEQ_FUNC)
@@ -142,6 +165,34 @@ inline bool equal(const Node *a, const Node *b) { return a == b || (a && b && *a
 inline bool equal(const INode *a, const INode *b) {
     return a == b || (a && b && *a->getNode() == *b->getNode());
 }
+
+/// Hash of a non-IR field of a node for equiv_hash, consistent with comparing the field with ==.
+/// Containers are hashed element by element, and values of IR (or nested IR) classes with their
+/// equiv_hash.  Any other type needs a Util::Hasher specialization or a boost-style hash_value.
+template <class T>
+size_t equiv_hash_field(const T &v) {
+    if constexpr (std::is_enum_v<T>) {
+        return Util::Hash{}(static_cast<std::underlying_type_t<T>>(v));
+    } else if constexpr (requires { Util::Hasher<T>{}(v); }) {
+        return Util::Hash{}(v);
+    } else if constexpr (requires { hash_value(v); }) {
+        return hash_value(v);
+    } else if constexpr (requires { v.equiv_hash(); }) {
+        return v.equiv_hash();
+    } else if constexpr (requires { v.has_value(); *v; }) {  // std::optional
+        return v.has_value() ? Util::hash_combine(size_t(1), equiv_hash_field(*v)) : 0;
+    } else if constexpr (requires { v.first; v.second; }) {  // std::pair, map elements
+        return Util::hash_combine(equiv_hash_field(v.first), equiv_hash_field(v.second));
+    } else if constexpr (std::ranges::range<T>) {
+        size_t rv = 0;
+        for (const auto &el : v) rv = Util::hash_combine(rv, equiv_hash_field(el));
+        return rv;
+    } else {
+        static_assert(sizeof(T) == 0, "equiv_hash can't hash this field type");
+        return 0;
+    }
+}
+
 inline bool equiv(const Node *a, const Node *b) { return a == b || (a && b && a->equiv(*b)); }
 inline bool equiv(const INode *a, const INode *b) {
     return a == b || (a && b && a->getNode()->equiv(*b->getNode()));
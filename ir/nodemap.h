@@ -85,6 +85,12 @@ class NodeMap : public Node {
             if (el.first != it->first || !el.second->equiv(*(it++)->second)) return false;
         return true;
     }
+    size_t equiv_hash() const override {
+        size_t rv = Node::equiv_hash();
+        for (auto &el : *this)
+            rv = Util::hash_combine(rv, Util::Hash{}(el.first, el.second->equiv_hash()));
+        return rv;
+    }
     cstring node_type_name() const override {
         return "NodeMap<" + KEY::static_type_name() + "," + VALUE::static_type_name() + ">";
     }
@@ -25,7 +25,9 @@ limitations under the License.
 
 #include "ir/dump.h"
 #include "ir/node.h"
+#include "ir/pass_profile.h"
 #include "ir/visitor.h"
+#include "lib/arena.h"
 #include "lib/error.h"
 #include "lib/gc.h"
 #include "lib/indent.h"
@@ -81,8 +83,31 @@ const IR::Node *PassManager::apply_visitor(const IR::Node *program, const char *
         try {
             try {
                 LOG1(log_indent << name() << " invoking " << v->name());
+                auto *arena = Util::Arena::current();
+                size_t arenaBefore = arena ? arena->bytesAllocated() : 0;
+                // A nested PassManager without an AnalysisManager of its own only uses this
+                // one while it runs.
+                struct lend_analyses {
+                    PassManager *pm = nullptr;
+                    ~lend_analyses() {
+                        if (pm) pm->analyses = nullptr;
+                    }
+                } lent;
+                if (analyses) {
+                    if (auto *pm = dynamic_cast<PassManager *>(v); pm && !pm->analyses) {
+                        pm->analyses = analyses;
+                        lent.pm = pm;
+                    }
+                    analyses->beforePass(v, program);
+                }
                 program = program->apply(**it, getChildContext());
+                if (analyses) analyses->afterPass(v, program);
                 if (LOGGING(3)) {
+                    if (arena)
+                        LOG3(log_indent << "arena after " << v->name() << ": allocated "
+                                        << n4(arena->bytesAllocated() - arenaBefore)
+                                        << "B, total " << n4(arena->bytesAllocated())
+                                        << "B, reserved " << n4(arena->bytesReserved()) << "B");
                     size_t maxmem, mem = gc_mem_inuse(&maxmem);  // triggers gc
                     LOG3(log_indent << "heap after " << v->name() << ": in use " << n4(mem)
                                     << "B, max " << n4(maxmem) << "B");
@@ -95,6 +120,7 @@ const IR::Node *PassManager::apply_visitor(const IR::Node *program, const char *
             }
         } catch (Backtrack::trigger &trig) {
             LOG1(log_indent << "caught backtrack trigger " << trig);
+            if (analyses) analyses->afterPass(v, nullptr);
             while (!backup.empty()) {
                 if (backup.back().first == it) {
                     backup.pop_back();
@@ -153,6 +179,7 @@ const IR::Node *PassRepeated::apply_visitor(const IR::Node *program, const char
     while (!done) {
         LOG5("PassRepeated state is:\n" << dumpToString(program));
         running = true;
+        PassProfile::iteration();
         auto newprogram = PassManager::apply_visitor(program, name);
         if (program == newprogram || newprogram == nullptr) done = true;
         if (stop_on_error && ::P4::errorCount() > initial_error_count) return program;
@@ -166,6 +193,7 @@ const IR::Node *PassRepeated::apply_visitor(const IR::Node *program, const char
 const IR::Node *PassRepeatUntil::apply_visitor(const IR::Node *program, const char *name) {
     do {
         running = true;
+        PassProfile::iteration();
         program = PassManager::apply_visitor(program, name);
     } while (!done());
     return program;
@@ -23,6 +23,7 @@ limitations under the License.
 #include <type_traits>
 #include <vector>
 
+#include "ir/analysis_manager.h"
 #include "ir/node.h"
 #include "ir/visitor.h"
 #include "lib/cstring.h"
@@ -48,6 +49,7 @@ class PassManager : virtual public Visitor, virtual public Backtrack {
     bool stop_on_error = true;
     bool running = false;
     unsigned seqNo = 0;
+    AnalysisManager *analyses = nullptr;
     void runDebugHooks(const char *visitorName, const IR::Node *node);
     profile_t init_apply(const IR::Node *root) override {
         running = true;
@@ -106,6 +108,9 @@ class PassManager : virtual public Visitor, virtual public Backtrack {
     bool backtrack(trigger &trig) override;
     bool never_backtracks() override;
     void setStopOnError(bool stop) { stop_on_error = stop; }
+    /// Keep the analyses registered with @am up to date while running the passes; nested
+    /// PassManagers use the same AnalysisManager unless they have their own.
+    void setAnalysisManager(AnalysisManager *am) { analyses = am; }
     void addDebugHook(DebugHook h, bool recursive = false) {
         debugHooks.push_back(h);
         if (recursive)
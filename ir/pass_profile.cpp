@@ -0,0 +1,235 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/pass_profile.h"
+
+#include <config.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "ir/visitor.h"
+#include "lib/arena.h"
+#include "lib/cstring.h"
+#include "lib/exceptions.h"
+#include "lib/gc.h"
+#include "lib/json.h"
+#include "lib/ordered_map.h"
+#include "lib/thread_pool.h"
+
+namespace P4 {
+
+using namespace P4::literals;
+
+bool PassProfile::enabled_ = false;
+std::atomic<uint64_t> PassProfile::nodesVisited{0};
+std::atomic<uint64_t> PassProfile::nodesCloned{0};
+std::atomic<uint64_t> PassProfile::bytesAllocated{0};
+
+namespace {
+
+#if HAVE_LIBGC || HAVE_IR_ARENA
+constexpr bool haveAllocTrace = true;
+#else
+constexpr bool haveAllocTrace = false;
+#endif
+
+#if HAVE_IR_ARENA
+constexpr bool haveArena = true;
+#else
+constexpr bool haveArena = false;
+#endif
+
+struct Counters {
+    uint64_t visited = 0, cloned = 0, bytes = 0, arenaBytes = 0;
+    Counters &operator+=(const Counters &a) {
+        visited += a.visited;
+        cloned += a.cloned;
+        bytes += a.bytes;
+        arenaBytes += a.arenaBytes;
+        return *this;
+    }
+    Counters operator-(const Counters &a) const {
+        return {visited - a.visited, cloned - a.cloned, bytes - a.bytes,
+                arenaBytes - a.arenaBytes};
+    }
+};
+
+/// Aggregated data for all the runs of a pass with the same name under the same parent.
+struct Entry {
+    cstring name;
+    unsigned calls = 0, iterations = 0;
+    absl::Duration time;
+    Counters counters;
+    ordered_map<cstring, Entry *> children;
+
+    Entry *child(cstring childName) {
+        auto &rv = children[childName];
+        if (!rv) {
+            rv = new Entry;
+            rv->name = childName;
+        }
+        return rv;
+    }
+};
+
+/// One run of a visitor, reported as a Chrome trace "complete" event.
+struct Event {
+    cstring name;
+    absl::Time start;
+    absl::Duration duration;
+    Counters counters;
+};
+
+struct Frame {
+    const Visitor *visitor;
+    Entry *entry;
+    absl::Time start;
+    Counters counters;
+};
+
+struct Profile {
+    Entry root;
+    std::vector<Frame> stack;
+    std::vector<Event> events;
+    absl::Time firstStart = absl::InfinitePast();
+    std::atomic<uint64_t> *savedCounter = nullptr;
+};
+
+Profile &profile() {
+    static auto *profile = new Profile;
+    return *profile;
+}
+
+Util::JsonObject *toJson(const Entry *entry) {
+    auto *rv = new Util::JsonObject();
+    rv->emplace("name"_cs, entry->name);
+    rv->emplace("calls"_cs, entry->calls);
+    if (entry->iterations) rv->emplace("iterations"_cs, entry->iterations);
+    rv->emplace("wall_us"_cs, absl::ToInt64Microseconds(entry->time));
+    rv->emplace("nodes_visited"_cs, entry->counters.visited);
+    rv->emplace("nodes_cloned"_cs, entry->counters.cloned);
+    if (haveAllocTrace) rv->emplace("alloc_bytes"_cs, entry->counters.bytes);
+    if (haveArena) rv->emplace("arena_bytes"_cs, entry->counters.arenaBytes);
+    if (!entry->children.empty()) {
+        auto *children = new Util::JsonArray();
+        for (auto &[_, child] : entry->children) children->append(toJson(child));
+        rv->emplace("children"_cs, children);
+    }
+    return rv;
+}
+
+/// The counters as they are now.  Arena usage is measured in the current arena, which is the same
+/// at the start and end of a pass.
+Counters current(const std::atomic<uint64_t> &visited, const std::atomic<uint64_t> &cloned,
+                 const std::atomic<uint64_t> &bytes) {
+    const auto *arena = Util::Arena::current();
+    return {visited.load(), cloned.load(), bytes.load(), arena ? arena->bytesAllocated() : 0};
+}
+
+}  // namespace
+
+void PassProfile::enable(bool enable) {
+    if (enable == enabled_) return;
+    enabled_ = enable;
+    if (haveAllocTrace) {
+        if (enable)
+            profile().savedCounter = set_alloc_counter(&bytesAllocated);
+        else
+            set_alloc_counter(profile().savedCounter);
+    }
+}
+
+void PassProfile::writeAtExit(std::filesystem::path file) {
+    static std::filesystem::path reportFile;
+    bool registered = !reportFile.empty();
+    reportFile = std::move(file);
+    enable();
+    if (registered) return;
+    std::atexit([] {
+        enable(false);
+        std::ofstream out(reportFile);
+        if (!out) {
+            // the compile context is gone by now, so this can't be reported as an error
+            std::cerr << "Can't write pass profile to " << reportFile << std::endl;
+            return;
+        }
+        write(out);
+    });
+}
+
+void PassProfile::reset() {
+    auto &p = profile();
+    BUG_CHECK(p.stack.empty(), "Resetting the pass profile while passes are running");
+    p.root.children.clear();
+    p.events.clear();
+    p.firstStart = absl::InfinitePast();
+}
+
+void PassProfile::begin(const Visitor &v) {
+    if (!enabled_ || Util::ThreadPool::inWorker()) return;
+    auto &p = profile();
+    auto *parent = p.stack.empty() ? &p.root : p.stack.back().entry;
+    auto now = absl::Now();
+    if (p.firstStart == absl::InfinitePast()) p.firstStart = now;
+    p.stack.push_back({&v, parent->child(cstring(v.name())), now,
+                       current(nodesVisited, nodesCloned, bytesAllocated)});
+}
+
+void PassProfile::end(const Visitor &v) {
+    if (Util::ThreadPool::inWorker()) return;
+    auto &p = profile();
+    // Visitors that were already running when profiling was enabled have no frame.
+    if (p.stack.empty() || p.stack.back().visitor != &v) return;
+    auto frame = p.stack.back();
+    p.stack.pop_back();
+    auto duration = absl::Now() - frame.start;
+    Counters counters = current(nodesVisited, nodesCloned, bytesAllocated) - frame.counters;
+    frame.entry->calls++;
+    frame.entry->time += duration;
+    frame.entry->counters += counters;
+    p.events.push_back({frame.entry->name, frame.start, duration, counters});
+}
+
+void PassProfile::iteration() {
+    if (!enabled_ || Util::ThreadPool::inWorker()) return;
+    auto &p = profile();
+    if (!p.stack.empty()) p.stack.back().entry->iterations++;
+}
+
+void PassProfile::write(std::ostream &out) {
+    auto &p = profile();
+    auto *events = new Util::JsonArray();
+    for (auto &event : p.events) {
+        auto *json = new Util::JsonObject();
+        json->emplace("name"_cs, event.name);
+        json->emplace("ph"_cs, "X");
+        json->emplace("ts"_cs, absl::ToInt64Microseconds(event.start - p.firstStart));
+        json->emplace("dur"_cs, absl::ToInt64Microseconds(event.duration));
+        json->emplace("pid"_cs, 1);
+        json->emplace("tid"_cs, 1);
+        auto *args = new Util::JsonObject();
+        args->emplace("nodes_visited"_cs, event.counters.visited);
+        args->emplace("nodes_cloned"_cs, event.counters.cloned);
+        if (haveAllocTrace) args->emplace("alloc_bytes"_cs, event.counters.bytes);
+        if (haveArena) args->emplace("arena_bytes"_cs, event.counters.arenaBytes);
+        json->emplace("args"_cs, args);
+        events->append(json);
+    }
+    auto *passes = new Util::JsonArray();
+    for (auto &[_, entry] : p.root.children) passes->append(toJson(entry));
+
+    Util::JsonObject report;
+    report.emplace("displayTimeUnit"_cs, "ms");
+    report.emplace("traceEvents"_cs, events);
+    report.emplace("passes"_cs, passes);
+    report.serialize(out);
+    out << std::endl;
+}
+
+}  // namespace P4
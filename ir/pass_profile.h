@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_PASS_PROFILE_H_
+#define IR_PASS_PROFILE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+
+namespace P4 {
+
+class Visitor;
+
+/// Collects a per-pass profile of a compilation: for every visitor applied (including the
+/// passes of nested PassManagers and PassRepeated loops) the wall time, the number of IR nodes
+/// visited, the number of nodes Modifiers and Transforms cloned and kept (because they changed),
+/// the bytes allocated and the number of loop iterations.  Runs of a pass with the same name
+/// under the same parent are aggregated in the report.
+///
+/// The report is a single JSON object in Chrome trace-event format: "traceEvents" holds one
+/// complete event per visitor run, so it can be loaded in chrome://tracing or Perfetto, and
+/// "passes" holds the aggregated pass hierarchy.
+///
+/// Allocated bytes are collected through the allocation counter (lib/gc.h), so they are only
+/// reported when the compiler is built with the GC or IR arenas.  When the compiler is built
+/// with IR arenas, the bytes each pass allocates in the current arena are also reported, as
+/// "arena_bytes".
+class PassProfile {
+    static bool enabled_;
+    static std::atomic<uint64_t> nodesVisited, nodesCloned, bytesAllocated;
+
+ public:
+    PassProfile() = delete;
+
+    static bool enabled() { return enabled_; }
+    /// Start or stop collecting the profile.  Data already collected is kept.
+    static void enable(bool enable = true);
+    /// Enable profiling and write the report to @file when the program exits.
+    static void writeAtExit(std::filesystem::path file);
+    /// Write the report for everything collected so far.
+    static void write(std::ostream &out);
+    /// Discard all collected data.
+    static void reset();
+
+    /// Hooks called by the visitors.
+    static void begin(const Visitor &v);
+    static void end(const Visitor &v);
+    static void iteration();
+    static void countVisit() {
+        if (enabled_) nodesVisited.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// Count a clone that is kept as the result of visiting a node.
+    static void countClone() {
+        if (enabled_) nodesCloned.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+}  // namespace P4
+
+#endif /* IR_PASS_PROFILE_H_ */
@@ -16,6 +16,10 @@ limitations under the License.
 
 #include <cstddef>
 #include <map>
+#ifdef MULTITHREAD
+#include <mutex>
+#endif
+#include <new>
 #include <utility>
 
 #include "frontends/common/parser_options.h"
@@ -49,19 +53,36 @@ const IR::ID IR::Type_Table::hit = ID("hit");
 const IR::ID IR::Type_Table::miss = ID("miss");
 const IR::ID IR::Type_Table::action_run = ID("action_run");
 
-long Type_Declaration::nextId = 0;
-long Type_InfInt::nextId = 0;
-long Type_Any::nextId = 0;
+namespace {
+/// Types cached for the whole process are allocated on the heap even when IR nodes are
+/// allocated in an arena (see Util::Arena), which is freed at the end of the compilation.
+template <class T, class... Args>
+const T *newCachedType(Args... args) {
+    return ::new (::operator new(sizeof(T))) T(args...);
+}
+}  // namespace
+
+std::atomic<long> Type_Declaration::nextId = 0;
+std::atomic<long> Type_InfInt::nextId = 0;
+std::atomic<long> Type_Any::nextId = 0;
 
 const Type *Type_Array::at(size_t) const { return elementType; }
 
 const Type_Bits *Type_Bits::get(int width, bool isSigned) {
     // map (width, signed) to type
     using bit_type_key = std::pair<int, bool>;
-    static std::map<bit_type_key, const IR::Type_Bits *> *type_map = nullptr;
-    if (type_map == nullptr) type_map = new std::map<bit_type_key, const IR::Type_Bits *>();
-    auto &result = (*type_map)[std::make_pair(width, isSigned)];
-    if (!result) result = new Type_Bits(width, isSigned);
+    static auto *type_map = new std::map<bit_type_key, const IR::Type_Bits *>();
+    const IR::Type_Bits *result;
+    {
+#ifdef MULTITHREAD
+        // Type inference of independent declarations may run concurrently.
+        static std::mutex type_map_lock;
+        std::lock_guard<std::mutex> guard(type_map_lock);
+#endif
+        auto &entry = (*type_map)[std::make_pair(width, isSigned)];
+        if (!entry) entry = newCachedType<Type_Bits>(width, isSigned);
+        result = entry;
+    }
     if (width > P4CContext::getConfig().maximumWidthSupported())
         ::P4::error(ErrorType::ERR_UNSUPPORTED, "%1%: Compiler only supports widths up to %2%",
                     result, P4CContext::getConfig().maximumWidthSupported());
@@ -95,8 +116,7 @@ const Type_Bits *Type_Bits::get(const Util::SourceInfo &si, const IR::Expression
 }
 
 const Type_Unknown *Type_Unknown::get() {
-    static const Type_Unknown *singleton = nullptr;
-    if (!singleton) singleton = (new Type_Unknown());
+    static const Type_Unknown *singleton = newCachedType<Type_Unknown>();
     return singleton;
 }
 
@@ -106,8 +126,7 @@ const Type_Unknown *Type_Unknown::get(const Util::SourceInfo &si) {
 }
 
 const Type_Boolean *Type_Boolean::get() {
-    static const Type_Boolean *singleton = nullptr;
-    if (!singleton) singleton = (new Type_Boolean());
+    static const Type_Boolean *singleton = newCachedType<Type_Boolean>();
     return singleton;
 }
 
@@ -117,8 +136,7 @@ const Type_Boolean *Type_Boolean::get(const Util::SourceInfo &si) {
 }
 
 const Type_String *Type_String::get() {
-    static const Type_String *singleton = nullptr;
-    if (!singleton) singleton = (new Type_String());
+    static const Type_String *singleton = newCachedType<Type_String>();
     return singleton;
 }
 
@@ -163,8 +181,7 @@ const Type_InfInt *Type_InfInt::get(const Util::SourceInfo &si) {
 }
 
 const Type_Dontcare *Type_Dontcare::get() {
-    static const Type_Dontcare *singleton;
-    if (!singleton) singleton = (new Type_Dontcare());
+    static const Type_Dontcare *singleton = newCachedType<Type_Dontcare>();
     return singleton;
 }
 
@@ -174,8 +191,7 @@ const Type_Dontcare *Type_Dontcare::get(const Util::SourceInfo &si) {
 }
 
 const Type_State *Type_State::get() {
-    static const Type_State *singleton;
-    if (!singleton) singleton = (new Type_State());
+    static const Type_State *singleton = newCachedType<Type_State>();
     return singleton;
 }
 
@@ -185,8 +201,7 @@ const Type_State *Type_State::get(const Util::SourceInfo &si) {
 }
 
 const Type_Void *Type_Void::get() {
-    static const Type_Void *singleton = nullptr;
-    if (!singleton) singleton = (new Type_Void());
+    static const Type_Void *singleton = newCachedType<Type_Void>();
     return singleton;
 }
 
@@ -196,8 +211,7 @@ const Type_Void *Type_Void::get(const Util::SourceInfo &si) {
 }
 
 const Type_MatchKind *Type_MatchKind::get() {
-    static const Type_MatchKind *singleton = nullptr;
-    if (!singleton) singleton = (new Type_MatchKind());
+    static const Type_MatchKind *singleton = newCachedType<Type_MatchKind>();
     return singleton;
 }
 
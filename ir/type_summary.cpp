@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/type_summary.h"
+
+#ifdef MULTITHREAD
+#include <mutex>
+#endif
+#include <cstdint>
+#include <unordered_set>
+
+#include "absl/container/flat_hash_map.h"
+#include "ir/ir.h"
+#include "ir/visitor.h"
+#include "lib/compile_context.h"
+#include "lib/exceptions.h"
+#include "lib/hash.h"
+
+namespace P4::IR {
+
+namespace {
+
+constexpr size_t numKinds = static_cast<size_t>(NodeKind::VectorBase) + 1;
+
+/// The number of nodes whose summaries are cached in each generation of the cache.
+constexpr size_t maxCachedNodes = 1 << 20;
+
+struct BitvecHash {
+    size_t operator()(const bitvec &bv) const {
+        uint64_t rv = 0;
+        for (auto bit : bv) rv = Util::hash_combine(rv, bit);
+        return rv;
+    }
+};
+
+/// The summary computed for a node, with the id the node had at the time.  A node that was
+/// assigned to, or a new node reusing the memory of a freed one, has a different id.
+struct CachedSummary {
+    int id;
+    const bitvec *summary;
+};
+
+/// Interned summaries, the kinds each dynamic node type `is<>`, and the summaries of nodes.
+struct Tables {
+    std::unordered_set<bitvec, BitvecHash> summaries;
+    absl::flat_hash_map<RTTI::TypeId, bitvec> kinds;
+    /// Keyed by the complemented address of the node, so that the cache does not keep nodes
+    /// alive when the compiler is built with the GC.  Summaries are added to @young; when it is
+    /// full it replaces @old, and summaries that are used again are moved back from @old.  So
+    /// only summaries not used for a whole generation are dropped, and the summaries of the
+    /// children of a node being summarized are still there.
+    absl::flat_hash_map<uintptr_t, CachedSummary> young, old;
+    /// The context whose end will empty the node cache.
+    AutoCompileContext *clearingContext = nullptr;
+#ifdef MULTITHREAD
+    std::mutex lock;
+#endif
+};
+
+uintptr_t cacheKey(const Node *n) { return ~reinterpret_cast<uintptr_t>(n); }
+
+Tables &tables() {
+    static auto *tables = new Tables;
+    return *tables;
+}
+
+const bitvec &kindsOf(Tables &t, const Node *n) {
+    auto [it, inserted] = t.kinds.try_emplace(n->typeId());
+    if (inserted) {
+        for (size_t k = static_cast<size_t>(NodeKind::INode); k < numKinds; ++k)
+            if (n->isA(k)) it->second.setbit(k);
+    }
+    return it->second;
+}
+
+/// Cache @summary as the summary of @n; called with the lock held.
+void remember(Tables &t, const Node *n, const bitvec *summary) {
+    if (t.young.size() >= maxCachedNodes) {
+        t.old = std::move(t.young);
+        t.young.clear();
+    }
+    t.young.insert_or_assign(cacheKey(n), CachedSummary{n->id, summary});
+}
+
+class SummarizeChildren : public Visitor {
+    bitvec &summary;
+    const Node *apply_visitor(const Node *n, const char * = 0) override {
+        if (n) summary |= TypeSummary::get(n);
+        return n;
+    }
+
+ public:
+    explicit SummarizeChildren(bitvec &summary) : summary(summary) {}
+};
+
+}  // namespace
+
+size_t TypeSummary::index(RTTI::TypeId id) {
+    BUG_CHECK(id > 0 && id < numKinds,
+              "Type summaries don't distinguish template IR classes; use IR::VectorBase");
+    return id;
+}
+
+const bitvec &TypeSummary::get(const Node *n) {
+    CHECK_NULL(n);
+    auto &t = tables();
+    {
+#ifdef MULTITHREAD
+        std::lock_guard<std::mutex> guard(t.lock);
+#endif
+        if (auto it = t.young.find(cacheKey(n)); it != t.young.end()) {
+            if (it->second.id == n->id) return *it->second.summary;
+        } else if (auto it = t.old.find(cacheKey(n)); it != t.old.end() && it->second.id == n->id) {
+            const auto *rv = it->second.summary;
+            t.old.erase(it);
+            remember(t, n, rv);
+            return *rv;
+        }
+    }
+    bitvec summary;
+    SummarizeChildren summarize(summary);
+    n->visit_children(summarize);
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(t.lock);
+#endif
+    summary |= kindsOf(t, n);
+    const auto *rv = &*t.summaries.insert(std::move(summary)).first;
+    remember(t, n, rv);
+    // Nodes in the arena of a compile context are freed when it ends.
+    if (auto *context = AutoCompileContext::innermost(); context && context != t.clearingContext) {
+        t.clearingContext = context;
+        context->atEnd([] { clear(); });
+    }
+    return *rv;
+}
+
+void TypeSummary::clear() {
+    auto &t = tables();
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(t.lock);
+#endif
+    t.young.clear();
+    t.old.clear();
+    t.clearingContext = nullptr;
+}
+
+size_t TypeSummary::size() {
+    auto &t = tables();
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(t.lock);
+#endif
+    return t.summaries.size();
+}
+
+}  // namespace P4::IR
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef IR_TYPE_SUMMARY_H_
+#define IR_TYPE_SUMMARY_H_
+
+#include <cstddef>
+
+#include "lib/bitvec.h"
+#include "lib/rtti.h"
+
+namespace P4::IR {
+
+class Node;
+
+/// Summaries of the kinds of IR nodes contained in a subtree, used by visitors to skip
+/// subtrees that contain nothing they are interested in (see Transform::onlyVisitSubtreesWith).
+///
+/// A summary is a bitvec indexed by the NodeKind (the RTTI typeid) of the IR classes and
+/// interfaces: the bit for a class is set if the subtree contains a node which `is<>` that
+/// class, so a summary includes the base classes of every node in it.  Template classes
+/// (IR::Vector, IR::IndexedVector, ...) are only represented by IR::VectorBase and IR::Node.
+///
+/// Summaries are computed on demand, once per node, and cached in a table keyed by the node and
+/// its id; identical summaries are shared.  As a clone or a node assigned to gets a different
+/// id, a node modified by a visitor gets a fresh summary the next time one is needed.  A node
+/// must not be modified in place once its summary has been computed.  When the cache is full,
+/// the summaries that have not been used for longest are dropped; it is emptied when the
+/// innermost compile context ends.
+class TypeSummary {
+ public:
+    TypeSummary() = delete;
+
+    /// @return the summary of the subtree rooted at @n.
+    static const bitvec &get(const Node *n);
+
+    /// @return the bit used for the IR class or interface with RTTI typeid @id.
+    static size_t index(RTTI::TypeId id);
+
+    /// @return a summary with the bits for the classes T set, to be tested against the
+    /// summary of a subtree with bitvec::intersects.
+    template <class... T>
+    static bitvec of() {
+        bitvec rv;
+        (rv.setbit(index(RTTI::TypeInfo<T>::id())), ...);
+        return rv;
+    }
+
+    /// @return the number of distinct summaries computed so far.
+    static size_t size();
+
+    /// Forget the summaries of all nodes.
+    static void clear();
+};
+
+}  // namespace P4::IR
+
+#endif /* IR_TYPE_SUMMARY_H_ */
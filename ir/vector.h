@@ -24,6 +24,8 @@ limitations under the License.
 #include "lib/safe_vector.h"
 
 namespace P4 {
+class BinaryGenerator;
+class BinaryLoader;
 class JSONLoader;
 }  // namespace P4
 
@@ -49,6 +51,7 @@ class VectorBase : public Node {
 
  protected:
     explicit VectorBase(JSONLoader &json) : Node(json) {}
+    explicit VectorBase(BinaryLoader &in) : Node(in) {}
 
     DECLARE_TYPEINFO_WITH_TYPEID(VectorBase, NodeKind::VectorBase, Node);
 };
@@ -65,6 +68,7 @@ class Vector : public VectorBase {
     Vector(const Vector &) = default;
     Vector(Vector &&) = default;
     explicit Vector(JSONLoader &json);
+    explicit Vector(BinaryLoader &in);
     Vector &operator=(const Vector &) = default;
     Vector &operator=(Vector &&) = default;
     explicit Vector(const T *a) { vec.emplace_back(a); }
@@ -75,6 +79,7 @@ class Vector : public VectorBase {
     Vector(Util::Enumerator<const T *> *e)  // NOLINT(runtime/explicit)
         : vec(e->begin(), e->end()) {}
     static Node *fromJSON(JSONLoader &json);
+    static Node *fromBinary(BinaryLoader &in);
 
     using iterator = typename safe_vector<const T *>::iterator;
     using const_iterator = typename safe_vector<const T *>::const_iterator;
@@ -185,6 +190,11 @@ class Vector : public VectorBase {
             if (!el->equiv(**it++)) return false;
         return true;
     }
+    size_t equiv_hash() const override {
+        size_t rv = Node::equiv_hash();
+        for (auto *el : *this) rv = Util::hash_combine(rv, el->equiv_hash());
+        return rv;
+    }
     cstring node_type_name() const override { return "Vector<" + T::static_type_name() + ">"; }
     static cstring static_type_name() { return "Vector<" + T::static_type_name() + ">"; }
     void visit_children(Visitor &v, const char *name) override;
@@ -192,6 +202,7 @@ class Vector : public VectorBase {
     virtual void parallel_visit_children(Visitor &v, const char *name = nullptr);
     virtual void parallel_visit_children(Visitor &v, const char *name = nullptr) const;
     void toJSON(JSONGenerator &json) const override;
+    void toBinary(BinaryGenerator &out) const override;
     Util::Enumerator<const T *> *getEnumerator() const { return Util::enumerate(vec); }
     template <typename S>
     Util::Enumerator<const S *> *only() const {
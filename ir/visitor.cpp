@@ -36,12 +36,16 @@ limitations under the License.
 #include "dbprint.h"
 #include "ir/id.h"
 #include "ir/ir.h"
+#include "ir/pass_profile.h"
 #include "ir/vector.h"
 #include "lib/algorithm.h"
+#include "lib/compile_context.h"
 #include "lib/error_catalog.h"
+#include "lib/error_reporter.h"
 #include "lib/indent.h"
 #include "lib/log.h"
 #include "lib/map.h"
+#include "lib/thread_pool.h"
 
 namespace P4 {
 
@@ -199,6 +203,13 @@ class Visitor::ChangeTracker {
         return done ? it->second.result : nullptr;
     }
 
+    /** Record the nodes finished by @other, a copy of this tracker used by a clone of
+     * the visitor on a worker thread, as finished here too. */
+    void merge(const ChangeTracker &other) {
+        for (const auto &[n, info] : other.visited)
+            if (!info.visit_in_progress) visited.emplace(n, info);
+    }
+
     void visitOnce(const IR::Node *n) {
         auto it = visited.find(n);
         if (it == visited.end()) BUG("visitor state tracker corrupted");
@@ -375,10 +386,11 @@ Visitor::profile_t Transform::init_apply(const IR::Node *root) {
 void Visitor::end_apply() {}
 void Visitor::end_apply(const IR::Node *) {}
 
-static indent_t profile_indent;
+static thread_local indent_t profile_indent;
 static absl::Time first_start = absl::InfinitePast();
 
 Visitor::profile_t::profile_t(Visitor &v_) : v(v_) {
+    PassProfile::begin(v);
     start = absl::Now();
     LOG3(profile_indent << v.name() << " statrting at +"
                         << (first_start != absl::InfinitePast()
@@ -394,6 +406,7 @@ Visitor::profile_t::~profile_t() {
         v.end_apply();
         --profile_indent;
         LOG1(profile_indent << v.name() << ' ' << (absl::Now() - start));
+        PassProfile::end(v);
     }
 }
 
@@ -480,6 +493,7 @@ const IR::Node *Modifier::apply_visitor(const IR::Node *n, const char *name) {
                 n = visited->result(n);
                 break;
             default: {  // New or Revisit
+                PassProfile::countVisit();
                 IR::Node *copy = n->clone();
                 local.current.node = copy;
                 if (!dontForwardChildrenBeforePreorder) {
@@ -491,6 +505,7 @@ const IR::Node *Modifier::apply_visitor(const IR::Node *n, const char *name) {
                     copy->apply_visitor_postorder(*this);
                 }
                 if (visited->finish(n, copy)) {
+                    PassProfile::countClone();
                     copy->validate();
                     if (onNodeTransformedHook) onNodeTransformedHook(n, copy);
                     n = copy;
@@ -518,6 +533,7 @@ const IR::Node *Inspector::apply_visitor(const IR::Node *n, const char *name) {
                 n->apply_visitor_revisit(*this);
                 break;
             default:  // New or Revisit
+                PassProfile::countVisit();
                 if (n->apply_visitor_preorder(*this)) {
                     n->visit_children(*this, name);
                     n->apply_visitor_postorder(*this);
@@ -536,7 +552,7 @@ const IR::Node *Inspector::apply_visitor(const IR::Node *n, const char *name) {
 
 const IR::Node *Transform::apply_visitor(const IR::Node *n, const char *name) {
     if (ctxt) ctxt->child_name = name;
-    if (n) {
+    if (n && !skipSubtree(n)) {
         PushContext local(ctxt, n);
         switch (visited->try_start(n, visitDagOnce)) {
             case VisitStatus::Busy:
@@ -549,6 +565,7 @@ const IR::Node *Transform::apply_visitor(const IR::Node *n, const char *name) {
                 n = visited->result(n);
                 break;
             default: {  // New or Revisit
+                PassProfile::countVisit();
                 auto *copy = n->clone();
                 local.current.node = copy;
                 if (!dontForwardChildrenBeforePreorder) {
@@ -588,6 +605,7 @@ const IR::Node *Transform::apply_visitor(const IR::Node *n, const char *name) {
                     *final_result == *preorder_result)
                     final_result = preorder_result;
                 if (visited->finish(n, final_result)) {
+                    if (final_result == copy) PassProfile::countClone();
                     if (final_result) final_result->validate();
                     if (n != final_result && onNodeTransformedHook)
                         onNodeTransformedHook(n, final_result);
@@ -605,6 +623,61 @@ const IR::Node *Transform::apply_visitor(const IR::Node *n, const char *name) {
     return n;
 }
 
+std::optional<std::vector<const IR::Node *>> Transform::parallel_transform(
+    const std::vector<const IR::Node *> &nodes, const char *name) {
+    BUG_CHECK(ctxt, "parallel_transform called outside of a visit");
+    size_t count = nodes.size();
+    size_t threads = std::min<size_t>(count, Util::ThreadPool::concurrency());
+    struct Worker {
+        Transform *visitor;
+        std::vector<std::pair<const IR::Node *, const IR::Node *>> transformed;
+        ErrorReporter::Deferred diagnostics;
+    };
+    std::vector<Worker> workers(threads);
+    for (auto &worker : workers) {
+        auto *cl = dynamic_cast<Transform *>(clone());
+        if (!cl || !cl->check_clone(this)) return std::nullopt;
+        cl->visited = std::make_shared<ChangeTracker>(*visited);
+        cl->split_link_mem = split_link();
+        cl->split_link_ptr = &cl->split_link_mem;
+        // the hook may not be thread-safe, so the transformed nodes are reported when merging
+        if (onNodeTransformedHook)
+            cl->onNodeTransformedHook = [&worker](const IR::Node *from, const IR::Node *to) {
+                worker.transformed.emplace_back(from, to);
+            };
+        worker.visitor = cl;
+    }
+
+    std::vector<const IR::Node *> result(nodes);
+    int start_index = ctxt->child_index;
+    bool logging = Log::Detail::enableLoggingInContext;
+    auto &errorReporter = BaseCompileContext::get().errorReporter();
+    try {
+        Util::ThreadPool::parallelFor(threads, [&](size_t w) {
+            auto &worker = workers[w];
+            // visiting children updates the parent context, so each worker needs its own copy
+            Context parent = *ctxt;
+            worker.visitor->ctxt = &parent;
+            Log::Detail::enableLoggingInContext = logging;
+            ErrorReporter::DeferScope defer(worker.diagnostics);
+            for (size_t i = count * w / threads; i < count * (w + 1) / threads; ++i)
+                worker.visitor->visit(result[i], name, start_index + i);
+            worker.visitor->ctxt = nullptr;
+        });
+    } catch (...) {
+        for (auto &worker : workers) errorReporter.replay(worker.diagnostics);
+        throw;
+    }
+    for (auto &worker : workers) {
+        visited->merge(*worker.visitor->visited);
+        for (auto [from, to] : worker.transformed) onNodeTransformedHook(from, to);
+        parallel_merge(*worker.visitor);
+        errorReporter.replay(worker.diagnostics);
+    }
+    ctxt->child_index = start_index + count;
+    return result;
+}
+
 void Inspector::revisit_visited() { visited->revisit_visited(); }
 bool Inspector::visit_in_progress(const IR::Node *n) const { return visited->busy(n); }
 void Modifier::revisit_visited() { visited->revisit_visited(); }
@@ -708,7 +781,7 @@ bool ControlFlowVisitor::join_flows(const IR::Node *n) {
     bool delta = true;
     while (delta && status.count >= 0) {
         delta = false;
-        for (auto *sl = split_link; sl; sl = sl->prev) {
+        for (auto *sl = split_link(); sl; sl = sl->prev) {
             if (sl->ready()) {
                 sl->do_visit();  //  visit some parallel stuff;
                 delta = true;
@@ -24,15 +24,20 @@ limitations under the License.
 #include <iosfwd>
 #include <map>
 #include <memory>
+#include <optional>
+#include <set>
 #include <type_traits>
+#include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "ir/gen-tree-macro.h"
 #include "ir/ir-tree-macros.h"
 #include "ir/node.h"
+#include "ir/type_summary.h"
 #include "ir/vector.h"
 #include "lib/castable.h"
 #include "lib/cstring.h"
@@ -203,14 +208,23 @@ class Visitor {
     virtual ControlFlowVisitor *controlFlowVisitor() { return nullptr; }
     virtual Visitor &flow_clone() { return *this; }
     // all flow_clones share a split_link chain to allow stack walking
-    SplitFlowVisit_base *split_link_mem = nullptr, *&split_link;
-    Visitor() : split_link(split_link_mem) {}
+    SplitFlowVisit_base *split_link_mem = nullptr, **split_link_ptr;
+    SplitFlowVisit_base *&split_link() { return *split_link_ptr; }
+    Visitor() : split_link_ptr(&split_link_mem) {}
 
     /** Merge the given visitor into this visitor at a joint point in the
      * control flow graph.  Should update @this and leave the other unchanged.
      */
     virtual void flow_merge(Visitor &) {}
     virtual bool flow_merge_closure(Visitor &) { BUG("%s pass does not support loops", name()); }
+    /** Merge a clone that visited some of the elements of a vector on a worker thread (see
+     * Transform::parallel_transform) back into this visitor.  Clones are merged in element
+     * order after all of them have finished.  Each clone started as a copy of this visitor,
+     * so like flow_merge this should combine state rather than simply add it up.
+     */
+    virtual void parallel_merge(Visitor &) {
+        BUG("%s pass does not support parallel visits", name());
+    }
     /** Support methods for non-local ControlFlow computations */
     virtual void flow_merge_global_to(cstring) {}
     virtual void flow_merge_global_from(cstring) {}
@@ -303,6 +317,10 @@ class Visitor {
         return ctxt->node ? ctxt->node->to<T>() : nullptr;
     }
 
+    bool preservesAnalysis(const std::type_info &analysis) const {
+        return preservedAnalyses.count(analysis) != 0;
+    }
+
     /// True if the warning with this kind is enabled at this point.
     /// Warnings can be disabled by using the @noWarn("unused") annotation
     /// in an enclosing environment.
@@ -334,6 +352,13 @@ class Visitor {
     // flow_merge the visitor from all the parents before visiting the node and its
     // children.  This only works for Inspector (not Modifier/Transform) currently.
     bool joinFlows = false;
+    // Analyses (see AnalysisManager) which remain valid when this visitor changes the IR,
+    // usually declared with 'preserves' in the derived Visitor class constructor.
+    std::set<std::type_index> preservedAnalyses;
+    template <class... T>
+    void preserves() {
+        (preservedAnalyses.emplace(typeid(T)), ...);
+    }
 
     virtual void init_join_flows(const IR::Node *) {
         BUG("joinFlows only supported in ControlFlowVisitor currently");
@@ -410,6 +435,10 @@ class Modifier : public virtual Visitor {
         const std::function<void(const IR::Node *from, const IR::Node *to)> &hook) {
         onNodeTransformedHook = hook;
     }
+    const std::function<void(const IR::Node *from, const IR::Node *to)> &
+    getOnNodeTransformedHook() const {
+        return onNodeTransformedHook;
+    }
 
  protected:
     bool forceClone = false;  // force clone whole tree even if unchanged
@@ -442,6 +471,10 @@ class Inspector : public virtual Visitor {
 class Transform : public virtual Visitor {
     std::shared_ptr<ChangeTracker> visited;
     bool prune_flag = false;
+    bitvec subtreeFilter;
+    bool skipSubtree(const IR::Node *n) const {
+        return !subtreeFilter.empty() && !IR::TypeSummary::get(n).intersects(subtreeFilter);
+    }
     void visitor_const_error() override;
     bool check_clone(const Visitor *) override;
     std::function<void(const IR::Node *from, const IR::Node *to)> onNodeTransformedHook;
@@ -470,6 +503,10 @@ class Transform : public virtual Visitor {
         const std::function<void(const IR::Node *from, const IR::Node *to)> &hook) {
         onNodeTransformedHook = hook;
     }
+    const std::function<void(const IR::Node *from, const IR::Node *to)> &
+    getOnNodeTransformedHook() const {
+        return onNodeTransformedHook;
+    }
 
  protected:
     const IR::Node *transform_child(const IR::Node *child) {
@@ -478,6 +515,28 @@ class Transform : public virtual Visitor {
         return rv;
     }
     bool forceClone = false;  // force clone whole tree even if unchanged
+
+    // Only visit subtrees containing a node of one of the classes T (usually called in the
+    // derived Transform's constructor); any other subtree is returned unchanged without calling
+    // preorder/postorder on any of its nodes.  T must cover every class the Transform has a
+    // preorder or postorder for.  Ancestors of the interesting nodes are still visited normally,
+    // so their context is available.  Uses the IR::TypeSummary of each node.
+    template <class... T>
+    void onlyVisitSubtreesWith() {
+        subtreeFilter = IR::TypeSummary::of<T...>();
+    }
+
+    // Transform @nodes, which must be consecutive children of the node currently being
+    // visited, concurrently: each worker thread runs its own clone() of the visitor on a
+    // contiguous run of them, and the clones are combined again with parallel_merge, in
+    // order, after all of them have finished.  Diagnostics reported by the workers are
+    // output in the same order as if the nodes had been visited serially.  The nodes must
+    // not depend on each other, and the visitor must not modify shared state from its
+    // preorder/postorder functions.  Advances the child_index of the context past @nodes.
+    // @return the transformed nodes, or std::nullopt (having done nothing) if the visitor
+    // can't be cloned.
+    std::optional<std::vector<const IR::Node *>> parallel_transform(
+        const std::vector<const IR::Node *> &nodes, const char *name = nullptr);
 };
 
 // turn this on for extra info tracking control joinFlows for debugging
@@ -643,10 +702,10 @@ class SplitFlowVisit_base {
     friend ControlFlowVisitor;
 
     explicit SplitFlowVisit_base(Visitor &v) : v(v) {
-        prev = v.split_link;
-        v.split_link = this;
+        prev = v.split_link();
+        v.split_link() = this;
     }
-    ~SplitFlowVisit_base() { v.split_link = prev; }
+    ~SplitFlowVisit_base() { v.split_link() = prev; }
     void *operator new(size_t);  // declared and not defined, as this class can
     // only be instantiated on the stack.  Trying to allocate one on the heap will
     // cause a linker error.
@@ -64,7 +64,7 @@ void AllocTrace::count(void **bt, size_t sz) {
 }
 
 std::ostream &operator<<(std::ostream &out, const AllocTrace &at) {
-#if HAVE_LIBGC
+#if HAVE_LIBGC || HAVE_IR_ARENA
     PauseTrace temp_pause;
 #endif
     using data_t = decltype(at.data)::value_type;
@@ -42,7 +42,7 @@ class AllocTrace {
 
  public:
     void clear() { data.clear(); }
-#if HAVE_LIBGC
+#if HAVE_LIBGC || HAVE_IR_ARENA
     alloc_trace_cb_t start() { return set_alloc_trace(callback, this); }
     void stop(alloc_trace_cb_t old) {
         auto tmp = set_alloc_trace(old);
@@ -50,7 +50,7 @@ class AllocTrace {
     }
 #else
     alloc_trace_cb_t start() {
-        BUG("Can't trace allocations without garbage collection");
+        BUG("Can't trace allocations without garbage collection or IR arenas");
         return alloc_trace_cb_t{};
     }
     void stop(alloc_trace_cb_t) {}
@@ -59,7 +59,7 @@ class AllocTrace {
 };
 
 class PauseTrace {
-#if HAVE_LIBGC
+#if HAVE_LIBGC || HAVE_IR_ARENA
     alloc_trace_cb_t hold;
     PauseTrace(const PauseTrace &) = delete;
 
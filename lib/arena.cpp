@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "lib/arena.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "lib/exceptions.h"
+#include "lib/gc.h"
+
+namespace P4::Util {
+
+// Chunks are linked from the most recently allocated back; the memory handed out by the arena
+// follows each header.  Every chunk starts on a unit boundary and covers whole units, so the
+// arena owning an address can be found from its unit alone.
+struct alignas(std::max_align_t) Arena::Chunk {
+    Chunk *prev;
+    size_t size;  // including the header
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+    char *end() { return reinterpret_cast<char *>(this) + size; }
+};
+
+Arena *Arena::currentArena = nullptr;
+
+namespace {
+
+constexpr unsigned unitBits = 20;
+constexpr size_t unitSize = size_t(1) << unitBits;  // 1MB
+constexpr size_t defaultChunkSize = unitSize;
+
+/// The owner of every unit of the address space, as a two-level table that is indexed by unit
+/// number.  Leaves are allocated the first time a chunk is placed in their range and are never
+/// freed, so lookups need no locks.
+constexpr unsigned addressBits = 48;
+constexpr unsigned leafBits = 14;
+constexpr unsigned rootBits = addressBits - unitBits - leafBits;
+using OwnerLeaf = std::array<std::atomic<Arena *>, size_t(1) << leafBits>;
+std::atomic<OwnerLeaf *> ownerRoot[size_t(1) << rootBits];
+
+std::atomic<Arena *> *ownerSlot(uintptr_t unit, bool create) {
+    if (unit >> (leafBits + rootBits)) {
+        BUG_CHECK(!create, "arena chunk outside of the %d bit address space", addressBits);
+        return nullptr;
+    }
+    auto &root = ownerRoot[unit >> leafBits];
+    auto *leaf = root.load(std::memory_order_acquire);
+    if (!leaf) {
+        if (!create) return nullptr;
+        auto *fresh = new OwnerLeaf();
+        if (root.compare_exchange_strong(leaf, fresh, std::memory_order_acq_rel))
+            leaf = fresh;
+        else
+            delete fresh;
+    }
+    return &(*leaf)[unit & ((size_t(1) << leafBits) - 1)];
+}
+
+void setOwner(char *begin, char *end, Arena *arena) {
+    for (auto unit = reinterpret_cast<uintptr_t>(begin) >> unitBits;
+         unit < reinterpret_cast<uintptr_t>(end) >> unitBits; ++unit)
+        ownerSlot(unit, true)->store(arena, std::memory_order_release);
+}
+
+}  // namespace
+
+Arena *Arena::owner(const void *p) {
+    auto *slot = ownerSlot(reinterpret_cast<uintptr_t>(p) >> unitBits, false);
+    return slot ? slot->load(std::memory_order_acquire) : nullptr;
+}
+
+Arena::~Arena() {
+    if (currentArena == this) currentArena = nullptr;
+    {
+#ifdef MULTITHREAD
+        std::lock_guard<std::mutex> guard(lock);
+#endif
+        destroying = true;
+    }
+    // All objects are destroyed before any memory is freed, as they may refer to each other.
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it)
+        if (it->destroy) it->destroy(it->obj);
+    while (chunks) {
+        auto *prev = chunks->prev;
+        setOwner(reinterpret_cast<char *>(chunks), chunks->end(), nullptr);
+        std::free(chunks);
+        chunks = prev;
+    }
+}
+
+Arena::Chunk *Arena::newChunk(size_t size) {
+    size = (sizeof(Chunk) + size + unitSize - 1) & ~(unitSize - 1);
+    auto *chunk = static_cast<Chunk *>(std::aligned_alloc(unitSize, size));
+    if (!chunk) throw std::bad_alloc();
+    chunk->size = size;
+    reserved += size;
+    setOwner(reinterpret_cast<char *>(chunk), chunk->end(), this);
+    return chunk;
+}
+
+void *Arena::allocate(size_t size, size_t align) {
+    BUG_CHECK(align && (align & (align - 1)) == 0, "arena alignment %d not a power of 2", align);
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(lock);
+#endif
+    auto aligned = [align](char *p) {
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((addr + align - 1) & ~(align - 1));
+    };
+    char *rv = next ? aligned(next) : nullptr;
+    if (!rv || rv + size > limit) {
+        if (size + align > defaultChunkSize / 4) {
+            // Big objects get a chunk of their own, so they don't waste the rest of the
+            // current one.
+            auto *chunk = newChunk(size + align);
+            if (chunks) {
+                chunk->prev = chunks->prev;
+                chunks->prev = chunk;
+            } else {
+                chunk->prev = nullptr;
+                chunks = chunk;
+            }
+            allocated += size;
+            trace_alloc(size);
+            return aligned(chunk->data());
+        }
+        auto *chunk = newChunk(defaultChunkSize - sizeof(Chunk));
+        chunk->prev = chunks;
+        chunks = chunk;
+        next = chunk->data();
+        limit = chunk->end();
+        rv = aligned(next);
+    }
+    next = rv + size;
+    allocated += size;
+    trace_alloc(size);
+    return rv;
+}
+
+void Arena::destroyLater(void *memory, void *obj, void (*destroy)(void *)) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(lock);
+#endif
+    finalizers.push_back({memory, obj, destroy});
+}
+
+void Arena::forget(void *memory) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> guard(lock);
+#endif
+    if (destroying) return;
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+        if (it->memory == memory) {
+            it->destroy = nullptr;
+            break;
+        }
+    }
+}
+
+}  // namespace P4::Util
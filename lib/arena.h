@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LIB_ARENA_H_
+#define LIB_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#ifdef MULTITHREAD
+#include <mutex>
+#endif
+
+namespace P4::Util {
+
+/// A region of memory that objects are bump-allocated from and that is freed all at once when
+/// the Arena is destroyed.  Destructors of objects allocated in the arena are only run if they
+/// are registered with destroyLater(); IR nodes register themselves when they are created.
+///
+/// When the compiler is built with ENABLE_IR_ARENA, IR nodes are allocated in the current
+/// arena (see ArenaScope), which AutoCompileContext can set up for the duration of a
+/// compilation.
+class Arena {
+    struct Chunk;
+    Chunk *chunks = nullptr;
+    char *next = nullptr, *limit = nullptr;
+    std::atomic<size_t> allocated = 0, reserved = 0;
+    struct Finalizer {
+        void *memory;  // the allocation that holds the object
+        void *obj;
+        void (*destroy)(void *);
+    };
+    /// Objects to destroy with the arena.
+    std::vector<Finalizer> finalizers;
+    bool destroying = false;
+#ifdef MULTITHREAD
+    std::mutex lock;
+#endif
+
+    static Arena *currentArena;
+    friend class ArenaScope;
+
+    Chunk *newChunk(size_t size);
+
+ public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    /// Allocate @size bytes aligned to @align, which must be a power of 2.  Never returns null.
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    /// @return the total number of bytes handed out by allocate().
+    size_t bytesAllocated() const { return allocated.load(std::memory_order_relaxed); }
+    /// @return the total number of bytes obtained from the system to back the arena.
+    size_t bytesReserved() const { return reserved.load(std::memory_order_relaxed); }
+
+    /// Call @p destroy(@p obj) when the arena is destroyed, before its memory is freed.
+    /// @p memory is the allocation that holds @p obj.  Objects are destroyed in the reverse
+    /// order of registration.
+    void destroyLater(void *memory, void *obj, void (*destroy)(void *));
+    /// Cancel destroyLater() for the object in @p memory, which has been destroyed already.
+    /// Searches from the most recently registered object, so it is fast for short-lived objects.
+    void forget(void *memory);
+
+    /// @return the arena that @p p points into, or nullptr if it is not arena memory.
+    /// This does not take any locks.
+    static Arena *owner(const void *p);
+    /// @return true if @p p points into memory handed out by an arena that still exists.
+    static bool isArenaMemory(const void *p) { return owner(p) != nullptr; }
+
+    /// @return the arena that IR nodes are currently allocated in, or nullptr if they are
+    /// allocated on the normal heap.
+    static Arena *current() { return currentArena; }
+};
+
+/// Makes an arena the current one for the lifetime of the ArenaScope object.  Scopes nest; the
+/// previous current arena (if any) is restored when the scope ends.
+class ArenaScope {
+    Arena *prev;
+
+ public:
+    explicit ArenaScope(Arena *arena) : prev(Arena::currentArena) { Arena::currentArena = arena; }
+    ArenaScope(const ArenaScope &) = delete;
+    ~ArenaScope() { Arena::currentArena = prev; }
+};
+
+}  // namespace P4::Util
+
+#endif /* LIB_ARENA_H_ */
@@ -10,10 +10,17 @@
 
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include "lib/hash.h"
+
 namespace P4 {
 
 using big_int = boost::multiprecision::cpp_int;
 
+template <>
+struct Util::Hasher<big_int> {
+    size_t operator()(const big_int &v) const { return boost::multiprecision::hash_value(v); }
+};
+
 }  // namespace P4
 
 #endif /* LIB_BIG_INT_H_ */
@@ -90,9 +90,6 @@ static inline int floor_log2(big_int v) {
 
 static inline int ceil_log2(big_int v) { return v ? floor_log2(v - 1) + 1 : -1; }
 
-template <>
-struct Util::Hasher<big_int> : Detail::StdHasher {};
-
 }  // namespace P4
 
 #endif /* LIB_BIG_INT_UTIL_H_ */
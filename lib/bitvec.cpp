@@ -18,26 +18,279 @@ limitations under the License.
 
 #include <ctype.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "hex.h"
 
 namespace P4 {
 
+namespace bv {
+
+namespace {
+
+bool or_with_scalar(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uintptr_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        changed |= b[i] & ~a[i];
+        a[i] |= b[i];
+    }
+    return changed != 0;
+}
+
+bool and_with_scalar(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uintptr_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        changed |= a[i] & ~b[i];
+        a[i] &= b[i];
+    }
+    return changed != 0;
+}
+
+bool andnot_with_scalar(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uintptr_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        changed |= a[i] & b[i];
+        a[i] &= ~b[i];
+    }
+    return changed != 0;
+}
+
+void xor_with_scalar(uintptr_t *a, const uintptr_t *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) a[i] ^= b[i];
+}
+
+bool intersects_scalar(const uintptr_t *a, const uintptr_t *b, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        if (a[i] & b[i]) return true;
+    return false;
+}
+
+int popcount_scalar(const uintptr_t *a, size_t n) {
+    int rv = 0;
+    for (size_t i = 0; i < n; ++i) rv += bv::popcount(a[i]);
+    return rv;
+}
+
+size_t find_nonzero_scalar(const uintptr_t *a, size_t n) {
+    size_t i = 0;
+    while (i < n && !a[i]) ++i;
+    return i;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BITVEC_HAVE_AVX2 1
+#define BITVEC_AVX2 __attribute__((target("avx2,popcnt")))
+
+// All of these process 4 words per iteration, then finish the tail with scalar code.
+BITVEC_AVX2 __m256i load4(const uintptr_t *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+BITVEC_AVX2 void store4(uintptr_t *p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+BITVEC_AVX2 bool or_with_avx2(uintptr_t *a, const uintptr_t *b, size_t n) {
+    __m256i changed = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load4(a + i), vb = load4(b + i);
+        changed = _mm256_or_si256(changed, _mm256_andnot_si256(va, vb));
+        store4(a + i, _mm256_or_si256(va, vb));
+    }
+    bool tail_changed = or_with_scalar(a + i, b + i, n - i);
+    return tail_changed || !_mm256_testz_si256(changed, changed);
+}
+
+BITVEC_AVX2 bool and_with_avx2(uintptr_t *a, const uintptr_t *b, size_t n) {
+    __m256i changed = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load4(a + i), vb = load4(b + i);
+        changed = _mm256_or_si256(changed, _mm256_andnot_si256(vb, va));
+        store4(a + i, _mm256_and_si256(va, vb));
+    }
+    bool tail_changed = and_with_scalar(a + i, b + i, n - i);
+    return tail_changed || !_mm256_testz_si256(changed, changed);
+}
+
+BITVEC_AVX2 bool andnot_with_avx2(uintptr_t *a, const uintptr_t *b, size_t n) {
+    __m256i changed = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = load4(a + i), vb = load4(b + i);
+        changed = _mm256_or_si256(changed, _mm256_and_si256(va, vb));
+        store4(a + i, _mm256_andnot_si256(vb, va));
+    }
+    bool tail_changed = andnot_with_scalar(a + i, b + i, n - i);
+    return tail_changed || !_mm256_testz_si256(changed, changed);
+}
+
+BITVEC_AVX2 void xor_with_avx2(uintptr_t *a, const uintptr_t *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) store4(a + i, _mm256_xor_si256(load4(a + i), load4(b + i)));
+    xor_with_scalar(a + i, b + i, n - i);
+}
+
+BITVEC_AVX2 bool intersects_avx2(const uintptr_t *a, const uintptr_t *b, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        if (!_mm256_testz_si256(load4(a + i), load4(b + i))) return true;
+    return intersects_scalar(a + i, b + i, n - i);
+}
+
+// Nibble lookup table popcount (Mula et al.): count the bits of each byte with two shuffles,
+// then sum the bytes of each 64-bit lane with a SAD against zero.
+BITVEC_AVX2 int popcount_avx2(const uintptr_t *a, size_t n) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,  //
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = load4(a + i);
+        __m256i lo = _mm256_and_si256(v, low_mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                      _mm256_shuffle_epi8(lookup, hi));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+    }
+    int64_t rv = _mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1) +
+                 _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3);
+    for (; i < n; ++i) rv += _mm_popcnt_u64(a[i]);
+    return rv;
+}
+
+BITVEC_AVX2 size_t find_nonzero_avx2(const uintptr_t *a, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = load4(a + i);
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    return i + find_nonzero_scalar(a + i, n - i);
+}
+
+const bulk_ops avx2_ops = {or_with_avx2,    and_with_avx2,   andnot_with_avx2,  xor_with_avx2,
+                           intersects_avx2, popcount_avx2,   find_nonzero_avx2, "avx2"};
+#endif /* __x86_64__ */
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define BITVEC_HAVE_NEON 1
+
+// All of these process 2 words per iteration, then finish the tail with scalar code.
+inline uint64x2_t load2(const uintptr_t *p) {
+    return vld1q_u64(reinterpret_cast<const uint64_t *>(p));
+}
+inline void store2(uintptr_t *p, uint64x2_t v) { vst1q_u64(reinterpret_cast<uint64_t *>(p), v); }
+inline bool any(uint64x2_t v) { return (vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) != 0; }
+
+bool or_with_neon(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uint64x2_t changed = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t va = load2(a + i), vb = load2(b + i);
+        changed = vorrq_u64(changed, vbicq_u64(vb, va));
+        store2(a + i, vorrq_u64(va, vb));
+    }
+    bool tail_changed = or_with_scalar(a + i, b + i, n - i);
+    return tail_changed || any(changed);
+}
+
+bool and_with_neon(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uint64x2_t changed = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t va = load2(a + i), vb = load2(b + i);
+        changed = vorrq_u64(changed, vbicq_u64(va, vb));
+        store2(a + i, vandq_u64(va, vb));
+    }
+    bool tail_changed = and_with_scalar(a + i, b + i, n - i);
+    return tail_changed || any(changed);
+}
+
+bool andnot_with_neon(uintptr_t *a, const uintptr_t *b, size_t n) {
+    uint64x2_t changed = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t va = load2(a + i), vb = load2(b + i);
+        changed = vorrq_u64(changed, vandq_u64(va, vb));
+        store2(a + i, vbicq_u64(va, vb));
+    }
+    bool tail_changed = andnot_with_scalar(a + i, b + i, n - i);
+    return tail_changed || any(changed);
+}
+
+void xor_with_neon(uintptr_t *a, const uintptr_t *b, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) store2(a + i, veorq_u64(load2(a + i), load2(b + i)));
+    xor_with_scalar(a + i, b + i, n - i);
+}
+
+bool intersects_neon(const uintptr_t *a, const uintptr_t *b, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        if (any(vandq_u64(load2(a + i), load2(b + i)))) return true;
+    return intersects_scalar(a + i, b + i, n - i);
+}
+
+int popcount_neon(const uintptr_t *a, size_t n) {
+    int rv = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) rv += vaddlvq_u8(vcntq_u8(vreinterpretq_u8_u64(load2(a + i))));
+    return rv + popcount_scalar(a + i, n - i);
+}
+
+size_t find_nonzero_neon(const uintptr_t *a, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        if (any(load2(a + i))) break;
+    return i + find_nonzero_scalar(a + i, n - i);
+}
+
+const bulk_ops neon_ops = {or_with_neon,    and_with_neon,   andnot_with_neon,  xor_with_neon,
+                           intersects_neon, popcount_neon,   find_nonzero_neon, "neon"};
+#endif /* __aarch64__ */
+
+const bulk_ops *best_bulk_ops() {
+#if BITVEC_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return &avx2_ops;
+#endif
+#if BITVEC_HAVE_NEON
+    return &neon_ops;
+#endif
+    return &bulk_ops::scalar;
+}
+
+}  // namespace
+
+const bulk_ops bulk_ops::scalar = {
+    or_with_scalar,    and_with_scalar,   andnot_with_scalar,  xor_with_scalar,
+    intersects_scalar, popcount_scalar,   find_nonzero_scalar, "scalar"};
+// Constant-initialized, so it is valid before any dynamic initialization runs...
+const bulk_ops *bulk_ops::active = &bulk_ops::scalar;
+// ...and switched to the best available kernels as part of dynamic initialization.
+[[maybe_unused]] static const bool bulk_ops_selected = (bulk_ops::active = best_bulk_ops(), true);
+
+}  // namespace bv
+
 std::ostream &operator<<(std::ostream &os, const bitvec &bv) {
-    if (bv.size == 1) {
-        os << hex(bv.data);
-    } else {
-        bool first = true;
-        for (int i = bv.size - 1; i >= 0; i--) {
-            if (first) {
-                if (!bv.ptr[i]) continue;
-                os << hex(bv.ptr[i]);
-                first = false;
-            } else {
-                os << hex(bv.ptr[i], sizeof(bv.data) * 2, '0');
-            }
+    const uintptr_t *w = bv.words();
+    bool first = true;
+    for (int i = bv.size - 1; i >= 0; i--) {
+        if (first) {
+            if (!w[i]) continue;
+            os << hex(w[i]);
+            first = false;
+        } else {
+            os << hex(w[i], sizeof(*w) * 2, '0');
         }
-        if (first) os << '0';
     }
+    if (first) os << '0';
     return os;
 }
 
@@ -77,27 +330,25 @@ bool operator>>(const char *s, bitvec &bv) {
 }
 
 bitvec &bitvec::operator>>=(size_t count) {
-    if (size == 1) {
-        if (count >= bits_per_unit)
-            data = 0;
-        else
-            data >>= count;
-        return *this;
-    }
-    int off = count / bits_per_unit;
+    uintptr_t *w = words();
+    size_t off = count / bits_per_unit;
     count %= bits_per_unit;
     for (size_t i = 0; i < size; i++)
         if (i + off < size) {
-            ptr[i] = ptr[i + off] >> count;
-            if (count && i + off + 1 < size) ptr[i] |= ptr[i + off + 1] << (bits_per_unit - count);
+            w[i] = w[i + off] >> count;
+            if (count && i + off + 1 < size) w[i] |= w[i + off + 1] << (bits_per_unit - count);
         } else {
-            ptr[i] = 0;
+            w[i] = 0;
+        }
+    if (!is_inline()) {
+        while (size > inline_units + 1 && !ptr[size - 1]) size--;
+        if (!ptr[size - 1]) {
+            // fits in the inline buffer again
+            uintptr_t *old = ptr;
+            memcpy(data, old, sizeof(data));
+            delete[] old;
+            size = inline_units;
         }
-    while (size > 1 && !ptr[size - 1]) size--;
-    if (size == 1) {
-        auto tmp = ptr[0];
-        delete[] ptr;
-        data = tmp;
     }
     return *this;
 }
@@ -105,18 +356,15 @@ bitvec &bitvec::operator>>=(size_t count) {
 bitvec &bitvec::operator<<=(size_t count) {
     size_t needsize = (max().index() + count + bits_per_unit) / bits_per_unit;
     if (needsize > size) expand(needsize);
-    if (size == 1) {
-        data <<= count;
-        return *this;
-    }
+    uintptr_t *w = words();
     int off = count / bits_per_unit;
     count %= bits_per_unit;
     for (int i = size - 1; i >= 0; i--)
         if (i >= off) {
-            ptr[i] = ptr[i - off] << count;
-            if (count && i > off) ptr[i] |= ptr[i - off - 1] >> (bits_per_unit - count);
+            w[i] = w[i - off] << count;
+            if (count && i > off) w[i] |= w[i - off - 1] >> (bits_per_unit - count);
         } else {
-            ptr[i] = 0;
+            w[i] = 0;
         }
     return *this;
 }
@@ -125,38 +373,36 @@ bitvec bitvec::getslice(size_t idx, size_t sz) const {
     if (sz == 0) return bitvec();
     if (idx >= size * bits_per_unit) return bitvec();
     if (idx + sz > size * bits_per_unit) sz = size * bits_per_unit - idx;
-    if (size > 1) {
-        bitvec rv;
-        unsigned shift = idx % bits_per_unit;
-        idx /= bits_per_unit;
-        if (sz > bits_per_unit) {
-            rv.expand((sz - 1) / bits_per_unit + 1);
-            for (size_t i = 0; i < rv.size; i++) {
-                if (shift != 0 && i != 0) rv.ptr[i - 1] |= ptr[idx + i] << (bits_per_unit - shift);
-                rv.ptr[i] = ptr[idx + i] >> shift;
-            }
-            if ((sz %= bits_per_unit))
-                rv.ptr[rv.size - 1] &= ~(~static_cast<uintptr_t>(1) << (sz - 1));
-        } else {
-            rv.data = ptr[idx] >> shift;
-            if (shift != 0 && idx + 1 < size) rv.data |= ptr[idx + 1] << (bits_per_unit - shift);
-            rv.data &= ~(~static_cast<uintptr_t>(1) << (sz - 1));
-        }
-        return rv;
-    } else {
-        return bitvec((data >> idx) & ~(~static_cast<uintptr_t>(1) << (sz - 1)));
+    bitvec rv;
+    unsigned shift = idx % bits_per_unit;
+    idx /= bits_per_unit;
+    size_t n = (sz - 1) / bits_per_unit + 1;
+    if (n > rv.size) rv.expand(n);
+    const uintptr_t *w = words();
+    uintptr_t *rw = rv.words();
+    for (size_t i = 0; i < n; i++) {
+        rw[i] = w[idx + i] >> shift;
+        if (shift != 0 && idx + i + 1 < size) rw[i] |= w[idx + i + 1] << (bits_per_unit - shift);
     }
+    if ((sz %= bits_per_unit)) rw[n - 1] &= ~(~static_cast<uintptr_t>(1) << (sz - 1));
+    return rv;
 }
 
 int bitvec::ffs(unsigned start) const {
-    uintptr_t val = ~static_cast<uintptr_t>(0);
-    unsigned idx = start / bits_per_unit;
-    val <<= (start % bits_per_unit);
-    while (idx < size && !(val &= word(idx))) {
+    size_t idx = start / bits_per_unit;
+    if (idx >= size) return -1;
+    const uintptr_t *w = words();
+    uintptr_t val = w[idx] & (~static_cast<uintptr_t>(0) << (start % bits_per_unit));
+    if (!val) {
         ++idx;
-        val = ~static_cast<uintptr_t>(0);
+        if (is_inline()) {
+            while (idx < size && !w[idx]) ++idx;
+        } else {
+            idx += bv::bulk_ops::active->find_nonzero(w + idx, size - idx);
+        }
+        if (idx >= size) return -1;
+        val = w[idx];
     }
-    if (idx >= size) return -1;
     unsigned rv = idx * bits_per_unit;
     rv += bv::count_trailing_zeroes(val);
     return rv;
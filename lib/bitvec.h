@@ -23,6 +23,7 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <type_traits>
 #include <utility>
@@ -115,15 +116,43 @@ int popcount(I x) {
     return rv;
 #endif
 }
+
+/// Kernels for bulk operations on arrays of words, used by bitvecs too large for the inline
+/// buffer.  The implementation is chosen once at startup, from what the CPU supports: AVX2 on
+/// x86-64, NEON on AArch64, and portable scalar loops otherwise.
+struct bulk_ops {
+    /// a |= b, a &= b, a &= ~b over n words; each returns true if any word of a changed
+    bool (*or_with)(uintptr_t *a, const uintptr_t *b, size_t n);
+    bool (*and_with)(uintptr_t *a, const uintptr_t *b, size_t n);
+    bool (*andnot_with)(uintptr_t *a, const uintptr_t *b, size_t n);
+    void (*xor_with)(uintptr_t *a, const uintptr_t *b, size_t n);
+    bool (*intersects)(const uintptr_t *a, const uintptr_t *b, size_t n);
+    int (*popcount)(const uintptr_t *a, size_t n);
+    /// index of the first non-zero word of a, or n if they are all zero
+    size_t (*find_nonzero)(const uintptr_t *a, size_t n);
+    const char *name;
+
+    static const bulk_ops scalar;
+    /// The kernels in use.  Starts out as 'scalar' (so bitvecs work during static
+    /// initialization) and is switched to the best supported implementation at startup.
+    static const bulk_ops *active;
+};
 }  // namespace bv
 
 class bitvec {
+    /// Number of words that are stored in the bitvec itself.  Bitvecs up to this size (most
+    /// bitvecs for fields and containers) never allocate.
+    static constexpr size_t inline_units = 4;
+    /// Number of words; inline_units while the words are in 'data', larger when in 'ptr'.
     size_t size;
     union {
-        uintptr_t data;
+        uintptr_t data[inline_units];
         uintptr_t *ptr;
     };
-    uintptr_t word(size_t i) const { return i < size ? size > 1 ? ptr[i] : data : 0; }
+    bool is_inline() const { return size <= inline_units; }
+    uintptr_t *words() { return is_inline() ? data : ptr; }
+    const uintptr_t *words() const { return is_inline() ? data : ptr; }
+    uintptr_t word(size_t i) const { return i < size ? words()[i] : 0; }
 
  public:
     static constexpr size_t bits_per_unit = CHAR_BIT * sizeof(uintptr_t);
@@ -145,16 +174,13 @@ class bitvec {
         int index() const { return idx; }
         int operator*() const { return idx; }
         bitref &operator++() {
-            while ((size_t)++idx < self.size * bitvec::bits_per_unit) {
-                if (auto w =
-                        self.word(idx / bitvec::bits_per_unit) >> (idx % bitvec::bits_per_unit)) {
-                    idx += bv::count_trailing_zeroes(w);
-                    return *this;
-                }
-                idx = (idx / bitvec::bits_per_unit) * bitvec::bits_per_unit +
-                      bitvec::bits_per_unit - 1;
+            ++idx;
+            if (auto w = self.word(idx / bitvec::bits_per_unit) >> (idx % bitvec::bits_per_unit)) {
+                idx += bv::count_trailing_zeroes(w);
+            } else {
+                // skip over the remaining empty words in bulk
+                idx = self.ffs((idx / bitvec::bits_per_unit + 1) * bitvec::bits_per_unit);
             }
-            idx = -1;
             return *this;
         }
         bitref &operator--() {
@@ -219,38 +245,46 @@ class bitvec {
     // incomplete type errors
     class copy_bitref;
 
-    bitvec() : size(1), data(0) {}
-    explicit bitvec(uintptr_t v) : size(1), data(v) {}
+    bitvec() : size(inline_units), data{} {}
+    explicit bitvec(uintptr_t v) : size(inline_units), data{v} {}
     template <typename T, typename = typename std::enable_if<std::is_integral<T>::value &&
                                                              (sizeof(T) > sizeof(uintptr_t))>::type>
-    explicit bitvec(T v) : size(1), data(v) {
-        if (v != data) {
-            size = sizeof(v) / sizeof(data);
-            ptr = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[size];
-            for (unsigned i = 0; i < size; ++i) {
-                ptr[i] = v;
-                v >>= bits_per_unit;
-            }
+    explicit bitvec(T v) : size(inline_units), data{} {
+        constexpr size_t n = sizeof(T) / sizeof(uintptr_t);
+        if (n > size) expand(n);
+        uintptr_t *w = words();
+        for (size_t i = 0; i < n; ++i) {
+            w[i] = v;
+            v >>= bits_per_unit;
         }
     }
-    bitvec(size_t lo, size_t cnt) : size(1), data(0) { setrange(lo, cnt); }
+    bitvec(size_t lo, size_t cnt) : size(inline_units), data{} { setrange(lo, cnt); }
     bitvec(const bitvec &a) : size(a.size) {
-        if (size > 1) {
+        if (is_inline()) {
+            memcpy(data, a.data, sizeof(data));
+        } else {
             ptr = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[size];
             memcpy(ptr, a.ptr, size * sizeof(*ptr));
-        } else {
-            data = a.data;
         }
     }
-    bitvec(bitvec &&a) : size(a.size), data(a.data) { a.size = 1; }
+    bitvec(bitvec &&a) : size(a.size) {
+        memcpy(data, a.data, sizeof(data));
+        a.size = inline_units;
+        memset(a.data, 0, sizeof(a.data));
+    }
     bitvec &operator=(const bitvec &a) {
         if (this == &a) return *this;
-        if (size > 1) delete[] ptr;
-        if ((size = a.size) > 1) {
+        if (!is_inline() && size == a.size) {
+            // same sized heap buffers -- reuse ours
+            memcpy(ptr, a.ptr, size * sizeof(*ptr));
+            return *this;
+        }
+        if (!is_inline()) delete[] ptr;
+        if ((size = a.size) > inline_units) {
             ptr = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[size];
             memcpy(ptr, a.ptr, size * sizeof(*ptr));
         } else {
-            data = a.data;
+            memcpy(data, a.data, sizeof(data));
         }
         return *this;
     }
@@ -260,81 +294,65 @@ class bitvec {
         return *this;
     }
     ~bitvec() {
-        if (size > 1) delete[] ptr;
+        if (!is_inline()) delete[] ptr;
     }
 
-    void clear() {
-        if (size > 1)
-            memset(ptr, 0, size * sizeof(*ptr));
-        else
-            data = 0;
-    }  // NOLINT(whitespace/newline)
+    void clear() { memset(words(), 0, size * sizeof(uintptr_t)); }
     bool setbit(size_t idx) {
         if (idx >= size * bits_per_unit) expand(1 + idx / bits_per_unit);
-        if (size > 1)
-            ptr[idx / bits_per_unit] |= (uintptr_t)1 << (idx % bits_per_unit);
-        else
-            data |= (uintptr_t)1 << idx;
+        words()[idx / bits_per_unit] |= (uintptr_t)1 << (idx % bits_per_unit);
         return true;
     }
     void setrange(size_t idx, size_t sz) {
         if (sz == 0) return;
         if (idx + sz > size * bits_per_unit) expand(1 + (idx + sz - 1) / bits_per_unit);
-        if (size == 1) {
-            data |= ~(~(uintptr_t)1 << (sz - 1)) << idx;
-        } else if (idx / bits_per_unit == (idx + sz - 1) / bits_per_unit) {
-            ptr[idx / bits_per_unit] |= ~(~(uintptr_t)1 << (sz - 1)) << (idx % bits_per_unit);
+        uintptr_t *w = words();
+        if (idx / bits_per_unit == (idx + sz - 1) / bits_per_unit) {
+            w[idx / bits_per_unit] |= ~(~(uintptr_t)1 << (sz - 1)) << (idx % bits_per_unit);
         } else {
             size_t i = idx / bits_per_unit;
-            ptr[i] |= ~(uintptr_t)0 << (idx % bits_per_unit);
+            w[i] |= ~(uintptr_t)0 << (idx % bits_per_unit);
             idx += sz;
             while (++i < idx / bits_per_unit) {
-                ptr[i] = ~(uintptr_t)0;
+                w[i] = ~(uintptr_t)0;
             }
-            if (i < size) ptr[i] |= (((uintptr_t)1 << (idx % bits_per_unit)) - 1);
+            if (i < size) w[i] |= (((uintptr_t)1 << (idx % bits_per_unit)) - 1);
         }
     }
     void setraw(uintptr_t raw) {
-        if (size == 1) {
-            data = raw;
-        } else {
-            ptr[0] = raw;
-            for (size_t i = 1; i < size; i++) ptr[i] = 0;
-        }
+        uintptr_t *w = words();
+        w[0] = raw;
+        for (size_t i = 1; i < size; i++) w[i] = 0;
     }
     template <typename T, typename = typename std::enable_if<std::is_integral<T>::value &&
                                                              (sizeof(T) > sizeof(uintptr_t))>::type>
     void setraw(T raw) {
         if (sizeof(T) / sizeof(uintptr_t) > size) expand(sizeof(T) / sizeof(uintptr_t));
+        uintptr_t *w = words();
         for (size_t i = 0; i < size; i++) {
-            ptr[i] = raw;
+            w[i] = raw;
             raw >>= bits_per_unit;
         }
     }
     void setraw(uintptr_t *raw, size_t sz) {
         if (sz > size) expand(sz);
-        if (size == 1) {
-            data = raw[0];
-        } else {
-            for (size_t i = 0; i < sz; i++) ptr[i] = raw[i];
-            for (size_t i = sz; i < size; i++) ptr[i] = 0;
-        }
+        uintptr_t *w = words();
+        for (size_t i = 0; i < sz; i++) w[i] = raw[i];
+        for (size_t i = sz; i < size; i++) w[i] = 0;
     }
     template <typename T, typename = typename std::enable_if<std::is_integral<T>::value &&
                                                              (sizeof(T) > sizeof(uintptr_t))>::type>
     void setraw(T *raw, size_t sz) {
         constexpr size_t m = sizeof(T) / sizeof(uintptr_t);
         if (m * sz > size) expand(m * sz);
+        uintptr_t *w = words();
         size_t i = 0;
-        for (; i < sz * m; ++i) ptr[i] = raw[i / m] >> ((i % m) * bits_per_unit);
-        for (; i < size; ++i) ptr[i] = 0;
+        for (; i < sz * m; ++i) w[i] = raw[i / m] >> ((i % m) * bits_per_unit);
+        for (; i < size; ++i) w[i] = 0;
     }
     bool clrbit(size_t idx) {
         if (idx >= size * bits_per_unit) return false;
-        if (size > 1)
-            ptr[idx / bits_per_unit] &= ~((uintptr_t)1 << (idx % bits_per_unit));
-        else
-            data &= ~((uintptr_t)1 << idx);
+        words()[idx / bits_per_unit] &= ~((uintptr_t)1 << (idx % bits_per_unit));
         return false;
     }
     void clrrange(size_t idx, size_t sz) {
@@ -342,21 +360,17 @@ class bitvec {
         if (size < sz / bits_per_unit)  // To avoid sz + idx overflow
             sz = size * bits_per_unit;
         if (idx >= size * bits_per_unit) return;
-        if (size == 1) {
-            if (idx + sz < bits_per_unit)
-                data &= ~(~(~(uintptr_t)1 << (sz - 1)) << idx);
-            else
-                data &= ~(~(uintptr_t)0 << idx);
-        } else if (idx / bits_per_unit == (idx + sz - 1) / bits_per_unit) {
-            ptr[idx / bits_per_unit] &= ~(~(~(uintptr_t)1 << (sz - 1)) << (idx % bits_per_unit));
+        uintptr_t *w = words();
+        if (idx / bits_per_unit == (idx + sz - 1) / bits_per_unit) {
+            w[idx / bits_per_unit] &= ~(~(~(uintptr_t)1 << (sz - 1)) << (idx % bits_per_unit));
         } else {
             size_t i = idx / bits_per_unit;
-            ptr[i] &= ~(~(uintptr_t)0 << (idx % bits_per_unit));
+            w[i] &= ~(~(uintptr_t)0 << (idx % bits_per_unit));
             idx += sz;
             while (++i < idx / bits_per_unit && i < size) {
-                ptr[i] = 0;
+                w[i] = 0;
             }
-            if (i < size) ptr[i] &= ~(((uintptr_t)1 << (idx % bits_per_unit)) - 1);
+            if (i < size) w[i] &= ~(((uintptr_t)1 << (idx % bits_per_unit)) - 1);
         }
     }
     bool getbit(size_t idx) const {
@@ -365,41 +379,34 @@ class bitvec {
     uintmax_t getrange(size_t idx, size_t sz) const {
         assert(sz > 0 && sz <= CHAR_BIT * sizeof(uintmax_t));
         if (idx >= size * bits_per_unit) return 0;
-        if (size > 1) {
-            unsigned shift = idx % bits_per_unit;
-            idx /= bits_per_unit;
-            uintmax_t rv = ptr[idx] >> shift;
-            shift = bits_per_unit - shift;
-            while (shift < sz) {
-                if (++idx >= size) break;
-                rv |= (uintmax_t)ptr[idx] << shift;
-                shift += bits_per_unit;
-            }
-            return rv & ~(~(uintmax_t)1 << (sz - 1));
-        } else {
-            return (data >> idx) & ~(~(uintmax_t)1 << (sz - 1));
+        const uintptr_t *w = words();
+        unsigned shift = idx % bits_per_unit;
+        idx /= bits_per_unit;
+        uintmax_t rv = w[idx] >> shift;
+        shift = bits_per_unit - shift;
+        while (shift < sz) {
+            if (++idx >= size) break;
+            rv |= (uintmax_t)w[idx] << shift;
+            shift += bits_per_unit;
         }
+        return rv & ~(~(uintmax_t)1 << (sz - 1));
     }
     void putrange(size_t idx, size_t sz, uintmax_t v) {
         assert(sz > 0 && sz <= CHAR_BIT * sizeof(uintmax_t));
         uintptr_t mask = ~(uintmax_t)0 >> (CHAR_BIT * sizeof(uintmax_t) - sz);
         v &= mask;
         if (idx + sz > size * bits_per_unit) expand(1 + (idx + sz - 1) / bits_per_unit);
-        if (size == 1) {
-            data &= ~(mask << idx);
-            data |= v << idx;
-        } else {
-            unsigned shift = idx % bits_per_unit;
-            idx /= bits_per_unit;
-            ptr[idx] &= ~(mask << shift);
-            ptr[idx] |= v << shift;
-            shift = bits_per_unit - shift;
-            while (shift < sz) {
-                assert(idx + 1 < size);
-                ptr[++idx] &= ~(mask >> shift);
-                ptr[idx] |= v >> shift;
-                shift += bits_per_unit;
-            }
+        uintptr_t *w = words();
+        unsigned shift = idx % bits_per_unit;
+        idx /= bits_per_unit;
+        w[idx] &= ~(mask << shift);
+        w[idx] |= v << shift;
+        shift = bits_per_unit - shift;
+        while (shift < sz) {
+            assert(idx + 1 < size);
+            w[++idx] &= ~(mask >> shift);
+            w[idx] |= v >> shift;
+            shift += bits_per_unit;
         }
     }
     bitvec getslice(size_t idx, size_t sz) const;
@@ -421,39 +428,28 @@ class bitvec {
     nonconst_bitref begin() & { return min(); }
     nonconst_bitref end() & { return nonconst_bitref(*this, -1); }
     bool empty() const {
-        for (size_t i = 0; i < size; i++)
-            if (word(i) != 0) return false;
+        if (!is_inline()) return bv::bulk_ops::active->find_nonzero(ptr, size) == size;
+        for (size_t i = 0; i < inline_units; i++)
+            if (data[i] != 0) return false;
         return true;
     }
     explicit operator bool() const { return !empty(); }
     bool operator&=(const bitvec &a) {
         bool rv = false;
-        if (size > 1) {
-            if (a.size > 1) {
-                for (size_t i = 0; i < size && i < a.size; i++) {
-                    rv |= ((ptr[i] & a.ptr[i]) != ptr[i]);
-                    ptr[i] &= a.ptr[i];
-                }
-            } else {
-                rv |= ((*ptr & a.data) != *ptr);
-                *ptr &= a.data;
-            }
-            if (size > a.size) {
-                if (!rv) {
-                    for (size_t i = a.size; i < size; i++)
-                        if (ptr[i]) {
-                            rv = true;
-                            break;
-                        }
-                }
-                memset(ptr + a.size, 0, (size - a.size) * sizeof(*ptr));
-            }
-        } else if (a.size > 1) {
-            rv |= ((data & a.ptr[0]) != data);
-            data &= a.ptr[0];
+        uintptr_t *w = words();
+        const uintptr_t *aw = a.words();
+        size_t n = std::min(size, a.size);
+        if (n > inline_units) {
+            rv = bv::bulk_ops::active->and_with(w, aw, n);
         } else {
-            rv |= ((data & a.data) != data);
-            data &= a.data;
+            for (size_t i = 0; i < n; i++) {
+                rv |= ((w[i] & aw[i]) != w[i]);
+                w[i] &= aw[i];
+            }
+        }
+        if (size > n) {
+            if (!rv) rv = bv::bulk_ops::active->find_nonzero(w + n, size - n) != size - n;
+            memset(w + n, 0, (size - n) * sizeof(*w));
         }
         return rv;
     }
@@ -469,27 +465,20 @@ class bitvec {
         }
     }
     bool operator|=(const bitvec &a) {
-        bool rv = false;
         if (size < a.size) expand(a.size);
-        if (size > 1) {
-            if (a.size > 1) {
-                for (size_t i = 0; i < a.size; i++) {
-                    rv |= ((ptr[i] | a.ptr[i]) != ptr[i]);
-                    ptr[i] |= a.ptr[i];
-                }
-            } else {
-                rv |= ((*ptr | a.data) != *ptr);
-                *ptr |= a.data;
-            }
-        } else {
-            rv |= ((data | a.data) != data);
-            data |= a.data;
+        uintptr_t *w = words();
+        const uintptr_t *aw = a.words();
+        if (a.size > inline_units) return bv::bulk_ops::active->or_with(w, aw, a.size);
+        bool rv = false;
+        for (size_t i = 0; i < inline_units; i++) {
+            rv |= ((w[i] | aw[i]) != w[i]);
+            w[i] |= aw[i];
         }
         return rv;
     }
     bool operator|=(uintptr_t a) {
         bool rv = false;
-        auto t = size > 1 ? ptr : &data;
+        auto t = words();
         rv |= ((*t | a) != *t);
         *t |= a;
         return rv;
@@ -518,14 +507,12 @@ class bitvec {
     }
     bitvec &operator^=(const bitvec &a) {
         if (size < a.size) expand(a.size);
-        if (size > 1) {
-            if (a.size > 1) {
-                for (size_t i = 0; i < a.size; i++) ptr[i] ^= a.ptr[i];
-            } else {
-                *ptr ^= a.data;
-            }
+        uintptr_t *w = words();
+        const uintptr_t *aw = a.words();
+        if (a.size > inline_units) {
+            bv::bulk_ops::active->xor_with(w, aw, a.size);
         } else {
-            data ^= a.data;
+            for (size_t i = 0; i < inline_units; i++) w[i] ^= aw[i];
         }
         return *this;
     }
@@ -535,23 +522,14 @@ class bitvec {
         return rv;
     }
     bool operator-=(const bitvec &a) {
+        uintptr_t *w = words();
+        const uintptr_t *aw = a.words();
+        size_t n = std::min(size, a.size);
+        if (n > inline_units) return bv::bulk_ops::active->andnot_with(w, aw, n);
         bool rv = false;
-        if (size > 1) {
-            if (a.size > 1) {
-                for (size_t i = 0; i < size && i < a.size; i++) {
-                    rv |= ((ptr[i] & ~a.ptr[i]) != ptr[i]);
-                    ptr[i] &= ~a.ptr[i];
-                }
-            } else {
-                rv |= ((*ptr & ~a.data) != *ptr);
-                *ptr &= ~a.data;
-            }
-        } else if (a.size > 1) {
-            rv |= ((data & ~a.ptr[0]) != data);
-            data &= ~a.ptr[0];
-        } else {
-            rv |= ((data & ~a.data) != data);
-            data &= ~a.data;
+        for (size_t i = 0; i < n; i++) {
+            rv |= ((w[i] & ~aw[i]) != w[i]);
+            w[i] &= ~aw[i];
         }
         return rv;
     }
@@ -561,9 +539,11 @@ class bitvec {
         return rv;
     }
     bool operator==(const bitvec &a) const {
-        for (size_t i = 0; i < size || i < a.size; i++)
-            if (word(i) != a.word(i)) return false;
-        return true;
+        size_t n = std::min(size, a.size);
+        if (memcmp(words(), a.words(), n * sizeof(uintptr_t)) != 0) return false;
+        const bitvec &longer = size > n ? *this : a;
+        return bv::bulk_ops::active->find_nonzero(longer.words() + n, longer.size - n) ==
+               longer.size - n;
     }
     bool operator!=(const bitvec &a) const { return !(*this == a); }
     bool operator<(const bitvec &a) const {
@@ -578,15 +558,19 @@ class bitvec {
     bool operator>=(const bitvec &a) const { return !(*this < a); }
     bool operator<=(const bitvec &a) const { return !(a < *this); }
     bool intersects(const bitvec &a) const {
-        for (size_t i = 0; i < size && i < a.size; i++)
-            if (word(i) & a.word(i)) return true;
+        size_t n = std::min(size, a.size);
+        if (n > inline_units) return bv::bulk_ops::active->intersects(words(), a.words(), n);
+        const uintptr_t *w = words(), *aw = a.words();
+        for (size_t i = 0; i < n; i++)
+            if (w[i] & aw[i]) return true;
         return false;
     }
     bool contains(const bitvec &a) const {  // is 'a' a subset or equal to 'this'?
+        const uintptr_t *w = words(), *aw = a.words();
         for (size_t i = 0; i < size && i < a.size; i++)
-            if ((word(i) & a.word(i)) != a.word(i)) return false;
+            if ((w[i] & aw[i]) != aw[i]) return false;
         for (size_t i = size; i < a.size; i++)
-            if (a.word(i)) return false;
+            if (aw[i]) return false;
         return true;
     }
     bitvec &operator>>=(size_t count);
@@ -604,8 +588,9 @@ class bitvec {
     void rotate_right(size_t start_bit, size_t rotation_idx, size_t end_bit);
     bitvec rotate_right_copy(size_t start_bit, size_t rotation_idx, size_t end_bit) const;
     int popcount() const {
+        if (!is_inline()) return bv::bulk_ops::active->popcount(ptr, size);
         int rv = 0;
-        for (size_t i = 0; i < size; i++) rv += bv::popcount(word(i));
+        for (size_t i = 0; i < inline_units; i++) rv += bv::popcount(data[i]);
         return rv;
     }
     bool is_contiguous() const;
@@ -622,18 +607,11 @@ class bitvec {
             m |= m >> 16;
             newsize = (newsize + m) & ~m;
         }
-        if (size > 1) {
-            uintptr_t *old = ptr;
-            ptr = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[newsize];
-            memcpy(ptr, old, size * sizeof(*ptr));
-            memset(ptr + size, 0, (newsize - size) * sizeof(*ptr));
-            delete[] old;
-        } else {
-            uintptr_t d = data;
-            ptr = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[newsize];
-            *ptr = d;
-            memset(ptr + size, 0, (newsize - size) * sizeof(*ptr));
-        }
+        auto *grown = new IF_HAVE_LIBGC((PointerFreeGC)) uintptr_t[newsize];
+        memcpy(grown, words(), size * sizeof(*grown));
+        memset(grown + size, 0, (newsize - size) * sizeof(*grown));
+        if (!is_inline()) delete[] ptr;
+        ptr = grown;
         size = newsize;
     }
 
@@ -5,6 +5,8 @@
 
 #include "lib/compile_context.h"
 
+#include <config.h>
+
 #include "lib/error.h"
 #include "lib/exceptions.h"
 
@@ -41,11 +43,33 @@ ICompileContext::~ICompileContext() {}
     return stack;
 }
 
-AutoCompileContext::AutoCompileContext(ICompileContext *context) {
+AutoCompileContext *AutoCompileContext::innermostContext = nullptr;
+
+AutoCompileContext::AutoCompileContext(ICompileContext *context, bool useArena)
+    : outer(innermostContext) {
     CompileContextStack::push(context);
+    innermostContext = this;
+#if HAVE_IR_ARENA
+    if (useArena) {
+        arena = std::make_unique<Util::Arena>();
+        arenaScope = std::make_unique<Util::ArenaScope>(arena.get());
+    }
+#else
+    (void)useArena;
+#endif
 }
 
-AutoCompileContext::~AutoCompileContext() { CompileContextStack::pop(); }
+AutoCompileContext::~AutoCompileContext() {
+    while (!endCallbacks.empty()) {
+        auto callback = std::move(endCallbacks.back());
+        endCallbacks.pop_back();
+        callback();
+    }
+    arenaScope.reset();
+    arena.reset();
+    innermostContext = outer;
+    CompileContextStack::pop();
+}
 
 /* static */ BaseCompileContext &BaseCompileContext::get() {
     return CompileContextStack::top<BaseCompileContext>();
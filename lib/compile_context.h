@@ -8,9 +8,12 @@
 #ifndef LIB_COMPILE_CONTEXT_H_
 #define LIB_COMPILE_CONTEXT_H_
 
+#include <functional>
+#include <memory>
 #include <typeinfo>
 #include <vector>
 
+#include "lib/arena.h"
 #include "lib/cstring.h"
 #include "lib/error_reporter.h"
 
@@ -66,8 +69,26 @@ struct CompileContextStack final {
 /// is always nested correctly, this is the only interface for pushing or popping
 /// compilation contexts.
 struct AutoCompileContext {
-    explicit AutoCompileContext(ICompileContext *context);
+    /// If @useArena is true and the compiler is built with ENABLE_IR_ARENA, IR nodes created
+    /// while this object exists are allocated in a new arena, which is freed (with all those
+    /// nodes) when it is destroyed.  Only use this when no IR will be used afterwards, e.g.
+    /// for the context covering a whole compilation in a compiler's main().
+    explicit AutoCompileContext(ICompileContext *context, bool useArena = false);
     ~AutoCompileContext();
+
+    /// @return the AutoCompileContext created last which still exists, or nullptr.
+    static AutoCompileContext *innermost() { return innermostContext; }
+    /// Call @fn when this object is destroyed, before the nodes in its arena are freed.
+    /// Callbacks are called in the reverse order of registration.
+    void atEnd(std::function<void()> fn) { endCallbacks.push_back(std::move(fn)); }
+
+ private:
+    std::unique_ptr<Util::Arena> arena;
+    std::unique_ptr<Util::ArenaScope> arenaScope;
+    std::vector<std::function<void()>> endCallbacks;
+    AutoCompileContext *outer;
+
+    static AutoCompileContext *innermostContext;
 };
 
 /// A base compilation context which provides members needed by code in
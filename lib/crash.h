@@ -21,6 +21,10 @@ namespace P4 {
 
 void setup_signals();
 const char *addr2line(void *addr, const char *text);
+#ifdef MULTITHREAD
+/// Record the calling thread so that crash handlers can report which thread failed.
+void register_thread();
+#endif  // MULTITHREAD
 
 }  // namespace P4
 
@@ -34,6 +34,7 @@ limitations under the License.
 #include <functional>
 #include <iomanip>
 #include <ios>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -58,6 +59,13 @@ inline table_entry_flags operator|(table_entry_flags l, table_entry_flags r) {
     return static_cast<table_entry_flags>(static_cast<int>(l) | static_cast<int>(r));
 }
 
+// lookup key carrying its precomputed hash, so that the hash used to pick a shard is not
+// computed a second time by the shard's hash set
+struct hashed_key {
+    std::string_view str;
+    size_t hash;
+};
+
 // cache entry, ordered by string length
 class table_entry {
     std::size_t m_length = 0;
@@ -146,6 +154,8 @@ class table_entry {
         return length() == other.length() && std::memcmp(string(), other.data(), length()) == 0;
     }
 
+    bool operator==(const hashed_key &other) const { return *this == other.str; }
+
  private:
     bool is_inplace() const {
         return (m_flags & table_entry_flags::inplace) == table_entry_flags::inplace;
@@ -167,37 +177,81 @@ struct TableEntryHash {
     size_t operator()(std::string_view entry) const {
         return Util::hash(entry.data(), entry.length());
     }
+
+    size_t operator()(const hashed_key &key) const { return key.hash; }
 };
 
-auto &cache() {
-    // We need node_hash_set due to SSO: we return address of embedded string
-    // that should be stable
-    static absl::node_hash_set<table_entry, TableEntryHash, std::equal_to<>> g_cache;
+// The cache is split into shards, each protected by its own lock, so that threads interning
+// strings concurrently rarely contend.  A string always lives in the shard selected by the
+// top bits of its hash (the low bits are used within the shard's hash set).
+class string_cache {
+    static constexpr unsigned shard_bits = 6;
+
+    struct alignas(64) shard {
+        std::mutex lock;
+        // We need node_hash_set due to SSO: we return address of embedded string
+        // that should be stable
+        absl::node_hash_set<table_entry, TableEntryHash, std::equal_to<>> entries;
+    };
+
+    shard shards[1U << shard_bits];
 
+ public:
+    static hashed_key key(std::string_view s) { return {s, TableEntryHash()(s)}; }
+
+    shard &shard_for(const hashed_key &key) {
+        return shards[key.hash >> (sizeof(key.hash) * 8 - shard_bits)];
+    }
+
+    const char *find(std::string_view s) {
+        auto k = key(s);
+        auto &sh = shard_for(k);
+        std::lock_guard<std::mutex> guard(sh.lock);
+        auto entry = sh.entries.find(k);
+        return entry == sh.entries.end() ? nullptr : entry->string();
+    }
+
+    const char *save(const char *string, std::size_t length, table_entry_flags flags) {
+        auto k = key(std::string_view(string, length));
+        auto &sh = shard_for(k);
+        std::lock_guard<std::mutex> guard(sh.lock);
+        // Checks if string is already cached and if not, calls ctor to construct in
+        // place.  As a result, only a single lookup is performed regardless whether
+        // entry is in cache or not.
+        return sh.entries
+            .lazy_emplace(
+                k, [string, length, flags](const auto &ctor) { ctor(string, length, flags); })
+            ->string();
+    }
+
+    size_t size(size_t &count) {
+        size_t rv = 0;
+        count = 0;
+        for (auto &sh : shards) {
+            std::lock_guard<std::mutex> guard(sh.lock);
+            count += sh.entries.size();
+            for (auto &s : sh.entries) rv += sizeof(s) + s.length();
+        }
+        return rv;
+    }
+};
+
+string_cache &cache() {
+    static string_cache g_cache;
     return g_cache;
 }
 
 const char *save_to_cache(const char *string, std::size_t length, table_entry_flags flags) {
-    // Checks if string is already cached and if not, calls ctor to construct in
-    // place.  As a result, only a single lookup is performed regardless whether
-    // entry is in cache or not.
-    return cache()
-        .lazy_emplace(table_entry(string, length, table_entry_flags::no_need_copy),
-                      [string, length, flags](const auto &ctor) { ctor(string, length, flags); })
-        ->string();
+    return cache().save(string, length, flags);
 }
 
 }  // namespace
 
-bool cstring::is_cached(std::string_view s) { return cache().contains(s); }
+bool cstring::is_cached(std::string_view s) { return cache().find(s) != nullptr; }
 
 cstring cstring::get_cached(std::string_view s) {
-    auto entry = cache().find(s);
-    if (entry == cache().end()) return nullptr;
-
     cstring res;
-    res.str = entry->string();
-
+    res.str = cache().find(s);
     return res;
 }
 
@@ -214,12 +268,7 @@ void cstring::construct_from_literal(const char *string, std::size_t length) {
     str = save_to_cache(string, length, table_entry_flags::no_need_copy);
 }
 
-size_t cstring::cache_size(size_t &count) {
-    size_t rv = 0;
-    count = cache().size();
-    for (auto &s : cache()) rv += sizeof(s) + s.length();
-    return rv;
-}
+size_t cstring::cache_size(size_t &count) { return cache().size(count); }
 
 bool cstring::startsWith(std::string_view prefix) const {
     if (prefix.empty()) return true;
@@ -9,10 +9,13 @@
 #define LIB_ERROR_REPORTER_H_
 
 #include <iostream>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/format.hpp>
 
@@ -49,6 +52,51 @@ class ErrorReporter {
     /// Track errors or warnings that have already been issued for a particular source location
     std::set<std::pair<int, const Util::SourceInfo>> errorTracker;
 
+ public:
+    /// Diagnostics reported on a thread while a Deferred is active there (see DeferScope) are
+    /// kept in it instead of being output.  Work done concurrently on worker threads uses this
+    /// to output its diagnostics in a deterministic order, with replay().
+    class Deferred {
+        friend class ErrorReporter;
+        struct Diagnostic {
+            std::optional<std::pair<int, const Util::SourceInfo>> key;  // for error_reported
+            ErrorMessage message;
+        };
+        std::vector<Diagnostic> diagnostics;
+        std::set<std::pair<int, const Util::SourceInfo>> reported;
+        std::optional<std::pair<int, const Util::SourceInfo>> key;  // of the next diagnostic
+        unsigned errors = 0;
+
+     public:
+        bool empty() const { return diagnostics.empty(); }
+    };
+
+    /// Makes a Deferred collect the diagnostics reported on the calling thread while it exists.
+    class DeferScope {
+        Deferred *previous;
+
+     public:
+        explicit DeferScope(Deferred &deferred) : previous(std::exchange(current, &deferred)) {}
+        DeferScope(const DeferScope &) = delete;
+        DeferScope &operator=(const DeferScope &) = delete;
+        ~DeferScope() { current = previous; }
+    };
+
+    /// Output the diagnostics collected by @p deferred, as if they were reported now.
+    void replay(Deferred &deferred) {
+        for (auto &diagnostic : deferred.diagnostics) {
+            if (diagnostic.key && error_reported(diagnostic.key->first, diagnostic.key->second))
+                continue;
+            report(std::move(diagnostic.message));
+        }
+        deferred.diagnostics.clear();
+        deferred.errors = 0;
+    }
+
+ protected:
+    /// The Deferred active on this thread, if any.
+    static inline thread_local Deferred *current = nullptr;
+
     /// Output the message and flush the stream
     virtual void emit_message(const ErrorMessage &msg) {
         *outputstream << msg.toString();
@@ -66,10 +114,38 @@ class ErrorReporter {
     /// list of seen errors, and return false.
     bool error_reported(int err, const Util::SourceInfo source) {
         if (!source.isValid()) return false;
+        if (current) {
+            // errorTracker is only read while diagnostics are deferred
+            if (errorTracker.count({err, source})) return true;
+            if (!current->reported.emplace(err, source).second) return true;
+            current->key.emplace(err, source);
+            return false;
+        }
         auto p = errorTracker.emplace(err, source);
         return !p.second;  // if insertion took place, then we have not seen the error.
     }
 
+    /// Count and output @p msg, or throw if there are too many errors.
+    void report(ErrorMessage msg) {
+        if (msg.type == ErrorMessage::MessageType::Info) {
+            // Avoid burying errors in a pile of info messages:
+            // don't emit any more info messages if we've emitted errors.
+            if (errorCount > 0) return;
+            infoCount++;
+        } else if (msg.type == ErrorMessage::MessageType::Warning) {
+            // Avoid burying errors in a pile of warnings: don't emit any more warnings if we've
+            // emitted errors.
+            if (errorCount > 0) return;
+            warningCount++;
+        } else if (msg.type == ErrorMessage::MessageType::Error) {
+            errorCount++;
+        }
+        emit_message(msg);
+
+        if (errorCount > maxErrorCount)
+            FATAL_ERROR("Number of errors exceeded set maximum of %1%", maxErrorCount);
+    }
+
     /// retrieve the format from the error catalog
     cstring get_error_name(int errorCode) { return ErrorCatalog::getCatalog().getName(errorCode); }
 
@@ -128,38 +204,33 @@ class ErrorReporter {
     template <typename... Args>
     void diagnose(DiagnosticAction action, const char *diagnosticName, const char *format,
                   const char *suffix, Args &&...args) {
+        auto key = current ? std::exchange(current->key, std::nullopt) : std::nullopt;
         if (action == DiagnosticAction::Ignore) return;
 
         ErrorMessage::MessageType msgType = ErrorMessage::MessageType::None;
         if (action == DiagnosticAction::Info) {
-            // Avoid burying errors in a pile of info messages:
-            // don't emit any more info messages if we've emitted errors.
-            if (errorCount > 0) return;
-
-            infoCount++;
+            if (getErrorCount() > 0) return;
             msgType = ErrorMessage::MessageType::Info;
         } else if (action == DiagnosticAction::Warn) {
-            // Avoid burying errors in a pile of warnings: don't emit any more warnings if we've
-            // emitted errors.
-            if (errorCount > 0) return;
-
-            warningCount++;
+            if (getErrorCount() > 0) return;
             msgType = ErrorMessage::MessageType::Warning;
         } else if (action == DiagnosticAction::Error) {
-            errorCount++;
             msgType = ErrorMessage::MessageType::Error;
         }
 
         boost::format fmt(format);
         ErrorMessage msg(msgType, diagnosticName ? diagnosticName : "", suffix);
         msg = ::P4::error_helper(fmt, msg, std::forward<Args>(args)...);
-        emit_message(msg);
-
-        if (errorCount > maxErrorCount)
-            FATAL_ERROR("Number of errors exceeded set maximum of %1%", maxErrorCount);
+        if (current) {
+            if (msgType == ErrorMessage::MessageType::Error) current->errors++;
+            current->diagnostics.push_back({key, std::move(msg)});
+            return;
+        }
+        report(std::move(msg));
     }
 
-    unsigned getErrorCount() const { return errorCount; }
+    /// The number of errors reported so far, including the ones deferred on this thread.
+    unsigned getErrorCount() const { return errorCount + (current ? current->errors : 0); }
 
     unsigned getMaxErrorCount() const { return maxErrorCount; }
     /// set maxErrorCount to a the @newMaxCount threshold and return the previous value
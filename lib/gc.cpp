@@ -47,6 +47,43 @@ limitations under the License.
 
 using namespace P4;
 
+// Allocation tracing and counting are also used for IR arenas (lib/arena.h), so they are
+// available with or without the GC.
+static alloc_trace_cb_t trace_cb;
+static bool tracing = false;
+static std::atomic<std::atomic<uint64_t> *> alloc_counter{nullptr};
+#define TRACE_ALLOC(size)                                                  \
+    {                                                                      \
+        if (auto *counter = alloc_counter.load(std::memory_order_relaxed)) \
+            counter->fetch_add(size, std::memory_order_relaxed);           \
+        if (trace_cb.fn && !tracing) {                                     \
+            void *buffer[ALLOC_TRACE_DEPTH];                               \
+            tracing = true;                                                \
+            absl::GetStackTrace(buffer, ALLOC_TRACE_DEPTH, 1);             \
+            trace_cb.fn(trace_cb.arg, buffer, size);                       \
+            tracing = false;                                               \
+        }                                                                  \
+    }
+
+std::atomic<uint64_t> *set_alloc_counter(std::atomic<uint64_t> *counter) {
+    return alloc_counter.exchange(counter);
+}
+
+alloc_trace_cb_t set_alloc_trace(alloc_trace_cb_t cb) {
+    alloc_trace_cb_t old = trace_cb;
+    trace_cb = cb;
+    return old;
+}
+
+alloc_trace_cb_t set_alloc_trace(void (*fn)(void *, void **, size_t), void *arg) {
+    alloc_trace_cb_t old = trace_cb;
+    trace_cb.fn = fn;
+    trace_cb.arg = arg;
+    return old;
+}
+
+void trace_alloc(size_t size) { TRACE_ALLOC(size) }
+
 // One can disable the GC, e.g., to run under Valgrind, by editing config.h or toggling
 // -DENABLE_GC=OFF in CMake.
 #if HAVE_LIBGC
@@ -57,17 +94,6 @@ static bool done_init, started_init;
 static char emergency_pool[16 * 1024];
 static char *emergency_ptr;
 
-static alloc_trace_cb_t trace_cb;
-static bool tracing = false;
-#define TRACE_ALLOC(size)                                  \
-    if (trace_cb.fn && !tracing) {                         \
-        void *buffer[ALLOC_TRACE_DEPTH];                   \
-        tracing = true;                                    \
-        absl::GetStackTrace(buffer, ALLOC_TRACE_DEPTH, 1); \
-        trace_cb.fn(trace_cb.arg, buffer, size);           \
-        tracing = false;                                   \
-    }
-
 static void maybe_initialize_gc() {
     if (!done_init) {
         started_init = true;
@@ -138,19 +164,6 @@ void *operator new(std::size_t size, std::align_val_t alignment, const std::noth
     return rv;
 }
 
-alloc_trace_cb_t set_alloc_trace(alloc_trace_cb_t cb) {
-    alloc_trace_cb_t old = trace_cb;
-    trace_cb = cb;
-    return old;
-}
-
-alloc_trace_cb_t set_alloc_trace(void (*fn)(void *, void **, size_t), void *arg) {
-    alloc_trace_cb_t old = trace_cb;
-    trace_cb.fn = fn;
-    trace_cb.arg = arg;
-    return old;
-}
-
 void operator delete(void *p) noexcept {
     if (p >= emergency_pool && p < emergency_pool + sizeof(emergency_pool)) {
         return;
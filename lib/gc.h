@@ -17,7 +17,9 @@ limitations under the License.
 #ifndef LIB_GC_H_
 #define LIB_GC_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 
 #define ALLOC_TRACE_DEPTH 5
 
@@ -30,5 +32,10 @@ struct alloc_trace_cb_t {
 };
 alloc_trace_cb_t set_alloc_trace(alloc_trace_cb_t cb);
 alloc_trace_cb_t set_alloc_trace(void (*fn)(void *arg, void **pc, size_t sz), void *arg);
+// add the size of every allocation to *counter, without the cost of a trace callback; nullptr
+// stops counting.  Returns the previous counter.
+std::atomic<uint64_t> *set_alloc_counter(std::atomic<uint64_t> *counter);
+// report an allocation made by a custom allocator to the alloc counter and trace callback, if any
+void trace_alloc(size_t sz);
 
 #endif /* LIB_GC_H_ */
@@ -5,9 +5,13 @@
 
 #include "hashvec.h"
 
+#include <cstring>
 #ifdef DEBUG
 #include <iomanip>
 #endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "exceptions.h"
 
@@ -23,125 +27,110 @@ struct hash_vector_base::internal {
     char ismap, ismulti, hashelsize;
 };
 
+namespace {
+constexpr size_t group_width = 16;
+
+/* address of the index for slot i in a table with indexes of elsize bytes */
+uint8_t *slotindex(uint8_t *table, size_t i, size_t elsize) {
+    return table + i / group_width * group_width * (1 + elsize) + group_width +
+           i % group_width * elsize;
+}
+}  // namespace
+
 uint32_t hash_vector_base::gethash_s1(const hash_vector_base *ht, size_t i) {
-    return ht->hash.s1[i];
+    return *slotindex(ht->table, i, sizeof(uint8_t));
 }
 uint32_t hash_vector_base::gethash_s2(const hash_vector_base *ht, size_t i) {
-    return ht->hash.s2[i];
+    return *reinterpret_cast<uint16_t *>(slotindex(ht->table, i, sizeof(uint16_t)));
 }
 uint32_t hash_vector_base::gethash_s3(const hash_vector_base *ht, size_t i) {
-    return ht->hash.s3[i];
+    return *reinterpret_cast<uint32_t *>(slotindex(ht->table, i, sizeof(uint32_t)));
 }
 void hash_vector_base::sethash_s1(hash_vector_base *ht, size_t i, uint32_t v) {
-    ht->hash.s1[i] = v;
+    *slotindex(ht->table, i, sizeof(uint8_t)) = v;
 }
 void hash_vector_base::sethash_s2(hash_vector_base *ht, size_t i, uint32_t v) {
-    ht->hash.s2[i] = v;
+    *reinterpret_cast<uint16_t *>(slotindex(ht->table, i, sizeof(uint16_t))) = v;
 }
 void hash_vector_base::sethash_s3(hash_vector_base *ht, size_t i, uint32_t v) {
-    ht->hash.s3[i] = v;
-}
-
-static size_t mod_f(size_t x) { return x % 0xf; }
-static size_t mod_1f(size_t x) { return x % 0x1f; }
-static size_t mod_3f(size_t x) { return x % 0x3f; }
-static size_t mod_7f(size_t x) { return x % 0x7f; }
-static size_t mod_ff(size_t x) { return x % 0xff; }
-static size_t mod_1ff(size_t x) { return x % 0x1ff; }
-static size_t mod_3ff(size_t x) { return x % 0x3ff; }
-static size_t mod_7ff(size_t x) { return x % 0x7ff; }
-static size_t mod_fff(size_t x) { return x % 0xfff; }
-static size_t mod_1fff(size_t x) { return x % 0x1fff; }
-static size_t mod_3fff(size_t x) { return x % 0x3fff; }
-static size_t mod_7fff(size_t x) { return x % 0x7fff; }
-static size_t mod_ffff(size_t x) { return x % 0xffff; }
-static size_t mod_1ffff(size_t x) { return x % 0x1ffff; }
-static size_t mod_3ffff(size_t x) { return x % 0x3ffff; }
-static size_t mod_7ffff(size_t x) { return x % 0x7ffff; }
-static size_t mod_fffff(size_t x) { return x % 0xfffff; }
-static size_t mod_1fffff(size_t x) { return x % 0x1fffff; }
-static size_t mod_3fffff(size_t x) { return x % 0x3fffff; }
-static size_t mod_7fffff(size_t x) { return x % 0x7fffff; }
-static size_t mod_ffffff(size_t x) { return x % 0xffffff; }
-static size_t mod_1ffffff(size_t x) { return x % 0x1ffffff; }
-static size_t mod_3ffffff(size_t x) { return x % 0x3ffffff; }
-static size_t mod_7ffffff(size_t x) { return x % 0x7ffffff; }
-static size_t mod_fffffff(size_t x) { return x % 0xfffffff; }
-static size_t mod_1fffffff(size_t x) { return x % 0x1fffffff; }
-static size_t mod_3fffffff(size_t x) { return x % 0x3fffffff; }
-static size_t mod_7fffffff(size_t x) { return x % 0x7fffffff; }
-static size_t mod_ffffffff(size_t x) { return x % 0xffffffff; }
-
-static size_t (*mod_hashsize[])(size_t x) = {
-    0,
-    0,
-    0,
-    0,
-    mod_f,
-    mod_1f,
-    mod_3f,
-    mod_7f,
-    mod_ff,
-    mod_1ff,
-    mod_3ff,
-    mod_7ff,
-    mod_fff,
-    mod_1fff,
-    mod_3fff,
-    mod_7fff,
-    mod_ffff,
-    mod_1ffff,
-    mod_3ffff,
-    mod_7ffff,
-    mod_fffff,
-    mod_1fffff,
-    mod_3fffff,
-    mod_7fffff,
-    mod_ffffff,
-    mod_1ffffff,
-    mod_3ffffff,
-    mod_7ffffff,
-    mod_fffffff,
-    mod_1fffffff,
-    mod_3fffffff,
-    mod_7fffffff,
-    mod_ffffffff,
-};
+    *reinterpret_cast<uint32_t *>(slotindex(ht->table, i, sizeof(uint32_t))) = v;
+}
 
-void hash_vector_base::allochash() {
-    // FIXME -- all switch cases are doing the same thing (just with different types) so
-    // it should be possible to simplify this
+/* switch rather than info->gethash so it can be inlined into probing */
+inline uint32_t hash_vector_base::getidx(size_t slot) const {
     switch (info->hashelsize) {
         case sizeof(uint8_t):
-            hash.s1 = new uint8_t[hashsize];
-            memset(hash.s1, 0, hashsize * info->hashelsize);
-            break;
+            return gethash_s1(this, slot);
         case sizeof(uint16_t):
-            hash.s2 = new uint16_t[hashsize];
-            memset(hash.s2, 0, hashsize * info->hashelsize);
-            break;
-        case sizeof(uint32_t):
-            hash.s3 = new uint32_t[hashsize];
-            memset(hash.s3, 0, hashsize * info->hashelsize);
-            break;
+            return gethash_s2(this, slot);
+        default:
+            return gethash_s3(this, slot);
     }
 }
 
-void hash_vector_base::freehash() {
-    // FIXME -- all switch cases are doing the same thing (just with different types) so
-    // it should be possible to simplify this
-    switch (info->hashelsize) {
-        case sizeof(uint8_t):
-            delete[] hash.s1;
-            break;
-        case sizeof(uint16_t):
-            delete[] hash.s2;
-            break;
-        case sizeof(uint32_t):
-            delete[] hash.s3;
-            break;
+size_t hash_vector_base::groupbytes() const { return group_width * (1 + info->hashelsize); }
+size_t hash_vector_base::tablebytes() const { return hashsize / group_width * groupbytes(); }
+inline int8_t *hash_vector_base::ctrl(size_t slot) const {
+    return reinterpret_cast<int8_t *>(table + slot / group_width * groupbytes()) +
+           slot % group_width;
+}
+
+namespace {
+
+/* control byte values; a slot in use holds the low 7 bits of its key's hash */
+constexpr int8_t ctrl_empty = -128;
+constexpr int8_t ctrl_deleted = -2;
+
+/* std::hash of pointers and integers is the identity, which leaves the low bits (used for
+ * the control bytes) nearly constant for pointers, so mix the hash before using it */
+size_t mix(size_t h) {
+    uint64_t m = static_cast<uint64_t>(h) * 0x9e3779b97f4a7c15ULL;
+    return m ^ (m >> 32);
+}
+int8_t h2(size_t hash) { return hash & 0x7f; }
+size_t h1(size_t hash) { return hash >> 7; }
+
+/* the control bytes of one group of slots, with bitmask queries over them */
+class group {
+#if defined(__SSE2__)
+    __m128i ctrl;
+
+ public:
+    explicit group(const int8_t *p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+    uint32_t match(int8_t h) const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h)));
+    }
+    uint32_t match_free() const { return _mm_movemask_epi8(ctrl); }
+#else
+    const int8_t *ctrl;
+
+ public:
+    explicit group(const int8_t *p) : ctrl(p) {}
+    uint32_t match(int8_t h) const {
+        uint32_t rv = 0;
+        for (size_t i = 0; i < group_width; ++i) rv |= static_cast<uint32_t>(ctrl[i] == h) << i;
+        return rv;
+    }
+    uint32_t match_free() const {
+        uint32_t rv = 0;
+        for (size_t i = 0; i < group_width; ++i) rv |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+        return rv;
     }
-    hash.s1 = nullptr;
+#endif
+    uint32_t match_empty() const { return match(ctrl_empty); }
+};
+
+}  // namespace
+
+void hash_vector_base::allochash() {
+    table = new uint8_t[tablebytes()];
+    memset(table, 0, tablebytes());
+    for (size_t i = 0; i < hashsize; i += group_width) memset(ctrl(i), ctrl_empty, group_width);
+}
+
+void hash_vector_base::freehash() {
+    delete[] table;
+    table = nullptr;
 }
 
 hash_vector_base::hash_vector_base(bool ismap, bool ismulti, size_t capacity) {
@@ -171,13 +160,13 @@ hash_vector_base::hash_vector_base(bool ismap, bool ismulti, size_t capacity) {
                                   UINT32_MAX, 1, 1, sizeof(uint32_t)},
                                  {0, 0, 0, 0, 0, 0}};
 
-    hashsize = 15;
+    hashsize = group_width;
     log_hashsize = 4;
-    while (hashsize / 2 < capacity) {
-        hashsize += hashsize + 1;
+    while (hashsize / 8 * 7 < capacity) {
+        hashsize *= 2;
         log_hashsize++;
     }
-    BUG_CHECK(hashsize + 1 == (1UL << log_hashsize), "hash corrupt");
+    BUG_CHECK(hashsize == (1UL << log_hashsize), "hash corrupt");
     info = formats + (ismap ? 3 : 0) + (ismulti ? 6 : 0);
     BUG_CHECK(info->ismap == ismap, "corrupt");
     while (capacity > info->maxset) {
@@ -185,29 +174,29 @@ hash_vector_base::hash_vector_base(bool ismap, bool ismulti, size_t capacity) {
         BUG_CHECK(info->ismap == ismap, "capacity %d exceeds max", capacity);
     }
     allochash();
-    inuse = collisions = 0;
+    inuse = used = 0;
 }
 
 hash_vector_base::hash_vector_base(const hash_vector_base &a)
     : info(a.info),
       hashsize(a.hashsize),
-      collisions(a.collisions),
+      used(a.used),
       log_hashsize(a.log_hashsize),
       inuse(a.inuse),
       erased(a.erased) {
     allochash();
-    memcpy(hash.s1, a.hash.s1, hashsize * info->hashelsize);
+    memcpy(table, a.table, tablebytes());
 }
 
 hash_vector_base::hash_vector_base(hash_vector_base &&a)
     : info(a.info),
       hashsize(a.hashsize),
-      collisions(a.collisions),
+      used(a.used),
       log_hashsize(a.log_hashsize),
       inuse(a.inuse),
       erased(a.erased) {
-    hash.s1 = a.hash.s1;
-    a.hash.s1 = nullptr;
+    table = a.table;
+    a.table = nullptr;
 }
 
 hash_vector_base &hash_vector_base::operator=(const hash_vector_base &a) {
@@ -216,11 +205,11 @@ hash_vector_base &hash_vector_base::operator=(const hash_vector_base &a) {
         info = a.info;
         hashsize = a.hashsize;
         inuse = a.inuse;
-        collisions = a.collisions;
+        used = a.used;
         log_hashsize = a.log_hashsize;
         erased = a.erased;
         allochash();
-        memcpy(hash.s1, a.hash.s1, hashsize * info->hashelsize);
+        memcpy(table, a.table, tablebytes());
     }
     return *this;
 }
@@ -231,11 +220,11 @@ hash_vector_base &hash_vector_base::operator=(hash_vector_base &&a) {
         info = a.info;
         hashsize = a.hashsize;
         inuse = a.inuse;
-        collisions = a.collisions;
+        used = a.used;
         log_hashsize = a.log_hashsize;
         erased = a.erased;
-        hash.s1 = a.hash.s1;
-        a.hash.s1 = nullptr;
+        table = a.table;
+        a.table = nullptr;
     }
     return *this;
 }
@@ -243,44 +232,73 @@ hash_vector_base &hash_vector_base::operator=(hash_vector_base &&a) {
 void hash_vector_base::clear() {
     freehash();
     while (info->hashelsize > 1) --info;
-    hashsize = 15;
-    collisions = 0;
+    hashsize = group_width;
+    used = 0;
     log_hashsize = 4;
     inuse = 0;
     erased.clear();
     allochash();
 }
 
-size_t hash_vector_base::find(const void *key, lookup_cache *cache) const {
-    size_t hash = mod_hashsize[log_hashsize](hashfn(key));
-    size_t idx, collisions = 0;
-    while ((idx = info->gethash(this, hash)) && (erased[idx - 1] || !cmpfn(key, idx - 1))) {
-        if (++collisions >= hashsize) {
-            idx = 0;
-            break;
+/* Probe for key, starting at group and continuing the probe sequence recorded in
+ * cache->collisions; the slots in the first group masked by skip are not considered.
+ * Groups are probed with triangular steps, which visits every group when the number of
+ * groups is a power of 2.  Stops at the first group with an empty slot, as no probe for the
+ * key can have continued past it when the key was inserted. */
+size_t hash_vector_base::probe(const void *key, lookup_cache *cache, size_t g,
+                               uint32_t skip) const {
+    size_t groups = hashsize / group_width;
+    size_t n = cache->collisions, free = hashsize;
+    while (n < groups) {
+        group grp(ctrl(g * group_width));
+        for (uint32_t m = grp.match(h2(cache->hash)) & ~skip; m; m &= m - 1) {
+            size_t slot = g * group_width + __builtin_ctz(m);
+            size_t idx = getidx(slot);
+            if (!erased[idx - 1] && cmpfn(key, idx - 1)) {
+                cache->slot = slot;
+                cache->collisions = n;
+                return idx;
+            }
+        }
+        skip = 0;
+        if (free == hashsize) {
+            if (uint32_t m = grp.match_free()) free = g * group_width + __builtin_ctz(m);
         }
-        if (++hash == hashsize) hash = 0;
+        if (grp.match_empty()) break;
+        g = (g + ++n) & (groups - 1);
     }
-    cache->slot = hash;
-    cache->collisions = collisions;
-    return idx;
+    BUG_CHECK(free < hashsize, "no free slots in hash_vector");
+    cache->slot = free;
+    cache->collisions = n;
+    return 0;
 }
 
-size_t hash_vector_base::find_next(const void *key, lookup_cache *cache) const {
-    size_t hash = cache->slot;
-    size_t idx, collisions = cache->collisions;
-    if (!(idx = info->gethash(this, hash))) return idx;
-    if (++hash == hashsize) hash = 0;
-    while ((idx = info->gethash(this, hash)) && (erased[idx - 1] || !cmpfn(key, idx - 1))) {
-        if (++collisions >= hashsize) {
-            idx = 0;
-            break;
-        }
-        if (++hash == hashsize) hash = 0;
+/* first deleted or empty slot in the probe sequence for hash */
+size_t hash_vector_base::find_free(size_t hash) const {
+    size_t groups = hashsize / group_width;
+    size_t g = h1(hash) & (groups - 1);
+    for (size_t n = 0;; g = (g + ++n) & (groups - 1)) {
+        if (uint32_t m = group(ctrl(g * group_width)).match_free())
+            return g * group_width + __builtin_ctz(m);
     }
-    cache->slot = hash;
-    cache->collisions = collisions;
-    return idx;
+}
+
+void hash_vector_base::setslot(size_t slot, size_t hash, uint32_t idx) {
+    if (*ctrl(slot) == ctrl_empty) ++used;
+    *ctrl(slot) = h2(hash);
+    info->sethash(this, slot, idx);
+}
+
+size_t hash_vector_base::find(const void *key, lookup_cache *cache) const {
+    cache->hash = mix(hashfn(key));
+    cache->collisions = 0;
+    return probe(key, cache, h1(cache->hash) & (hashsize / group_width - 1), 0);
+}
+
+size_t hash_vector_base::find_next(const void *key, lookup_cache *cache) const {
+    size_t slot = cache->slot;
+    if (!info->gethash(this, slot)) return 0;
+    return probe(key, cache, slot / group_width, (2U << (slot % group_width)) - 1);
 }
 
 void *hash_vector_base::lookup(const void *key, lookup_cache *cache) {
@@ -297,30 +315,22 @@ void *hash_vector_base::lookup_next(const void *key, lookup_cache *cache) {
     return idx ? getval(idx - 1) : 0;
 }
 
+/* Rebuild the index from scratch, compacting away erased elements */
 void hash_vector_base::redo_hash() {
     size_t i, j;
-    lookup_cache cache;
-    memset(hash.s1, 0, hashsize * info->hashelsize);
-    collisions = 0;
+    memset(table, 0, tablebytes());
+    for (i = 0; i < hashsize; i += group_width) memset(ctrl(i), ctrl_empty, group_width);
+    used = 0;
     size_t limit = this->limit();
     auto erased = this->erased;
     this->erased.clear();
     for (i = j = 0; i < limit; i++) {
         if (erased[i]) continue;
-        const void *k = getkey(i);
-        if (find(k, &cache)) {
-            if (info->ismulti) {
-                while (find_next(k, &cache)) {
-                }
-            } else {
-                BUG("duplicate keys in hash_vector_base::redo_hash");
-            }
-        }
         if (j != i) {
             moveentry(j, i);
         }
-        info->sethash(this, cache.slot, ++j);
-        collisions += cache.collisions;
+        size_t h = mix(hashfn(getkey(j)));
+        setslot(find_free(h), h, ++j);
     }
     resizedata(j);
     inuse = j;
@@ -343,42 +353,17 @@ size_t hash_vector_base::hv_insert(const void *key, lookup_cache *cache) {
             while (find_next(key, cache)) {
             }
     }
-    if ((collisions += cache->collisions) > hashsize / 2) {
-        /* Too many collisions -- redo hash table */
-        if (inuse * 3 < limit() * 2) {
-            /* Many empty slots from removals, so don't expand anything */
-        } else if (/* !ht->hashfn[1] && */ hashsize > inuse * 10) {
-            /* Hashtable 90% empty and no alternate hash function.   Hash
-             * function isn't working but expanding further will likely
-             * make things worse, not better.
-             * Nothing we can do, so punt */
-        } else /* if (!ht->hashfn[1] || ht->hashsize < ht->limit*3) */ {
-            /* No alternate hashfn, or hashtable pretty full, expand hash */
-            hashsize += hashsize + 1;
-            log_hashsize++;
-            BUG_CHECK((hashsize & (hashsize + 1)) == 0, "hash corruption");
-            BUG_CHECK(hashsize + 1 == (1UL << log_hashsize), "hash corruption");
-            freehash();
-            allochash();
-#if 0
-        } else {
-            // FIXME -- figure out a way to allow changing the hash function in this case
-            ht->hashfn++;
-#endif
-        }
-        redo_hash();
-        if (find(key, cache) && info->ismulti)
-            while (find_next(key, cache)) {
-            }
-    }
     if ((idx = info->gethash(this, cache->slot)) == 0) {
         bool need_redo = false;
-        if (limit() >= hashsize) {
-            hashsize += hashsize + 1;
-            log_hashsize++;
-            BUG_CHECK((hashsize & (hashsize + 1)) == 0, "hash corruption");
-            BUG_CHECK(hashsize + 1 == (1UL << log_hashsize), "hash corruption");
-            freehash();
+        if (*ctrl(cache->slot) == ctrl_empty && (used + 1) * 8 > hashsize * 7) {
+            /* Out of empty slots -- if most of the slots are deleted or refer to erased
+             * elements, rebuilding the index in place will free them up, otherwise expand */
+            if (inuse * 16 >= hashsize * 7) {
+                freehash();
+                hashsize *= 2;
+                log_hashsize++;
+                BUG_CHECK(hashsize == (1UL << log_hashsize), "hash corruption");
+            }
             need_redo = true;
         }
         if (limit() >= info->maxset) {
@@ -388,13 +373,13 @@ size_t hash_vector_base::hv_insert(const void *key, lookup_cache *cache) {
             need_redo = true;
         }
         if (need_redo) {
-            allochash();
+            if (!table) allochash();
             redo_hash();
             if (find(key, cache) && info->ismulti)
                 while (find_next(key, cache)) {
                 }
         }
-        info->sethash(this, cache->slot, limit() + 1);
+        setslot(cache->slot, cache->hash, limit() + 1);
         inuse++;
         return -1;
     } else if (erased[idx - 1]) {
@@ -409,10 +394,9 @@ size_t hash_vector_base::remove(const void *key, lookup_cache *cache) {
     if (cache) {
 #ifndef NDEBUG
         if (find(key, &local) && info->ismulti)
-            while (local.slot != cache->slot && find_next(key, cache)) {
+            while (local.slot != cache->slot && find_next(key, &local)) {
             }
-        BUG_CHECK(local.slot == cache->slot && local.collisions == cache->collisions,
-                  "invalid cache in hash_vector_base::remove");
+        BUG_CHECK(local.slot == cache->slot, "invalid cache in hash_vector_base::remove");
 #endif
     } else {
         cache = &local;
@@ -422,8 +406,15 @@ size_t hash_vector_base::remove(const void *key, lookup_cache *cache) {
         if (!erased[idx - 1]) inuse--;
         if (idx == limit()) {
             resizedata(idx - 1);
+            /* If the group has an empty slot, no probe sequence continues past it, so this
+             * slot can become empty too; otherwise it must be left as deleted */
+            if (group(ctrl(cache->slot & ~(group_width - 1))).match_empty()) {
+                *ctrl(cache->slot) = ctrl_empty;
+                --used;
+            } else {
+                *ctrl(cache->slot) = ctrl_deleted;
+            }
             info->sethash(this, cache->slot, 0);
-            collisions -= cache->collisions;
         } else {
             erased[idx - 1] = 1;
         }
@@ -458,7 +449,7 @@ void hash_vector_base::dump(std::ostream &out) {
     out << "hash_vector " << (void *)this << ": " << (info->ismap ? "map" : "set")
         << static_cast<int>(info->hashelsize) << "\n";
     out << "hashsize=" << hashsize << ", limit=" << limit() << ", inuse=" << inuse
-        << ", collisions=" << collisions;
+        << ", used=" << used;
     size_t limit = this->limit();
     if (limit > 999999) {
         fs = 8;
@@ -475,7 +466,12 @@ void hash_vector_base::dump(std::ostream &out) {
     }
     for (size_t i = 0; i < hashsize; i++) {
         if (i % ls == 0) out << "\n";
-        out << std::setw(fs) << info->gethash(this, i);
+        if (*ctrl(i) == ctrl_empty)
+            out << std::setw(fs) << '.';
+        else if (*ctrl(i) == ctrl_deleted)
+            out << std::setw(fs) << 'x';
+        else
+            out << std::setw(fs) << info->gethash(this, i);
     }
     out << "\nerased=" << erased << std::endl;
 }
@@ -17,15 +17,22 @@
 
 namespace P4 {
 
+/// Hash index shared by hvec_map and hvec_set.  The elements themselves live in a vector
+/// in insertion order; this class maps keys to indexes in that vector.
+///
+/// The index is an open-addressing table in the style of SwissTable: each slot has a control
+/// byte that is either empty, deleted, or holds 7 bits of the key's hash.  Slots are probed a
+/// group at a time, matching the hash bits against all the control bytes of the group at once
+/// (with SSE2 where available), so most lookups touch only one group and the single element
+/// they are looking for.
 class hash_vector_base {
     struct internal;
     internal *info;
-    union {
-        uint8_t *s1;
-        uint16_t *s2;
-        uint32_t *s3;
-        // FIXME -- add uint64_t for vectors of more than 2**32 elements?
-    } hash;
+    /* The slots, a group at a time: the control bytes for the group followed by the index
+     * (plus 1) into the data for each slot, 1, 2, or 4 bytes each depending on the size of
+     * the data, so that probing a group usually touches a single cache line.
+     * FIXME -- add uint64_t indexes for vectors of more than 2**32 elements? */
+    uint8_t *table;
     static uint32_t gethash_s1(const hash_vector_base *, size_t);
     static uint32_t gethash_s2(const hash_vector_base *, size_t);
     static uint32_t gethash_s3(const hash_vector_base *, size_t);
@@ -34,14 +41,19 @@ class hash_vector_base {
     static void sethash_s3(hash_vector_base *, size_t, uint32_t);
     void allochash();
     void freehash();
+    size_t groupbytes() const;
+    size_t tablebytes() const;
+    int8_t *ctrl(size_t slot) const;
+    uint32_t getidx(size_t slot) const;
 
-    size_t hashsize;                 /* size of the hash array - always a power-of-2-minus-1 */
-    size_t collisions, log_hashsize; /* log(base 2) of hashsize+1 */
+    size_t hashsize;           /* number of slots - always a power of 2, at least one group */
+    size_t used, log_hashsize; /* slots not empty (in use or deleted); log(base 2) of hashsize */
 
  public:
     struct lookup_cache {
-        size_t slot;
-        size_t collisions;
+        size_t hash;       /* mixed hash of the key */
+        size_t slot;       /* slot found, or the slot to insert into if not found */
+        size_t collisions; /* number of groups probed before finishing */
         uint32_t getidx(const hash_vector_base *);
         const void *getkey(const hash_vector_base *);
         void *getval(hash_vector_base *);
@@ -50,6 +62,11 @@ class hash_vector_base {
     void dump(std::ostream &);
 #endif
 
+ private:
+    size_t probe(const void *key, lookup_cache *cache, size_t group, uint32_t skip) const;
+    size_t find_free(size_t hash) const;
+    void setslot(size_t slot, size_t hash, uint32_t idx);
+
  protected:
     size_t inuse;  /* number of elements in use in the table */
     bitvec erased; /* elements that have been erased */
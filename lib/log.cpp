@@ -44,7 +44,11 @@ namespace Detail {
 int verbosity = 0;
 int maximumLogLevel = 0;
 bool enableLoggingGlobally = true;
+#ifdef MULTITHREAD
+thread_local bool enableLoggingInContext = false;
+#else
 bool enableLoggingInContext = false;
+#endif  // MULTITHREAD
 
 // The time at which logging was initialized; used so that log messages can have
 // relative rather than absolute timestamps.
@@ -42,7 +42,12 @@ extern int maximumLogLevel;
 
 // Used to restrict logging to a specific IR context.
 extern bool enableLoggingGlobally;
-extern bool enableLoggingInContext;  // if enableLoggingGlobally is true, this is ignored.
+// if enableLoggingGlobally is true, this is ignored.
+#ifdef MULTITHREAD
+extern thread_local bool enableLoggingInContext;  // set per thread by the visitor context
+#else
+extern bool enableLoggingInContext;
+#endif  // MULTITHREAD
 
 // Look up the log level of @file.
 int fileLogLevel(const char *file);
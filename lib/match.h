@@ -40,6 +40,7 @@ struct match_t {
     explicit operator bool() const { return (word0 | word1) != 0; }
     bool operator==(const match_t &a) const { return word0 == a.word0 && word1 == a.word1; }
     bool operator!=(const match_t &a) const { return word0 != a.word0 || word1 != a.word1; }
+    friend size_t hash_value(const match_t &m) { return Util::Hash{}(m.word0, m.word1); }
     bool matches(big_int v) const {
         return (v | word1) == word1 && ((~v & word1) | word0) == word0;
     }
@@ -49,7 +49,7 @@ cstring SourcePosition::toString() const {
 //////////////////////////////////////////////////////////////////////////////////////////
 
 SourceInfo::SourceInfo(const InputSources *sources, SourcePosition start, SourcePosition end)
-    : sources(sources), start(start), end(end) {
+    : sources(sources) {
     BUG_CHECK(sources != nullptr, "Invalid InputSources in SourceInfo");
     if (!start.isValid() || !end.isValid()) {
         BUG("Invalid source position in SourceInfo %1%-%2% for %3%", start.toString(),
@@ -57,32 +57,85 @@ SourceInfo::SourceInfo(const InputSources *sources, SourcePosition start, Source
     }
     if (start > end)
         BUG("SourceInfo position start %1% after end %2%", start.toString(), end.toString());
+    this->start = sources->encode(start);
+    this->end = sources->encode(end);
 }
 
 SourceInfo::SourceInfo(const InputSources *sources, SourcePosition point)
     : SourceInfo(sources, point, point) {}
 
-SourceInfo::SourceInfo(cstring filename, int line, int column, cstring srcBrief) {
-    this->filename = filename;
-    this->line = line;
-    this->column = column;
-    this->srcBrief = srcBrief;
+SourceInfo::SourceInfo(cstring filename, int line, int column, cstring srcBrief)
+    : saved(new Saved{filename, line, column, srcBrief}), end(1) {}
+
+SourceInfo SourceInfo::fromOffsets(const InputSources *sources, unsigned start, unsigned end) {
+    BUG_CHECK(sources != nullptr, "Invalid InputSources in SourceInfo");
+    if (start > end || end > sources->text.size())
+        BUG("Invalid source offsets %1%-%2% in SourceInfo", start, end);
+    SourceInfo rv;
+    rv.sources = sources;
+    rv.start = start + 1;
+    rv.end = end + 1;
+    return rv;
+}
+
+SourcePosition SourceInfo::getStart() const {
+    return isValid() ? sources->decode(start) : SourcePosition();
+}
+
+SourcePosition SourceInfo::getEnd() const {
+    return isValid() ? sources->decode(end) : SourcePosition();
 }
 
 cstring SourceInfo::toString() const {
-    return absl::StrFormat("(%v)-(%v)", start.toString(), end.toString());
+    return absl::StrFormat("(%v)-(%v)", getStart().toString(), getEnd().toString());
 }
 
 std::ostream &operator<<(std::ostream &os, const SourceInfo &info) {
-    os << absl::StrFormat("(%v)-(%v)", info.start, info.end);
+    os << absl::StrFormat("(%v)-(%v)", info.getStart(), info.getEnd());
     return os;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-InputSources::InputSources() : sealed(false) {
-    mapLine("", 1);  // the first line read will be line 1 of stdin
-    contents.push_back("");
+// Lines not mapped by a line directive are lines of stdin.
+InputSources::InputSources() : sealed(false) {}
+
+void InputSources::indexLines() const {
+    if (indexed.load(std::memory_order_acquire) == text.size()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = indexed; (i = text.find('\n', i)) != std::string::npos;)
+        lineStarts.push_back(++i);
+    indexed.store(text.size(), std::memory_order_release);
+}
+
+unsigned InputSources::lineAt(unsigned offset) const {
+    indexLines();
+    return std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+}
+
+uint32_t InputSources::encode(SourcePosition position) const {
+    if (!position.isValid()) return 0;
+    unsigned line = position.getLineNumber(), column = position.getColumnNumber();
+    indexLines();
+    if (line <= lineStarts.size()) {
+        // the last column of a line is its newline, except for the last line
+        size_t lineEnd = line < lineStarts.size() ? lineStarts[line] - 1 : text.size();
+        if (column <= lineEnd - lineStarts[line - 1]) return lineStarts[line - 1] + column + 1;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    outside.push_back(position);
+    return (outside.size() - 1) | OUTSIDE;
+}
+
+SourcePosition InputSources::decode(uint32_t position) const {
+    if (position == 0) return SourcePosition();
+    if (position & OUTSIDE) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return outside.at(position & ~OUTSIDE);
+    }
+    unsigned offset = position - 1;
+    unsigned line = lineAt(offset);
+    return SourcePosition(line, offset - lineStarts[line - 1]);
 }
 
 void InputSources::addComment(SourceInfo srcInfo, bool singleLine, cstring body) {
@@ -102,63 +155,31 @@ void InputSources::seal() {
 }
 
 unsigned InputSources::lineCount() const {
-    int size = contents.size();
-    if (contents.back().empty()) {
-        // do not count the last line if it is empty.
-        size -= 1;
-        if (size < 0) BUG("Negative line count");
-    }
-    return size;
+    indexLines();
+    // do not count the last line if it is empty.
+    return lineStarts.size() - (lineStarts.back() == text.size());
 }
 
 // Append this text to the last line
 void InputSources::appendToLastLine(std::string_view text) {
     if (sealed) BUG("Appending to sealed InputSources");
     // Text should not contain any newline characters
-    for (size_t i = 0; i < text.size(); i++) {
-        char c = text[i];
-        if (c == '\n') BUG("Text contains newlines");
-    }
-    contents.back() += text;
+    if (text.find('\n') != std::string_view::npos) BUG("Text contains newlines");
+    this->text += text;
 }
 
 // Append a newline and start a new line
 void InputSources::appendNewline(std::string_view newline) {
     if (sealed) BUG("Appending to sealed InputSources");
-    contents.back() += newline;
-    contents.push_back("");  // start a new line
+    text += newline;
 }
 
 void InputSources::appendText(const char *text) {
     if (text == nullptr) BUG("Null text being appended");
-    std::string_view ref(text);
-
-    while (ref.size() > 0) {
-        auto nlPos = ref.find_first_of("\r\n");
-        if (nlPos == std::string_view::npos) {
-            appendToLastLine(ref);
-            break;
-        }
-
-        size_t toCut = nlPos;
-        if (toCut != 0) {
-            std::string_view nonnl(ref.data(), toCut);
-            appendToLastLine(nonnl);
-            ref.remove_prefix(toCut);
-        } else {
-            if (ref[0] == '\n') {
-                appendNewline("\n");
-                ref.remove_prefix(1);
-            } else if (ref.size() > 2 && ref[0] == '\r' && ref[1] == '\n') {
-                appendNewline("\r\n");
-                ref.remove_prefix(2);
-            } else {
-                // Just \r
-                appendToLastLine(ref.substr(0, 1));
-                ref.remove_prefix(1);
-            }
-        }
-    }
+    if (sealed) BUG("Appending to sealed InputSources");
+    // Lines end with \n (a lone \r does not end a line)
+    this->text += text;
+    if (this->text.size() >= OUTSIDE) BUG("Input too large");
 }
 
 std::string_view InputSources::getLine(unsigned lineNumber) const {
@@ -168,41 +189,51 @@ std::string_view InputSources::getLine(unsigned lineNumber) const {
         // don't throw: this code may be called by exceptions
         // reporting on elements that have no source position
     }
-    return contents.at(lineNumber - 1);
+    indexLines();
+    size_t start = lineStarts.at(lineNumber - 1);
+    size_t end = lineNumber < lineStarts.size() ? lineStarts[lineNumber] : text.size();
+    return std::string_view(text).substr(start, end - start);
 }
 
 void InputSources::mapLine(std::string_view file, unsigned originalSourceLineNo) {
     if (sealed) BUG("Changing mapping to sealed InputSources");
-    unsigned lineno = getCurrentLineNumber();
-    line_file_map.emplace(lineno, SourceFileLine(file, originalSourceLineNo));
+    // the start of the current line, found without indexing the lines
+    auto lineStart = text.rfind('\n');
+    lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+    line_file_map.emplace(lineStart, SourceFileLine(file, originalSourceLineNo));
 }
 
 SourceFileLine InputSources::getSourceLine(unsigned line) const {
-    auto it = line_file_map.upper_bound(line);
-    if (it == line_file_map.begin())
-        // There must be always something mapped to line 0
-        BUG("No source information for line %1%", line);
-    LOG3(line << " mapped to " << it->first << "," << it->second.toString());
+    if (line == 0) return SourceFileLine("", 0);
+    indexLines();
+    // lines past the end of the text may come from positions made up by tests
+    auto it = line_file_map.upper_bound(line <= lineStarts.size() ? lineStarts[line - 1]
+                                                                    : text.size());
+    if (it == line_file_map.begin()) return SourceFileLine("", line);
     --it;
-    LOG3(line << " corrected to " << it->first << "," << it->second.toString());
+    unsigned directiveLine = lineAt(it->first);
+    LOG3(line << " mapped to " << directiveLine << "," << it->second.toString());
     // For a source file such as
     // ----------
     // # 1 "x.p4"
     // parser start { }
     // ----------
     // The first line indicates that line 2 is the first line in x.p4
-    // line=2, it->first=1, it->second.sourceLine=1
+    // line=2, directiveLine=1, it->second.sourceLine=1
     // So we have to subtract one to get the real line number.
-    const auto nominalLine = line - it->first + it->second.sourceLine;
+    const auto nominalLine = line - directiveLine + it->second.sourceLine;
     const auto realLine = nominalLine > 0 ? nominalLine - 1 : 0;
     return SourceFileLine(it->second.fileName, realLine);
 }
 
-unsigned InputSources::getCurrentLineNumber() const { return contents.size(); }
+unsigned InputSources::getCurrentLineNumber() const {
+    indexLines();
+    return lineStarts.size();
+}
 
 SourcePosition InputSources::getCurrentPosition() const {
     unsigned line = getCurrentLineNumber();
-    unsigned column = contents.back().size();
+    unsigned column = text.size() - lineStarts.back();
     return SourcePosition(line, column);
 }
 
@@ -317,10 +348,10 @@ cstring InputSources::getBriefSourceFragment(const SourceInfo &position) const {
 
 cstring InputSources::toDebugString() const {
     std::stringstream builder;
-    for (const auto &line : contents) builder << line;
+    builder << text;
     builder << "---------------" << std::endl;
     for (const auto &lf : line_file_map)
-        builder << lf.first << ": " << lf.second.toString() << std::endl;
+        builder << lineAt(lf.first) << ": " << lf.second.toString() << std::endl;
     return {builder};
 }
 
@@ -338,12 +369,13 @@ cstring SourceInfo::toBriefSourceFragment() const {
 
 cstring SourceInfo::toPositionString() const {
     if (!isValid()) return ""_cs;
-    SourceFileLine position = sources->getSourceLine(start.getLineNumber());
+    SourceFileLine position = sources->getSourceLine(getStart().getLineNumber());
     return position.toString();
 }
 
 cstring SourceInfo::toSourcePositionData(unsigned *outLineNumber, unsigned *outColumnNumber) const {
-    SourceFileLine position = sources->getSourceLine(start.getLineNumber());
+    auto start = getStart();
+    SourceFileLine position = sources->getSourceLine(getStart().getLineNumber());
     if (outLineNumber != nullptr) {
         *outLineNumber = position.sourceLine;
     }
@@ -354,20 +386,20 @@ cstring SourceInfo::toSourcePositionData(unsigned *outLineNumber, unsigned *outC
 }
 
 SourceFileLine SourceInfo::toPosition() const {
-    return sources->getSourceLine(start.getLineNumber());
+    return sources->getSourceLine(getStart().getLineNumber());
 }
 
 SourceFileLine SourceInfo::toPositionEnd() const {
-    return sources->getSourceLine(end.getLineNumber());
+    return sources->getSourceLine(getEnd().getLineNumber());
 }
 
 cstring SourceInfo::getSourceFile() const {
-    auto sourceLine = sources->getSourceLine(start.getLineNumber());
+    auto sourceLine = sources->getSourceLine(getStart().getLineNumber());
     return sourceLine.fileName;
 }
 
 cstring SourceInfo::getLineNum() const {
-    SourceFileLine sourceLine = sources->getSourceLine(start.getLineNumber());
+    SourceFileLine sourceLine = sources->getSourceLine(getStart().getLineNumber());
     return Util::toString(sourceLine.sourceLine);
 }
 
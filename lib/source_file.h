@@ -21,7 +21,12 @@ limitations under the License.
 #ifndef LIB_SOURCE_FILE_H_
 #define LIB_SOURCE_FILE_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string_view>
 #include <vector>
@@ -127,14 +132,25 @@ interpreted relative to some InputSources.
 For a program element, the start is inclusive and the end is
 exclusive (the first position after the language element).
 
+Every IR node has a SourceInfo, so it is kept small: the positions are
+encoded in 32 bits each by the InputSources (see InputSources::encode),
+usually as offsets in its text, and their lines and columns are only
+computed when they are needed, e.g. for a diagnostic.
+
 SourceInfo can also be "invalid"
 */
 class SourceInfo final {
  public:
-    cstring filename = ""_cs;
-    int line = -1;
-    int column = -1;
-    cstring srcBrief = ""_cs;
+    /// The position of an IR node read from a JSON or binary IR file without the
+    /// InputSources it referred to.
+    struct Saved {
+        cstring filename = ""_cs;
+        int line = -1;
+        int column = -1;
+        cstring srcBrief = ""_cs;
+    };
+
+    /// Creates an "invalid" SourceInfo with a Saved position
     SourceInfo(cstring filename, int line, int column, cstring srcBrief);
     /// Creates an "invalid" SourceInfo
     SourceInfo() = default;
@@ -144,6 +160,13 @@ class SourceInfo final {
 
     SourceInfo(const InputSources *sources, SourcePosition start, SourcePosition end);
 
+    /// Creates a SourceInfo for the text of @p sources from offset @p start to offset
+    /// @p end (see InputSources::getCurrentOffset), without computing lines and columns.
+    static SourceInfo fromOffsets(const InputSources *sources, unsigned start, unsigned end);
+    static SourceInfo fromOffsets(const InputSources *sources, unsigned point) {
+        return fromOffsets(sources, point, point);
+    }
+
     SourceInfo(const SourceInfo &other) = default;
     SourceInfo &operator=(const SourceInfo &other) = default;
     ~SourceInfo() = default;
@@ -153,22 +176,36 @@ class SourceInfo final {
         However, if this or rhs is invalid, it is not taken into account */
     SourceInfo operator+(const SourceInfo &rhs) const {
         if (!this->isValid()) return rhs;
-        if (!rhs.isValid()) return *this;
-        SourcePosition s = start.min(rhs.start);
-        SourcePosition e = end.max(rhs.end);
-        return SourceInfo(sources, s, e);
+        SourceInfo rv(*this);
+        return rv += rhs;
     }
     SourceInfo &operator+=(const SourceInfo &rhs) {
         if (!isValid()) {
             *this = rhs;
         } else if (rhs.isValid()) {
-            start = start.min(rhs.start);
-            end = end.max(rhs.end);
+            if (sameText(rhs)) {
+                start = std::min(start, rhs.start);
+                end = std::max(end, rhs.end);
+            } else {
+                *this = SourceInfo(sources, getStart().min(rhs.getStart()),
+                                   getEnd().max(rhs.getEnd()));
+            }
         }
         return *this;
     }
 
-    bool operator==(const SourceInfo &rhs) const { return start == rhs.start && end == rhs.end; }
+    bool operator==(const SourceInfo &rhs) const {
+        if (!isValid() || !rhs.isValid()) return isValid() == rhs.isValid();
+        if (sameText(rhs)) return start == rhs.start && end == rhs.end;
+        return getStart() == rhs.getStart() && getEnd() == rhs.getEnd();
+    }
+
+    /// A SourceInfo for the point at the end of this one.
+    SourceInfo atEnd() const {
+        SourceInfo rv(*this);
+        rv.start = end;
+        return rv;
+    }
 
     cstring toString() const;
 
@@ -188,15 +225,18 @@ class SourceInfo final {
     SourceFileLine toPosition() const;
     SourceFileLine toPositionEnd() const;
 
-    bool isValid() const { return this->start.isValid(); }
+    bool isValid() const { return start != 0; }
     explicit operator bool() const { return isValid(); }
 
     cstring getSourceFile() const;
     cstring getLineNum() const;
 
-    const SourcePosition &getStart() const { return this->start; }
+    SourcePosition getStart() const;
 
-    const SourcePosition &getEnd() const { return this->end; }
+    SourcePosition getEnd() const;
+
+    /// The position read from a JSON or binary IR file, if any.
+    const Saved *getSaved() const { return start == 0 && end != 0 ? saved : nullptr; }
 
     /**
        True if this comes 'before' this source position.
@@ -206,7 +246,8 @@ class SourceInfo final {
     bool operator<(const SourceInfo &rhs) const {
         if (!rhs.isValid()) return false;
         if (!isValid()) return true;
-        return this->start < rhs.start;
+        if (sameText(rhs)) return start < rhs.start;
+        return getStart() < rhs.getStart();
     }
     inline bool operator>(const SourceInfo &rhs) const { return rhs.operator<(*this); }
     inline bool operator<=(const SourceInfo &rhs) const { return !this->operator>(rhs); }
@@ -215,9 +256,19 @@ class SourceInfo final {
     friend std::ostream &operator<<(std::ostream &os, const SourceInfo &info);
 
  private:
-    const InputSources *sources = nullptr;
-    SourcePosition start = SourcePosition();
-    SourcePosition end = SourcePosition();
+    /// The InputSources of a valid SourceInfo, or the Saved position of an invalid one
+    /// (which then has end != 0).
+    union {
+        const InputSources *sources = nullptr;
+        const Saved *saved;
+    };
+    /// The positions, encoded by InputSources::encode; 0 if invalid.
+    uint32_t start = 0;
+    uint32_t end = 0;
+
+    /// True if the positions of this and @p rhs are both offsets in the same text, and so
+    /// can be compared without decoding them.
+    bool sameText(const SourceInfo &rhs) const;
 };
 
 class IHasSourceInfo {
@@ -284,6 +335,12 @@ class Comment final : IHasDbPrint, IHasSourceInfo {
   The mutable part of the API is tailored for interaction with the lexer.
   After the lexer is done this object can be "sealed" and never changes again.
 
+  The text is kept in a single string.  The table of the offsets where lines
+  start is only computed (or extended) when a line number is needed, so the
+  lexer does not pay for it, and does not need to build SourcePositions for
+  each token (see getCurrentOffset).  It can be used from several threads
+  once the lexer is done.
+
   This class implements a singleton pattern: there is a single instance of this class.
 */
 class InputSources final {
@@ -300,6 +357,8 @@ class InputSources final {
     unsigned lineCount() const;
     SourcePosition getCurrentPosition() const;
     unsigned getCurrentLineNumber() const;
+    /// The offset of the end of the text appended so far.
+    unsigned getCurrentOffset() const { return text.size(); }
 
     /// Prevents further changes; currently not used.
     void seal();
@@ -333,17 +392,42 @@ class InputSources final {
     /// Append a newline and start a new line
     void appendNewline(std::string_view newline);
 
+    friend class SourceInfo;
+    /// Positions are encoded as 1 + their offset in the text, or (for positions which
+    /// are not in the text, e.g. made up by tests) as this bit plus their index in
+    /// `outside`.  0 is an invalid position.
+    static constexpr uint32_t OUTSIDE = 1U << 31;
+    uint32_t encode(SourcePosition position) const;
+    SourcePosition decode(uint32_t position) const;
+    /// Extend lineStarts to the end of the text.
+    void indexLines() const;
+    /// The number of the line containing @p offset.
+    unsigned lineAt(unsigned offset) const;
+
     /// Input program that is being currently compiled; there can be only one.
     bool sealed;
 
+    /// The start offsets of the lines with line directives, with the original file and
+    /// line number of the line following them.
     std::map<unsigned, SourceFileLine> line_file_map;
 
-    /// Each line also stores the end-of-line character(s)
-    std::vector<std::string> contents;
+    /// The text, with the end-of-line character(s) of each line.
+    std::string text;
+    /// The offsets of the start of each line, computed up to `indexed`.
+    mutable std::vector<uint32_t> lineStarts = {0};
+    mutable std::atomic<size_t> indexed = 0;
+    mutable std::deque<SourcePosition> outside;
+    /// Protects lineStarts and outside.
+    mutable std::mutex mutex;
     /// The commends found in the file.
     std::vector<Comment *> comments;
 };
 
+inline bool SourceInfo::sameText(const SourceInfo &rhs) const {
+    return sources == rhs.sources &&
+           ((start | end | rhs.start | rhs.end) & InputSources::OUTSIDE) == 0;
+}
+
 }  // namespace P4::Util
 
 namespace P4 {
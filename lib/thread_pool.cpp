@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "lib/thread_pool.h"
+
+#include <config.h>
+
+#include <cstdlib>
+
+#ifdef MULTITHREAD
+#include <pthread.h>
+#if HAVE_LIBGC
+#include <gc/gc.h>
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#endif  // MULTITHREAD
+
+#include "lib/crash.h"
+#include "lib/exceptions.h"
+
+namespace P4::Util {
+
+namespace {
+
+#ifdef MULTITHREAD
+/// Threads requested with setConcurrency() or P4C_THREADS; 0 means hardware concurrency.
+unsigned requestedThreads() {
+    static unsigned threads = [] {
+        const char *env = getenv("P4C_THREADS");
+        return env ? static_cast<unsigned>(atoi(env)) : 0U;
+    }();
+    return threads;
+}
+
+unsigned configuredThreads = ~0U;  // ~0U until set explicitly
+
+thread_local bool isWorkerThread = false;
+
+/// One parallelFor invocation.  Participants (the calling thread and any workers that join)
+/// claim indices from @next until it reaches @count.
+struct Job {
+    const std::function<void(size_t)> &fn;
+    size_t count;
+    std::atomic<size_t> next{0};
+    unsigned active = 1;       // participants currently running calls; guarded by Pool::lock
+    std::exception_ptr error;  // first exception thrown by a call; guarded by Pool::lock
+    std::condition_variable done;
+
+    Job(const std::function<void(size_t)> &fn, size_t count) : fn(fn), count(count) {}
+    bool exhausted() const { return next.load() >= count; }
+
+    /// Run calls until no unclaimed indices are left; called without holding the pool lock.
+    std::exception_ptr runCalls() {
+        std::exception_ptr rv;
+        for (size_t i; (i = next.fetch_add(1)) < count;) {
+            try {
+                fn(i);
+            } catch (...) {
+                if (!rv) rv = std::current_exception();
+                next = count;  // don't start any more calls
+            }
+        }
+        return rv;
+    }
+};
+
+class Pool {
+    std::mutex lock;
+    std::condition_variable haveWork;
+    std::deque<Job *> jobs;
+    std::vector<pthread_t> workers;  // worker threads started so far
+    unsigned useWorkers = 0;         // workers allowed to pick up jobs
+    bool stopping = false;           // workers should exit
+
+    Job *findJob() {
+        for (auto *job : jobs)
+            if (!job->exhausted()) return job;
+        return nullptr;
+    }
+
+    void finishCalls(Job &job, std::exception_ptr error) {
+        if (error && !job.error) job.error = error;
+        if (--job.active == 0) job.done.notify_all();
+    }
+
+    static void *workerMain(void *arg) {
+        auto *self = static_cast<std::pair<Pool *, unsigned> *>(arg);
+        Pool *pool = self->first;
+        unsigned index = self->second;
+        delete self;
+#if HAVE_LIBGC
+        GC_stack_base sb;
+        GC_get_stack_base(&sb);
+        GC_register_my_thread(&sb);
+#endif
+        register_thread();
+        isWorkerThread = true;
+        std::unique_lock<std::mutex> guard(pool->lock);
+        while (true) {
+            Job *job = nullptr;
+            pool->haveWork.wait(guard, [&] {
+                return pool->stopping ||
+                       (index < pool->useWorkers && (job = pool->findJob()) != nullptr);
+            });
+            if (pool->stopping) break;
+            ++job->active;
+            guard.unlock();
+            auto error = job->runCalls();
+            guard.lock();
+            pool->finishCalls(*job, error);
+        }
+        guard.unlock();
+#if HAVE_LIBGC
+        GC_unregister_my_thread();
+#endif
+        return nullptr;
+    }
+
+    void startWorkers(unsigned count) {
+        static bool init_mt = true;
+        if (init_mt) {
+#if HAVE_LIBGC
+            GC_allow_register_threads();
+#endif
+            atexit([] { ThreadPool::shutdown(); });
+            init_mt = false;
+        }
+        while (workers.size() < count) {
+            pthread_t tid;
+            pthread_attr_t attr;
+            int err;
+            // Visitors recurse deeply on big programs, so give workers a generous stack.
+            size_t stack_size = 1024 * 1024 * 64;  // 64MB
+            err = pthread_attr_init(&attr);
+            BUG_CHECK(!err, "Pthread Attribute initialization fail with error: %d", err);
+            err = pthread_attr_setstacksize(&attr, stack_size);
+            BUG_CHECK(!err, "Pthread Attribute Set Stack Size fail with error: %d", err);
+            err = pthread_create(&tid, &attr, workerMain,
+                                 new std::pair<Pool *, unsigned>(this, workers.size()));
+            BUG_CHECK(!err, "Pthread Creation fail with error: %d", err);
+            err = pthread_attr_destroy(&attr);
+            BUG_CHECK(!err, "Pthread Attribute destroy fail with error: %d", err);
+            workers.push_back(tid);
+        }
+    }
+
+ public:
+    void run(size_t count, const std::function<void(size_t)> &fn) {
+        Job job(fn, count);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            useWorkers = ThreadPool::concurrency() - 1;
+            startWorkers(useWorkers);
+            jobs.push_back(&job);
+        }
+        haveWork.notify_all();
+        auto error = job.runCalls();
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finishCalls(job, error);
+            job.done.wait(guard, [&] { return job.active == 0; });
+            for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+                if (*it == &job) {
+                    jobs.erase(it);
+                    break;
+                }
+            }
+        }
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    /// Stop and join all worker threads.  Does nothing while a parallelFor is running, which
+    /// happens when exit() is called from one of its calls.
+    void stop() {
+        std::vector<pthread_t> joining;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!jobs.empty() || isWorkerThread) return;
+            stopping = true;
+            joining.swap(workers);
+        }
+        haveWork.notify_all();
+        for (auto tid : joining) {
+            int err = pthread_join(tid, nullptr);
+            BUG_CHECK(!err, "Pthread join fail with error: %d", err);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = false;
+    }
+};
+
+Pool *thePool = nullptr;
+#endif  // MULTITHREAD
+
+}  // namespace
+
+unsigned ThreadPool::concurrency() {
+#ifdef MULTITHREAD
+    unsigned threads = configuredThreads != ~0U ? configuredThreads : requestedThreads();
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+#else
+    return 1;
+#endif
+}
+
+void ThreadPool::setConcurrency(unsigned threads) {
+#ifdef MULTITHREAD
+    configuredThreads = threads;
+#else
+    (void)threads;
+#endif
+}
+
+bool ThreadPool::inWorker() {
+#ifdef MULTITHREAD
+    return isWorkerThread;
+#else
+    return false;
+#endif
+}
+
+void ThreadPool::shutdown() {
+#ifdef MULTITHREAD
+    if (thePool) thePool->stop();
+#endif
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+#ifdef MULTITHREAD
+    if (count > 1 && !isWorkerThread && concurrency() > 1) {
+        static Pool *pool = thePool = new Pool;
+        pool->run(count, fn);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) fn(i);
+}
+
+}  // namespace P4::Util
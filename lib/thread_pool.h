@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LIB_THREAD_POOL_H_
+#define LIB_THREAD_POOL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace P4::Util {
+
+/// A process-wide pool of worker threads for running independent pieces of compiler work
+/// concurrently.  Worker threads are only started when the compiler is built with
+/// ENABLE_MULTITHREAD (which requires a garbage collector built with thread support);
+/// otherwise all work submitted to the pool runs serially on the calling thread, so code
+/// using the pool does not need to care how the compiler was built.
+class ThreadPool {
+ public:
+    ThreadPool() = delete;
+
+    /// @return the number of threads (including the calling thread) that parallelFor may use.
+    /// This is always 1 when the compiler is built without ENABLE_MULTITHREAD.
+    static unsigned concurrency();
+
+    /// Limit the number of threads used by the pool, including the calling thread.
+    /// 0 means use std::thread::hardware_concurrency().  The environment variable
+    /// P4C_THREADS sets the initial value.  Must not be called while parallel work is
+    /// running.
+    static void setConcurrency(unsigned threads);
+
+    /// @return true if called from one of the pool's worker threads.
+    static bool inWorker();
+
+    /// Call @fn(i) for each i in [0, @count), distributing the calls over the pool's worker
+    /// threads and the calling thread, and wait for all of them to complete.  Calls may run
+    /// in any order.  If any call throws, no further calls are started and the first exception
+    /// is rethrown on the calling thread once the calls already running have finished.
+    /// Nested calls made from a worker thread run serially on that worker.
+    static void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    /// Stop and join the pool's worker threads.  This is done automatically at exit; a later
+    /// parallelFor starts new workers.  Must not be called while parallel work is running.
+    static void shutdown();
+};
+
+}  // namespace P4::Util
+
+#endif /* LIB_THREAD_POOL_H_ */
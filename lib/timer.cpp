@@ -8,6 +8,7 @@
 #include <chrono>  // NOLINT linter forbids using chrono, but we don't have alternatives
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 
@@ -48,28 +49,33 @@ struct CounterEntry {
 struct RootCounter {
     /// The topmost counter.
     CounterEntry counter;
-    /// The most inner currently active counter.
-    CounterEntry *current;
     Clock::time_point start;
+    /// Guards the counter tree, which is shared by all threads.
+    std::mutex lock;
 
     static RootCounter &get() {
-        // TODO: not threadsafe currently. Instance of RootCounter could be thread_local:
-        //
-        // thread_local RootCounter root;
-        //
-        // however libgc cannot scan thread local data, which can lead to premature object
-        // garbage collection.
         static RootCounter ROOT;
-        ROOT.counter.duration = Clock::now() - ROOT.start;
         return ROOT;
     }
 
-    CounterEntry *getCurrent() const { return current; }
+    /// The most inner currently active counter of the calling thread. Durations measured on
+    /// different threads add up in the same tree, so they may exceed the wall-clock time of
+    /// their parent. The entries are owned by the tree, so libgc does not need to see this
+    /// thread-local pointer.
+    static CounterEntry *&current() {
+        thread_local CounterEntry *CURRENT = nullptr;
+        return CURRENT;
+    }
+
+    CounterEntry *getCurrent() {
+        auto *c = current();
+        return c != nullptr ? c : &counter;
+    }
 
-    void setCurrent(CounterEntry *c) { current = c; }
+    void setCurrent(CounterEntry *c) { current() = c; }
 
  private:
-    RootCounter() : counter(""), current(&counter) { start = Clock::now(); }
+    RootCounter() : counter("") { start = Clock::now(); }
 };
 
 }  // namespace
@@ -90,19 +96,28 @@ struct ScopedTimerCtx {
     CounterEntry *self = nullptr;
     Clock::time_point startTime;
 
-    explicit ScopedTimerCtx(const char *timerName)
-        : parent(RootCounter::get().getCurrent()), self(parent->openSubcounter(timerName)) {
+    explicit ScopedTimerCtx(const char *timerName) {
+        auto &root = RootCounter::get();
+        parent = root.getCurrent();
+        {
+            std::lock_guard<std::mutex> guard(root.lock);
+            self = parent->openSubcounter(timerName);
+        }
         startTime = Clock::now();
         // Push new active counter - the current active counter becomes the parent of this
         // counter, and this counter becomes the current active counter.
-        RootCounter::get().setCurrent(self);
+        root.setCurrent(self);
     }
     ~ScopedTimerCtx() {
         // Close the current timer invocation, measure time and add it to the counter.
         auto duration = Clock::now() - startTime;
-        self->add(duration);
+        auto &root = RootCounter::get();
+        {
+            std::lock_guard<std::mutex> guard(root.lock);
+            self->add(duration);
+        }
         // Restore previous counter as current.
-        RootCounter::get().setCurrent(parent);
+        root.setCurrent(parent);
     }
 };
 #pragma GCC diagnostic pop
@@ -146,7 +161,10 @@ static void formatCounters(std::vector<TimerEntry> &out, CounterEntry &current,
 std::vector<TimerEntry> getTimers() {
     std::vector<TimerEntry> ret;
     std::string namePrefix;
-    formatCounters(ret, RootCounter::get().counter, namePrefix, 0);
+    auto &root = RootCounter::get();
+    std::lock_guard<std::mutex> guard(root.lock);
+    root.counter.duration = Clock::now() - root.start;
+    formatCounters(ret, root.counter, namePrefix, 0);
     return ret;
 }
 
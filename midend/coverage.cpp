@@ -6,6 +6,7 @@
 
 #include <ostream>
 
+#include "lib/hash.h"
 #include "lib/log.h"
 
 namespace P4::Coverage {
@@ -18,6 +19,14 @@ bool SourceIdCmp::operator()(const IR::Node *s1, const IR::Node *s2) const {
     return s1->srcInfo < s2->srcInfo;
 }
 
+size_t SourceIdHash::operator()(const IR::Node *s) const {
+    if (!s->srcInfo.isValid()) {
+        return 0;
+    }
+    auto start = s->srcInfo.getStart();
+    return Util::Hash()(start.getLineNumber(), start.getColumnNumber());
+}
+
 CollectNodes::CollectNodes(CoverageOptions coverageOptions) : coverageOptions(coverageOptions) {}
 
 bool CollectNodes::preorder(const IR::BaseAssignmentStatement *stmt) {
@@ -27,6 +27,19 @@ struct SourceIdCmp {
     bool operator()(const IR::Node *s1, const IR::Node *s2) const;
 };
 
+/// Hash for IR nodes, consistent with SourceIdCmp. Nodes with the same start position in the
+/// program have the same hash.
+struct SourceIdHash {
+    size_t operator()(const IR::Node *s) const;
+};
+
+/// Equality for IR nodes, consistent with SourceIdCmp.
+struct SourceIdEqual {
+    bool operator()(const IR::Node *s1, const IR::Node *s2) const {
+        return !SourceIdCmp()(s1, s2) && !SourceIdCmp()(s2, s1);
+    }
+};
+
 /// Specifies general options and which IR nodes to track with this particular visitor.
 struct CoverageOptions {
     /// Cover IR::Statement.
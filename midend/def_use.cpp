@@ -33,13 +33,17 @@ int ComputeDefUse::uid_ctr = 0;
 const hvec_set<const ComputeDefUse::loc_t *> ComputeDefUse::empty;
 
 ComputeDefUse::ComputeDefUse()
-    : ResolutionContext(true), cached_locs(*new std::unordered_set<loc_t>), defuse(*new defuse_t) {
+    : ResolutionContext(true),
+      cached_locs(*new std::unordered_set<loc_t>),
+      loc_index(*new std::vector<const loc_t *>),
+      defuse(*new defuse_t) {
     joinFlows = true;
     visitDagOnce = false;
 }
 
 void ComputeDefUse::clear() {
     cached_locs.clear();
+    loc_index.clear();
     def_info.clear();
     defuse.defs.clear();
     defuse.uses.clear();
@@ -118,9 +122,9 @@ ComputeDefUse::def_info_t &ComputeDefUse::def_info_t::operator=(ComputeDefUse::d
 }
 
 void ComputeDefUse::def_info_t::flow_merge(def_info_t &a) {
-    defs.insert(a.defs.begin(), a.defs.end());
+    defs |= a.defs;
     live |= a.live;
-    valid_bit_defs.insert(a.valid_bit_defs.begin(), a.valid_bit_defs.end());
+    valid_bit_defs |= a.valid_bit_defs;
     for (auto &f : a.fields) fields[f.first].flow_merge(f.second);
     for (auto &s : a.slices) {
         split_slice(s.first);
@@ -134,15 +138,11 @@ void ComputeDefUse::def_info_t::flow_merge(def_info_t &a) {
 }
 
 bool ComputeDefUse::def_info_t::operator==(const def_info_t &a) const {
-    if (defs.size() != a.defs.size()) return false;
-    for (auto *l : defs)
-        if (!a.defs.count(l)) return false;
+    if (defs != a.defs) return false;
     if (live != a.live) return false;
     // Don't check the parent field as it is not set consistently (it is only set in
     // copy/move ctors above) and nothing appears to depend on it.  Should be removed?
-    if (valid_bit_defs.size() != a.valid_bit_defs.size()) return false;
-    for (auto *l : valid_bit_defs)
-        if (!a.valid_bit_defs.count(l)) return false;
+    if (valid_bit_defs != a.valid_bit_defs) return false;
     if (fields.size() != a.fields.size()) return false;
     for (auto &[field, info] : fields) {
         auto it = a.fields.find(field);
@@ -229,6 +229,14 @@ const ComputeDefUse::loc_t *ComputeDefUse::getLoc(const IR::Node *n, const Visit
     return &*cached_locs.insert(tmp).first;
 }
 
+size_t ComputeDefUse::defIndex(const loc_t *loc) {
+    if (!loc->index) {
+        loc_index.push_back(loc);
+        loc->index = loc_index.size();
+    }
+    return loc->index - 1;
+}
+
 /* sanity check on slices -- make sure keys do not overlap */
 void ComputeDefUse::def_info_t::slices_sanity() {
     auto prev = slices.end();
@@ -316,7 +324,7 @@ bool ComputeDefUse::preorder(const IR::P4Control *c) {
     bool is_type_declaration = !c->getTypeParameters()->empty();
     for (auto *p : c->getApplyParameters()->parameters)
         if (p->direction == IR::Direction::In || p->direction == IR::Direction::InOut) {
-            def_info[p].defs.insert(getLoc(p));
+            def_info[p].defs.setbit(defIndex(getLoc(p)));
             // Assume that all components of input parameters are live: we don't currently
             // propagate liveness innformation across parser/control block boundaries.
             if (!is_type_declaration) {
@@ -353,7 +361,7 @@ bool ComputeDefUse::preorder(const IR::P4Table *tbl) {
 
 bool ComputeDefUse::preorder(const IR::P4Action *act) {
     if (state == SKIPPING) return false;
-    for (auto *p : *act->parameters) def_info[p].defs.insert(getLoc(p));
+    for (auto *p : *act->parameters) def_info[p].defs.setbit(defIndex(getLoc(p)));
     IndentCtl::TempIndent indent;
     LOG5("ComputeDefUse" << uid << "(P4Action " << act->name << ")" << indent);
     visit(act->body, "body");
@@ -365,7 +373,7 @@ bool ComputeDefUse::preorder(const IR::Function *fn) {
     LOG5("ComputeDefUse" << uid << "(Function " << fn->name << ")" << indent);
     auto oldstate = state;
     if (state == SKIPPING) state = NORMAL;
-    for (auto *p : *fn->type->parameters) def_info[p].defs.insert(getLoc(p));
+    for (auto *p : *fn->type->parameters) def_info[p].defs.setbit(defIndex(getLoc(p)));
     visit(fn->body, "body");
     state = oldstate;
     return false;
@@ -377,7 +385,7 @@ bool ComputeDefUse::preorder(const IR::P4Parser *p) {
     LOG5("ComputeDefUse" << uid << "(P4Parser " << p->name << ")" << indent);
     for (auto *a : p->getApplyParameters()->parameters)
         if (a->direction == IR::Direction::In || a->direction == IR::Direction::InOut)
-            def_info[a].defs.insert(getLoc(a));
+            def_info[a].defs.setbit(defIndex(getLoc(a)));
     state = NORMAL;
     if (auto start = p->states.getDeclaration<IR::ParserState>("start"_cs)) {
         visit(start, "start");
@@ -414,7 +422,8 @@ bool ComputeDefUse::preorder(const IR::BaseAssignmentStatement *as) {
 // Add all definitions in the given def_info_t (whole and partial) as defs that reach
 // a use at the specified location
 void ComputeDefUse::add_uses(const loc_t *loc, def_info_t &di) {
-    for (auto *l : di.defs) {
+    for (auto i : di.defs) {
+        const auto *l = loc_index[i];
         defuse.uses[l->node].insert(loc);
         defuse.defs[loc->node].insert(l);
     }
@@ -467,7 +476,8 @@ const IR::Expression *ComputeDefUse::do_read(def_info_t &di, const IR::Expressio
     } else if (auto *m = ctxt->node->to<IR::Member>()) {
         if (auto *t = isValid(m, ctxt->parent)) {
             auto loc = getLoc(t);
-            for (auto *l : di.valid_bit_defs) {
+            for (auto i : di.valid_bit_defs) {
+                const auto *l = loc_index[i];
                 defuse.uses[l->node].insert(loc);
                 defuse.defs[loc->node].insert(l);
             }
@@ -519,7 +529,8 @@ const IR::Expression *ComputeDefUse::do_read(def_info_t &di, const IR::Expressio
         }
     }
     auto loc = getLoc(e);
-    for (auto *l : di.defs) {
+    for (auto i : di.defs) {
+        const auto *l = loc_index[i];
         defuse.uses[l->node].insert(loc);
         defuse.defs[loc->node].insert(l);
     }
@@ -544,7 +555,7 @@ const IR::Expression *ComputeDefUse::do_write(def_info_t &di, const IR::Expressi
     } else if (auto *m = ctxt->node->to<IR::Member>()) {
         if (auto *t = isValid(m, ctxt->parent)) {
             di.valid_bit_defs.clear();
-            di.valid_bit_defs.insert(getLoc(t));
+            di.valid_bit_defs.setbit(defIndex(getLoc(t)));
             return t;
         } else if (auto *str = m->expr->type->to<IR::Type_StructLike>()) {
             int fi = str->getFieldIndex(m->member.name);
@@ -565,7 +576,7 @@ const IR::Expression *ComputeDefUse::do_write(def_info_t &di, const IR::Expressi
             return e;
         } else if (auto *ts = m->expr->type->to<IR::Type_Array>()) {
             if (m->member.name == "next" || m->member.name == "last") {
-                di.defs.insert(getLoc(m));
+                di.defs.setbit(defIndex(getLoc(m)));
                 di.live.setrange(0, ts->getSize());
             } else if (m->member.name == "push_front" || m->member.name == "pop_front") {
                 int cnt = constIntMethodArg(ctxt->parent);
@@ -606,7 +617,7 @@ const IR::Expression *ComputeDefUse::do_write(def_info_t &di, const IR::Expressi
             if (!di.live) di.defs.clear();
             e = do_write(di.slices[le_bitrange(i, i)], ai, ctxt->parent);
         } else {
-            di.defs.insert(getLoc(ai));
+            di.defs.setbit(defIndex(getLoc(ai)));
             di.live.setrange(0, ai->left->type->to<IR::Type_Indexed>()->getSize());
             e = ai;
         }
@@ -614,7 +625,7 @@ const IR::Expression *ComputeDefUse::do_write(def_info_t &di, const IR::Expressi
     } else {
         di.defs.clear();
     }
-    di.defs.insert(getLoc(e));
+    di.defs.setbit(defIndex(getLoc(e)));
     di.fields.clear();
     di.slices.clear();
     if (auto *s = e->type->to<IR::Type_StructLike>()) {
@@ -58,6 +58,9 @@ class ComputeDefUse : public Inspector,
         const IR::Node *node;
         const loc_t *parent;
         mutable size_t computedHash = 0;
+        // 1 + dense index of this location if it is a definition, 0 if it has none yet;
+        // see ComputeDefUse::defIndex
+        mutable size_t index = 0;
         bool operator<(const loc_t &a) const {
             if (node != a.node) return node->id < a.node->id;
             if (!parent || !a.parent) return parent != nullptr;
@@ -92,6 +95,9 @@ class ComputeDefUse : public Inspector,
  private:
     // DANGER -- pointers to elements of this set must be stable
     std::unordered_set<loc_t> &cached_locs;
+    // definition locations, by their dense index; sets of definitions are bitvecs of these
+    std::vector<const loc_t *> &loc_index;
+    size_t defIndex(const loc_t *);
     const loc_t *getLoc(const Visitor::Context *ctxt);
     const loc_t *getLoc() { return getLoc(getChildContext()); }
     const loc_t *getLoc(const IR::Node *, const Visitor::Context *);
@@ -100,15 +106,16 @@ class ComputeDefUse : public Inspector,
     // flow tracking info about defs live at the point we are currently visiting
     struct def_info_t {
         // definitions of a symbol (or part of a symbol) visible at this point in the
-        // program.  `defs` will be empty if `live` is; if not those defs are visible only
+        // program, as a set of loc_t indexes, so merging flows is a word-wise OR.
+        // `defs` will be empty if `live` is; if not those defs are visible only
         // for those bits/elements/fields where live is set.
-        locset_t defs;
+        bitvec defs;
         bitvec live;
         // FIXME -- this parent field is never used and is not set consistently, so
         // appears to be useless?
         def_info_t *parent = nullptr;
         // track valid bit access for headers separate from the rest of the header
-        locset_t valid_bit_defs;
+        bitvec valid_bit_defs;
         // one of these maps will always be empty.
         std::map<cstring, def_info_t> fields;
         std::map<le_bitrange, def_info_t> slices;  // also used for arrays
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/analysis_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include "ir/ir.h"
+#include "ir/pass_manager.h"
+
+namespace P4::Test {
+
+using namespace P4::literals;
+
+namespace {
+
+/// A trivial analysis: the set of nodes in the tree.
+class KnownNodes : public CachedAnalysis {
+    const IR::Node *root = nullptr;
+
+ public:
+    std::set<const IR::Node *> nodes;
+    unsigned invalidations = 0;
+
+    void compute(const IR::Node *program) {
+        root = program;
+        nodes.clear();
+        forAllMatching<IR::Node>(program, [this](const IR::Node *n) { nodes.insert(n); });
+    }
+    bool known(const IR::Node *n) const { return nodes.count(n) != 0; }
+
+    cstring analysisName() const override { return "KnownNodes"_cs; }
+    const IR::Node *analyzedRoot() const override { return root; }
+    void nodeReplaced(const IR::Node *node, const IR::Node *replacement) override {
+        if (replacement && known(node)) nodes.insert(replacement);
+    }
+    void rootReplaced(const IR::Node *program) override { root = program; }
+    void invalidate() override {
+        root = nullptr;
+        ++invalidations;
+    }
+};
+
+class IncrementConstants : public Transform {
+ public:
+    explicit IncrementConstants(bool preserve) {
+        if (preserve) preserves<KnownNodes>();
+    }
+    const IR::Node *postorder(IR::Constant *c) override {
+        c->value += 1;
+        return c;
+    }
+};
+
+class PreservingPasses : public PassManager {
+ public:
+    explicit PreservingPasses(const std::initializer_list<VisitorRef> &init) {
+        addPasses(init);
+        preserves<KnownNodes>();
+    }
+};
+
+}  // namespace
+
+TEST(AnalysisManager, PreservedAndInvalidated) {
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Node *program = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+
+    KnownNodes known;
+    AnalysisManager analyses;
+    analyses.registerAnalysis(&known);
+    bool validAfterPreserving = false, validAfterNested = false;
+    auto checkValid = [&known](bool &valid) {
+        return [&known, &valid](const IR::Node *n) {
+            auto *add = n->to<IR::Add>();
+            valid = known.analyzedRoot() == n && known.known(add->left) && known.known(add->right);
+        };
+    };
+
+    PassManager passes({
+        [&known](const IR::Node *n) { known.compute(n); },
+        new IncrementConstants(true),
+        checkValid(validAfterPreserving),
+        new PreservingPasses({new IncrementConstants(false)}),
+        checkValid(validAfterNested),
+        new IncrementConstants(false),
+    });
+    passes.setAnalysisManager(&analyses);
+    auto *result = program->apply(passes)->to<IR::Add>();
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->left->to<IR::Constant>()->value, 4);
+
+    EXPECT_TRUE(validAfterPreserving);
+    EXPECT_TRUE(validAfterNested);
+    EXPECT_EQ(known.invalidations, 1u);
+    EXPECT_EQ(known.analyzedRoot(), nullptr);
+}
+
+TEST(AnalysisManager, UnchangedProgram) {
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Node *program = new IR::Neg(t, new IR::Constant(t, 1));
+
+    KnownNodes known;
+    AnalysisManager analyses;
+    analyses.registerAnalysis(&known);
+    bool valid = false;
+    PassManager passes({
+        [&known](const IR::Node *n) { known.compute(n); },
+        // returns the tree unchanged
+        [](const IR::Node *n) { return n; },
+        [&known, &valid](const IR::Node *n) { valid = known.analyzedRoot() == n; },
+    });
+    passes.setAnalysisManager(&analyses);
+    EXPECT_EQ(program->apply(passes), program);
+    EXPECT_TRUE(valid);
+    EXPECT_EQ(known.invalidations, 0u);
+    EXPECT_EQ(known.analyzedRoot(), program);
+}
+
+// A nested PassManager only uses the AnalysisManager of the PassManager running it while it
+// runs.
+TEST(AnalysisManager, NestedManagerNotKept) {
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Node *program = new IR::Neg(t, new IR::Constant(t, 1));
+
+    KnownNodes known;
+    AnalysisManager analyses;
+    analyses.registerAnalysis(&known);
+    PassManager inner({new IncrementConstants(false)});
+    PassManager outer({[&known](const IR::Node *n) { known.compute(n); }, &inner});
+    outer.setAnalysisManager(&analyses);
+    program = program->apply(outer);
+    EXPECT_EQ(known.invalidations, 1u);
+
+    known.compute(program);
+    program = program->apply(inner);
+    EXPECT_EQ(known.invalidations, 1u);
+    EXPECT_NE(known.analyzedRoot(), nullptr);
+}
+
+}  // namespace P4::Test
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "lib/arena.h"
+
+#include <gtest/gtest.h>
+
+#include <config.h>
+
+#include <cstdint>
+
+#include "ir/hash_cons.h"
+#include "ir/ir.h"
+#include "lib/compile_context.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+TEST(Arena, Allocate) {
+    Util::Arena arena;
+    EXPECT_EQ(arena.bytesAllocated(), 0u);
+    EXPECT_EQ(arena.bytesReserved(), 0u);
+
+    auto *a = static_cast<char *>(arena.allocate(3, 1));
+    auto *b = static_cast<char *>(arena.allocate(8, 8));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    EXPECT_GE(b, a + 3);
+    auto *c = arena.allocate(40, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    EXPECT_EQ(arena.bytesAllocated(), 51u);
+    size_t reserved = arena.bytesReserved();
+    EXPECT_GE(reserved, 51u);
+
+    // a big allocation gets its own chunk, and doesn't use up the current one
+    auto *big = static_cast<char *>(arena.allocate(4 * 1024 * 1024));
+    big[4 * 1024 * 1024 - 1] = 0;
+    EXPECT_GE(arena.bytesReserved(), reserved + 4 * 1024 * 1024);
+    reserved = arena.bytesReserved();
+    arena.allocate(16);
+    EXPECT_EQ(arena.bytesReserved(), reserved);
+}
+
+TEST(Arena, Destructors) {
+    struct Counted {
+        int *destroyed;
+        ~Counted() { ++*destroyed; }
+    };
+    auto destroy = [](void *obj) { static_cast<Counted *>(obj)->~Counted(); };
+    int destroyed = 0;
+    {
+        Util::Arena arena;
+        void *a = arena.allocate(sizeof(Counted));
+        void *b = arena.allocate(sizeof(Counted));
+        arena.destroyLater(a, new (a) Counted{&destroyed}, destroy);
+        arena.destroyLater(b, new (b) Counted{&destroyed}, destroy);
+        EXPECT_EQ(Util::Arena::owner(a), &arena);
+        // an object destroyed early is not destroyed again with the arena
+        static_cast<Counted *>(a)->~Counted();
+        arena.forget(a);
+        EXPECT_EQ(destroyed, 1);
+    }
+    EXPECT_EQ(destroyed, 2);
+}
+
+TEST(Arena, Scope) {
+    Util::Arena outer, inner;
+    EXPECT_EQ(Util::Arena::current(), nullptr);
+    {
+        Util::ArenaScope outerScope(&outer);
+        EXPECT_EQ(Util::Arena::current(), &outer);
+        {
+            Util::ArenaScope innerScope(&inner);
+            EXPECT_EQ(Util::Arena::current(), &inner);
+        }
+        EXPECT_EQ(Util::Arena::current(), &outer);
+    }
+    EXPECT_EQ(Util::Arena::current(), nullptr);
+}
+
+TEST(Arena, CompileContextNodes) {
+    AutoCompileContext context(new GTestContext(GTestContext::get()), /* useArena */ true);
+    auto *arena = Util::Arena::current();
+#if HAVE_IR_ARENA
+    ASSERT_NE(arena, nullptr);
+    size_t before = arena->bytesAllocated();
+    auto *c = new IR::Constant(42);
+    EXPECT_GE(arena->bytesAllocated(), before + sizeof(IR::Constant));
+    EXPECT_EQ(c->asInt(), 42);
+    auto *copy = c->clone();
+    EXPECT_GE(arena->bytesAllocated(), before + 2 * sizeof(IR::Constant));
+    EXPECT_TRUE(copy->equiv(*c));
+    EXPECT_TRUE(Util::Arena::isArenaMemory(c));
+    EXPECT_EQ(Util::Arena::owner(c), arena);
+    int onStack = 0;
+    EXPECT_FALSE(Util::Arena::isArenaMemory(&onStack));
+    // nodes with node members and nodes deleted early are each destroyed once
+    auto *st = new IR::Type_Struct(IR::ID("S"));
+    st->fields.push_back(new IR::StructField(IR::ID("f"), IR::Type_Bits::get(8)));
+    EXPECT_EQ(st->fields.size(), 1u);
+    delete copy;
+#else
+    EXPECT_EQ(arena, nullptr);
+#endif
+}
+
+TEST(Arena, HeapNodes) {
+    // nodes allocated outside of an arena are freed normally
+    auto *c = new IR::Constant(1);
+    EXPECT_FALSE(Util::Arena::isArenaMemory(c));
+    delete c;
+}
+
+TEST(Arena, HashConsClearedFirst) {
+    IR::HashCons::enable();
+    {
+        AutoCompileContext context(new GTestContext(GTestContext::get()), /* useArena */ true);
+        auto *arena = Util::Arena::current();
+        // the hash-consing table refers to nodes in the arena, so it must be cleared while the
+        // arena is still alive; callbacks run in reverse order, so this one runs after the clear
+        AutoCompileContext::innermost()->atEnd([arena]() {
+            EXPECT_EQ(Util::Arena::current(), arena);
+            EXPECT_EQ(IR::HashCons::size(), 0u);
+        });
+        IR::HashCons::make<IR::Constant>(IR::Type_Bits::get(8), 1);
+        EXPECT_EQ(IR::HashCons::size(), 1u);
+    }
+    EXPECT_EQ(IR::HashCons::size(), 0u);
+    IR::HashCons::enable(false);
+}
+
+}  // namespace P4::Test
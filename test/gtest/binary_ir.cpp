@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "ir/binary_generator.h"
+#include "ir/binary_loader.h"
+#include "ir/ir.h"
+#include "ir/json_generator.h"
+#include "lib/exceptions.h"
+
+namespace P4::Test {
+
+using namespace P4::literals;
+
+namespace {
+
+template <typename T>
+void roundTrip(const T &data, T &copy) {
+    std::stringstream ss;
+    BinaryGenerator(ss).emit(data);
+    auto bytes = ss.str();
+    BinaryLoader loader(bytes.data(), bytes.size());
+    ASSERT_TRUE(loader);
+    loader >> copy;
+}
+
+}  // namespace
+
+TEST(BinaryIR, Nodes) {
+    auto *t = IR::Type_Bits::get(16, true);
+    auto *c = new IR::Constant(t, -5);
+    const IR::Expression *e1 = new IR::Add(t, c, new IR::Mul(t, c, new IR::Constant(t, 1)));
+    IR::Vector<IR::Node> objects;
+    objects.push_back(
+        new IR::Declaration_Constant(IR::ID(Util::SourceInfo(), "a"_cs, "orig_a"_cs), t, e1));
+    objects.push_back(new IR::Declaration_Constant(IR::ID("b"), t, c));
+    objects.push_back(new IR::BlockStatement({new IR::Declaration_Variable(IR::ID("v"), t)}));
+    const IR::P4Program *program = new IR::P4Program(objects);
+
+    const IR::P4Program *copy = nullptr;
+    roundTrip(program, copy);
+    ASSERT_NE(copy, nullptr);
+    EXPECT_TRUE(program->equiv(*copy));
+    // loaded nodes get new ids, as the saved ones may belong to other nodes of this process
+    EXPECT_NE(copy->id, program->id);
+
+    ASSERT_EQ(copy->objects.size(), 3u);
+    auto *a = copy->objects.at(0)->to<IR::Declaration_Constant>();
+    auto *b = copy->objects.at(1)->to<IR::Declaration_Constant>();
+    auto *block = copy->objects.at(2)->to<IR::BlockStatement>();
+    ASSERT_TRUE(a && b && block);
+    EXPECT_NE(block->getDeclByName("v"_cs), nullptr);
+    EXPECT_EQ(a->name.originalName, "orig_a");
+    // shared nodes are read back once
+    auto *add = a->initializer->to<IR::Add>();
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->left, add->right->to<IR::Mul>()->left);
+    EXPECT_EQ(add->left, b->initializer);
+    EXPECT_EQ(add->left->to<IR::Constant>()->value, -5);
+
+    std::stringstream json, binary;
+    JSONGenerator(json).emit(program);
+    BinaryGenerator(binary).emit(program);
+    EXPECT_LT(binary.str().size() * 4, json.str().size());
+}
+
+TEST(BinaryIR, Values) {
+    std::vector<string_map<std::string>> strings, stringsCopy;
+    strings.resize(2);
+    strings[0]["x"] = "\ttab";
+    strings[1]["x"] = "";
+    strings[1]["\x1c"] = "esc";
+    roundTrip(strings, stringsCopy);
+    EXPECT_EQ(strings, stringsCopy);
+
+    std::map<big_int, bitvec> bits, bitsCopy;
+    bits[big_int(1) << 100].setrange(100, 100);
+    bits[-1] = bitvec(1);
+    bits[0];
+    roundTrip(bits, bitsCopy);
+    EXPECT_EQ(bits, bitsCopy);
+
+    std::vector<std::variant<int, cstring, std::optional<unsigned>>> variants, variantsCopy;
+    variants.emplace_back(-2);
+    variants.emplace_back("foobar"_cs);
+    variants.emplace_back(cstring());
+    variants.emplace_back(std::optional<unsigned>(7));
+    variants.emplace_back(std::optional<unsigned>());
+    variants.emplace_back("foobar"_cs);
+    roundTrip(variants, variantsCopy);
+    EXPECT_EQ(variants, variantsCopy);
+}
+
+TEST(BinaryIR, SourcePositions) {
+    auto *sources = new Util::InputSources;
+    sources->mapLine("prog.p4", 1);
+    sources->appendText("const bit<8> a = 1;\nconst bit<8> b = 2;\n");
+    auto *c = new IR::Constant(Util::SourceInfo(sources, Util::SourcePosition(2, 17),
+                                                Util::SourcePosition(2, 18)),
+                               2);
+
+    std::stringstream ss;
+    BinaryGenerator(ss, BinaryIR::SourcePositions).emit(c);
+    auto bytes = ss.str();
+    BinaryLoader loader(bytes.data(), bytes.size());
+    ASSERT_TRUE(loader);
+    EXPECT_TRUE(loader.hasSourcePositions());
+    loader.setSources(sources);
+    const IR::Constant *copy = nullptr;
+    loader >> copy;
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->srcInfo.getStart(), c->srcInfo.getStart());
+    EXPECT_EQ(copy->srcInfo.getEnd(), c->srcInfo.getEnd());
+    EXPECT_EQ(copy->srcInfo.toPosition().fileName, "prog.p4");
+
+    // positions past the end of the sources are rejected
+    auto *shorter = new Util::InputSources;
+    shorter->appendText("const bit<8> a = 1;\n");
+    BinaryLoader mismatched(bytes.data(), bytes.size());
+    mismatched.setSources(shorter);
+    const IR::Node *node = nullptr;
+    EXPECT_THROW(mismatched >> node, Util::CompilationError);
+}
+
+TEST(BinaryIR, InvalidInput) {
+    std::string json = "{ \"Node_ID\" : 1 }";
+    EXPECT_FALSE(BinaryLoader(json.data(), json.size()));
+
+    std::stringstream ss;
+    BinaryGenerator(ss).emit(new IR::Neg(new IR::Constant(1)));
+    auto bytes = ss.str();
+    BinaryLoader truncated(bytes.data(), bytes.size() - 1);
+    ASSERT_TRUE(truncated);
+    const IR::Node *node = nullptr;
+    EXPECT_THROW(truncated >> node, Util::CompilationError);
+}
+
+}  // namespace P4::Test
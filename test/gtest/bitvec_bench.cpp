@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Microbenchmarks for the bulk bitvec operations.  Each benchmark runs the operation on
+// bitvecs of a few sizes -- from inline (at most 256 bits) to large heap allocated ones --
+// once with the kernels selected for this CPU and once with the portable scalar kernels,
+// and records the time per operation as a test property.  They are built into
+// gtestp4c-bench, not into gtestp4c.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "lib/bitvec.h"
+
+namespace P4::Test {
+
+namespace {
+
+bitvec randomBits(std::mt19937 &rng, size_t bits) {
+    bitvec rv;
+    for (size_t i = 0; i < bits; ++i)
+        if (rng() & 1) rv.setbit(i);
+    return rv;
+}
+
+/// Restores the kernels in use when it goes out of scope, even if a benchmark fails.
+class RestoreBulkOps {
+    const bv::bulk_ops *saved = bv::bulk_ops::active;
+
+ public:
+    RestoreBulkOps() = default;
+    RestoreBulkOps(const RestoreBulkOps &) = delete;
+    RestoreBulkOps &operator=(const RestoreBulkOps &) = delete;
+    ~RestoreBulkOps() { bv::bulk_ops::active = saved; }
+};
+
+/// Run @p op @p iterations times with each of the available kernels, and record how long
+/// each call took on average, in ns.
+void bench(const char *name, size_t bits, int iterations, const std::function<void()> &op) {
+    RestoreBulkOps restore;
+    const auto *active = bv::bulk_ops::active;
+    for (const auto *ops : {active, &bv::bulk_ops::scalar}) {
+        bv::bulk_ops::active = ops;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) op();
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        ::testing::Test::RecordProperty(absl::StrCat(name, "_", bits, "_", ops->name, "_ns"),
+                                        std::to_string(elapsed.count() / iterations));
+        if (active == &bv::bulk_ops::scalar) break;
+    }
+}
+
+constexpr size_t sizes[] = {64, 256, 1024, 8192};
+
+int iterationsFor(size_t bits) { return 4000000 / bits + 1000; }
+
+}  // namespace
+
+TEST(BitvecBench, BinaryOps) {
+    std::mt19937 rng(42);
+    for (size_t bits : sizes) {
+        bitvec a = randomBits(rng, bits), b = randomBits(rng, bits);
+        volatile bool sink = false;
+        int n = iterationsFor(bits);
+        bench("or", bits, n, [&] {
+            bitvec t(a);
+            sink = t |= b;
+        });
+        bench("and", bits, n, [&] {
+            bitvec t(a);
+            sink = t &= b;
+        });
+        bench("andnot", bits, n, [&] {
+            bitvec t(a);
+            sink = t -= b;
+        });
+        bench("intersects", bits, n, [&] { sink = a.intersects(b); });
+        bench("equal", bits, n, [&] { sink = a == bitvec(a); });
+        EXPECT_EQ(a | b, b | a);
+    }
+}
+
+TEST(BitvecBench, Scans) {
+    std::mt19937 rng(42);
+    for (size_t bits : sizes) {
+        bitvec dense = randomBits(rng, bits);
+        // a sparse vector with one bit in each 1024 bit chunk, and one at the end
+        bitvec sparse;
+        for (size_t i = 0; i < bits; i += 1024) sparse.setbit(i + rng() % 1024 % (bits - i));
+        sparse.setbit(bits - 1);
+        // all zero, but with room for the given number of bits
+        bitvec zeros(bits - 1, 1);
+        zeros.clrbit(bits - 1);
+        volatile int sink = 0;
+        int n = iterationsFor(bits);
+        bench("popcount", bits, n, [&] { sink = dense.popcount(); });
+        bench("ffs_sparse", bits, n, [&] { sink = sparse.ffs(1); });
+        bench("iterate", bits, n / 10, [&] {
+            for (int i : sparse) sink = i;
+        });
+        bench("empty", bits, n, [&] { sink = zeros.empty(); });
+        EXPECT_EQ(sparse.max().index(), int(bits) - 1);
+    }
+}
+
+}  // namespace P4::Test
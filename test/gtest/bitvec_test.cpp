@@ -7,6 +7,9 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 namespace P4::Test {
 
 TEST(Bitvec, Shift) {
@@ -129,4 +132,91 @@ TEST(Bitvec, io) {
     EXPECT_EQ(a, b);
 }
 
+TEST(Bitvec, inlineAndHeap) {
+    // 256 bits fit in the inline buffer, one more bit needs a heap buffer
+    bitvec a(0, 256);
+    bitvec b = a;
+    b.setbit(256);
+    EXPECT_EQ(a.popcount(), 256);
+    EXPECT_EQ(b.popcount(), 257);
+    EXPECT_NE(a, b);
+    b.clrbit(256);
+    EXPECT_EQ(a, b);
+    b.setbit(1000);
+    b >>= 800;
+    EXPECT_EQ(b.popcount(), 1);
+    EXPECT_EQ(b.ffs(), 200);
+    bitvec c(std::move(b));
+    EXPECT_EQ(c.ffs(), 200);
+    EXPECT_TRUE(b.empty());  // NOLINT(bugprone-use-after-move)
+}
+
+namespace {
+
+/// Random bitvec with about @p density percent of the first @p bits bits set, and
+/// the reference vector<bool> of its bits.
+bitvec randomBitvec(std::mt19937 &rng, size_t bits, int density, std::vector<bool> &ref) {
+    bitvec rv;
+    ref.assign(bits, false);
+    for (size_t i = 0; i < bits; ++i) {
+        if (int(rng() % 100) < density) {
+            rv.setbit(i);
+            ref[i] = true;
+        }
+    }
+    return rv;
+}
+
+void checkBulkOps(std::mt19937 &rng) {
+    for (size_t abits : {0, 60, 64, 200, 256, 257, 300, 640, 1000}) {
+        for (size_t bbits : {0, 64, 256, 257, 700}) {
+            for (int density : {0, 3, 50, 100}) {
+                std::vector<bool> ra, rb;
+                bitvec a = randomBitvec(rng, abits, density, ra);
+                bitvec b = randomBitvec(rng, bbits, 50, rb);
+                size_t n = std::max(abits, bbits);
+                ra.resize(n), rb.resize(n);
+                bitvec vor = a | b, vand = a & b, vandnot = a - b, vxor = a ^ b;
+                int count = 0;
+                bool intersects = false, contains = true;
+                for (size_t i = 0; i < n; ++i) {
+                    ASSERT_EQ(vor[i], ra[i] || rb[i]);
+                    ASSERT_EQ(vand[i], ra[i] && rb[i]);
+                    ASSERT_EQ(vandnot[i], ra[i] && !rb[i]);
+                    ASSERT_EQ(vxor[i], ra[i] != rb[i]);
+                    count += ra[i];
+                    intersects |= ra[i] && rb[i];
+                    contains &= ra[i] || !rb[i];
+                }
+                EXPECT_EQ(a.popcount(), count);
+                EXPECT_EQ(a.empty(), count == 0);
+                EXPECT_EQ(a.intersects(b), intersects);
+                EXPECT_EQ(a.contains(b), contains);
+                EXPECT_EQ(a == b, ra == rb);
+                EXPECT_EQ(bitvec(a) |= b, vor != a);
+                EXPECT_EQ(bitvec(a) &= b, vand != a);
+                EXPECT_EQ(bitvec(a) -= b, vandnot != a);
+                int expected = 0;
+                for (int i : a) {
+                    while (!ra[expected]) ++expected;
+                    ASSERT_EQ(i, expected++);
+                }
+                EXPECT_EQ(a.ffs(), count ? a.min().index() : -1);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST(Bitvec, bulkOps) {
+    std::mt19937 rng(1);
+    checkBulkOps(rng);
+    // and again with the portable kernels, if the CPU has vectorized ones
+    auto *active = bv::bulk_ops::active;
+    bv::bulk_ops::active = &bv::bulk_ops::scalar;
+    checkBulkOps(rng);
+    bv::bulk_ops::active = active;
+}
+
 }  // namespace P4::Test
@@ -0,0 +1,235 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/compileServer.h"
+
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "frontends/common/options.h"
+#include "frontends/common/parseInput.h"
+#include "frontends/p4/frontend.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+
+namespace P4::Test {
+
+namespace {
+
+/// Stands in for a compiler: prints its working directory and arguments, and exits with
+/// the number of arguments, or aborts if one of them is `crash`.
+int echoArgs(int argc, char *const argv[]) {
+    std::cout << std::filesystem::current_path().string();
+    for (int i = 0; i < argc; ++i) {
+        if (std::string(argv[i]) == "crash") abort();
+        std::cout << ' ' << argv[i];
+    }
+    std::cout << std::endl;
+    return argc;
+}
+
+/// A compiler running the frontend on the program named on its command line.
+int runFrontEnd(int argc, char *const argv[]) {
+    AutoCompileContext context(new P4CContextWithOptions<CompilerOptions>);
+    auto &options = P4CContextWithOptions<CompilerOptions>::get().options();
+    options.langVersion = CompilerOptions::FrontendVersion::P4_16;
+    if (options.process(argc, argv) != nullptr) options.setInputFile();
+    if (::P4::errorCount() > 0) return 1;
+    const auto *program = P4::parseP4File(options);
+    if (program != nullptr && ::P4::errorCount() == 0) P4::FrontEnd().run(options, program);
+    return ::P4::errorCount() > 0;
+}
+
+class CompileServerTest : public ::testing::Test {
+ protected:
+    std::filesystem::path dir, socket;
+    pid_t server = -1;
+
+    /// The compiler the server runs.
+    virtual CompileServer::Compile compiler() const { return echoArgs; }
+
+    void SetUp() override {
+        char name[] = "/tmp/compile_server_XXXXXX";
+        ASSERT_NE(mkdtemp(name), nullptr);
+        dir = name;
+        socket = dir / "socket";
+        CompileServer::Options options;
+        options.socket = socket;
+        options.workers = 2;
+        std::cout.flush();
+        server = fork();
+        ASSERT_GE(server, 0);
+        if (server == 0) _exit(CompileServer(options).run(compiler()));
+        for (int i = 0; i < 500 && !std::filesystem::is_socket(socket); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    void TearDown() override {
+        if (server > 0) {
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+        }
+        std::filesystem::remove_all(dir);
+    }
+
+    /// Compile @p args on the server.  @return the exit status and what was printed on the
+    /// standard output and error.
+    std::pair<std::optional<int>, std::string> compile(const std::vector<std::string> &args) {
+        int out[2];
+        EXPECT_EQ(pipe(out), 0);
+        // the server may not be listening yet
+        std::optional<int> status;
+        for (int i = 0; i < 100; ++i) {
+            if ((status = compileOnServer(socket, args, 0, out[1], out[1]))) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        close(out[1]);
+        std::string output;
+        char buffer[256];
+        for (ssize_t n; (n = read(out[0], buffer, sizeof(buffer))) > 0;) output.append(buffer, n);
+        close(out[0]);
+        return {status, output};
+    }
+};
+
+}  // namespace
+
+TEST_F(CompileServerTest, Compile) {
+    auto [status, output] = compile({"p4test", "prog.p4"});
+    EXPECT_EQ(status, 5);
+    EXPECT_EQ(output, std::filesystem::current_path().string() +
+                          " p4test --builtin-cpp --precompiled-header " + socket.string() +
+                          ".pch prog.p4\n");
+    EXPECT_TRUE(std::filesystem::is_directory(socket.string() + ".pch"));
+    // only the user running the server can connect
+    EXPECT_EQ(std::filesystem::status(socket).permissions() & std::filesystem::perms::all,
+              std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+}
+
+TEST_F(CompileServerTest, ClientEntryPoint) {
+    // wait for the server
+    EXPECT_EQ(compile({"p4test"}).first, 4);
+    int out[2];
+    ASSERT_EQ(pipe(out), 0);
+    std::cout.flush();
+    pid_t client = fork();
+    ASSERT_GE(client, 0);
+    if (client == 0) {
+        dup2(out[1], 1);
+        close(out[0]);
+        close(out[1]);
+        std::string socketName = socket.string();
+        const char *argv[] = {"p4test", "--client", socketName.c_str(), "prog.p4"};
+        _exit(compileAsClient(4, const_cast<char **>(argv)).value_or(-1));
+    }
+    close(out[1]);
+    std::string output;
+    char buffer[256];
+    for (ssize_t n; (n = read(out[0], buffer, sizeof(buffer))) > 0;) output.append(buffer, n);
+    close(out[0]);
+    int status;
+    ASSERT_EQ(waitpid(client, &status, 0), client);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 5);
+    EXPECT_EQ(output, std::filesystem::current_path().string() +
+                          " p4test --builtin-cpp --precompiled-header " + socket.string() +
+                          ".pch prog.p4\n");
+
+    const char *local[] = {"p4test", "prog.p4"};
+    EXPECT_EQ(compileAsClient(2, const_cast<char **>(local)), std::nullopt);
+}
+
+TEST_F(CompileServerTest, ConcurrentClients) {
+    std::vector<std::thread> clients;
+    std::vector<std::pair<std::optional<int>, std::string>> results(4);
+    for (size_t i = 0; i < results.size(); ++i)
+        clients.emplace_back([&, i] {
+            std::vector<std::string> args = {"p4test"};
+            for (size_t j = 0; j <= i; ++j) args.push_back("a" + std::to_string(i));
+            results[i] = compile(args);
+        });
+    for (auto &client : clients) client.join();
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].first, int(i) + 5);
+        EXPECT_NE(results[i].second.find(" a" + std::to_string(i) + "\n"), std::string::npos);
+    }
+}
+
+TEST_F(CompileServerTest, Crash) {
+    EXPECT_EQ(compile({"p4test", "crash"}).first, 128 + SIGABRT);
+    // the server is still running
+    EXPECT_EQ(compile({"p4test"}).first, 4);
+}
+
+TEST_F(CompileServerTest, Stop) {
+    EXPECT_EQ(compile({"p4test"}).first, 4);
+    EXPECT_TRUE(stopCompileServer(socket));
+    int status;
+    ASSERT_EQ(waitpid(server, &status, 0), server);
+    server = -1;
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_FALSE(std::filesystem::exists(socket));
+    EXPECT_EQ(compileOnServer(socket, {"p4test"}), std::nullopt);
+    EXPECT_FALSE(stopCompileServer(socket));
+}
+
+/// Compiles real programs on a server running the frontend.
+class CompileServerFrontEndTest : public CompileServerTest {
+ protected:
+    CompileServer::Compile compiler() const override { return runFrontEnd; }
+
+    void write(const std::string &name, const std::string &text) {
+        std::ofstream(dir / name) << text;
+    }
+};
+
+TEST_F(CompileServerFrontEndTest, CompileProgram) {
+    write("inc.p4", "const bit<8> A = 1;\n");
+    write("prog.p4", "#include \"inc.p4\"\nconst bit<8> B = A + 1;\n");
+    write("bad.p4", "#include \"inc.p4\"\nconst bit<8> C = D;\n");
+
+    auto [status, output] = compile({"p4test", (dir / "prog.p4").string()});
+    EXPECT_EQ(status, 0);
+    EXPECT_EQ(output, "");
+    // the server kept the parsed header
+    EXPECT_FALSE(std::filesystem::is_empty(socket.string() + ".pch"));
+
+    // errors are reported on the client's standard error
+    std::tie(status, output) = compile({"p4test", (dir / "bad.p4").string()});
+    EXPECT_EQ(status, 1);
+    EXPECT_NE(output.find("bad.p4(2)"), std::string::npos) << output;
+    EXPECT_NE(output.find("D"), std::string::npos) << output;
+
+    // and a later compilation is not affected by them
+    EXPECT_EQ(compile({"p4test", (dir / "prog.p4").string()}).first, 0);
+}
+
+TEST(CompileServer, ParseCommandLine) {
+    const char *compile[] = {"p4test", "--server-workers", "2", "prog.p4"};
+    EXPECT_EQ(CompileServer::parseCommandLine(4, const_cast<char **>(compile)), std::nullopt);
+
+    const char *serve[] = {"p4test", "--server", "s", "--server-workers", "3",
+                           "--server-cache", "c"};
+    auto options = CompileServer::parseCommandLine(7, const_cast<char **>(serve));
+    ASSERT_TRUE(options);
+    EXPECT_EQ(options->socket, "s");
+    EXPECT_EQ(options->workers, 3U);
+    EXPECT_EQ(options->headerCache, "c");
+
+    const char *extra[] = {"p4test", "--server", "s", "prog.p4"};
+    options = CompileServer::parseCommandLine(4, const_cast<char **>(extra));
+    ASSERT_TRUE(options);
+    EXPECT_TRUE(options->socket.empty());
+}
+
+}  // namespace P4::Test
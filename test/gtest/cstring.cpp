@@ -7,6 +7,11 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+#include "lib/thread_pool.h"
+
 namespace P4::Test {
 
 using namespace P4::literals;
@@ -147,4 +152,35 @@ TEST(cstring, get_cached) {
     EXPECT_FALSE(cstring::get_cached("test").isNullOrEmpty());
 }
 
+/// Interns the same strings from several threads at once, checking that every thread gets the
+/// same pointer for each string.  Threads are only used when the compiler is built with
+/// ENABLE_MULTITHREAD.
+TEST(cstring, concurrentIntern) {
+    const size_t stringCount = 20000;
+    const unsigned threads = 4;
+
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < stringCount; ++i)
+        strings.push_back("concurrentIntern." + std::to_string(i));
+    // each task interns all strings, starting at a different offset, so that tasks race
+    // both to insert new strings and to look up ones inserted by other tasks
+    std::vector<std::vector<const char *>> interned(threads,
+                                                    std::vector<const char *>(stringCount));
+
+    Util::ThreadPool::setConcurrency(threads);
+    Util::ThreadPool::parallelFor(threads, [&](size_t task) {
+        for (size_t j = 0; j < stringCount; ++j) {
+            size_t i = (j + task * stringCount / threads) % stringCount;
+            interned[task][i] = cstring(strings[i]).c_str();
+        }
+    });
+    Util::ThreadPool::setConcurrency(0);
+
+    for (size_t i = 0; i < stringCount; ++i) {
+        ASSERT_EQ(interned[0][i], cstring::get_cached(strings[i]).c_str());
+        for (unsigned task = 1; task < threads; ++task)
+            ASSERT_EQ(interned[task][i], interned[0][i]);
+    }
+}
+
 }  // namespace P4::Test
@@ -87,3 +87,40 @@ TEST(JSON, variant) {
         EXPECT_EQ(data[i], copy[i]);
     }
 }
+
+TEST(JSON, out_of_order_fields) {
+    std::stringstream ss(R"({ "second" : [1, 2, 3], "unused" : { "a" : [ {}, "]}" ] },
+                              "first" : "x" })");
+    std::pair<std::string, std::vector<int>> copy;
+
+    JSONLoader(ss) >> copy;
+
+    EXPECT_EQ(copy.first, "x");
+    EXPECT_EQ(copy.second, std::vector<int>({1, 2, 3}));
+}
+
+TEST(JSON, shared_nodes) {
+    auto *t = IR::Type_Bits::get(16);
+    auto *c = new IR::Constant(t, 5);
+    IR::Vector<IR::Node> objects;
+    objects.push_back(new IR::Declaration_Constant(IR::ID("a"), t, new IR::Add(t, c, c)));
+    objects.push_back(new IR::Declaration_Constant(IR::ID("b"), t, c));
+    const IR::P4Program *program = new IR::P4Program(objects), *copy = nullptr;
+
+    std::stringstream ss;
+    JSONGenerator(ss).emit(program);
+    JSONLoader loader(ss);
+    EXPECT_TRUE(loader.is<JsonObject>());
+    loader >> copy;
+
+    ASSERT_NE(copy, nullptr);
+    EXPECT_TRUE(program->equiv(*copy));
+    ASSERT_EQ(copy->objects.size(), 2u);
+    auto *a = copy->objects.at(0)->to<IR::Declaration_Constant>();
+    auto *b = copy->objects.at(1)->to<IR::Declaration_Constant>();
+    ASSERT_TRUE(a && b);
+    auto *add = a->initializer->to<IR::Add>();
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->left, add->right);
+    EXPECT_EQ(add->left, b->initializer);
+}
@@ -61,3 +61,54 @@ TEST(IR, Equiv) {
     pr2->add("listb"_cs, list1);
     EXPECT_FALSE(pr1->equiv(*pr2));
 }
+
+TEST(IR, EquivHash) {
+    auto *t = IR::Type::Bits::get(16);
+    auto *a1 = new IR::Constant(t, 10);
+    auto *a2 = new IR::Constant(t, 10);
+    auto *b = new IR::Constant(IR::Type::Bits::get(10), 10);
+    auto *c = new IR::Constant(t, 20);
+    auto *d1 = new IR::PathExpression("d");
+    auto *d2 = new IR::PathExpression("d");
+    auto *e = new IR::PathExpression("e");
+
+    EXPECT_EQ(a1->equiv_hash(), a2->equiv_hash());
+    EXPECT_EQ(d1->equiv_hash(), d2->equiv_hash());
+    EXPECT_NE(a1->equiv_hash(), b->equiv_hash());
+    EXPECT_NE(a1->equiv_hash(), c->equiv_hash());
+    EXPECT_NE(d1->equiv_hash(), e->equiv_hash());
+    EXPECT_NE(a1->equiv_hash(), d1->equiv_hash());
+
+    // values wider than a machine word are hashed in full
+    auto *wide = IR::Type::Bits::get(128);
+    auto *w1 = new IR::Constant(wide, big_int(1) << 100);
+    auto *w2 = new IR::Constant(wide, (big_int(1) << 100) + (big_int(1) << 64));
+    EXPECT_EQ(w1->equiv_hash(), (new IR::Constant(wide, big_int(1) << 100))->equiv_hash());
+    EXPECT_NE(w1->equiv_hash(), w2->equiv_hash());
+
+    // source positions are ignored, as they are by equiv
+    Util::InputSources sources;
+    auto *a3 = a1->clone();
+    a3->srcInfo = Util::SourceInfo(&sources, Util::SourcePosition(3, 4));
+    EXPECT_EQ(a1->equiv_hash(), a3->equiv_hash());
+
+    auto *call1 = new IR::MethodCallExpression(new IR::Member(d1, "m"), {a1, d1});
+    auto *call2 = new IR::MethodCallExpression(new IR::Member(d2, "m"), {a2, d2});
+    auto *call3 = new IR::MethodCallExpression(new IR::Member(d1, "m"), {b, d1});
+    EXPECT_EQ(call1->equiv_hash(), call2->equiv_hash());
+    EXPECT_NE(call1->equiv_hash(), call3->equiv_hash());
+
+    auto *list1 = new IR::ListExpression({a1, b, d1});
+    auto *list2 = new IR::ListExpression({a2, b, d2});
+    auto *list3 = new IR::ListExpression({a1, b});
+    EXPECT_EQ(list1->equiv_hash(), list2->equiv_hash());
+    EXPECT_NE(list1->equiv_hash(), list3->equiv_hash());
+
+    auto *pr1 = new IR::V1Program;
+    auto *pr2 = pr1->clone();
+    pr1->add("a"_cs, a1);
+    pr1->add("call"_cs, call1);
+    pr2->add("a"_cs, a2);
+    pr2->add("call"_cs, call2);
+    EXPECT_EQ(pr1->equiv_hash(), pr2->equiv_hash());
+}
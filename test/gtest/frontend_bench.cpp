@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Benchmarks of frontend passes on generated programs, and of the shared state they use.  They
+// are built into gtestp4c-bench, not into gtestp4c, record their timings as test properties and
+// fail only when a pass stops scaling linearly.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "frontends/common/parseInput.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/common/resolveReferences/resolveReferences.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+#include "helpers.h"
+#include "ir/ir.h"
+#include "lib/cstring.h"
+#include "lib/thread_pool.h"
+
+namespace P4::Test {
+
+namespace {
+
+/// @return the fastest of a few runs of @p run on a program parsed from @p source, in
+/// microseconds.
+int64_t timeOnProgram(const std::string &source,
+                      const std::function<void(const IR::Node *)> &run) {
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    EXPECT_TRUE(program);
+    if (!program) return 0;
+    int64_t best = INT64_MAX;
+    for (int rep = 0; rep < 3; ++rep) {
+        auto start = std::chrono::steady_clock::now();
+        run(program);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        best = std::min(best, static_cast<int64_t>(elapsed.count()));
+    }
+    EXPECT_EQ(::P4::errorCount(), 0u);
+    return std::max(best, int64_t(1));
+}
+
+/// Records the timings of @p times, keyed by problem size, and checks that growing the size
+/// by 8x costs less than 32x the time, which a quadratic pass would not meet.
+void checkScaling(const char *name, const std::map<int, int64_t> &times) {
+    for (const auto &[size, time] : times)
+        ::testing::Test::RecordProperty(absl::StrCat(name, size, "_us"), std::to_string(time));
+    auto smallest = *times.begin(), largest = *times.rbegin();
+    ASSERT_EQ(largest.first, 8 * smallest.first);
+    EXPECT_LT(largest.second, 32 * smallest.second)
+        << name << ": " << largest.first << " took " << largest.second << "us, "
+        << smallest.first << " took " << smallest.second << "us";
+}
+
+}  // namespace
+
+struct P4CFrontendBench : P4CTest {};
+
+// Type unification on generic-heavy code: every integer literal of a struct initializer is a
+// type variable of the same unification problem.
+TEST_F(P4CFrontendBench, TypeUnification) {
+    std::map<int, int64_t> times;
+    for (int fields : {100, 200, 400, 800}) {
+        std::string source = "struct S {";
+        std::string initializer;
+        for (int i = 0; i < fields; ++i) {
+            absl::StrAppend(&source, " bit<8> f", i, ";");
+            absl::StrAppend(&initializer, i ? ", " : "", i % 256);
+        }
+        absl::StrAppend(&source, " }\n",
+                        "extern T id<T>(in T x);\n"
+                        "S make() { return id<S>({",
+                        initializer,
+                        "}); }\n"
+                        "S copy(in S s) { S t = {",
+                        initializer, "}; return id(id(s)) == t ? t : s; }\n");
+        times[fields] = timeOnProgram(source, [](const IR::Node *program) {
+            TypeMap typeMap;
+            program->apply(TypeInference(&typeMap, false));
+        });
+    }
+    checkScaling("fields", times);
+}
+
+// Name resolution: each lookup should cost O(1) per enclosing scope, including the lookup of
+// match kinds in table keys.
+TEST_F(P4CFrontendBench, ResolveReferences) {
+    std::map<int, int64_t> times;
+    for (int declarations : {2500, 5000, 10000, 20000}) {
+        std::string source;
+        for (int i = 0; i < declarations; ++i)
+            absl::StrAppend(&source, "const bit<32> c", i, " = ", i, ";\n");
+        // Declared last, so that a linear scan for match kinds would be quadratic overall.
+        absl::StrAppend(&source, "match_kind { exact }\ncontrol C(inout bit<32> x) {\n");
+        for (int i = 0; i < declarations; ++i)
+            absl::StrAppend(&source, "  action a", i, "() { x = c", i, "; }\n",
+                            "  table t", i, " { key = { x : exact; } actions = { a", i,
+                            "; } }\n");
+        absl::StrAppend(&source, "  apply {}\n}\n");
+        times[declarations] = timeOnProgram(source, [](const IR::Node *program) {
+            ReferenceMap refMap;
+            program->apply(ResolveReferences(&refMap));
+        });
+    }
+    checkScaling("declarations", times);
+}
+
+// Intern throughput of cstring from 1 to N threads at once.  Each thread count interns its own
+// strings, so that every run both inserts new strings and looks up ones inserted by other
+// threads.  Threads are only used when the compiler is built with ENABLE_MULTITHREAD.
+TEST_F(P4CFrontendBench, ConcurrentIntern) {
+    const size_t stringCount = 200000;
+    unsigned maxThreads = std::clamp(std::thread::hardware_concurrency(), 1U, 8U);
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        std::vector<std::string> strings;
+        for (size_t i = 0; i < stringCount; ++i)
+            strings.push_back(absl::StrCat("concurrentIntern.", threads, ".", i));
+        Util::ThreadPool::setConcurrency(threads);
+        auto start = std::chrono::steady_clock::now();
+        Util::ThreadPool::parallelFor(threads, [&](size_t task) {
+            for (size_t j = 0; j < stringCount; ++j)
+                (void)cstring(strings[(j + task * stringCount / threads) % stringCount]);
+        });
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        int64_t us = std::max<int64_t>(elapsed.count(), 1);
+        Util::ThreadPool::setConcurrency(0);
+        RecordProperty(absl::StrCat("intern_", threads, "_threads_us"), std::to_string(us));
+        // interns per millisecond, over all threads
+        RecordProperty(absl::StrCat("intern_", threads, "_threads_per_ms"),
+                       std::to_string(threads * stringCount * 1000 / us));
+    }
+}
+
+}  // namespace P4::Test
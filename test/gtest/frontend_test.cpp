@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <sstream>
+
+#include "absl/strings/str_cat.h"
 #include "frontends/common/constantFolding.h"
 #include "frontends/common/parseInput.h"
 #include "frontends/common/resolveReferences/referenceMap.h"
@@ -194,4 +197,252 @@ TEST_F(P4CFrontendMoveInitializers, P4ControlSrcInfo) {
     }
 }
 
+// Tests for incremental type checking
+struct P4CFrontendIncrementalTypeChecking : P4CTest {};
+
+TEST_F(P4CFrontendIncrementalTypeChecking, SkipsUnchangedDeclarations) {
+    std::string source = P4_SOURCE(R"(
+        const bit<8> a = 1;
+        const bit<8> b = 2;
+    )");
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    TypeMap typeMap;
+    typeMap.setIncremental(true);
+    program = program->apply(TypeInference(&typeMap, false));
+    ASSERT_EQ(::P4::errorCount(), 0);
+    const auto &objects = program->to<IR::P4Program>()->objects;
+    ASSERT_EQ(objects.size(), 2u);
+    const auto *a = objects.at(0)->to<IR::Declaration_Constant>();
+    const auto *b = objects.at(1)->to<IR::Declaration_Constant>();
+    ASSERT_TRUE(a && b);
+    EXPECT_TRUE(typeMap.isChecked(a));
+    EXPECT_TRUE(typeMap.isChecked(b));
+
+    // Rewrite b.  a is modified in place behind the back of type inference, which is only
+    // noticed if a is visited again.
+    auto *newB = b->clone();
+    newB->initializer = new IR::Constant(IR::Type_Bits::get(8), 3);
+    const auto *newInitA = new IR::Constant(IR::Type_Bits::get(8), 4);
+    const_cast<IR::Declaration_Constant *>(a)->initializer = newInitA;
+    IR::Vector<IR::Node> newObjects;
+    newObjects.push_back(a);
+    newObjects.push_back(newB);
+    const IR::Node *modified = new IR::P4Program(program->srcInfo, newObjects);
+    EXPECT_FALSE(typeMap.isChecked(newB));
+
+    EXPECT_EQ(modified->apply(TypeInference(&typeMap, true)), modified);
+    ASSERT_EQ(::P4::errorCount(), 0);
+    EXPECT_TRUE(typeMap.isChecked(a));
+    EXPECT_TRUE(typeMap.isChecked(newB));
+    // the old version of b was superseded by the new one
+    EXPECT_FALSE(typeMap.isChecked(b));
+    EXPECT_NE(typeMap.getType(newB->initializer), nullptr);
+    EXPECT_EQ(typeMap.getType(newInitA), nullptr);
+
+    // Without incremental mode everything is visited.
+    typeMap.setIncremental(false);
+    typeMap.clear();
+    modified->apply(TypeInference(&typeMap, true));
+    EXPECT_NE(typeMap.getType(newInitA), nullptr);
+}
+
+TEST_F(P4CFrontendIncrementalTypeChecking, ChecksDependentDeclarations) {
+    std::string source = P4_SOURCE(R"(
+        typedef bit<8> T;
+        const T a = 1;
+        const bit<8> b = 2;
+    )");
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    TypeMap typeMap;
+    typeMap.setIncremental(true);
+    program = program->apply(TypeInference(&typeMap, false));
+    ASSERT_EQ(::P4::errorCount(), 0);
+    const auto &objects = program->to<IR::P4Program>()->objects;
+    ASSERT_EQ(objects.size(), 3u);
+    const auto *t = objects.at(0)->to<IR::Type_Typedef>();
+    const auto *a = objects.at(1)->to<IR::Declaration_Constant>();
+    const auto *b = objects.at(2)->to<IR::Declaration_Constant>();
+    ASSERT_TRUE(t && a && b);
+
+    // Widen T.  a refers to T, so it is checked again although it did not change, and b is
+    // skipped.  Their initializers are replaced in place to tell which ones are visited.
+    auto *newT = t->clone();
+    newT->type = IR::Type_Bits::get(16);
+    const auto *newInitA = new IR::Constant(IR::Type_Bits::get(16), 4);
+    const auto *newInitB = new IR::Constant(IR::Type_Bits::get(8), 5);
+    const_cast<IR::Declaration_Constant *>(a)->initializer = newInitA;
+    const_cast<IR::Declaration_Constant *>(b)->initializer = newInitB;
+    IR::Vector<IR::Node> newObjects;
+    newObjects.push_back(newT);
+    newObjects.push_back(a);
+    newObjects.push_back(b);
+    const IR::Node *modified = new IR::P4Program(program->srcInfo, newObjects);
+
+    EXPECT_EQ(modified->apply(TypeInference(&typeMap, true)), modified);
+    ASSERT_EQ(::P4::errorCount(), 0);
+    EXPECT_TRUE(typeMap.isChecked(newT));
+    EXPECT_TRUE(typeMap.isChecked(a));
+    EXPECT_TRUE(typeMap.isChecked(b));
+    EXPECT_TRUE(typeMap.equivalent(typeMap.getType(a), IR::Type_Bits::get(16)));
+    EXPECT_NE(typeMap.getType(newInitA), nullptr);
+    EXPECT_EQ(typeMap.getType(newInitB), nullptr);
+
+    // Removing T makes a refer to an undeclared type, which is only noticed if a is checked.
+    IR::Vector<IR::Node> withoutT;
+    withoutT.push_back(a);
+    withoutT.push_back(b);
+    (void)(new IR::P4Program(program->srcInfo, withoutT))
+        ->apply(TypeInference(&typeMap, false, true, /* errorOnNullDecls */ true));
+    EXPECT_NE(::P4::errorCount(), 0);
+}
+
+// Tests for parallel type checking
+struct P4CFrontendParallelTypeChecking : P4CTest {};
+
+TEST_F(P4CFrontendParallelTypeChecking, InfersIndependentDeclarations) {
+    std::string source = P4_SOURCE(R"(
+        const bit<8> c = 1;
+        bit<8> f(in bit<8> x) { return x + c; }
+        bit<8> g(in bit<8> x) { return x + 2; }
+        bit<8> h(in bit<8> x) { return f(x) + g(x); }
+        action a(inout bit<8> x) { x = h(x); }
+    )");
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    TypeMap typeMap;
+    typeMap.setParallel(true);
+    program = program->apply(TypeInference(&typeMap, false));
+    ASSERT_EQ(::P4::errorCount(), 0);
+    const auto &objects = program->to<IR::P4Program>()->objects;
+    ASSERT_EQ(objects.size(), 5u);
+    for (const auto *obj : objects) {
+        const IR::Expression *expr = nullptr;
+        if (const auto *function = obj->to<IR::Function>()) {
+            expr = function->body->components.at(0)->to<IR::ReturnStatement>()->expression;
+        } else if (const auto *action = obj->to<IR::P4Action>()) {
+            expr = action->body->components.at(0)->to<IR::AssignmentStatement>()->right;
+        } else {
+            continue;
+        }
+        const auto *type = typeMap.getType(expr);
+        ASSERT_TRUE(type && type->is<IR::Type_Bits>()) << obj;
+        EXPECT_EQ(type->to<IR::Type_Bits>()->width_bits(), 8);
+    }
+}
+
+TEST_F(P4CFrontendParallelTypeChecking, MergesForkedTypeMap) {
+    const auto *type = IR::Type_Bits::get(8);
+    const auto *x = new IR::Constant(type, 1);
+    const auto *y = new IR::Constant(type, 2);
+    TypeMap typeMap;
+    typeMap.setType(x, type);
+    typeMap.setCompileTimeConstant(x);
+
+    // The fork sees the types of the map it was made from, but does not change it.
+    TypeMap fork(&typeMap);
+    EXPECT_EQ(fork.getType(x), type);
+    EXPECT_TRUE(fork.isCompileTimeConstant(x));
+    fork.setType(y, type);
+    fork.forget(x);
+    EXPECT_EQ(fork.getType(x), nullptr);
+    EXPECT_EQ(typeMap.getType(x), type);
+    EXPECT_EQ(typeMap.getType(y), nullptr);
+
+    typeMap.merge(fork);
+    EXPECT_EQ(typeMap.getType(x), nullptr);
+    EXPECT_FALSE(typeMap.isCompileTimeConstant(x));
+    EXPECT_EQ(typeMap.getType(y), type);
+    EXPECT_EQ(typeMap.size(), 1u);
+}
+
+TEST_F(P4CFrontendParallelTypeChecking, ReportsErrorsInDeclarationOrder) {
+    std::string source = P4_SOURCE(R"(
+        bit<8> f() { return true; }
+        bit<8> g() { return false; }
+    )");
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    TypeMap typeMap;
+    typeMap.setParallel(true);
+    std::stringstream errors;
+    auto &reporter = BaseCompileContext::get().errorReporter();
+    auto *output = reporter.getOutputStream();
+    reporter.setOutputStream(&errors);
+    program->apply(TypeInference(&typeMap, false));
+    reporter.setOutputStream(output);
+    EXPECT_EQ(::P4::errorCount(), 2u);
+    auto f = errors.str().find("true");
+    auto g = errors.str().find("false");
+    ASSERT_NE(f, std::string::npos);
+    ASSERT_NE(g, std::string::npos);
+    EXPECT_LT(f, g);
+}
+
+// Type unification on generic-heavy code: every integer literal of a struct initializer is a
+// type variable of the same unification problem.  frontend_bench.cpp times bigger versions.
+struct P4CFrontendTypeUnification : P4CTest {};
+
+TEST_F(P4CFrontendTypeUnification, GenericHeavyProgram) {
+    constexpr int fields = 100;
+    std::string source = "struct S {";
+    std::string initializer;
+    for (int i = 0; i < fields; ++i) {
+        absl::StrAppend(&source, " bit<8> f", i, ";");
+        absl::StrAppend(&initializer, i ? ", " : "", i % 256);
+    }
+    absl::StrAppend(&source, " }\n",
+                    "extern T id<T>(in T x);\n"
+                    "S make() { return id<S>({",
+                    initializer,
+                    "}); }\n"
+                    "S copy(in S s) { S t = {",
+                    initializer, "}; return id(id(s)) == t ? t : s; }\n");
+    const IR::Node *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    TypeMap typeMap;
+    program = program->apply(TypeInference(&typeMap, false));
+    ASSERT_EQ(::P4::errorCount(), 0u);
+    // every call of id was inferred to return the struct
+    int calls = 0;
+    forAllMatching<IR::MethodCallExpression>(program, [&](const IR::MethodCallExpression *call) {
+        const auto *type = typeMap.getType(call);
+        ASSERT_NE(type, nullptr);
+        EXPECT_TRUE(type->is<IR::Type_Struct>()) << type;
+        ++calls;
+    });
+    EXPECT_EQ(calls, 3);
+}
+
+struct P4CFrontendResolveReferences : P4CTest {};
+
+/// Match kinds declared after the other declarations of the program are still found by table
+/// keys.  frontend_bench.cpp checks that resolution scales linearly on bigger versions.
+TEST_F(P4CFrontendResolveReferences, ManyDeclarations) {
+    constexpr int declarations = 100;
+    std::string source;
+    for (int i = 0; i < declarations; ++i)
+        absl::StrAppend(&source, "const bit<32> c", i, " = ", i, ";\n");
+    absl::StrAppend(&source, "match_kind { exact }\ncontrol C(inout bit<32> x) {\n");
+    for (int i = 0; i < declarations; ++i)
+        absl::StrAppend(&source, "  action a", i, "() { x = c", i, "; }\n",
+                        "  table t", i, " { key = { x : exact; } actions = { a", i, "; } }\n");
+    absl::StrAppend(&source, "  apply {}\n}\n");
+    const auto *program = P4::parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+
+    ReferenceMap refMap;
+    program->apply(ResolveReferences(&refMap));
+    ASSERT_EQ(::P4::errorCount(), 0u);
+    cstring lastConstant(absl::StrCat("c", declarations - 1));
+    EXPECT_TRUE(refMap.isUsed(program->getDeclsByName(lastConstant)->single()));
+    int keys = 0;
+    forAllMatching<IR::KeyElement>(program, [&](const IR::KeyElement *key) {
+        EXPECT_NE(refMap.getDeclaration(key->matchType->path), nullptr);
+        ++keys;
+    });
+    EXPECT_EQ(keys, declarations);
+}
+
 }  // namespace P4::Test
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/hash_cons.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "frontends/common/constantFolding.h"
+#include "frontends/common/parseInput.h"
+#include "ir/ir.h"
+#include "lib/compile_context.h"
+#include "lib/error.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+class HashCons : public ::testing::Test {
+ protected:
+    void SetUp() override { IR::HashCons::enable(); }
+    void TearDown() override {
+        IR::HashCons::clear();
+        IR::HashCons::enable(false);
+    }
+};
+
+TEST_F(HashCons, Disabled) {
+    IR::HashCons::enable(false);
+    auto *t = IR::Type_Bits::get(8);
+    auto *a = IR::HashCons::make<IR::Constant>(t, 1);
+    auto *b = IR::HashCons::make<IR::Constant>(t, 1);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(IR::HashCons::intern(a), a);
+    EXPECT_EQ(IR::HashCons::size(), 0u);
+}
+
+TEST_F(HashCons, Literals) {
+    auto *t = IR::Type_Bits::get(8);
+    auto *a = IR::HashCons::make<IR::Constant>(t, 1);
+    EXPECT_EQ(IR::HashCons::make<IR::Constant>(t, 1), a);
+    EXPECT_EQ(IR::HashCons::intern(new IR::Constant(t, 1)), a);
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(t, 2), a);
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(IR::Type_Bits::get(16), 1), a);
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(t, 1, 16), a);
+
+    auto *tr = IR::HashCons::make<IR::BoolLiteral>(true);
+    EXPECT_EQ(IR::HashCons::make<IR::BoolLiteral>(true), tr);
+    EXPECT_NE(IR::HashCons::make<IR::BoolLiteral>(false), tr);
+
+    auto *s = IR::HashCons::make<IR::StringLiteral>(cstring("str"));
+    EXPECT_EQ(IR::HashCons::make<IR::StringLiteral>(cstring("str")), s);
+    EXPECT_EQ(IR::HashCons::size(), 7u);
+
+    IR::HashCons::clear();
+    EXPECT_EQ(IR::HashCons::size(), 0u);
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(t, 1), a);
+}
+
+TEST_F(HashCons, SourcePositions) {
+    Util::InputSources sources;
+    Util::SourceInfo first(&sources, Util::SourcePosition(1, 1));
+    Util::SourceInfo second(&sources, Util::SourcePosition(2, 1));
+    auto *t = IR::Type_Bits::get(8);
+    auto *a = IR::HashCons::make<IR::Constant>(first, t, 1);
+    EXPECT_EQ(IR::HashCons::make<IR::Constant>(first, t, 1), a);
+    // Nodes at different positions are not shared, so each keeps its own position.
+    auto *b = IR::HashCons::make<IR::Constant>(second, t, 1);
+    EXPECT_NE(b, a);
+    EXPECT_TRUE(a->srcInfo == first);
+    EXPECT_TRUE(b->srcInfo == second);
+    EXPECT_EQ(IR::HashCons::make<IR::Constant>(second, t, 1), b);
+}
+
+TEST_F(HashCons, DiagnosticOnFoldedConstant) {
+    AutoCompileContext context(new GTestContext(GTestContext::get()));
+    std::string source = P4_SOURCE(R"(
+        const bit<8> a = 8w1 + 8w1;
+        const bit<8> b =
+            8w1 + 8w1;
+    )");
+    const IR::Node *program = parseP4String(source, CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(program);
+    program = program->apply(DoConstantFolding());
+    const IR::Expression *folded[2] = {nullptr, nullptr};
+    forAllMatching<IR::Declaration_Constant>(program, [&](const IR::Declaration_Constant *d) {
+        folded[d->name == "b"] = d->initializer;
+    });
+    ASSERT_TRUE(folded[0] && folded[1]);
+    ASSERT_TRUE(folded[1]->is<IR::Constant>());
+    EXPECT_NE(folded[0], folded[1]);
+
+    // A diagnostic about the second constant points at the line of its expression.
+    std::stringstream errors;
+    auto &reporter = BaseCompileContext::get().errorReporter();
+    auto *output = reporter.getOutputStream();
+    reporter.setOutputStream(&errors);
+    ::P4::warning(ErrorType::WARN_UNUSED, "%1%: folded constant", folded[1]);
+    reporter.setOutputStream(output);
+    auto line = folded[1]->srcInfo.toPosition().sourceLine;
+    EXPECT_EQ(line, folded[0]->srcInfo.toPosition().sourceLine + 2);
+    EXPECT_NE(errors.str().find(absl::StrCat("(", line, ")")), std::string::npos) << errors.str();
+}
+
+TEST_F(HashCons, CompileContext) {
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Constant *a = nullptr;
+    {
+        AutoCompileContext context(new GTestContext(GTestContext::get()));
+        a = IR::HashCons::make<IR::Constant>(t, 1);
+        EXPECT_EQ(IR::HashCons::make<IR::Constant>(t, 1), a);
+        EXPECT_EQ(IR::HashCons::size(), 1u);
+    }
+    // The table is emptied when the context in which the nodes were interned ends.
+    EXPECT_EQ(IR::HashCons::size(), 0u);
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(t, 1), a);
+}
+
+TEST_F(HashCons, TypeVariables) {
+    // Constants of type InfInt are told apart by type inference, so they are never shared.
+    auto *a = IR::HashCons::make<IR::Constant>(1);
+    ASSERT_TRUE(a->type->is<IR::Type_InfInt>());
+    EXPECT_NE(IR::HashCons::make<IR::Constant>(1), a);
+    EXPECT_EQ(IR::HashCons::size(), 0u);
+}
+
+}  // namespace P4::Test
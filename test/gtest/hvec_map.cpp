@@ -7,6 +7,9 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <random>
+
 namespace P4::Test {
 
 TEST(hvec_map, map_equal) {
@@ -166,4 +169,59 @@ TEST(hvec_map, string_map) {
     }
 }
 
+TEST(hvec_map, random_ops) {
+    // enough keys to need 16 and 32 bit indexes, and to exercise growing, erasing and
+    // rebuilding the index; check against std::map, and that insertion order is kept
+    hvec_map<unsigned, unsigned> m;
+    std::map<unsigned, unsigned> ref;
+    std::vector<unsigned> order;  // keys in insertion order, with stale entries
+    std::map<unsigned, size_t> pos;  // where each key in ref is in order
+    std::mt19937 rng(1);
+    for (int i = 0; i < 200000; ++i) {
+        unsigned k = rng() % 100000;
+        switch (rng() % 8) {
+            case 0:
+                EXPECT_EQ(m.erase(k), ref.erase(k));
+                break;
+            case 1:
+                if (auto it = m.find(k); it != m.end()) {
+                    EXPECT_EQ(ref.count(k), 1U);
+                    m.erase(it);
+                    ref.erase(k);
+                }
+                break;
+            case 2:
+                EXPECT_EQ(m.count(k), ref.count(k));
+                break;
+            default:
+                if (!ref.count(k)) {
+                    pos[k] = order.size();
+                    order.push_back(k);
+                }
+                m[k] = ref[k] = i;
+                break;
+        }
+        ASSERT_EQ(m.size(), ref.size());
+    }
+    for (auto &[k, v] : ref) EXPECT_EQ(m.at(k), v);
+    std::vector<unsigned> live;
+    for (size_t i = 0; i < order.size(); ++i)
+        if (ref.count(order[i]) && pos[order[i]] == i) live.push_back(order[i]);
+    auto it = live.begin();
+    for (auto &el : m) EXPECT_EQ(el.first, *it++);
+    EXPECT_TRUE(it == live.end());
+}
+
+TEST(hvec_map, pointer_keys) {
+    std::vector<std::unique_ptr<int>> objs;
+    hvec_map<const int *, int> m;
+    for (int i = 0; i < 5000; ++i) {
+        objs.push_back(std::make_unique<int>(i));
+        m[objs.back().get()] = i;
+    }
+    for (auto &o : objs) EXPECT_EQ(m.at(o.get()), *o);
+    int x;
+    EXPECT_EQ(m.count(&x), 0U);
+}
+
 }  // namespace P4::Test
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Microbenchmarks comparing hvec_map against std::unordered_map and absl::flat_hash_map on
+// pointer keys -- the common case in the compiler, which maps IR nodes to per-node data.
+// Records the time per operation for a few table sizes as test properties.  They are built
+// into gtestp4c-bench, not into gtestp4c.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "lib/hvec_map.h"
+
+namespace P4::Test {
+
+namespace {
+
+struct Node {
+    int id;
+    char payload[56];  // so nodes are spread out like IR nodes
+};
+
+template <class MAP>
+class MapBench {
+    const std::vector<const Node *> &keys, &misses;
+
+ public:
+    MapBench(const std::vector<const Node *> &keys, const std::vector<const Node *> &misses)
+        : keys(keys), misses(misses) {}
+
+    // Time each operation over all the keys, and return ns/op for insert, lookup hit,
+    // lookup miss and iteration.
+    std::array<double, 4> run(int reps) {
+        std::array<double, 4> rv = {};
+        volatile size_t sink = 0;
+        for (int r = 0; r < reps; ++r) {
+            MAP map;
+            rv[0] += time([&] {
+                for (auto *k : keys) map[k] = k->id;
+            });
+            rv[1] += time([&] {
+                for (auto *k : keys) sink = sink + map.find(k)->second;
+            });
+            rv[2] += time([&] {
+                for (auto *k : misses) sink = sink + map.count(k);
+            });
+            rv[3] += time([&] {
+                for (auto &el : map) sink = sink + el.second;
+            });
+            EXPECT_EQ(map.size(), keys.size());
+        }
+        for (auto &t : rv) t /= double(reps) * keys.size();
+        return rv;
+    }
+
+ private:
+    template <class F>
+    static double time(F f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+};
+
+/// Records the times @p t, in ns per operation, of the map @p name on @p n keys.
+void record(const char *name, size_t n, const std::array<double, 4> &t) {
+    const char *operations[] = {"insert", "hit", "miss", "iterate"};
+    for (size_t i = 0; i < t.size(); ++i)
+        ::testing::Test::RecordProperty(absl::StrCat(name, "_", n, "_", operations[i], "_ns"),
+                                        std::to_string(t[i]));
+}
+
+}  // namespace
+
+TEST(HvecMapBench, PointerKeys) {
+    std::mt19937 rng(7);
+    for (size_t n : {100, 10000, 200000}) {
+        // allocate keys and misses interleaved, then shuffle so lookups are not sequential
+        std::vector<std::unique_ptr<Node>> nodes;
+        std::vector<const Node *> keys, misses;
+        for (size_t i = 0; i < 2 * n; ++i) {
+            nodes.push_back(std::make_unique<Node>(Node{int(i), {}}));
+            (i % 2 ? misses : keys).push_back(nodes.back().get());
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        std::shuffle(misses.begin(), misses.end(), rng);
+        int reps = 2000000 / n + 1;
+        record("hvec_map", n, MapBench<hvec_map<const Node *, int>>(keys, misses).run(reps));
+        record("unordered_map", n,
+               MapBench<std::unordered_map<const Node *, int>>(keys, misses).run(reps));
+        record("flat_hash_map", n,
+               MapBench<absl::flat_hash_map<const Node *, int>>(keys, misses).run(reps));
+    }
+}
+
+}  // namespace P4::Test
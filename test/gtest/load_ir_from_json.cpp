@@ -47,4 +47,25 @@ TEST_F(FromJSONTest, load_ir_from_json) {
     ASSERT_FALSE(exitCode);
 }
 
+TEST_F(FromJSONTest, load_ir_from_binary) {
+    int exitCode = system(
+        "./p4c-bm2-ss -o outputTO.json test/test_fromJSON.p4 "
+        "--toBinaryIR irFile.bin");
+    ASSERT_FALSE(exitCode);
+    exitCode = system("./p4c-bm2-ss -o outputFROM.json --fromBinaryIR irFile.bin");
+    ASSERT_FALSE(exitCode);
+    exitCode = system(
+        "grep -v program outputTO.json > outputTO.json.tmp; "
+        "mv outputTO.json.tmp outputTO.json");
+    ASSERT_FALSE(exitCode);
+    exitCode = system(
+        "grep -v program outputFROM.json > outputFROM.json.tmp; "
+        "mv outputFROM.json.tmp outputFROM.json");
+    ASSERT_FALSE(exitCode);
+    exitCode = system("diff outputTO.json outputFROM.json");
+    ASSERT_FALSE(exitCode);
+    exitCode = system("rm -f outputFROM.json outputTO.json irFile.bin");
+    ASSERT_FALSE(exitCode);
+}
+
 }  // namespace P4::Test
@@ -0,0 +1,167 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/pass_profile.h"
+
+#include <gtest/gtest.h>
+
+#include <config.h>
+
+#include <sstream>
+
+#include "ir/ir.h"
+#include "ir/json_parser.h"
+#include "ir/pass_manager.h"
+#include "lib/compile_context.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+namespace {
+
+class CountConstants : public Inspector {
+ public:
+    unsigned count = 0;
+    CountConstants() { setName("CountConstants"); }
+    void postorder(const IR::Constant *) override { ++count; }
+};
+
+/// Decrements every positive constant; repeating it converges once all constants are zero.
+class DecrementConstants : public Transform {
+ public:
+    DecrementConstants() { setName("DecrementConstants"); }
+    const IR::Node *postorder(IR::Constant *c) override {
+        if (c->value > 0) c->value -= 1;
+        return c;
+    }
+};
+
+const JsonData *jsonField(const JsonData *obj, const char *name) {
+    auto *o = obj->to<JsonObject>();
+    if (!o) return nullptr;
+    auto it = o->find(cstring(name));
+    return it == o->end() ? nullptr : it->second.get();
+}
+
+int jsonNumber(const JsonData *obj, const char *name) {
+    auto *n = jsonField(obj, name);
+    return n && n->is<JsonNumber>() ? int(*n->to<JsonNumber>()) : -1;
+}
+
+std::string jsonString(const JsonData *obj, const char *name) {
+    auto *s = jsonField(obj, name);
+    return s && s->is<JsonString>() ? std::string(*s->to<JsonString>()) : std::string();
+}
+
+const JsonVector *jsonVector(const JsonData *obj, const char *name) {
+    auto *v = jsonField(obj, name);
+    return v ? v->to<JsonVector>() : nullptr;
+}
+
+}  // namespace
+
+TEST(PassProfile, NestedPasses) {
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Node *program = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+
+    CountConstants count;
+    PassManager passes({&count, new PassRepeated({new DecrementConstants})});
+    passes.setName("Outer");
+
+    PassProfile::reset();
+    PassProfile::enable();
+    program = program->apply(passes);
+    PassProfile::enable(false);
+    EXPECT_EQ(count.count, 2u);
+
+    std::stringstream report;
+    PassProfile::write(report);
+    std::unique_ptr<JsonData> json;
+    report >> json;
+    ASSERT_NE(json, nullptr);
+
+    auto *events = jsonVector(json.get(), "traceEvents");
+    ASSERT_NE(events, nullptr);
+    // Outer, CountConstants, PassRepeated and one DecrementConstants per iteration
+    EXPECT_EQ(events->size(), 6u);
+    for (auto &event : *events) {
+        EXPECT_EQ(jsonString(event.get(), "ph"), "X");
+        EXPECT_GE(jsonNumber(event.get(), "dur"), 0);
+        EXPECT_GE(jsonNumber(event.get(), "ts"), 0);
+    }
+
+    auto *passList = jsonVector(json.get(), "passes");
+    ASSERT_NE(passList, nullptr);
+    ASSERT_EQ(passList->size(), 1u);
+    auto *outer = passList->at(0).get();
+    EXPECT_EQ(jsonString(outer, "name"), "Outer");
+    EXPECT_EQ(jsonNumber(outer, "calls"), 1);
+    EXPECT_GE(jsonNumber(outer, "wall_us"), 0);
+    // The Add, both constants and their (shared) type are visited by each of the 4 visitor runs.
+    EXPECT_EQ(jsonNumber(outer, "nodes_visited"), 16);
+
+    auto *children = jsonVector(outer, "children");
+    ASSERT_NE(children, nullptr);
+    ASSERT_EQ(children->size(), 2u);
+    auto *inspector = children->at(0).get();
+    EXPECT_EQ(jsonString(inspector, "name"), "CountConstants");
+    EXPECT_EQ(jsonNumber(inspector, "nodes_visited"), 4);
+    EXPECT_EQ(jsonNumber(inspector, "nodes_cloned"), 0);
+
+    // 1,2 -> 0,1 -> 0,0 -> no change
+    auto *repeated = children->at(1).get();
+    EXPECT_EQ(jsonNumber(repeated, "iterations"), 3);
+    auto *repeatedChildren = jsonVector(repeated, "children");
+    ASSERT_NE(repeatedChildren, nullptr);
+    ASSERT_EQ(repeatedChildren->size(), 1u);
+    auto *transform = repeatedChildren->at(0).get();
+    EXPECT_EQ(jsonString(transform, "name"), "DecrementConstants");
+    EXPECT_EQ(jsonNumber(transform, "calls"), 3);
+    EXPECT_EQ(jsonNumber(transform, "nodes_visited"), 12);
+    // Only the changed constants and their parent Add are kept: 3 + 2 + 0.
+    EXPECT_EQ(jsonNumber(transform, "nodes_cloned"), 5);
+
+    PassProfile::reset();
+}
+
+TEST(PassProfile, ArenaBytes) {
+    AutoCompileContext context(new GTestContext(GTestContext::get()), /* useArena */ true);
+    auto *t = IR::Type_Bits::get(8);
+    const IR::Node *program = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+
+    CountConstants count;
+    PassManager passes({&count, new DecrementConstants});
+    passes.setName("Outer");
+
+    PassProfile::reset();
+    PassProfile::enable();
+    program = program->apply(passes);
+    PassProfile::enable(false);
+
+    std::stringstream report;
+    PassProfile::write(report);
+    std::unique_ptr<JsonData> json;
+    report >> json;
+    ASSERT_NE(json, nullptr);
+    auto *passList = jsonVector(json.get(), "passes");
+    ASSERT_NE(passList, nullptr);
+    ASSERT_EQ(passList->size(), 1u);
+    auto *children = jsonVector(passList->at(0).get(), "children");
+    ASSERT_NE(children, nullptr);
+    ASSERT_EQ(children->size(), 2u);
+#if HAVE_IR_ARENA
+    // The inspector allocates no nodes; the transform allocates its clones in the arena.
+    EXPECT_EQ(jsonNumber(children->at(0).get(), "arena_bytes"), 0);
+    EXPECT_GE(jsonNumber(children->at(1).get(), "arena_bytes"), int(2 * sizeof(IR::Constant)));
+    // Arena allocations are also counted as allocated bytes.
+    EXPECT_GE(jsonNumber(children->at(1).get(), "alloc_bytes"),
+              jsonNumber(children->at(1).get(), "arena_bytes"));
+#else
+    EXPECT_EQ(jsonField(children->at(1).get(), "arena_bytes"), nullptr);
+#endif
+
+    PassProfile::reset();
+}
+
+}  // namespace P4::Test
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/precompiledHeader.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "frontends/common/options.h"
+#include "frontends/common/preprocessor.h"
+#include "ir/ir.h"
+#include "lib/error.h"
+#include "test/gtest/helpers.h"
+
+namespace P4::Test {
+
+using namespace P4::literals;
+
+namespace {
+
+class PrecompiledHeaderTest : public P4CTest {
+ protected:
+    std::filesystem::path dir;
+    CompilerOptions options;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() /
+              ("p4c-precompiled-header-" + std::to_string(getpid()));
+        std::filesystem::create_directories(dir / "pch");
+        Preprocessor::clearCache();
+        options.file = dir / "prog.p4";
+        options.precompiledHeader = dir / "pch";
+        write("prog.p4", "#include \"inc.p4\"\nconst bit<8> B = A;\n");
+        write("inc.p4", "const bit<8> A = 1;\n");
+    }
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    void write(const std::string &name, const std::string &text) {
+        std::ofstream(dir / name) << text;
+    }
+
+    /// @return the declaration of A in the program parsed with the precompiled header.
+    const IR::Declaration_Constant *parseA() {
+        auto program = parseWithPrecompiledHeader(options);
+        EXPECT_TRUE(program.has_value());
+        if (!program || !*program) return nullptr;
+        EXPECT_EQ(::P4::errorCount(), 0u);
+        EXPECT_EQ((*program)->objects.size(), 2u);
+        EXPECT_NE((*program)->getDeclsByName("B"_cs)->count(), 0u);
+        auto decls = (*program)->getDeclsByName("A"_cs)->toVector();
+        return decls.size() == 1 ? decls.front()->to<IR::Declaration_Constant>() : nullptr;
+    }
+
+    /// @return the precompiled header files written so far.
+    std::vector<std::filesystem::path> headerFiles() const {
+        std::vector<std::filesystem::path> rv;
+        for (const auto &entry : std::filesystem::directory_iterator(dir / "pch"))
+            rv.push_back(entry.path());
+        return rv;
+    }
+};
+
+}  // namespace
+
+TEST_F(PrecompiledHeaderTest, CreateReuseInvalidate) {
+    // The first compilation creates the header.
+    auto *created = parseA();
+    ASSERT_NE(created, nullptr);
+    auto files = headerFiles();
+    ASSERT_EQ(files.size(), 1u);
+    auto written = std::filesystem::last_write_time(files.front());
+
+    // The next one uses the header kept in memory, without writing it again.
+    EXPECT_EQ(parseA(), created);
+    EXPECT_EQ(std::filesystem::last_write_time(files.front()), written);
+
+    // A header read from the file gets new node ids, which do not collide with the ids of the
+    // nodes created by the first compilation.
+    EXPECT_EQ(preloadPrecompiledHeaders(dir / "pch"), 1u);
+    auto *loaded = parseA();
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_NE(loaded, created);
+    EXPECT_TRUE(loaded->equiv(*created));
+    EXPECT_NE(loaded->id, created->id);
+    EXPECT_NE(loaded->initializer->id, created->initializer->id);
+    EXPECT_TRUE(loaded->srcInfo == created->srcInfo);
+
+    // Changing an included file makes the header out of date, so it is created again.
+    write("inc.p4", "const bit<8> A = 2;\n");
+    std::filesystem::last_write_time(dir / "inc.p4",
+                                     std::filesystem::last_write_time(files.front()) +
+                                         std::chrono::seconds(1));
+    auto *changed = parseA();
+    ASSERT_NE(changed, nullptr);
+    auto *value = changed->initializer->to<IR::Constant>();
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->asInt(), 2);
+    EXPECT_EQ(headerFiles().size(), 1u);
+}
+
+}  // namespace P4::Test
@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "frontends/common/preprocessor.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "frontends/common/parser_options.h"
+#include "lib/error.h"
+
+namespace P4::Test {
+
+namespace {
+
+/// The non-empty lines of @p text, without line markers and with runs of whitespace collapsed.
+std::string lines(const std::optional<std::string> &text) {
+    if (!text) return "<error>";
+    std::istringstream in(*text);
+    std::string rv;
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind("# ", 0) == 0) continue;
+        std::istringstream words(line);
+        std::string word, joined;
+        while (words >> word) joined += (joined.empty() ? "" : " ") + word;
+        if (!joined.empty()) rv += joined + '\n';
+    }
+    return rv;
+}
+
+class PreprocessorTest : public ::testing::Test {
+ protected:
+    std::filesystem::path dir;
+
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() /
+              ("p4c-preprocessor-" + std::to_string(getpid()));
+        std::filesystem::create_directories(dir);
+        Preprocessor::clearCache();
+    }
+    void TearDown() override { std::filesystem::remove_all(dir); }
+
+    void write(const std::string &name, const std::string &text) {
+        std::ofstream(dir / name) << text;
+    }
+};
+
+}  // namespace
+
+TEST_F(PreprocessorTest, Macros) {
+    Preprocessor pp;
+    pp.define("WIDTH=8");
+    auto out = pp.process(
+        "#define T bit<WIDTH>\n"
+        "#define ADD(a, b) ((a) + (b))\n"
+        "#define NAME(x) x ## _t\n"
+        "#define STR(x) #x\n"
+        "#define CALL(f, ...) f(__VA_ARGS__)\n"
+        "#define SELF SELF + 1\n"
+        "T x = ADD(1, ADD(2,\n"
+        "             3));\n"
+        "typedef T NAME(word);\n"
+        "@name(STR(a + b)) CALL(foo, 1, 2);\n"
+        "SELF __LINE__\n",
+        "macros.p4");
+    EXPECT_EQ(lines(out),
+              "bit<8> x = ((1) + (((2) + (3))));\n"
+              "typedef bit<8> word_t;\n"
+              "@name(\"a + b\") foo(1, 2);\n"
+              "SELF + 1 11\n");
+}
+
+TEST_F(PreprocessorTest, Conditionals) {
+    Preprocessor pp;
+    pp.define("V=2");
+    auto out = pp.process(
+        "#if V > 1 && defined(V)\n"
+        "a\n"
+        "#  ifdef W\n"
+        "b\n"
+        "#  elif !defined W\n"
+        "c\n"
+        "#  endif\n"
+        "#elif 1\n"
+        "d\n"
+        "#else\n"
+        "#error not reached\n"
+        "#endif\n"
+        "#ifndef V\n"
+        "e\n"
+        "#endif\n",
+        "conditionals.p4");
+    EXPECT_EQ(lines(out), "a\nc\n");
+}
+
+TEST_F(PreprocessorTest, Errors) {
+    Preprocessor pp;
+    auto errors = errorCount();
+    EXPECT_FALSE(pp.process("#error stop\n", "error.p4"));
+    EXPECT_FALSE(pp.process("#if 1\n", "unterminated.p4"));
+    EXPECT_FALSE(pp.process("#include <missing.p4>\n", "missing.p4"));
+    EXPECT_EQ(errorCount(), errors + 3);
+}
+
+TEST_F(PreprocessorTest, LineMarkers) {
+    write("inc.p4", "included\n");
+    Preprocessor pp({dir});
+    auto out =
+        pp.process("a\n\n\nb\n#include <inc.p4>\nc\n#line 100 \"other.p4\"\nd\n", "lines.p4");
+    ASSERT_TRUE(out);
+    EXPECT_EQ(*out, "# 1 \"lines.p4\"\na\n\n\nb\n# 1 \"" + (dir / "inc.p4").string() +
+                        "\" 1\nincluded\n# 6 \"lines.p4\" 2\nc\n# 100 \"other.p4\"\nd\n");
+}
+
+TEST_F(PreprocessorTest, CommandLineMacros) {
+    ParserOptions options;
+    // As the shell passes -D 'WORDS=a b' -D 'QUOTE="it'"'"'s"' -DONE=1.
+    char *argv[] = {const_cast<char *>("p4test"), const_cast<char *>("-D"),
+                    const_cast<char *>("WORDS=a b"), const_cast<char *>("-D"),
+                    const_cast<char *>("QUOTE=\"it's\""), const_cast<char *>("-DONE=1"),
+                    const_cast<char *>("prog.p4")};
+    ASSERT_NE(options.process(7, argv), nullptr);
+    auto pp = options.makeBuiltinPreprocessor();
+    ASSERT_TRUE(pp);
+    EXPECT_EQ(lines(pp->process("WORDS QUOTE ONE\n", "macros.p4")), "a b \"it's\" 1\n");
+}
+
+TEST_F(PreprocessorTest, IncludeCache) {
+    write("guard.p4",
+          "#ifndef GUARD\n"
+          "#define GUARD\n"
+          "#define FROM_GUARD 1\n"
+          "const bit<8> g = VALUE;\n"
+          "#endif\n");
+    write("prog.p4",
+          "#include \"guard.p4\"\n"
+          "#include \"guard.p4\"\n"
+          "const bit<8> f = FROM_GUARD;\n");
+    std::string expected = "const bit<8> g = 1;\nconst bit<8> f = 1;\n";
+
+    Preprocessor first({dir});
+    first.define("VALUE=1");
+    EXPECT_EQ(lines(first.process(dir / "prog.p4")), expected);
+    auto stats = Preprocessor::cacheStats();
+    EXPECT_EQ(stats.hits, 0u);
+    EXPECT_EQ(stats.misses, 2u);
+
+    // Same macros: both #includes are reused, including the macros they define.
+    Preprocessor second({dir});
+    second.define("VALUE=1");
+    EXPECT_EQ(lines(second.process(dir / "prog.p4")), expected);
+    EXPECT_EQ(Preprocessor::cacheStats().hits, 2u);
+
+    // Different macros: both #includes are expanded again.
+    Preprocessor third({dir});
+    third.define("VALUE=2");
+    EXPECT_EQ(lines(third.process(dir / "prog.p4")),
+              "const bit<8> g = 2;\nconst bit<8> f = 1;\n");
+    EXPECT_EQ(Preprocessor::cacheStats().misses, 4u);
+
+    // A modified header is read again.
+    write("guard.p4", "const bit<8> h = VALUE;\n");
+    std::filesystem::last_write_time(
+        dir / "guard.p4",
+        std::filesystem::last_write_time(dir / "guard.p4") + std::chrono::seconds(10));
+    Preprocessor fourth({dir});
+    fourth.define("VALUE=1");
+    EXPECT_EQ(lines(fourth.process(dir / "prog.p4")),
+              "const bit<8> h = 1;\nconst bit<8> h = 1;\nconst bit<8> f = FROM_GUARD;\n");
+}
+
+}  // namespace P4::Test
@@ -88,4 +88,49 @@ TEST(UtilSourceFile, SourceInfo) {
     EXPECT_FALSE(invalid.isValid());
 }
 
+TEST(UtilSourceFile, SourceInfoOffsets) {
+    // every IR node has a SourceInfo
+    EXPECT_LE(sizeof(SourceInfo), 2 * sizeof(void *));
+
+    Util::InputSources sources;
+    sources.mapLine("prog.p4", 1);
+    sources.appendText("const bit<8> a = 1;\r\n");
+    unsigned start = sources.getCurrentOffset();
+    sources.appendText("const");
+    SourceInfo token = SourceInfo::fromOffsets(&sources, start, sources.getCurrentOffset());
+    sources.appendText(" bit<8> b = 2;\n");
+
+    EXPECT_EQ(SourcePosition(2, 0), token.getStart());
+    EXPECT_EQ(SourcePosition(2, 5), token.getEnd());
+    EXPECT_EQ(token, SourceInfo(&sources, SourcePosition(2, 0), SourcePosition(2, 5)));
+    EXPECT_EQ(token.atEnd(), SourceInfo(&sources, SourcePosition(2, 5)));
+    EXPECT_EQ("prog.p4", token.getSourceFile());
+    EXPECT_EQ("1", token.getLineNum());
+
+    SourceInfo first(&sources, SourcePosition(1, 6), SourcePosition(1, 12));
+    EXPECT_LT(first, token);
+    SourceInfo span = first + token;
+    EXPECT_EQ(SourcePosition(1, 6), span.getStart());
+    EXPECT_EQ(SourcePosition(2, 5), span.getEnd());
+
+    // positions which are not in the text are kept as they are
+    SourceInfo outside(&sources, SourcePosition(2, 40), SourcePosition(7, 1));
+    EXPECT_EQ(SourcePosition(2, 40), outside.getStart());
+    EXPECT_EQ(SourcePosition(7, 1), outside.getEnd());
+    EXPECT_LT(token, outside);
+    span = token + outside;
+    EXPECT_EQ(SourcePosition(2, 0), span.getStart());
+    EXPECT_EQ(SourcePosition(7, 1), span.getEnd());
+}
+
+TEST(UtilSourceFile, SavedSourceInfo) {
+    SourceInfo saved("prog.p4"_cs, 3, 4, "a = 1"_cs);
+    EXPECT_FALSE(saved.isValid());
+    ASSERT_NE(saved.getSaved(), nullptr);
+    EXPECT_EQ("prog.p4", saved.getSaved()->filename);
+    EXPECT_EQ(3, saved.getSaved()->line);
+    EXPECT_EQ(SourceInfo(), saved);
+    EXPECT_EQ(SourceInfo().getSaved(), nullptr);
+}
+
 }  // namespace P4::Util
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "lib/thread_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace P4::Test {
+
+using Util::ThreadPool;
+
+TEST(ThreadPool, parallelForCallsEachIndexOnce) {
+    ThreadPool::setConcurrency(4);
+    std::vector<std::atomic<int>> calls(1000);
+    ThreadPool::parallelFor(calls.size(), [&](size_t i) { calls[i]++; });
+    ThreadPool::setConcurrency(0);
+    for (auto &count : calls) EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadPool, parallelForRethrows) {
+    ThreadPool::setConcurrency(2);
+    EXPECT_THROW(ThreadPool::parallelFor(8,
+                                         [](size_t i) {
+                                             if (i == 5) throw std::runtime_error("failed");
+                                         }),
+                 std::runtime_error);
+    ThreadPool::setConcurrency(0);
+}
+
+// Stopped workers are started again by the next parallelFor.
+TEST(ThreadPool, restartAfterShutdown) {
+    ThreadPool::setConcurrency(2);
+    std::atomic<int> calls = 0;
+    ThreadPool::parallelFor(8, [&](size_t) { calls++; });
+    ThreadPool::shutdown();
+    ThreadPool::parallelFor(8, [&](size_t) { calls++; });
+    ThreadPool::setConcurrency(0);
+    EXPECT_EQ(calls, 16);
+    EXPECT_FALSE(ThreadPool::inWorker());
+}
+
+}  // namespace P4::Test
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2024 The P4 Language Consortium
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ir/type_summary.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+#include "ir/ir.h"
+#include "ir/visitor.h"
+
+namespace P4::Test {
+
+namespace {
+
+/// Swaps the operands of every addition.
+class SwapAddOperands : public Transform {
+ public:
+    unsigned visited = 0;
+    explicit SwapAddOperands(bool filter) {
+        if (filter) onlyVisitSubtreesWith<IR::Add>();
+    }
+    const IR::Node *preorder(IR::Node *n) override {
+        ++visited;
+        return n;
+    }
+    const IR::Node *postorder(IR::Add *add) override {
+        std::swap(add->left, add->right);
+        return add;
+    }
+};
+
+}  // namespace
+
+TEST(TypeSummary, Kinds) {
+    auto *t = IR::Type_Bits::get(8);
+    auto *add = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+    auto *stmt = new IR::AssignmentStatement(new IR::PathExpression("x"), add);
+
+    const auto &summary = IR::TypeSummary::get(stmt);
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::AssignmentStatement>()));
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::Constant>()));
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::Type_Bits>()));
+    // base classes and interfaces
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::Operation_Binary>()));
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::Literal>()));
+    EXPECT_TRUE(summary.intersects(IR::TypeSummary::of<IR::Statement>()));
+    EXPECT_FALSE(summary.intersects(IR::TypeSummary::of<IR::IfStatement, IR::Sub>()));
+
+    const auto &addSummary = IR::TypeSummary::get(add);
+    EXPECT_FALSE(addSummary.intersects(IR::TypeSummary::of<IR::PathExpression>()));
+    EXPECT_TRUE(summary.contains(addSummary));
+    // summaries are computed once and shared
+    EXPECT_EQ(&IR::TypeSummary::get(stmt), &summary);
+    EXPECT_EQ(&IR::TypeSummary::get(new IR::Constant(t, 3)),
+              &IR::TypeSummary::get(add->left));
+}
+
+TEST(TypeSummary, Clone) {
+    auto *t = IR::Type_Bits::get(8);
+    auto *neg = new IR::Neg(t, new IR::Constant(t, 1));
+    EXPECT_FALSE(IR::TypeSummary::get(neg).intersects(IR::TypeSummary::of<IR::Add>()));
+
+    auto *copy = neg->clone();
+    copy->expr = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+    EXPECT_TRUE(IR::TypeSummary::get(copy).intersects(IR::TypeSummary::of<IR::Add>()));
+    EXPECT_FALSE(IR::TypeSummary::get(neg).intersects(IR::TypeSummary::of<IR::Add>()));
+}
+
+TEST(TypeSummary, Assignment) {
+    auto *t = IR::Type_Bits::get(8);
+    auto *neg = new IR::Neg(t, new IR::Constant(t, 1));
+    EXPECT_FALSE(IR::TypeSummary::get(neg).intersects(IR::TypeSummary::of<IR::Add>()));
+
+    // the summary of a node is not carried over by assigning to it
+    *neg = IR::Neg(t, new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2)));
+    EXPECT_TRUE(IR::TypeSummary::get(neg).intersects(IR::TypeSummary::of<IR::Add>()));
+}
+
+TEST(TypeSummary, TransformSkipsSubtrees) {
+    auto *t = IR::Type_Bits::get(8);
+    auto *add = new IR::Add(t, new IR::Constant(t, 1), new IR::Constant(t, 2));
+    auto *neg = new IR::Neg(t, new IR::Constant(t, 3));
+    const IR::Node *program = new IR::Vector<IR::Expression>({add, neg});
+
+    SwapAddOperands unfiltered(false);
+    auto *expected = program->apply(unfiltered);
+    SwapAddOperands filtered(true);
+    auto *result = program->apply(filtered);
+    EXPECT_TRUE(result->equiv(*expected));
+    EXPECT_NE(result, program);
+
+    // The Neg subtree is returned as is, without visiting it.
+    auto *vec = result->to<IR::Vector<IR::Expression>>();
+    ASSERT_NE(vec, nullptr);
+    EXPECT_EQ(vec->at(1), neg);
+    // Vector, Add, its constants and their (shared) type, Neg and its constant
+    EXPECT_EQ(unfiltered.visited, 7u);
+    // Only the Vector and the Add; the preorder(IR::Node *) is deliberately not covered by the
+    // filter, so the subtrees without an Add are not visited at all.
+    EXPECT_EQ(filtered.visited, 2u);
+}
+
+}  // namespace P4::Test
@@ -16,6 +16,8 @@ limitations under the License.
 
 #include "irclass.h"
 
+#include <tuple>
+
 #include "lib/enumerator.h"
 #include "lib/exceptions.h"
 
@@ -142,6 +144,8 @@ void IrDefinitions::generate(std::ostream &t, std::ostream &out, std::ostream &i
         << std::endl;
 
     impl << "#include \"ir/ir-generated.h\"    // IWYU pragma: keep\n\n"
+         << "#include \"ir/binary_generator.h\"  // IWYU pragma: keep\n"
+         << "#include \"ir/binary_loader.h\"   // IWYU pragma: keep\n"
          << "#include \"ir/ir-inline.h\"       // IWYU pragma: keep\n"
          << "#include \"ir/json_generator.h\"  // IWYU pragma: keep\n"
          << "#include \"ir/json_loader.h\"     // IWYU pragma: keep\n"
@@ -169,27 +173,35 @@ void IrDefinitions::generate(std::ostream &t, std::ostream &out, std::ostream &i
         << std::endl
         << "class JSONLoader;\n"
         << "using NodeFactoryFn = IR::Node*(*)(JSONLoader&);\n"
+        << "class BinaryLoader;\n"
+        << "using BinaryNodeFactoryFn = IR::Node*(*)(BinaryLoader&);\n"
         << std::endl
         << "namespace IR {\n"
         << "extern std::map<cstring, NodeFactoryFn> unpacker_table;\n"
+        << "extern std::map<cstring, BinaryNodeFactoryFn> binary_unpacker_table;\n"
         << "using namespace P4::literals;\n"
         << "}\n";
 
-    impl << "std::map<cstring, NodeFactoryFn> IR::unpacker_table = {\n";
+    for (auto [table, factory, fn] :
+         {std::make_tuple("unpacker_table", "NodeFactoryFn", "fromJSON"),
+          std::make_tuple("binary_unpacker_table", "BinaryNodeFactoryFn", "fromBinary")}) {
+        impl << "std::map<cstring, " << factory << "> IR::" << table << " = {\n";
 
-    bool first = true;
-    for (auto cls : *getClasses()) {
-        if (cls->kind == NodeKind::Concrete) {
-            if (first)
-                first = false;
-            else
-                impl << ",\n";
-            impl << "{\"" << cls->name << "\"_cs, NodeFactoryFn(&IR::";
-            if (cls->containedIn && cls->containedIn->name) impl << cls->containedIn->name << "::";
-            impl << cls->name << "::fromJSON)}";
+        bool first = true;
+        for (auto cls : *getClasses()) {
+            if (cls->kind == NodeKind::Concrete) {
+                if (first)
+                    first = false;
+                else
+                    impl << ",\n";
+                impl << "{\"" << cls->name << "\"_cs, " << factory << "(&IR::";
+                if (cls->containedIn && cls->containedIn->name)
+                    impl << cls->containedIn->name << "::";
+                impl << cls->name << "::" << fn << ")}";
+            }
         }
+        impl << " };\n" << std::endl;
     }
-    impl << " };\n" << std::endl;
 
     impl << "template class IR::Vector<IR::Node>;" << std::endl;
     out << "extern template class IR::Vector<IR::Node>;" << std::endl;
@@ -274,10 +274,10 @@ class IrClass : public IrElement {
     int generateConstructor(const ctor_args_t &args, const IrMethod *user, unsigned skip_opt);
     void generateMethods();
     bool shouldSkip(cstring feature) const;
-    bool hasNoDirective(cstring feature) const;
     friend class IrDefinitions;
 
  public:
+    bool hasNoDirective(cstring feature) const;
     const IrClass *getParent() const {
         if (concreteParent == nullptr && this != nodeClass() && kind != NodeKind::Nested)
             return IrClass::nodeClass();
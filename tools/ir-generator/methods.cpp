@@ -64,6 +64,53 @@ const ordered_map<cstring, IrMethod::info_t> IrMethod::Generate = {
           buf << cl->indent << "}";
           return {buf};
       }}},
+    // equiv_hash must come before equiv, so that we can still see whether equiv is user-defined
+    {"equiv_hash"_cs,
+     {&NamedType::Size_t(),
+      {},
+      CONST + IN_IMPL + INCL_NESTED + OVERRIDE,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          // A user-defined equiv may ignore some fields, so only the parent's fields can be
+          // hashed consistently with it.
+          if (cl->hasNoDirective("equiv"_cs) ||
+              Util::enumerate(cl->elements)
+                  ->where([](IrElement *el) { return el->is<IrMethod>(); })
+                  ->where([](IrElement *el) { return el->to<IrMethod>()->name == "equiv"; })
+                  ->any())
+              return cstring();
+          std::stringstream buf;
+          buf << "{" << std::endl << cl->indent << cl->indent << "size_t rv = ";
+          if (auto parent = cl->getParent())
+              buf << parent->qualified_name(cl->containedIn) << "::equiv_hash();" << std::endl;
+          else
+              buf << "0;" << std::endl;
+          auto combine = [&](const std::string &hash) {
+              buf << cl->indent << cl->indent << "rv = Util::hash_combine(rv, " << hash << ");"
+                  << std::endl;
+          };
+          for (auto f : *cl->getFields()) {
+              if (f->type && *f->type == NamedType::SourceInfo())
+                  continue;  // not compared by equiv either
+              if (!f->type) {  // variant field
+                  combine(f->name + ".index()");
+              } else if (f->type->resolve(cl->containedIn) == nullptr) {
+                  // This is not an IR pointer
+                  if (auto *arr = dynamic_cast<const ArrayType *>(f->type)) {
+                      for (int i = 0; i < arr->size; ++i)
+                          combine("equiv_hash_field("_cs + f->name + "[" + std::to_string(i) +
+                                  "])");
+                  } else {
+                      combine("equiv_hash_field("_cs + f->name + ")");
+                  }
+              } else if (f->isInline) {
+                  combine(f->name + ".equiv_hash()");
+              } else {
+                  combine("("_cs + f->name + " ? " + f->name + "->equiv_hash() : 0)");
+              }
+          }
+          buf << cl->indent << cl->indent << "return rv;" << std::endl << cl->indent << "}";
+          return {buf};
+      }}},
     {"equiv"_cs,
      {&NamedType::Bool(),
       {new IrField(new ReferenceType(new NamedType(IrClass::nodeClass()), true), "a_"_cs)},
@@ -378,6 +425,52 @@ const ordered_map<cstring, IrMethod::info_t> IrMethod::Generate = {
           buf << "{ return new " << cl->name << "(json); }";
           return {buf};
       }}},
+    {"toBinary"_cs,
+     {&NamedType::Void(),
+      {new IrField(new ReferenceType(&NamedType::BinaryGenerator()), "out"_cs)},
+      CONST + IN_IMPL + OVERRIDE + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          buf << "{" << std::endl;
+          if (auto parent = cl->getParent())
+              buf << cl->indent << parent->qualified_name(cl->containedIn) << "::toBinary(out);"
+                  << std::endl;
+          for (auto f : *cl->getFields()) {
+              if (f->type && *f->type == NamedType::SourceInfo())
+                  continue;  // written by BinaryGenerator, if requested
+              buf << cl->indent << "out.emit(" << f->name << ");" << std::endl;
+          }
+          buf << "}";
+          return {buf};
+      }}},
+    // constructors are named after their class, so the key is only used to find this entry
+    {"binary_constructor"_cs,
+     {nullptr,
+      {new IrField(new ReferenceType(&NamedType::BinaryLoader()), "in"_cs)},
+      IN_IMPL + CONSTRUCTOR + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          if (auto parent = cl->getParent())
+              buf << ": " << parent->qualified_name(cl->containedIn) << "(in)";
+          buf << " {" << std::endl;
+          for (auto f : *cl->getFields()) {
+              if (f->type && *f->type == NamedType::SourceInfo()) continue;
+              buf << cl->indent << "in.load(" << f->name << ");" << std::endl;
+          }
+          buf << "}";
+          return {buf};
+      }}},
+    {"fromBinary"_cs,
+     {nullptr,
+      {
+          new IrField(new ReferenceType(&NamedType::BinaryLoader()), "in"_cs),
+      },
+      FACTORY + IN_IMPL + CONCRETE_ONLY + INCL_NESTED,
+      [](IrClass *cl, Util::SourceInfo, cstring) -> cstring {
+          std::stringstream buf;
+          buf << "{ return new " << cl->name << "(in); }";
+          return {buf};
+      }}},
     {"toString"_cs,
      {&NamedType::Cstring(),
       {},
@@ -456,7 +549,7 @@ void IrClass::generateMethods() {
         if (!IrMethod::Generate.count(m->name))
             throw Util::CompilationError("Unrecognized predefined method %1%", m->name);
         auto &info = IrMethod::Generate.at(m->name);
-        if (m->name) {
+        if (!(info.flags & CONSTRUCTOR)) {
             if (info.rtype) {
                 // This predefined method has an explicit return type.
                 m->rtype = info.rtype;
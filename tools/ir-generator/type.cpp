@@ -86,6 +86,11 @@ NamedType &NamedType::Int() {
     return nt;
 }
 
+NamedType &NamedType::Size_t() {
+    static NamedType nt("size_t"_cs);
+    return nt;
+}
+
 NamedType &NamedType::Void() {
     static NamedType nt("void"_cs);
     return nt;
@@ -111,6 +116,16 @@ NamedType &NamedType::Unordered_Set() {
     return nt;
 }
 
+NamedType &NamedType::BinaryGenerator() {
+    static NamedType nt("BinaryGenerator"_cs);
+    return nt;
+}
+
+NamedType &NamedType::BinaryLoader() {
+    static NamedType nt("BinaryLoader"_cs);
+    return nt;
+}
+
 NamedType &NamedType::JSONGenerator() {
     static NamedType nt("JSONGenerator"_cs);
     return nt;
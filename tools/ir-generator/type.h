@@ -103,11 +103,14 @@ class NamedType : public Type {
     static NamedType &Bool();
     static NamedType &Char();
     static NamedType &Int();
+    static NamedType &Size_t();
     static NamedType &Void();
     static NamedType &Cstring();
     static NamedType &Ostream();
     static NamedType &Visitor();
     static NamedType &Unordered_Set();
+    static NamedType &BinaryGenerator();
+    static NamedType &BinaryLoader();
     static NamedType &JSONGenerator();
     static NamedType &JSONLoader();
     static NamedType &JSONObject();